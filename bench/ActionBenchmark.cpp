@@ -0,0 +1,192 @@
+// One round of a large skirmish: every goblin attacks a fighter, every
+// fighter makes its two-attack multiattack against a goblin and every mage
+// casts a saving-throw spell. ActionPipeline rolls all d20s in one call and
+// the damage dice in one call per die size; the baseline rolls attack by
+// attack with RollOne and DiceExpression::Roll, recording the same outcomes
+// and applying each hit to the store as it lands.
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "combat/ActionPipeline.h"
+#include "entities/CreatureStore.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+// Hit points that never run out, so every round does the same work
+constexpr int kHitPoints = 1'000'000'000;
+
+Statblock Goblin()
+{
+  Statblock goblin;
+  goblin.SetHP(kHitPoints);
+  goblin.SetAC(15);
+  goblin.SetStat(Stats::DEX, 14);
+  goblin.AddAction(ActionType::ACTION, Action {"Scimitar", 4, "1d6+2"_dice});
+  return goblin;
+}
+
+Statblock Fighter()
+{
+  Statblock fighter;
+  fighter.SetHP(kHitPoints);
+  fighter.SetAC(18);
+  fighter.SetStat(Stats::STR, 16);
+  fighter.AddAction(ActionType::ACTION, Action {"Multiattack", MultiattackEffect {{1, 1}}});
+  fighter.AddAction(ActionType::ACTION, Action {"Longsword", 5, "1d8+3"_dice});
+  return fighter;
+}
+
+Statblock Mage()
+{
+  Statblock mage;
+  mage.SetHP(kHitPoints);
+  mage.SetAC(12);
+  mage.SetStat(Stats::INT, 17);
+  mage.AddAction(ActionType::ACTION, Action {"Burning Hands", SaveEffect {Stats::DEX, 13, "3d6"_dice, true}});
+  return mage;
+}
+
+template <typename Fn>
+void Report(const std::string& name, int rounds, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long checksum = 0;
+  for (int i = 0; i < rounds; i++)
+  {
+    checksum += fn();
+  }
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<28} {:>10.2f} us/round  (checksum {})\n",
+                           name, seconds * 1e6 / rounds, checksum);
+}
+
+
+void Run(int goblins)
+{
+  const int fighters = std::max(goblins / 5, 1);
+  const int mages = std::max(goblins / 20, 1);
+  const int rounds = 2000;
+
+  CreatureStore store;
+  for (int i = 0; i < goblins; i++)
+  {
+    store.Add(Goblin());
+  }
+  for (int i = 0; i < fighters; i++)
+  {
+    store.Add(Fighter());
+  }
+  for (int i = 0; i < mages; i++)
+  {
+    store.Add(Mage());
+  }
+
+  // Actions by dense index: goblins first, then fighters, then mages
+  const std::size_t first_fighter = goblins;
+  const std::size_t first_mage = first_fighter + fighters;
+
+  std::cout << std::format("{} goblins, {} fighters, {} mages\n", goblins, fighters, mages);
+
+  DiceEngine engine(5);
+  ActionPipeline pipeline;
+  Report("ActionPipeline", rounds, [&] {
+    for (int i = 0; i < goblins; i++)
+    {
+      pipeline.Queue(store, i, ActionType::ACTION, 0, first_fighter + i % fighters);
+    }
+    for (int i = 0; i < fighters; i++)
+    {
+      pipeline.Queue(store, first_fighter + i, ActionType::ACTION, 0, i * 5);
+    }
+    for (int i = 0; i < mages; i++)
+    {
+      pipeline.Queue(store, first_mage + i, ActionType::ACTION, 0, i * 20);
+    }
+
+    long long damage = 0;
+    for (const AttackOutcome& outcome : pipeline.Resolve(store, engine))
+    {
+      damage += outcome.damage;
+    }
+    return damage;
+  });
+
+  const std::span<const int> armor_class = store.ArmorClasses();
+  const std::span<const int> dexterity = store.Scores(Stats::DEX);
+  std::vector<AttackOutcome> outcomes;
+
+  auto record = [&](std::size_t attacker, std::size_t target, int d20, int damage, bool hit, bool critical) {
+    const std::uint32_t index = static_cast<std::uint32_t>(target);
+    outcomes.push_back({static_cast<std::uint32_t>(attacker), index, damage,
+                        static_cast<std::uint8_t>(d20), hit, critical});
+    store.ApplyDamage(std::span(&index, 1), std::span(&damage, 1));
+    return damage;
+  };
+
+  auto attack = [&](std::size_t attacker, const AttackEffect& effect, std::size_t target) {
+    const int d20 = engine.RollOne(20);
+    if (d20 == 1 || (d20 != 20 && d20 + effect.attackBonus < armor_class[target]))
+    {
+      return record(attacker, target, d20, 0, false, false);
+    }
+    int damage = effect.damage.Roll(engine);
+    if (d20 == 20)
+    {
+      damage += effect.damage.Roll(engine) - effect.damage.modifier;
+    }
+    return record(attacker, target, d20, std::max(damage, 0), true, d20 == 20);
+  };
+
+  Report("One attack at a time", rounds, [&] {
+    outcomes.clear();
+    long long damage = 0;
+    for (int i = 0; i < goblins; i++)
+    {
+      damage += attack(i, std::get<AttackEffect>(store.Actions(i, ActionType::ACTION)[0].effect),
+                       first_fighter + i % fighters);
+    }
+    for (int i = 0; i < fighters; i++)
+    {
+      const std::span<const Action> actions = store.Actions(first_fighter + i, ActionType::ACTION);
+      for (std::uint8_t index : std::get<MultiattackEffect>(actions[0].effect).actions)
+      {
+        damage += attack(first_fighter + i, std::get<AttackEffect>(actions[index].effect), i * 5);
+      }
+    }
+    for (int i = 0; i < mages; i++)
+    {
+      const auto& spell = std::get<SaveEffect>(store.Actions(first_mage + i, ActionType::ACTION)[0].effect);
+      const int d20 = engine.RollOne(20);
+      const int roll = spell.damage.Roll(engine);
+      const bool saved = d20 + (dexterity[i * 20] >> 1) - 5 >= spell.dc;
+      damage += record(first_mage + i, i * 20, d20, saved ? roll / 2 : roll, !saved, false);
+    }
+    return damage;
+  });
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+  {
+    Run(std::atoi(argv[1]));
+    return 0;
+  }
+
+  for (int goblins : {20, 2000})
+  {
+    Run(goblins);
+  }
+  return 0;
+}
@@ -0,0 +1,197 @@
+// Heap allocations and time of setting up and tearing down an encounter:
+// copying the party's and the monsters' statblocks into std::vectors, then
+// destroying them, against copying them into an Arena that is Reset() when
+// the encounter ends. Then the per-turn initiative order, built on the heap
+// and in a per-turn Arena. The arena paths must reach zero heap allocations
+// once warm; the benchmark exits with 1 when they do not.
+//
+//   ArenaBenchmark [encounters] [monsters]
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "combat/InitiativeTracker.h"
+#include "entities/Statblock.h"
+#include "utils/Arena.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+std::uint64_t gAllocations = 0;
+
+}
+
+void* operator new(std::size_t size)
+{
+  gAllocations++;
+  if (void* memory = std::malloc(size ? size : 1))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned forms
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  gAllocations++;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  if (void* memory = std::aligned_alloc(align, (size + align - 1) / align * align))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace
+{
+
+Statblock Fighter()
+{
+  Statblock fighter;
+  fighter.SetHP(28);
+  fighter.SetAC(18);
+  fighter.SetStat(Stats::DEX, 12);
+  fighter.AddAction(ActionType::ACTION, Action {"Multiattack", MultiattackEffect {{1, 1}}});
+  fighter.AddAction(ActionType::ACTION, Action {"Longsword of the Northern Reaches", 5, "1d8+3"_dice});
+  fighter.AddAction(ActionType::BONUS_ACTION, Action {"Second Wind", 0, "1d10+1"_dice});
+  return fighter;
+}
+
+Statblock GoblinBoss()
+{
+  Statblock goblin;
+  goblin.SetHP(21);
+  goblin.SetAC(17);
+  goblin.SetStat(Stats::DEX, 14);
+  goblin.AddAction(ActionType::ACTION, Action {"Multiattack", MultiattackEffect {{1, 1}}});
+  goblin.AddAction(ActionType::ACTION, Action {"Scimitar", 4, "1d6+2"_dice});
+  goblin.AddAction(ActionType::REACTION, Action {"Redirect Attack", 0, "0"_dice});
+  return goblin;
+}
+
+struct Result
+{
+  double nsPerItem;
+  double allocationsPerItem;
+};
+
+template <typename Fn>
+Result Measure(int items, Fn&& fn)
+{
+  // Warm up, so arenas have grown to their steady size
+  for (int i = 0; i < 16; i++)
+  {
+    fn();
+  }
+
+  const std::uint64_t allocations_before = gAllocations;
+  const auto start = cr::steady_clock::now();
+  for (int i = 0; i < items; i++)
+  {
+    fn();
+  }
+  const double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+  return {seconds * 1e9 / items, static_cast<double>(gAllocations - allocations_before) / items};
+}
+
+void Print(const char* name, const Result& result)
+{
+  std::cout << std::format("  {:<22} {:>10.0f} ns {:>10.2f} allocations\n",
+                           name, result.nsPerItem, result.allocationsPerItem);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int encounters = argc > 1 ? std::atoi(argv[1]) : 20'000;
+  const int num_monsters = argc > 2 ? std::atoi(argv[2]) : 12;
+
+  const Statblock fighter = Fighter();
+  const Statblock boss = GoblinBoss();
+  long long checksum = 0;
+
+  std::cout << std::format("Encounter of 4 fighters and {} goblin bosses, set up and torn down\n", num_monsters);
+
+  const Result heap = Measure(encounters, [&]
+  {
+    std::vector<Statblock> party(4, fighter);
+    std::vector<Statblock> monsters(num_monsters, boss);
+    checksum += party.back().GetActions(ActionType::ACTION).size() + monsters.size();
+  });
+  Print("std::vector", heap);
+
+  Arena encounter;
+  const Result arena = Measure(encounters, [&]
+  {
+    {
+      std::pmr::vector<Statblock> party(4, fighter, &encounter);
+      std::pmr::vector<Statblock> monsters(num_monsters, boss, &encounter);
+      checksum += party.back().GetActions(ActionType::ACTION).size() + monsters.size();
+    }
+    encounter.Reset();
+  });
+  Print("Arena", arena);
+
+  InitiativeTracker tracker;
+  for (int i = 0; i < 4 + num_monsters; i++)
+  {
+    tracker.Add(i < 4 ? fighter : boss);
+  }
+
+  std::cout << std::format("Turn order of {} combatants, once per turn\n", 4 + num_monsters);
+
+  const Result order_heap = Measure(encounters, [&]
+  {
+    checksum += tracker.Order().size();
+    tracker.NextTurn();
+  });
+  Print("heap", order_heap);
+
+  Arena turn(1024);
+  const Result order_arena = Measure(encounters, [&]
+  {
+    checksum += tracker.Order(&turn).size();
+    tracker.NextTurn();
+    turn.Reset();
+  });
+  Print("Arena", order_arena);
+
+  std::cout << std::format("  (checksum {})\n", checksum);
+
+  if (arena.allocationsPerItem > 0.0 || order_arena.allocationsPerItem > 0.0)
+  {
+    std::cout << "  arena paths allocated on the heap\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Startup time and resident memory for hundreds of monster sprites: baking
+// them from RGBA at startup versus mapping a pre-baked atlas.
+//
+//   AtlasBenchmark [sprites] [size]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+#include <unistd.h>
+
+#include "graphics/SpriteAtlas.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+long ResidentKiB()
+{
+  long pages = 0;
+  long resident = 0;
+  if (std::FILE* statm = std::fopen("/proc/self/statm", "r"))
+  {
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+    {
+      resident = 0;
+    }
+    std::fclose(statm);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+RgbaImage Monster(DiceEngine& engine, int size)
+{
+  RgbaImage image {size, size, std::vector<std::uint8_t>(static_cast<std::size_t>(size) * size * 4)};
+  for (std::uint8_t& channel : image.pixels)
+  {
+    channel = static_cast<std::uint8_t>(engine.Next());
+  }
+  return image;
+}
+
+long long TouchAll(const std::vector<SpriteView>& sprites)
+{
+  long long checksum = 0;
+  for (const SpriteView& sprite : sprites)
+  {
+    for (const AtlasCell& cell : sprite.cells)
+    {
+      checksum += cell.glyph + cell.colorPair;
+    }
+  }
+  return checksum;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int sprites = argc > 1 ? std::atoi(argv[1]) : 500;
+  const int size = argc > 2 ? std::atoi(argv[2]) : 32;
+  const std::string path = (std::filesystem::temp_directory_path() / "AtlasBenchmark.atlas").string();
+
+  DiceEngine engine(3);
+  std::vector<RgbaImage> images;
+  for (int i = 0; i < sprites; i++)
+  {
+    images.push_back(Monster(engine, size));
+  }
+
+  {
+    SpriteAtlasWriter writer;
+    for (int i = 0; i < sprites; i++)
+    {
+      writer.Add(std::format("monster{:04}", i), images[i]);
+    }
+    writer.Write(path);
+  }
+
+  // Baking at startup, which is what decoding PNGs at runtime would add to
+  auto start = cr::steady_clock::now();
+  std::vector<std::vector<AtlasCell>> baked;
+  long long checksum = 0;
+  for (const RgbaImage& image : images)
+  {
+    int width = 0;
+    int height = 0;
+    baked.push_back(BakeSprite(image, width, height));
+    checksum += baked.back().size();
+  }
+  double bake_ms = cr::duration<double, std::milli>(cr::steady_clock::now() - start).count();
+  long bake_kib = checksum * static_cast<long>(sizeof(AtlasCell)) / 1024;
+
+  images.clear();
+  images.shrink_to_fit();
+
+  long before = ResidentKiB();
+  start = cr::steady_clock::now();
+  SpriteAtlas atlas;
+  atlas.Open(path);
+  std::vector<SpriteView> views;
+  for (int i = 0; i < sprites; i++)
+  {
+    views.push_back(atlas.Find(std::format("monster{:04}", i)));
+  }
+  double map_ms = cr::duration<double, std::milli>(cr::steady_clock::now() - start).count();
+  long map_kib = ResidentKiB() - before;
+  checksum += TouchAll(views);
+  long touched_kib = ResidentKiB() - before;
+
+  std::cout << std::format("{} sprites of {}x{} pixels, atlas {} KiB\n",
+                           sprites, size, size, std::filesystem::file_size(path) / 1024);
+  std::cout << std::format("  bake at startup    {:>8.2f} ms  {:>6} KiB of heap\n", bake_ms, bake_kib);
+  std::cout << std::format("  map atlas          {:>8.2f} ms  {:>6} KiB resident, {} KiB once every cell is read\n",
+                           map_ms, map_kib, touched_kib);
+  std::cout << std::format("  (checksum {})\n", checksum);
+
+  std::filesystem::remove(path);
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Area of effect queries on a crowded battle map: scanning every creature
+// versus walking the squares of the template in the occupancy grid.
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "map/BattleMap.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+template <typename Fn>
+void Report(const std::string& name, int queries, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long hits = 0;
+  for (int i = 0; i < queries; i++)
+  {
+    hits += fn(i);
+  }
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<34} {:>9.1f} ns/query  ({} hits)\n",
+                           name, seconds * 1e9 / queries, hits);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int creatures = argc > 1 ? std::atoi(argv[1]) : 200;
+  const int size = argc > 2 ? std::atoi(argv[2]) : 100;
+  const int queries = 200'000;
+
+  DiceEngine engine(42);
+  BattleMap map(size, size);
+  std::vector<GridPos> positions;
+
+  while (static_cast<int>(positions.size()) < creatures)
+  {
+    const GridPos pos {engine.RollOne(size) - 1, engine.RollOne(size) - 1};
+    if (map.Place(pos, 1, 1, 1, engine.RollOne(2)) != kNoToken)
+    {
+      positions.push_back(pos);
+    }
+  }
+
+  std::vector<GridPos> targets(queries);
+  for (GridPos& target : targets)
+  {
+    target = {engine.RollOne(size) - 1, engine.RollOne(size) - 1};
+  }
+
+  // Fireball: 20 foot radius
+  std::vector<AreaTemplate> fireballs;
+  std::vector<AreaTemplate> cones;
+  std::vector<AreaTemplate> lines;
+  for (int i = 0; i < 1024; i++)
+  {
+    fireballs.push_back(AreaTemplate::Sphere(targets[i], 4.0));
+    cones.push_back(AreaTemplate::Cone(targets[i], targets[i + 1], 3.0));
+    lines.push_back(AreaTemplate::Line(targets[i], targets[i + 1], 20.0));
+  }
+
+  std::cout << std::format("{} creatures on a {}x{} map\n", creatures, size, size);
+
+  Report("Sphere r4, build template", queries, [&](int i) {
+    return static_cast<long long>(AreaTemplate::Sphere(targets[i], 4.0).NumCells());
+  });
+
+  Report("Sphere r4, scan all creatures", queries, [&](int i) {
+    const GridPos center = targets[i & 1023];
+    long long hits = 0;
+    for (const GridPos& pos : positions)
+    {
+      const int dx = pos.x - center.x;
+      const int dy = pos.y - center.y;
+      hits += dx * dx + dy * dy <= 16;
+    }
+    return hits;
+  });
+
+  std::vector<TokenId> hits;
+  Report("Sphere r4, BattleMap::Query", queries, [&](int i) {
+    hits.clear();
+    map.Query(fireballs[i & 1023], hits);
+    return static_cast<long long>(hits.size());
+  });
+
+  Report("Cone 15ft, BattleMap::Query", queries, [&](int i) {
+    hits.clear();
+    map.Query(cones[i & 1023], hits);
+    return static_cast<long long>(hits.size());
+  });
+
+  Report("Line 100ft, BattleMap::Query", queries, [&](int i) {
+    hits.clear();
+    map.Query(lines[i & 1023], hits);
+    return static_cast<long long>(hits.size());
+  });
+
+  Report("BattleMap::Threatening", queries, [&](int i) {
+    hits.clear();
+    map.Threatening(static_cast<TokenId>(i % creatures), hits);
+    return static_cast<long long>(hits.size());
+  });
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+// Startup time and resident memory for a bestiary of thousands of monsters:
+// parsing the text source into Statblocks versus mapping the compiled file.
+//
+//   BestiaryBenchmark [creatures]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include "entities/Bestiary.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+long ResidentKiB()
+{
+  long pages = 0;
+  long resident = 0;
+  if (std::FILE* statm = std::fopen("/proc/self/statm", "r"))
+  {
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+    {
+      resident = 0;
+    }
+    std::fclose(statm);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long HeapKiB()
+{
+  return static_cast<long>(mallinfo2().uordblks / 1024);
+}
+
+void WriteSource(const std::string& path, int creatures)
+{
+  DiceEngine engine(9);
+  std::ofstream out(path);
+
+  for (int i = 0; i < creatures; i++)
+  {
+    out << std::format("creature Monster {:05}\n", i);
+    out << std::format("cr {}\n", engine.RollOne(30) - 1);
+    out << std::format("hp {}\nac {}\n", engine.RollSum(8, 10), engine.RollOne(10) + 10);
+    out << "stats";
+    for (const char* stat : {"STR", "DEX", "CON", "INT", "WIS", "CHA"})
+    {
+      out << std::format(" {} {}", stat, engine.RollSum(3, 6));
+    }
+    out << "\naction Multiattack: multiattack Bite, Claw, Claw\n";
+    out << std::format("action Bite: attack +{} 2d10+{}\n", engine.RollOne(10), engine.RollOne(6));
+    out << std::format("action Claw: attack +{} 2d6+{}\n", engine.RollOne(10), engine.RollOne(6));
+    out << std::format("action Breath: save DEX {} {}d6 half\n", engine.RollOne(10) + 10, engine.RollOne(16));
+    out << std::format("legendary_action Tail: attack +{} 2d8+{}\n\n", engine.RollOne(10), engine.RollOne(6));
+  }
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int creatures = argc > 1 ? std::atoi(argv[1]) : 5000;
+  const auto directory = std::filesystem::temp_directory_path();
+  const std::string source = (directory / "BestiaryBenchmark.txt").string();
+  const std::string compiled = (directory / "BestiaryBenchmark.bestiary").string();
+
+  WriteSource(source, creatures);
+  {
+    std::ifstream in(source);
+    std::vector<BestiaryEntry> entries;
+    std::string error;
+    ParseBestiary(in, entries, error);
+
+    BestiaryWriter writer;
+    for (BestiaryEntry& entry : entries)
+    {
+      writer.Add(std::move(entry.name), entry.statblock);
+    }
+    writer.Write(compiled);
+  }
+
+  long before = ResidentKiB();
+  auto start = cr::steady_clock::now();
+  Bestiary bestiary;
+  bestiary.Open(compiled);
+  const std::size_t boss = bestiary.Find(std::format("Monster {:05}", creatures / 2));
+  long long checksum = bestiary.At(boss).GetHP() + bestiary.ByChallenge(5.0f, 10.0f).size();
+  double map_ms = cr::duration<double, std::milli>(cr::steady_clock::now() - start).count();
+  long map_kib = ResidentKiB() - before;
+
+  for (std::size_t i = 0; i < bestiary.Size(); i++)
+  {
+    const CreatureView creature = bestiary.At(i);
+    checksum += creature.GetHP() + creature.GetAction(ActionType::ACTION, 1).damage->modifier;
+  }
+  long touched_kib = ResidentKiB() - before;
+
+  // Heap in use rather than resident size, which the compile step's freed
+  // heap would hide
+  before = HeapKiB();
+  start = cr::steady_clock::now();
+  std::ifstream in(source);
+  std::vector<BestiaryEntry> entries;
+  std::string error;
+  ParseBestiary(in, entries, error);
+  checksum += entries[creatures / 2].statblock.GetHP();
+  double parse_ms = cr::duration<double, std::milli>(cr::steady_clock::now() - start).count();
+  long parse_kib = HeapKiB() - before;
+
+  std::cout << std::format("{} creatures, source {} KiB, bestiary {} KiB\n", creatures,
+                           std::filesystem::file_size(source) / 1024,
+                           std::filesystem::file_size(compiled) / 1024);
+  std::cout << std::format("  parse source       {:>8.2f} ms  {:>6} KiB of heap\n", parse_ms, parse_kib);
+  std::cout << std::format("  map bestiary       {:>8.3f} ms  {:>6} KiB resident, {} KiB once every creature is read\n",
+                           map_ms, map_kib, touched_kib);
+  std::cout << std::format("  (checksum {})\n", checksum);
+
+  std::filesystem::remove(source);
+  std::filesystem::remove(compiled);
+  return 0;
+}
@@ -0,0 +1,111 @@
+// Re-rating thousands of homebrew monsters: rating every statblock from
+// scratch, re-reading cached ratings after tweaking hit points, and the
+// parallel batch mode.
+//
+//   ChallengeRatingBenchmark [creatures] [threads]
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "entities/ChallengeRating.h"
+#include "entities/Statblock.h"
+#include "rules/DiceEngine.h"
+#include "utils/ThreadPool.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+template <typename Fn>
+void Report(const std::string& name, std::size_t creatures, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  const double checksum = fn();
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<34} {:>8.1f} ns/creature  (checksum {:.1f})\n",
+                           name, seconds * 1e9 / creatures, checksum);
+}
+
+Statblock Homebrew(DiceEngine& engine)
+{
+  static const DiceExpression kDamage[] = {"1d6+2"_dice, "2d6+4"_dice, "1d10+5"_dice,
+                                           "2d10+6+1d6"_dice, "4d6kh3+3"_dice, "12d6"_dice};
+
+  Statblock statblock;
+  statblock.SetHP(engine.RollSum(engine.RollOne(30), 10));
+  statblock.SetAC(engine.RollOne(10) + 10);
+  statblock.AddAction(ActionType::ACTION, Action {"Multiattack", MultiattackEffect {{1, 1, 2}}});
+  statblock.AddAction(ActionType::ACTION, Action {"Claw", engine.RollOne(10) + 2, kDamage[engine.RollOne(6) - 1]});
+  statblock.AddAction(ActionType::ACTION, Action {"Bite", engine.RollOne(10) + 2, kDamage[engine.RollOne(6) - 1]});
+  statblock.AddAction(ActionType::ACTION,
+                      Action {"Breath", SaveEffect {Stats::DEX, engine.RollOne(10) + 10, kDamage[5], true}});
+  statblock.AddAction(ActionType::BONUS_ACTION, Action {"Tail", engine.RollOne(10) + 2, kDamage[1]});
+  return statblock;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const std::size_t creatures = argc > 1 ? std::atoll(argv[1]) : 100'000;
+  const std::size_t threads = argc > 2 ? std::atoll(argv[2]) : 0;
+
+  DiceEngine engine(16);
+  std::vector<Statblock> originals;
+  for (std::size_t i = 0; i < creatures; i++)
+  {
+    originals.push_back(Homebrew(engine));
+  }
+
+  Report("RateStatblock, from scratch", creatures, [&] {
+    double total = 0.0;
+    for (const Statblock& statblock : originals)
+    {
+      total += RateStatblock(statblock).cr;
+    }
+    return total;
+  });
+
+  std::vector<Statblock> statblocks = originals;
+  for (const Statblock& statblock : statblocks)
+  {
+    statblock.GetCalculatedCR();
+  }
+
+  Report("GetCalculatedCR after SetHP", creatures, [&] {
+    double total = 0.0;
+    for (Statblock& statblock : statblocks)
+    {
+      statblock.SetHP(statblock.GetHP() + 10);
+      total += statblock.GetCalculatedCR().cr;
+    }
+    return total;
+  });
+
+  Report("GetCalculatedCR, unchanged", creatures, [&] {
+    double total = 0.0;
+    for (const Statblock& statblock : statblocks)
+    {
+      total += statblock.GetCalculatedCR().cr;
+    }
+    return total;
+  });
+
+  ThreadPool pool(threads);
+  statblocks = originals;
+  Report(std::format("RateAll on {} workers", pool.NumWorkers()), creatures, [&] {
+    RateAll(statblocks, pool);
+    double total = 0.0;
+    for (const Statblock& statblock : statblocks)
+    {
+      total += statblock.GetCalculatedCR().cr;
+    }
+    return total;
+  });
+
+  return 0;
+}
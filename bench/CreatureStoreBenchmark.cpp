@@ -0,0 +1,94 @@
+// Encounter-wide queries over an array of Statblocks versus a CreatureStore.
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "entities/CreatureStore.h"
+#include "entities/Statblock.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+template <typename Fn>
+void Report(const std::string& name, int repetitions, std::size_t creatures, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long checksum = 0;
+  for (int i = 0; i < repetitions; i++)
+  {
+    checksum += fn();
+  }
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<34} {:>8.2f} ns/creature  (checksum {})\n",
+                           name, seconds * 1e9 / (repetitions * creatures), checksum);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const std::size_t creatures = argc > 1 ? std::atoll(argv[1]) : 10'000;
+  const int repetitions = 200;
+
+  DiceEngine engine(42);
+  std::vector<Statblock> statblocks(creatures);
+  CreatureStore store;
+
+  for (std::size_t i = 0; i < creatures; i++)
+  {
+    Statblock& statblock = statblocks[i];
+    statblock.SetCR(static_cast<float>(i % 8) / 2.0f);
+    statblock.SetStat(Stats::DEX, engine.RollSum(3, 6));
+    statblock.SetStat(Stats::CON, engine.RollSum(3, 6));
+    statblock.AddAction(ActionType::ACTION, Action {"Scimitar", 4, "1d6+2"_dice});
+    store.Add(statblock);
+  }
+
+  Report("Statblock[] sum of CR", repetitions, creatures, [&] {
+    float total = 0;
+    for (const Statblock& statblock : statblocks) total += statblock.GetCR();
+    return static_cast<long long>(total);
+  });
+
+  Report("CreatureStore::TotalCR", repetitions, creatures, [&] {
+    return static_cast<long long>(store.TotalCR());
+  });
+
+  Report("Statblock[] DEX saves DC 13", repetitions, creatures, [&] {
+    long long saved = 0;
+    for (const Statblock& statblock : statblocks)
+    {
+      saved += engine.RollOne(20) + statblock.GetModifier<Stats::DEX>() >= 13;
+    }
+    return saved;
+  });
+
+  std::vector<std::uint8_t> success(creatures);
+  Report("CreatureStore DEX saves DC 13", repetitions, creatures, [&] {
+    store.RollSavingThrows(Stats::DEX, 13, Roll::STRIGHT, engine, success);
+    long long saved = 0;
+    for (std::uint8_t s : success) saved += s;
+    return saved;
+  });
+
+  Report("CreatureStore DEX saves, advantage", repetitions, creatures, [&] {
+    store.RollSavingThrows(Stats::DEX, 13, Roll::ADVANTAGE, engine, success);
+    long long saved = 0;
+    for (std::uint8_t s : success) saved += s;
+    return saved;
+  });
+
+  std::vector<int> initiative(creatures);
+  Report("CreatureStore initiative", repetitions, creatures, [&] {
+    store.RollInitiative(engine, initiative);
+    return static_cast<long long>(initiative[0]);
+  });
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+// Time to answer "chance 2d6+3 beats AC 15" and "chance a +5 attack with
+// advantage hits AC 17" by sampling versus with DiceDistribution.
+#include <chrono>
+#include <format>
+#include <iostream>
+
+#include "rules/DiceDistribution.h"
+#include "rules/Roll.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+template <typename Fn>
+void Report(const std::string& name, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  double chance = fn();
+  double micros = cr::duration<double, std::micro>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<36} p = {:.5f}  {:>12.2f} us\n", name, chance, micros);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const long long samples = argc > 1 ? std::atoll(argv[1]) : 10'000'000;
+
+  Report("Monte Carlo 2d6+3 >= 15", [&] {
+    long long hits = 0;
+    for (long long i = 0; i < samples; i++) hits += (Die::Roll(2, 6) + 3 >= 15);
+    return static_cast<double>(hits) / samples;
+  });
+
+  Report("exact 2d6+3 >= 15 (first query)", [] {
+    return DiceDistribution::Of({.nDice = 2, .facesDie = 6, .modifier = 3}).AtLeast(15);
+  });
+
+  Report("exact 2d6+3 >= 15 (memoized)", [] {
+    return DiceDistribution::Of({.nDice = 2, .facesDie = 6, .modifier = 3}).AtLeast(15);
+  });
+
+  Report("Monte Carlo advantage +5 vs AC 17", [&] {
+    long long hits = 0;
+    for (long long i = 0; i < samples; i++) hits += (Die::RollAdvantage() + 5 >= 17);
+    return static_cast<double>(hits) / samples;
+  });
+
+  Report("exact advantage +5 vs AC 17", [] {
+    return DiceDistribution::D20(Roll::ADVANTAGE).AtLeast(17 - 5);
+  });
+
+  Report("exact 4d6kh3 >= 15", [] {
+    return DiceDistribution::Of({.nDice = 4, .facesDie = 6, .keep = 3}).AtLeast(15);
+  });
+
+  Report("exact 200d20 >= 2200 (FFT)", [] {
+    return DiceDistribution::Of({.nDice = 200, .facesDie = 20}).AtLeast(2200);
+  });
+
+  return 0;
+}
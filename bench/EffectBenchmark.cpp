@@ -0,0 +1,134 @@
+// Timed conditions on a large battle: every creature carries a few effects,
+// half of them until the end of someone's next turn, the rest for 1-10
+// rounds or 1-10 minutes, and every turn applies as many new ones as
+// expired to keep the count steady. EffectSystem expires them through its
+// timing wheel; the baseline scans every active effect at the end of each
+// turn, which is what a plain list of durations comes down to. Both must
+// expire the same number of effects on every turn.
+//
+//   EffectBenchmark [creatures] [effects per creature] [turns]
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "combat/EffectSystem.h"
+#include "entities/CreatureStore.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+constexpr Condition kConditions[] = {Condition::BLINDED, Condition::FRIGHTENED, Condition::POISONED,
+                                     Condition::PRONE, Condition::RESTRAINED, Condition::STUNNED};
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int creatures = argc > 1 ? std::atoi(argv[1]) : 10'000;
+  const int per_creature = argc > 2 ? std::atoi(argv[2]) : 4;
+  const int turns = argc > 3 ? std::atoi(argv[3]) : 2'000;
+
+  CreatureStore store;
+  std::vector<CreatureHandle> handles;
+  Statblock goblin;
+  goblin.SetHP(7);
+  goblin.SetAC(15);
+  for (int i = 0; i < creatures; i++)
+  {
+    handles.push_back(store.Add(goblin));
+  }
+
+  std::mt19937 rng(23);
+  std::uniform_int_distribution<int> pick_creature(0, creatures - 1);
+  std::uniform_int_distribution<int> pick_condition(0, static_cast<int>(std::size(kConditions)) - 1);
+  std::uniform_int_distribution<int> pick_kind(0, 9);
+  std::uniform_int_distribution<int> pick_count(1, 10);
+  std::uniform_int_distribution<int> pick_turn(1, creatures);
+
+  // In turns, a round being every creature's turn
+  auto pick_duration = [&]
+  {
+    const int kind = pick_kind(rng);
+    return kind < 5 ? pick_turn(rng) : kind < 8 ? pick_count(rng) * creatures : pick_count(rng) * 10 * creatures;
+  };
+
+  EffectSystem effects(store);
+  effects.SetRoundLength(creatures);
+
+  // Baseline: deadline and target of every active effect, scanned each turn
+  struct Timed
+  {
+    std::uint64_t deadline;
+    std::uint32_t creature;
+  };
+  std::vector<Timed> scanned;
+  std::uint64_t scan_now = 0;
+
+  auto apply = [&]
+  {
+    const int creature = pick_creature(rng);
+    const int duration = pick_duration();
+    effects.Apply(handles[creature], kConditions[pick_condition(rng)], Duration::Turns(duration));
+    scanned.push_back({scan_now + duration, static_cast<std::uint32_t>(creature)});
+  };
+
+  for (int i = 0; i < creatures * per_creature; i++)
+  {
+    apply();
+  }
+
+  double wheel_seconds = 0.0;
+  double scan_seconds = 0.0;
+  std::size_t expired = 0;
+  bool agree = true;
+
+  for (int turn = 0; turn < turns; turn++)
+  {
+    auto start = cr::steady_clock::now();
+    const std::size_t by_wheel = effects.EndTurn(handles[turn % creatures]).size();
+    wheel_seconds += cr::duration<double>(cr::steady_clock::now() - start).count();
+
+    start = cr::steady_clock::now();
+    scan_now++;
+    std::size_t by_scan = 0;
+    for (std::size_t i = 0; i < scanned.size();)
+    {
+      if (scanned[i].deadline <= scan_now)
+      {
+        scanned[i] = scanned.back();
+        scanned.pop_back();
+        by_scan++;
+      }
+      else
+      {
+        i++;
+      }
+    }
+    scan_seconds += cr::duration<double>(cr::steady_clock::now() - start).count();
+
+    agree &= by_wheel == by_scan;
+    expired += by_wheel;
+    for (std::size_t i = 0; i < by_wheel; i++)
+    {
+      apply();
+    }
+  }
+
+  std::cout << std::format("{} creatures, {} active effects, {} turns, {:.1f} expiring per turn\n",
+                           creatures, effects.Size(), turns, static_cast<double>(expired) / turns);
+  std::cout << std::format("  timing wheel  {:>10.2f} us/turn\n", wheel_seconds * 1e6 / turns);
+  std::cout << std::format("  scan          {:>10.2f} us/turn\n", scan_seconds * 1e6 / turns);
+
+  if (!agree)
+  {
+    std::cout << "  the wheel and the scan expired different effects\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Visibility of every creature against every other on a walled battle map:
+// full recomputation versus incremental updates, and pairwise CanSee versus
+// word-wise visible token scans.
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "map/FieldOfView.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+template <typename Fn>
+void Report(const std::string& name, int repetitions, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long checksum = 0;
+  for (int i = 0; i < repetitions; i++)
+  {
+    checksum += fn(i);
+  }
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<38} {:>10.2f} us  (checksum {})\n",
+                           name, seconds * 1e6 / repetitions, checksum);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int creatures = argc > 1 ? std::atoi(argv[1]) : 200;
+  const int size = argc > 2 ? std::atoi(argv[2]) : 100;
+  const int radius = 12;    // 60 feet
+
+  DiceEngine engine(7);
+  BattleMap map(size, size);
+  for (int i = 0; i < size * size / 10; i++)
+  {
+    map.SetWall({engine.RollOne(size) - 1, engine.RollOne(size) - 1}, true);
+  }
+
+  std::vector<TokenId> tokens;
+  while (static_cast<int>(tokens.size()) < creatures)
+  {
+    const TokenId id = map.Place({engine.RollOne(size) - 1, engine.RollOne(size) - 1}, 1, 1, 1, engine.RollOne(2));
+    if (id != kNoToken)
+    {
+      tokens.push_back(id);
+    }
+  }
+
+  FieldOfView fov(map, radius);
+  for (TokenId id : tokens)
+  {
+    fov.Track(id);
+  }
+
+  std::cout << std::format("{} creatures on a {}x{} map, {} square sight\n", creatures, size, size, radius);
+
+  Report("Update, every creature", 50, [&](int) {
+    for (TokenId id : tokens)
+    {
+      fov.MarkMoved(id);
+    }
+    return static_cast<long long>(fov.Update());
+  });
+
+  Report("Update, after one creature moves", 2000, [&](int i) {
+    const TokenId id = tokens[i % creatures];
+    const GridPos pos = map.GetToken(id).pos;
+    const GridPos to {pos.x + (i & 1 ? 1 : -1), pos.y};
+    if (map.Move(id, to))
+    {
+      fov.MarkMoved(id);
+    }
+    return static_cast<long long>(fov.Update());
+  });
+
+  Report("All pairs, CanSee", 20, [&](int) {
+    long long pairs = 0;
+    for (TokenId viewer : tokens)
+    {
+      for (TokenId target : tokens)
+      {
+        pairs += fov.CanSee(viewer, target);
+      }
+    }
+    return pairs;
+  });
+
+  std::vector<TokenId> seen;
+  Report("All pairs, VisibleTokens", 20, [&](int) {
+    long long pairs = 0;
+    for (TokenId viewer : tokens)
+    {
+      seen.clear();
+      fov.VisibleTokens(viewer, seen);
+      pairs += seen.size();
+    }
+    return pairs;
+  });
+
+  VisibilityGrid team_view;
+  Report("TeamView", 2000, [&](int i) {
+    fov.TeamView(1 + (i & 1), team_view);
+    return static_cast<long long>(team_view.LastRow() - team_view.FirstRow());
+  });
+
+  return 0;
+}
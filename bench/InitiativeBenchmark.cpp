@@ -0,0 +1,181 @@
+// Turn order for large swarms: every step takes a turn, summons a creature,
+// kills one, delays one and queues a legendary action. The tracker keeps an
+// indexed heap; the baseline re-sorts a vector after every change, which is
+// what ordering turns without a dedicated structure comes down to.
+//
+// Exits with 1 when a delay during one's own turn, or a delay or interrupt of
+// a removed combatant, leaves the wrong order.
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "combat/InitiativeTracker.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+struct SortedCombatant
+{
+  int initiative;
+  int dexterity;
+  std::uint32_t id;
+};
+
+bool Before(const SortedCombatant& a, const SortedCombatant& b)
+{
+  return a.initiative != b.initiative ? a.initiative > b.initiative
+                                      : a.dexterity != b.dexterity ? a.dexterity > b.dexterity : a.id < b.id;
+}
+
+template <typename Fn>
+void Report(const std::string& name, std::size_t swarm, int steps, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long checksum = 0;
+  for (int i = 0; i < steps; i++)
+  {
+    checksum += fn(i);
+  }
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<26} {:>8} creatures {:>12.1f} ns/step  (checksum {})\n",
+                           name, swarm, seconds * 1e9 / steps, checksum);
+}
+
+// A (20), B (15) and C (10) are added and A takes the first turn. Then
+// change() runs, and the turns after it must be expected, as (id, round).
+template <typename Fn>
+bool CheckOrder(const std::string& name, Fn&& change, std::initializer_list<std::pair<CombatantId, int>> expected)
+{
+  InitiativeTracker tracker;
+  tracker.Add(20, 10);
+  tracker.Add(15, 10);
+  tracker.Add(10, 10);
+
+  tracker.NextTurn();
+  change(tracker);
+
+  for (const auto& [combatant, round] : expected)
+  {
+    const Turn turn = tracker.NextTurn();
+    if (turn.combatant != combatant || turn.round != round)
+    {
+      std::cout << std::format("FAILED: {}, got {} in round {}, expected {} in round {}\n",
+                               name, turn.combatant, turn.round, combatant, round);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CheckDelays()
+{
+  constexpr CombatantId a = 0;
+  constexpr CombatantId b = 1;
+  constexpr CombatantId c = 2;
+
+  // A later count this round: A acts again between B and C
+  return CheckOrder("delay during own turn",
+                    [](InitiativeTracker& tracker) { tracker.Delay(a, 12); },
+                    {{b, 1}, {a, 1}, {c, 1}, {b, 2}, {a, 2}, {c, 2}}) &&
+         // An earlier or the same count would be a second turn: next round
+         CheckOrder("delay earlier during own turn",
+                    [](InitiativeTracker& tracker) { tracker.Delay(a, 25); },
+                    {{b, 1}, {c, 1}, {a, 2}, {b, 2}, {c, 2}}) &&
+         CheckOrder("delay to the same count during own turn",
+                    [](InitiativeTracker& tracker) { tracker.Delay(a, 20); },
+                    {{b, 1}, {c, 1}, {a, 2}, {b, 2}, {c, 2}}) &&
+         // Ids that are not combatants change nothing
+         CheckOrder("delay and interrupt of removed ids",
+                    [](InitiativeTracker& tracker) {
+                      tracker.Remove(c);
+                      tracker.Delay(c, 30);
+                      tracker.Interrupt(c);
+                      tracker.Interrupt(99);
+                    },
+                    {{b, 1}, {a, 2}, {b, 2}});
+}
+
+void Run(std::size_t swarm)
+{
+  DiceEngine engine(11);
+
+  InitiativeTracker tracker;
+  std::vector<CombatantId> alive;
+  for (std::size_t i = 0; i < swarm; i++)
+  {
+    alive.push_back(tracker.Add(engine.RollOne(20) + 2, engine.RollOne(20)));
+  }
+  const CombatantId dragon = tracker.Add(30, 10);
+
+  Report("InitiativeTracker", swarm, 200'000, [&](int step) {
+    const Turn turn = tracker.NextTurn();
+    if (step % 3 == 0)
+    {
+      tracker.Interrupt(dragon);
+    }
+
+    const CombatantId summon = tracker.Add(engine.RollOne(20) + 2, engine.RollOne(20));
+    const std::size_t victim = engine.RollOne(static_cast<int>(alive.size())) - 1;
+    tracker.Remove(alive[victim]);
+    alive[victim] = summon;
+
+    tracker.Delay(alive[engine.RollOne(static_cast<int>(alive.size())) - 1], engine.RollOne(10));
+    return static_cast<long long>(turn.combatant);
+  });
+
+  std::vector<SortedCombatant> order;
+  std::uint32_t next_id = 0;
+  for (std::size_t i = 0; i < swarm; i++)
+  {
+    order.push_back({engine.RollOne(20) + 2, engine.RollOne(20), next_id++});
+  }
+  std::sort(order.begin(), order.end(), Before);
+  std::size_t current = 0;
+
+  const int sorted_steps = swarm > 10'000 ? 50 : 500;
+  Report("Re-sorted vector", swarm, sorted_steps, [&](int) {
+    const std::uint32_t acting = order[current % order.size()].id;
+    current++;
+
+    order.push_back({engine.RollOne(20) + 2, engine.RollOne(20), next_id++});
+    std::sort(order.begin(), order.end(), Before);
+
+    order.erase(order.begin() + (engine.RollOne(static_cast<int>(order.size())) - 1));
+
+    order[engine.RollOne(static_cast<int>(order.size())) - 1].initiative = engine.RollOne(10);
+    std::sort(order.begin(), order.end(), Before);
+    return static_cast<long long>(acting);
+  });
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  if (!CheckDelays())
+  {
+    return 1;
+  }
+
+  if (argc > 1)
+  {
+    Run(std::atoll(argv[1]));
+    return 0;
+  }
+
+  for (std::size_t swarm : {100, 10'000, 1'000'000})
+  {
+    Run(swarm);
+  }
+  return 0;
+}
@@ -0,0 +1,202 @@
+// Key-to-photon latency of the game loop. A writer thread types arrow keys
+// (as the escape sequences a terminal sends) into a pipe at random 3-20 ms
+// intervals while DemoScene runs headlessly in a 60 Hz GameLoop. For every
+// key it measures the time until the scene handled it and until the frame
+// showing it was presented, for three ways of reading input:
+//
+//   sleep   the loop sleeps until its next deadline and reads input after
+//   poll    the loop sleeps on the input fd and decodes keys itself
+//   thread  an InputThread decodes keys and the loop sleeps on its wake fd
+//
+//   InputLatencyBenchmark [keys]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "game/DemoScene.h"
+#include "graphics/NcursesGraphics.h"
+#include "utils/GameLoop.h"
+#include "utils/InputThread.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+using Clock = GameLoop::Clock;
+
+enum class Mode
+{
+  SLEEP,
+  POLL,
+  THREAD,
+};
+
+struct Latencies
+{
+  std::vector<double> handled;      // ms from typing to OnKey
+  std::vector<double> shown;        // ms from typing to the presented frame
+};
+
+double Percentile(std::vector<double> samples, double quantile)
+{
+  if (samples.empty())
+  {
+    return 0.0;
+  }
+  const std::size_t rank = std::min(samples.size() - 1, static_cast<std::size_t>(quantile * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+double Ms(Clock::duration duration)
+{
+  return cr::duration<double, std::milli>(duration).count();
+}
+
+Latencies Run(Mode mode, std::size_t numKeys)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    return {};
+  }
+  if (mode != Mode::THREAD)
+  {
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  }
+
+  std::vector<Clock::time_point> sent(numKeys);
+  std::atomic<std::size_t> num_sent {0};
+
+  std::thread writer([&]
+  {
+    std::mt19937 rng(20);
+    std::uniform_int_distribution<int> pause_us(3000, 20000);
+    for (std::size_t i = 0; i < numKeys; i++)
+    {
+      std::this_thread::sleep_for(cr::microseconds(pause_us(rng)));
+      sent[i] = Clock::now();
+      num_sent.store(i + 1, std::memory_order_release);
+      [[maybe_unused]] const ssize_t written = write(fds[1], "\x1b[C", 3);
+    }
+  });
+
+  Display display;
+  display.InitHeadless(200, 60);
+  DemoScene scene(200, 60);
+
+  InputThread input;
+  int wait_fd = -1;
+  if (mode == Mode::POLL)
+  {
+    wait_fd = fds[0];
+  }
+  else if (mode == Mode::THREAD)
+  {
+    input.Start(fds[0]);
+    wait_fd = input.WakeFd();
+  }
+
+  KeyDecoder decoder;
+  std::vector<int> decoded;
+  std::deque<int> keys;
+
+  auto read_key = [&]
+  {
+    if (mode == Mode::THREAD)
+    {
+      InputEvent event;
+      return input.Poll(event) ? event.key : -1;
+    }
+    if (keys.empty())
+    {
+      std::uint8_t buffer[256];
+      const ssize_t got = read(fds[0], buffer, sizeof(buffer));
+      if (got > 0)
+      {
+        decoded.clear();
+        decoder.Feed({buffer, static_cast<std::size_t>(got)}, decoded);
+        keys.insert(keys.end(), decoded.begin(), decoded.end());
+      }
+    }
+    if (keys.empty())
+    {
+      return -1;
+    }
+    const int key = keys.front();
+    keys.pop_front();
+    return key;
+  };
+
+  Latencies latencies;
+  std::size_t num_handled = 0;
+  std::size_t num_shown = 0;
+  GameLoop loop(60.0, 60.0, wait_fd);
+
+  auto on_key = [&](int key)
+  {
+    const Clock::time_point now = Clock::now();
+    num_sent.load(std::memory_order_acquire);
+    latencies.handled.push_back(Ms(now - sent[num_handled++]));
+    return scene.OnKey(key);
+  };
+
+  auto on_render = [&](double)
+  {
+    scene.Render(display, loop.GetFrameTimes());
+    const Clock::time_point now = Clock::now();
+    for (; num_shown < num_handled; num_shown++)
+    {
+      latencies.shown.push_back(Ms(now - sent[num_shown]));
+    }
+    if (num_shown == numKeys)
+    {
+      loop.Stop();
+    }
+  };
+
+  loop.Run(read_key, on_key, [&](Clock::duration) { scene.Tick(); }, on_render);
+
+  writer.join();
+  input.Stop();
+  close(fds[0]);
+  close(fds[1]);
+  return latencies;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const std::size_t num_keys = argc > 1 ? std::stoul(argv[1]) : 300;
+
+  std::cout << std::format("{} keys at 3-20 ms intervals, 60 Hz ticks and frames\n", num_keys);
+  std::cout << "          handled p50   p99    shown p50   p99 (ms)\n";
+
+  const std::pair<Mode, const char*> modes[] = {{Mode::SLEEP, "sleep"}, {Mode::POLL, "poll"}, {Mode::THREAD, "thread"}};
+  for (const auto& [mode, name] : modes)
+  {
+    const Latencies latencies = Run(mode, num_keys);
+    std::cout << std::format("  {:<6} {:>11.2f} {:>6.2f} {:>11.2f} {:>6.2f}\n",
+                             name,
+                             Percentile(latencies.handled, 0.5),
+                             Percentile(latencies.handled, 0.99),
+                             Percentile(latencies.shown, 0.5),
+                             Percentile(latencies.shown, 0.99));
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+// Planning one step for every monster chasing a single target: one A* search
+// per monster, the same searches answered from the cache, and one shared
+// flow field.
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "map/Pathfinder.h"
+#include "rules/DiceEngine.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+template <typename Fn>
+void Report(const std::string& name, int turns, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long checksum = 0;
+  for (int i = 0; i < turns; i++)
+  {
+    checksum += fn(i);
+  }
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<34} {:>10.1f} us/turn  (checksum {})\n",
+                           name, seconds * 1e6 / turns, checksum);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int monsters = argc > 1 ? std::atoi(argv[1]) : 150;
+  const int size = argc > 2 ? std::atoi(argv[2]) : 100;
+  const int turns = 50;
+
+  DiceEngine engine(3);
+  BattleMap map(size, size);
+  for (int i = 0; i < size * size / 10; i++)
+  {
+    map.SetWall({engine.RollOne(size) - 1, engine.RollOne(size) - 1}, true);
+  }
+
+  auto random_square = [&] {
+    GridPos pos;
+    do
+    {
+      pos = {engine.RollOne(size) - 1, engine.RollOne(size) - 1};
+    } while (map.IsWall(pos) || map.At(pos) != kNoToken);
+    return pos;
+  };
+
+  std::vector<GridPos> positions;
+  for (int i = 0; i < monsters; i++)
+  {
+    positions.push_back(random_square());
+    map.Place(positions.back(), 1, 1);
+  }
+
+  std::vector<GridPos> targets;
+  for (int i = 0; i < turns; i++)
+  {
+    targets.push_back(random_square());
+  }
+
+  std::cout << std::format("{} monsters on a {}x{} map\n", monsters, size, size);
+
+  Pathfinder pathfinder(map);
+
+  Report("A* per monster", turns, [&](int turn) {
+    long long steps = 0;
+    for (const GridPos& pos : positions)
+    {
+      steps += pathfinder.FindPath(pos, targets[turn]).size();
+    }
+    return steps;
+  });
+
+  // The last turns are still in the cache
+  Report("A* per monster, cached", turns, [&](int turn) {
+    long long steps = 0;
+    for (const GridPos& pos : positions)
+    {
+      steps += pathfinder.FindPath(pos, targets[turns - 1 - turn % 10]).size();
+    }
+    return steps;
+  });
+
+  Pathfinder shared(map);
+  Report("Shared flow field", turns, [&](int turn) {
+    const FlowField& field = shared.FlowFieldTo(targets[turn]);
+    long long steps = 0;
+    for (const GridPos& pos : positions)
+    {
+      const GridPos next = field.Next(pos);
+      steps += field.Distance(pos) != FlowField::kUnreachable ? field.Distance(pos) : 0;
+      steps += next.x - pos.x;
+    }
+    return steps;
+  });
+
+  Report("Shared flow field, cached", turns, [&](int turn) {
+    const FlowField& field = shared.FlowFieldTo(targets[turn % 16 + turns - 16]);
+    long long steps = 0;
+    for (const GridPos& pos : positions)
+    {
+      steps += field.Next(pos).x - pos.x;
+    }
+    return steps;
+  });
+
+  return 0;
+}
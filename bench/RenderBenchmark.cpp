@@ -0,0 +1,207 @@
+// Bytes sent to the terminal per frame for the main.cpp goblin/player scene,
+// with the old erase() + full redraw and with the diffing Display.
+//
+//   RenderBenchmark [frames] [columns] [lines]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include <ncurses.h>
+
+#include "graphics/NcursesGraphics.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+const std::vector<std::vector<char>> kGoblin {
+    {'<', '(', 'o', '_', 'o', ')', '>'},
+    {' ', '-', '|', '_', '|', '-', '/'},
+    {' ', ' ', '|', ' ', '|', ' ', ' '},
+};
+
+int GoblinX(int frame)
+{
+    // Walks right and back so every frame moves something
+    return 10 + (frame % 40 < 20 ? frame % 20 : 20 - frame % 20);
+}
+
+long Written(std::FILE* output)
+{
+    std::fflush(output);
+    return std::ftell(output);
+}
+
+// The per-frame work main.cpp and Display did before the frame buffer
+long LegacyFrames(int frames)
+{
+    std::FILE* output = std::tmpfile();
+    SCREEN* screen = newterm(nullptr, output, stdin);
+    set_term(screen);
+    start_color();
+    for (short pair = 1; pair <= 15; pair++)
+    {
+        init_pair(pair, pair % 8, pair / 8);
+    }
+
+    long start = Written(output);
+    for (int frame = 0; frame < frames; frame++)
+    {
+        erase();
+        attron(COLOR_PAIR(4));
+        box(stdscr, 0, 0);
+        attroff(COLOR_PAIR(4));
+
+        std::string fps = std::format("FPS: {:.2f}", 60.0 + frame % 7);
+        attron(COLOR_PAIR(6));
+        mvprintw(1, COLS - 15, "%s", fps.c_str());
+        attroff(COLOR_PAIR(6));
+        attron(COLOR_PAIR(2));
+        mvprintw(10, 10, "Hello, ncurses!");
+        mvprintw(12, 10, "Move with arrow keys!");
+        mvprintw(14, 10, "Press 'q' to quit");
+        attroff(COLOR_PAIR(2));
+
+        const int x = GoblinX(frame);
+        for (std::size_t row = 0; row < kGoblin.size(); row++)
+        {
+            for (std::size_t col = 0; col < kGoblin[row].size(); col++)
+            {
+                if (kGoblin[row][col] != ' ')
+                {
+                    attron(COLOR_PAIR(8));
+                    mvprintw(5 + row, x + col, "%c", kGoblin[row][col]);
+                    attroff(COLOR_PAIR(8));
+                }
+            }
+        }
+        attron(COLOR_PAIR(14));
+        mvprintw(5, x + 10, "#");
+        attroff(COLOR_PAIR(14));
+
+        refresh();
+    }
+    long bytes = Written(output) - start;
+
+    endwin();
+    delscreen(screen);
+    std::fclose(output);
+    return bytes;
+}
+
+long DisplayFrames(int frames, int& runs)
+{
+    std::FILE* output = std::tmpfile();
+    long bytes = 0;
+    runs = 0;
+    {
+        Display display;
+        display.Init(output, stdin);
+        display.SetMarginColor(FontColor::BLUE_OVER_BLACK);
+
+        TextSprite goblin(kGoblin, FontColor::BLACK_OVER_RED);
+        TextSprite player({{'#'}}, FontColor::WHITE_OVER_RED);
+
+        long start = Written(output);
+        for (int frame = 0; frame < frames; frame++)
+        {
+            display.NewFrame();
+            display.DrawText(std::format("FPS: {:.2f}", 60.0 + frame % 7),
+                             display.NumColumns() - 15, 1, FontColor::CYAN_OVER_BLACK);
+            display.DrawText("Hello, ncurses!", 10, 10, FontColor::GREEN_OVER_BLACK);
+            display.DrawText("Move with arrow keys!", 10, 12, FontColor::GREEN_OVER_BLACK);
+            display.DrawText("Press 'q' to quit", 10, 14, FontColor::GREEN_OVER_BLACK);
+
+            const int x = GoblinX(frame);
+            goblin.SetPos(x, 5);
+            player.SetPos(x + 10, 5);
+            goblin.Draw(display);
+            player.Draw(display);
+
+            display.Refresh();
+            runs += display.LastFrameStats().runs;
+        }
+        bytes = Written(output) - start;
+    }
+    std::fclose(output);
+    return bytes;
+}
+
+// Nanoseconds per frame to draw `sprites` goblins into the back buffer,
+// cell by cell through std::string(1, c) as TextSprite used to, and run by run.
+void SpriteBlits(int frames, int sprites)
+{
+    std::FILE* output = std::tmpfile();
+    {
+        Display display;
+        display.Init(output, stdin);
+        TextSprite goblin(kGoblin, FontColor::BLACK_OVER_RED);
+
+        auto start = cr::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            display.NewFrame();
+            for (int i = 0; i < sprites; i++)
+            {
+                const int x = 1 + (i * 9) % (display.NumColumns() - 10);
+                const int y = 1 + (i * 4) % (display.NumLines() - 4);
+                for (std::size_t row = 0; row < kGoblin.size(); row++)
+                {
+                    for (std::size_t col = 0; col < kGoblin[row].size(); col++)
+                    {
+                        if (kGoblin[row][col] != ' ')
+                        {
+                            display.DrawText(std::string(1, kGoblin[row][col]), x + col, y + row,
+                                             FontColor::BLACK_OVER_RED);
+                        }
+                    }
+                }
+            }
+        }
+        double per_cell = cr::duration<double, std::nano>(cr::steady_clock::now() - start).count() / frames;
+
+        start = cr::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            display.NewFrame();
+            for (int i = 0; i < sprites; i++)
+            {
+                goblin.SetPos(1 + (i * 9) % (display.NumColumns() - 10), 1 + (i * 4) % (display.NumLines() - 4));
+                goblin.Draw(display);
+            }
+        }
+        double per_run = cr::duration<double, std::nano>(cr::steady_clock::now() - start).count() / frames;
+
+        std::cout << std::format("{} goblin sprites per frame\n", sprites);
+        std::cout << std::format("  cell by cell       {:>8.0f} ns/frame\n", per_cell);
+        std::cout << std::format("  run-length blits   {:>8.0f} ns/frame\n", per_run);
+    }
+    std::fclose(output);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 1000;
+    setenv("COLUMNS", argc > 2 ? argv[2] : "200", 1);
+    setenv("LINES", argc > 3 ? argv[3] : "60", 1);
+    setenv("TERM", "xterm-256color", 0);
+
+    int runs = 0;
+    const long legacy = LegacyFrames(frames);
+    const long diffed = DisplayFrames(frames, runs);
+
+    std::cout << std::format("{} frames, {}x{} terminal\n", frames, std::getenv("COLUMNS"), std::getenv("LINES"));
+    std::cout << std::format("  erase() + redraw   {:>8.1f} bytes/frame\n", static_cast<double>(legacy) / frames);
+    std::cout << std::format("  frame buffer diff  {:>8.1f} bytes/frame, {:.1f} runs/frame\n",
+                             static_cast<double>(diffed) / frames, static_cast<double>(runs) / frames);
+
+    SpriteBlits(frames, 300);
+    return 0;
+}
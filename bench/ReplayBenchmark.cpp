@@ -0,0 +1,184 @@
+// An hour long recorded session of a large battle at 60 ticks per second:
+// every tick a few creatures attack, rolling through Die, and hit points
+// change. Measures the cost of recording, how much faster than real time a
+// headless replay runs, and seeking into the session from the nearest
+// snapshot versus replaying it from the start.
+//
+//   ReplayBenchmark [creatures] [minutes]
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "replay/ReplayLog.h"
+#include "rules/DiceEngine.h"
+#include "rules/Roll.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+constexpr std::uint32_t kTickRate = 60;
+constexpr int kAttacksPerTick = 4;
+
+struct Hit
+{
+  std::uint32_t target;
+  int damage;
+};
+
+// The game code: which creatures the tick's attacks hit and for how much.
+// Only Die decides, so replaying the log reproduces it exactly.
+template <typename OnHit>
+void PlayTick(std::uint32_t creatures, OnHit&& onHit)
+{
+  for (int attack = 0; attack < kAttacksPerTick; attack++)
+  {
+    const auto target = static_cast<std::uint32_t>(Die::Roll(1, static_cast<int>(creatures)) - 1);
+    if (Die::Roll(1, 20) + 4 >= 15)
+    {
+      onHit(Hit {target, Die::Roll(1, 6) + 2});
+    }
+  }
+}
+
+double Seconds(cr::steady_clock::time_point start)
+{
+  return cr::duration<double>(cr::steady_clock::now() - start).count();
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const std::uint32_t creatures = argc > 1 ? std::atoi(argv[1]) : 10'000;
+  const std::uint64_t minutes = argc > 2 ? std::atoll(argv[2]) : 60;
+  const std::uint64_t ticks = minutes * 60 * kTickRate;
+  const std::string path = (std::filesystem::temp_directory_path() / "ReplayBenchmark.log").string();
+
+  DiceEngine::ThreadLocal().Seed(5);
+
+  CreatureState state;
+  state.Resize(creatures);
+  for (std::uint32_t creature = 0; creature < creatures; creature++)
+  {
+    state.Set(creature, StateField::HIT_POINTS, 20 + static_cast<int>(creature % 50));
+    state.Set(creature, StateField::X, static_cast<int>(creature % 100));
+    state.Set(creature, StateField::Y, static_cast<int>(creature / 100));
+  }
+
+  // Record: one snapshot every 10 seconds of play
+  long long recorded_damage = 0;
+  std::size_t shared_pages = 0;
+  auto start = cr::steady_clock::now();
+  {
+    ReplayWriter writer(10 * kTickRate);
+    if (!writer.Open(path, state, kTickRate))
+    {
+      std::cerr << "cannot write " << path << "\n";
+      return 1;
+    }
+    writer.RecordDice();
+
+    for (std::uint64_t tick = 0; tick < ticks; tick++)
+    {
+      writer.Tick(state);
+      PlayTick(creatures, [&](Hit hit) {
+        recorded_damage += hit.damage;
+        const int hp = state.Get(hit.target, StateField::HIT_POINTS);
+        writer.Set(state, hit.target, StateField::HIT_POINTS, hp > hit.damage ? hp - hit.damage : 50);
+      });
+      shared_pages += state.SharedPages();
+
+      // Keys arrive while the loop waits for the next tick
+      if (tick % 45 == 0)
+      {
+        writer.Key('a' + static_cast<int>(tick % 26));
+      }
+    }
+  }
+  const double record_seconds = Seconds(start);
+
+  const std::uintmax_t log_bytes = std::filesystem::file_size(path);
+  const std::uintmax_t snapshot_bytes = std::filesystem::file_size(path + ".snapshots");
+
+  ReplayReader reader;
+  if (!reader.Open(path))
+  {
+    std::cerr << "cannot read " << path << "\n";
+    return 1;
+  }
+  const double real_seconds = static_cast<double>(reader.LastTick()) / reader.TickRate();
+
+  std::cout << std::format("{} creatures, {} ticks ({:.0f} s of play), {} snapshots\n",
+                           creatures, reader.LastTick(), real_seconds, reader.NumSnapshots());
+  std::cout << std::format("{:<30} {:>10.1f} ns/tick  ({:.1f} shared pages per tick)\n",
+                           "record", record_seconds * 1e9 / ticks, static_cast<double>(shared_pages) / ticks);
+  std::cout << std::format("{:<30} {:>10.1f} KiB     ({:.2f} bytes/tick)\n",
+                           "event log", log_bytes / 1024.0, static_cast<double>(log_bytes) / ticks);
+  std::cout << std::format("{:<30} {:>10.1f} KiB\n", "snapshots", snapshot_bytes / 1024.0);
+
+  // Headless replay of the state changes alone
+  CreatureState replayed;
+  start = cr::steady_clock::now();
+  reader.SeekFromStart(0, replayed);
+  {
+    ReplaySession session(reader, replayed);
+    session.Run(reader.LastTick());
+  }
+  double seconds = Seconds(start);
+  std::cout << std::format("{:<30} {:>10.1f} ms      ({:.0f}x real time, final state {})\n",
+                           "replay state", seconds * 1e3, real_seconds / seconds,
+                           replayed == state ? "matches" : "DIFFERS");
+
+  // Headless replay driving the game code again, its rolls answered from the log
+  long long replayed_damage = 0;
+  std::size_t desyncs = 0;
+  start = cr::steady_clock::now();
+  reader.SeekFromStart(0, replayed);
+  {
+    ReplaySession session(reader, replayed);
+    session.Run(reader.LastTick(), {}, [&](std::uint64_t) {
+      PlayTick(creatures, [&](Hit hit) { replayed_damage += hit.damage; });
+    });
+    desyncs = session.Desyncs();
+  }
+  seconds = Seconds(start);
+  std::cout << std::format("{:<30} {:>10.1f} ms      ({:.0f}x real time, {} desyncs, damage {})\n",
+                           "replay game code", seconds * 1e3, real_seconds / seconds, desyncs,
+                           replayed_damage == recorded_damage ? "matches" : "DIFFERS");
+
+  // Random access
+  DiceEngine engine(3);
+  constexpr int kSeeks = 20;
+  double from_start = 0.0;
+  double from_snapshot = 0.0;
+  int mismatches = 0;
+  CreatureState expected;
+  for (int i = 0; i < kSeeks; i++)
+  {
+    const std::uint64_t tick = engine.Next() % (reader.LastTick() + 1);
+
+    start = cr::steady_clock::now();
+    reader.SeekFromStart(tick, expected);
+    from_start += Seconds(start);
+
+    start = cr::steady_clock::now();
+    reader.Seek(tick, replayed);
+    from_snapshot += Seconds(start);
+
+    mismatches += !(replayed == expected);
+  }
+  std::cout << std::format("{:<30} {:>10.3f} ms/seek\n", "seek replaying from start", from_start * 1e3 / kSeeks);
+  std::cout << std::format("{:<30} {:>10.3f} ms/seek  ({} mismatches)\n",
+                           "seek from nearest snapshot", from_snapshot * 1e3 / kSeeks, mismatches);
+
+  reader.Close();
+  std::filesystem::remove(path);
+  std::filesystem::remove(path + ".snapshots");
+  return 0;
+}
@@ -0,0 +1,95 @@
+// Rolls per second of the dice engine against the original implementation
+// (one function-static std::mt19937 and uniform_int_distribution).
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "rules/DiceEngine.h"
+#include "rules/Roll.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+int LegacyRoll(int nDice, int facesDie)
+{
+  int sum = 0;
+  static std::random_device seed;
+
+  static std::mt19937 gen(seed());
+
+  static std::uniform_int_distribution<int>distrib(1, facesDie);
+
+  for (int num_die = 0;  num_die < nDice; num_die++)
+  {
+    sum += distrib(gen);
+  }
+
+  return sum;
+}
+
+template <typename Fn>
+void Report(const std::string& name, long long rolls, Fn&& fn)
+{
+  auto start = cr::steady_clock::now();
+  long long checksum = fn();
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("{:<28} {:>10.1f} Mrolls/s  (checksum {})\n",
+                           name, rolls / seconds / 1e6, checksum);
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const long long rolls = argc > 1 ? std::atoll(argv[1]) : 50'000'000;
+
+  Report("legacy Roll(1, 20)", rolls, [&] {
+    long long sum = 0;
+    for (long long i = 0; i < rolls; i++) sum += LegacyRoll(1, 20);
+    return sum;
+  });
+
+  Report("Die::Roll(1, 20)", rolls, [&] {
+    long long sum = 0;
+    for (long long i = 0; i < rolls; i++) sum += Die::Roll(1, 20);
+    return sum;
+  });
+
+  Report("legacy Roll(8, 6)", rolls, [&] {
+    long long sum = 0;
+    for (long long i = 0; i < rolls / 8; i++) sum += LegacyRoll(8, 6);
+    return sum;
+  });
+
+  Report("Die::Roll(8, 6)", rolls, [&] {
+    long long sum = 0;
+    for (long long i = 0; i < rolls / 8; i++) sum += Die::Roll(8, 6);
+    return sum;
+  });
+
+  Report("Die::RollAdvantage()", rolls, [&] {
+    long long sum = 0;
+    for (long long i = 0; i < rolls / 2; i++) sum += Die::RollAdvantage();
+    return sum;
+  });
+
+  Report("DiceEngine::RollMany(d6)", rolls, [&] {
+    std::vector<int> block(DiceEngine::kBlockSize * 16);
+    DiceEngine& engine = DiceEngine::ThreadLocal();
+    long long sum = 0;
+    for (long long done = 0; done < rolls; done += block.size())
+    {
+      engine.RollMany(block.size(), 6, block);
+      for (int roll : block) sum += roll;
+    }
+    return sum;
+  });
+
+  return 0;
+}
@@ -0,0 +1,202 @@
+// The game's scene (DemoScene), driven headlessly for N frames through the
+// in-memory render target: scripted arrow keys, a tick and a render per
+// frame. Reports the time, heap allocations and terminal output per frame.
+// With budgets it exits with 1 when one is exceeded, so a rendering
+// regression fails a script or CI job.
+//
+//   SceneBenchmark [frames] [columns] [lines] [--capture <path>] [--trace <path>]
+//                  [--max-ns <n>] [--max-allocs <n>] [--max-bytes <n>]
+//
+// --trace profiles the frames and writes them as a Chrome trace.
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "game/DemoScene.h"
+#include "graphics/NcursesGraphics.h"
+#include "graphics/SpriteAtlas.h"
+#include "utils/GameLoop.h"
+#include "utils/Profiler.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+std::uint64_t gAllocations = 0;
+
+}
+
+void* operator new(std::size_t size)
+{
+  gAllocations++;
+  if (void* memory = std::malloc(size ? size : 1))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned forms
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  gAllocations++;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  if (void* memory = std::aligned_alloc(align, (size + align - 1) / align * align))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace
+{
+
+// The player walks a loop around the goblin's wall
+int ScriptedKey(int frame)
+{
+  constexpr Key kLoop[] = {Key::RIGHT, Key::RIGHT, Key::RIGHT, Key::RIGHT, Key::RIGHT,
+                           Key::DOWN, Key::DOWN, Key::DOWN,
+                           Key::LEFT, Key::LEFT, Key::LEFT, Key::LEFT, Key::LEFT,
+                           Key::UP, Key::UP, Key::UP};
+  return frame % 4 == 0 ? static_cast<int>(kLoop[(frame / 4) % std::size(kLoop)]) : -1;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> positional;
+  std::string capture;
+  std::string trace;
+  double max_ns = 0.0;
+  double max_allocs = -1.0;
+  double max_bytes = 0.0;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    if (i + 1 < argc && arg == "--capture")         capture = argv[++i];
+    else if (i + 1 < argc && arg == "--trace")      trace = argv[++i];
+    else if (i + 1 < argc && arg == "--max-ns")     max_ns = std::atof(argv[++i]);
+    else if (i + 1 < argc && arg == "--max-allocs") max_allocs = std::atof(argv[++i]);
+    else if (i + 1 < argc && arg == "--max-bytes")  max_bytes = std::atof(argv[++i]);
+    else positional.push_back(arg);
+  }
+  const int frames = positional.size() > 0 ? std::atoi(positional[0].c_str()) : 10'000;
+  const int columns = positional.size() > 1 ? std::atoi(positional[1].c_str()) : 200;
+  const int lines = positional.size() > 2 ? std::atoi(positional[2].c_str()) : 60;
+
+  Profiler::Enable(!trace.empty());
+
+  Display display;
+  MemoryTarget& screen = display.InitHeadless(columns, lines);
+  display.SetMarginColor(FontColor::BLUE_OVER_BLACK);
+
+  SpriteAtlas atlas;
+#ifdef DND_SPRITE_ATLAS
+  atlas.Open(DND_SPRITE_ATLAS);
+#endif
+
+  DemoScene scene(columns, lines, atlas.Find("racket"));
+  FrameTimes frame_times;
+
+  auto play = [&](int frame) {
+    const int key = ScriptedKey(frame);
+    if (key >= 0)
+    {
+      screen.PushKey(key);
+    }
+    for (int ch = display.GetChar(); ch >= 0; ch = display.GetChar())
+    {
+      scene.OnKey(ch);
+    }
+    scene.Tick();
+    scene.Render(display, frame_times);
+  };
+
+  // The first frames draw everything and size the buffers
+  constexpr int kWarmUp = 60;
+  for (int frame = 0; frame < kWarmUp; frame++)
+  {
+    play(frame);
+  }
+
+  const std::uint64_t bytes_before = screen.OutputBytes();
+  const std::uint64_t allocations_before = gAllocations;
+  long long runs = 0;
+
+  auto start = cr::steady_clock::now();
+  auto last = start;
+  for (int frame = kWarmUp; frame < kWarmUp + frames; frame++)
+  {
+    play(frame);
+    runs += display.LastFrameStats().runs;
+
+    const auto now = cr::steady_clock::now();
+    frame_times.Record(now - last);
+    last = now;
+  }
+  const double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  const double ns_per_frame = seconds * 1e9 / frames;
+  const double allocs_per_frame = static_cast<double>(gAllocations - allocations_before) / frames;
+  const double bytes_per_frame = static_cast<double>(screen.OutputBytes() - bytes_before) / frames;
+
+  std::cout << std::format("{} frames, {}x{} headless\n", frames, columns, lines);
+  std::cout << std::format("  {:>10.0f} ns/frame  (p99 {:.3f} ms)\n", ns_per_frame, frame_times.PercentileMs(0.99));
+  std::cout << std::format("  {:>10.2f} allocations/frame\n", allocs_per_frame);
+  std::cout << std::format("  {:>10.1f} output bytes/frame, {:.1f} runs/frame\n",
+                           bytes_per_frame, static_cast<double>(runs) / frames);
+
+  if (!capture.empty())
+  {
+    std::ofstream(capture, std::ios::binary) << screen.Capture();
+    std::cout << "  last frame written to " << capture << "\n";
+  }
+
+  if (!trace.empty())
+  {
+    Profiler::WriteChromeTrace(trace);
+    std::cout << "  trace written to " << trace << "\n";
+  }
+
+  bool within_budget = true;
+  auto check = [&](const char* name, double value, double budget, bool set) {
+    if (set && value > budget)
+    {
+      std::cout << std::format("  over budget: {} {:.2f} > {:.2f}\n", name, value, budget);
+      within_budget = false;
+    }
+  };
+  check("ns/frame", ns_per_frame, max_ns, max_ns > 0.0);
+  check("allocations/frame", allocs_per_frame, max_allocs, max_allocs >= 0.0);
+  check("output bytes/frame", bytes_per_frame, max_bytes, max_bytes > 0.0);
+
+  return within_budget ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+// Load generator for TableServer. Opens a number of sessions, each a player
+// pressing an arrow key every 50-150 ms once the previous key was shown,
+// and measures the time from a key going out to the frame that
+// acknowledges it. Every session replays its frames onto a screen of its
+// own, which must show the scene's text at the end.
+//
+// Without --socket the server runs in this process on [workers] threads,
+// and the CPU time of its workers gives sessions per core: how many such
+// players one fully busy core would host. The clients run on one more
+// thread, so on a small machine they compete with the server for cores.
+//
+//   ServerLoadBenchmark [sessions] [seconds] [workers] [--socket <path>]
+//                       [--max-p99-ms <ms>]
+//
+// Exits with 1 when a session is dropped, a key is never shown, a screen
+// is wrong or the p99 is over budget.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "graphics/NcursesGraphics.h"
+#include "server/TableClient.h"
+#include "server/TableServer.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+using Clock = cr::steady_clock;
+
+constexpr int kColumns = 80;
+constexpr int kLines = 24;
+
+struct Player
+{
+  TableClient client;
+  Clock::time_point nextKey {};
+  Clock::time_point sentAt {};
+  std::uint32_t tag {0};
+  bool waiting {false};
+  bool open {true};
+};
+
+double Percentile(std::vector<double> samples, double quantile)
+{
+  if (samples.empty())
+  {
+    return 0.0;
+  }
+  const std::size_t rank = std::min(samples.size() - 1, static_cast<std::size_t>(quantile * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+bool ShowsScene(const FrameBuffer& screen)
+{
+  constexpr std::string_view kText = "Hello, ncurses!";
+  for (std::size_t i = 0; i < kText.size(); i++)
+  {
+    if (screen.At(10 + static_cast<int>(i), 10).glyph != static_cast<std::uint8_t>(kText[i]))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> positional;
+  std::string socket_path;
+  double max_p99_ms = 0.0;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    if (i + 1 < argc && arg == "--socket")            socket_path = argv[++i];
+    else if (i + 1 < argc && arg == "--max-p99-ms")   max_p99_ms = std::atof(argv[++i]);
+    else positional.push_back(arg);
+  }
+  const int sessions = positional.size() > 0 ? std::atoi(positional[0].c_str()) : 200;
+  const double seconds = positional.size() > 1 ? std::atof(positional[1].c_str()) : 5.0;
+  const std::size_t workers = positional.size() > 2 ? std::strtoul(positional[2].c_str(), nullptr, 10) : 0;
+
+  std::unique_ptr<TableServer> server;
+  if (socket_path.empty())
+  {
+    socket_path = std::format("/tmp/dnd-load-{}.sock", getpid());
+    ServerConfig config;
+    config.workers = workers;
+    server = std::make_unique<TableServer>(config);
+    if (!server->Listen(socket_path) || !server->Start())
+    {
+      std::cerr << "Cannot start a server on " << socket_path << "\n";
+      return 1;
+    }
+  }
+
+  std::mt19937 rng(24);
+  std::uniform_int_distribution<int> pick_think_ms(50, 150);
+  std::uniform_int_distribution<int> pick_key(static_cast<int>(Key::DOWN), static_cast<int>(Key::RIGHT));
+
+  const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<std::unique_ptr<Player>> players;
+  std::vector<double> latencies_ms;
+  bool measuring = false;
+
+  for (int i = 0; i < sessions; i++)
+  {
+    auto player = std::make_unique<Player>();
+    Player& self = *player;
+    if (!self.client.Connect(socket_path, {kColumns, kLines, static_cast<std::uint64_t>(i + 1)}))
+    {
+      std::cerr << std::format("Session {} could not connect\n", i);
+      return 1;
+    }
+    self.nextKey = Clock::now() + cr::milliseconds(pick_think_ms(rng));
+    self.client.SetOnFrame([&](const FrameMessage& frame)
+    {
+      if (self.waiting && frame.tag == self.tag)
+      {
+        const Clock::time_point now = Clock::now();
+        if (measuring)
+        {
+          latencies_ms.push_back(cr::duration<double, std::milli>(now - self.sentAt).count());
+        }
+        self.waiting = false;
+        self.nextKey = now + cr::milliseconds(pick_think_ms(rng));
+      }
+    });
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.ptr = player.get();
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, self.client.Fd(), &event);
+    players.push_back(std::move(player));
+  }
+
+  // The first second is warm-up: sessions start and the caches fill
+  const Clock::time_point start = Clock::now();
+  const Clock::time_point measure_from = start + cr::seconds(1);
+  const Clock::time_point end = measure_from + cr::duration_cast<Clock::duration>(cr::duration<double>(seconds));
+  ServerStats stats_before {};
+  std::uint64_t keys_sent = 0;
+  std::size_t dropped = 0;
+
+  epoll_event events[256];
+  for (Clock::time_point now = start; now < end; now = Clock::now())
+  {
+    if (!measuring && now >= measure_from)
+    {
+      measuring = true;
+      if (server)
+      {
+        stats_before = server->Stats();
+      }
+    }
+
+    const int ready = epoll_wait(epoll_fd, events, 256, 1);
+    for (int i = 0; i < ready; i++)
+    {
+      Player& player = *static_cast<Player*>(events[i].data.ptr);
+      const bool open = (!(events[i].events & EPOLLOUT) || player.client.Flush()) && player.client.Receive();
+      if (!open && player.open)
+      {
+        player.open = false;
+        dropped++;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, player.client.Fd(), nullptr);
+      }
+    }
+
+    now = Clock::now();
+    for (const std::unique_ptr<Player>& player : players)
+    {
+      if (player->open && !player->waiting && now >= player->nextKey)
+      {
+        player->tag++;
+        player->waiting = true;
+        player->sentAt = now;
+        player->open = player->client.SendKey(pick_key(rng), player->tag);
+        keys_sent += measuring;
+      }
+    }
+  }
+
+  const double measured = cr::duration<double>(Clock::now() - measure_from).count();
+  std::size_t lost = 0;
+  std::size_t wrong_screens = 0;
+  std::uint64_t frames = 0;
+  std::uint64_t bytes = 0;
+  for (const std::unique_ptr<Player>& player : players)
+  {
+    lost += player->open && player->waiting && Clock::now() - player->sentAt > cr::seconds(1);
+    wrong_screens += player->open && !ShowsScene(player->client.Screen());
+    frames += player->client.Frames();
+    bytes += player->client.BytesReceived();
+  }
+
+  const double p50 = Percentile(latencies_ms, 0.5);
+  const double p99 = Percentile(latencies_ms, 0.99);
+  const double p999 = Percentile(latencies_ms, 0.999);
+  const double total = cr::duration<double>(Clock::now() - start).count();
+
+  std::cout << std::format("{} sessions, {:.1f} s measured, {} keys shown\n", sessions, measured, latencies_ms.size());
+  std::cout << std::format("  key to frame  p50 {:.2f} ms  p99 {:.2f} ms  p99.9 {:.2f} ms  max {:.2f} ms\n",
+                           p50,
+                           p99,
+                           p999,
+                           latencies_ms.empty() ? 0.0 : *std::max_element(latencies_ms.begin(), latencies_ms.end()));
+  std::cout << std::format("  {:.1f} frames/s and {:.0f} bytes/s per session, {:.0f} bytes/frame\n",
+                           frames / total / sessions,
+                           bytes / total / sessions,
+                           frames ? static_cast<double>(bytes) / frames : 0.0);
+
+  if (server)
+  {
+    const ServerStats stats = server->Stats();
+    const double cores = (stats.cpuNs - stats_before.cpuNs) / 1e9 / measured;
+    std::cout << std::format("  {} workers busy {:.2f} cores: {:.0f} sessions per core\n",
+                             server->NumWorkers(),
+                             cores,
+                             cores > 0.0 ? sessions / cores : 0.0);
+    std::cout << std::format("  {} frames skipped for slow clients, {} connections rejected\n",
+                             stats.skippedFrames,
+                             stats.rejected);
+    server->Stop();
+  }
+  close(epoll_fd);
+
+  bool ok = true;
+  auto check = [&](bool failed, const std::string& what) {
+    if (failed)
+    {
+      std::cout << "  FAILED: " << what << "\n";
+      ok = false;
+    }
+  };
+  check(dropped > 0, std::format("{} sessions dropped", dropped));
+  check(lost > 0, std::format("{} keys never shown", lost));
+  check(wrong_screens > 0, std::format("{} screens do not show the scene", wrong_screens));
+  check(keys_sent == 0 || latencies_ms.empty(), "no keys were shown");
+  check(max_p99_ms > 0.0 && p99 > max_p99_ms, std::format("p99 {:.2f} ms over {:.2f} ms", p99, max_p99_ms));
+  return ok ? 0 : 1;
+}
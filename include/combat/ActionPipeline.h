@@ -0,0 +1,100 @@
+#ifndef __ACTION_PIPELINE_H__
+#define __ACTION_PIPELINE_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "entities/Action.h"
+#include "entities/CreatureStore.h"
+#include "rules/Conditions.h"
+#include "rules/DiceEngine.h"
+
+// Result of one queued attack or saving throw.
+struct AttackOutcome
+{
+  std::uint32_t attacker {0};
+  std::uint32_t target {0};
+  int damage {0};
+  std::uint8_t d20 {0};     // Attack roll, or the target's saving throw
+  bool hit {false};         // The attack hit, or the saving throw failed
+  bool critical {false};
+};
+
+
+// Resolves a round worth of attacks and saving throws against the creatures
+// of a CreatureStore. Queueing counts the damage dice by die size; Resolve
+// then rolls every d20 with one RollMany call and every damage die of a size
+// with one more, decides hits and damage in a single pass over the queue and
+// applies all the damage to the store at the end. Criticals roll their extra
+// dice on their own. Creatures are dense indices of the store; queued actions
+// point into it, so it must not change between Queue and Resolve.
+//
+// Advantage and disadvantage come from the conditions of the attacker and
+// the target in the store (see RollRules); every attack counts as melee.
+class ActionPipeline
+{
+public:
+  explicit ActionPipeline(const RollRules& rules = {});
+
+  // Queues the action at actionIndex of the attacker's actions of that type.
+  // A multiattack queues each of the actions it lists against target. An
+  // actionIndex past the end of the list queues nothing.
+  void Queue(const CreatureStore& store, std::size_t attacker, ActionType type,
+             std::size_t actionIndex, std::size_t target);
+
+  // Same for an action that is not in the store; list holds the actions a
+  // multiattack refers to. action and list must outlive Resolve.
+  void Queue(std::size_t attacker, const Action& action, std::span<const Action> list,
+             std::size_t target);
+
+  std::size_t Size() const;
+
+  // Resolves and applies everything queued, then empties the queue. The
+  // outcomes are in queue order and valid until the next Resolve.
+  std::span<const AttackOutcome> Resolve(CreatureStore& store, DiceEngine& engine);
+
+  void Clear();
+
+private:
+  // Dice up to d100 find their group without a search
+  static constexpr int kIndexedFaces = 101;
+
+  struct Pending
+  {
+    const ActionEffect* effect {nullptr};
+    std::uint32_t attacker {0};
+    std::uint32_t target {0};
+  };
+
+  // All the plain dice of one size rolled in a pass.
+  struct DiceGroup
+  {
+    int facesDie {0};
+    std::size_t count {0};
+    std::size_t next {0};
+    std::vector<int> rolls;
+  };
+
+  void QueueEffect(std::size_t attacker, const ActionEffect& effect, std::size_t target);
+
+  DiceGroup& Group(int facesDie);
+
+  int RollDamage(const DiceExpression& damage, bool critical, DiceEngine& engine);
+
+  RollRules _rules;
+  std::vector<Pending> _pending;
+  std::vector<int> _d20;
+  std::vector<int> _second_d20;       // For advantage and disadvantage
+  std::vector<Roll> _modes;
+  std::vector<DiceGroup> _groups;
+  std::array<std::uint16_t, kIndexedFaces> _group_of_faces {};   // Index in _groups + 1
+  std::vector<AttackOutcome> _outcomes;
+  std::vector<std::uint32_t> _targets;
+  std::vector<int> _damage;
+};
+
+
+#endif // __ACTION_PIPELINE_H__
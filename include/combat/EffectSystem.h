@@ -0,0 +1,157 @@
+#ifndef __EFFECT_SYSTEM_H__
+#define __EFFECT_SYSTEM_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "entities/CreatureStore.h"
+#include "rules/Conditions.h"
+#include "rules/DiceEngine.h"
+#include "utils/TimingWheel.h"
+
+// Stable reference to an effect; stops being valid once the effect ends.
+struct EffectHandle
+{
+  std::uint32_t slot {UINT32_MAX};
+  std::uint32_t generation {0};
+
+  bool operator==(const EffectHandle& other) const = default;
+};
+
+// How long an effect lasts. Time is counted in turns of the encounter, so
+// rounds and minutes depend on how many combatants take turns.
+class Duration
+{
+public:
+  // Until ended by hand or by the end of a concentration
+  static Duration Permanent();
+
+  static Duration Turns(int turns);
+
+  static Duration Rounds(int rounds);
+
+  // 10 rounds each
+  static Duration Minutes(int minutes);
+
+  // "Until the end of its next turn", e.g. the target of a Shove or Vicious
+  // Mockery: ends when creature's next turn does.
+  static Duration EndOfNextTurn(CreatureHandle creature);
+
+private:
+  friend class EffectSystem;
+
+  enum class Kind : std::uint8_t
+  {
+    PERMANENT,
+    TURNS,
+    ROUNDS,
+    END_OF_NEXT_TURN,
+  };
+
+  Kind _kind {Kind::PERMANENT};
+  int _count {0};
+  CreatureHandle _creature {};
+};
+
+
+// Timed conditions on the creatures of a CreatureStore. Each effect adds
+// conditions to its target, whose ConditionSet in the store is the union
+// of its effects; durations run on a TimingWheel whose clock is the turns
+// of the encounter, so ending a turn costs O(expired effects) whatever the
+// number of active ones. Effects applied with a concentrating caster end
+// together when the caster's concentration does.
+//
+// The conditions of creatures under an EffectSystem belong to it: set
+// lasting ones with Apply() and Duration::Permanent().
+class EffectSystem
+{
+public:
+  explicit EffectSystem(CreatureStore& store, const RollRules& rules = {});
+
+  // Turns in a round, i.e. combatants in initiative
+  void SetRoundLength(int turns);
+
+  EffectHandle Apply(CreatureHandle target, ConditionSet conditions, Duration duration,
+                     CreatureHandle concentration = {});
+
+  void End(EffectHandle effect);
+
+  bool IsActive(EffectHandle effect) const;
+
+  // Starting a new concentration spell ends the previous one: call this,
+  // then Apply() its effects with the caster as concentration.
+  void BreakConcentration(CreatureHandle caster);
+
+  bool IsConcentrating(CreatureHandle caster) const;
+
+  // Taking damage while concentrating: a CON saving throw against
+  // max(10, damage / 2), with the caster's conditions. Returns whether the
+  // concentration held.
+  bool ConcentrationCheck(CreatureHandle caster, int damage, DiceEngine& engine);
+
+  void StartTurn(CreatureHandle creature);
+
+  // Advances the clock a turn and ends what ran out; returns those effects,
+  // valid until the next call.
+  std::span<const EffectHandle> EndTurn(CreatureHandle creature);
+
+  // Ends every effect on or concentrated on by creature, before it leaves
+  // the store.
+  void Forget(CreatureHandle creature);
+
+  std::size_t Size() const;
+
+  // Turns ended so far
+  std::uint64_t Now() const;
+
+private:
+  static constexpr std::uint32_t kNone = UINT32_MAX;
+  static constexpr std::uint64_t kNever = UINT64_MAX;
+
+  struct Effect
+  {
+    CreatureHandle target {};
+    CreatureHandle caster {};
+    ConditionSet conditions {};
+    TimingWheel::TimerId timer {TimingWheel::kNoTimer};
+    std::uint32_t nextOnTarget {kNone};
+    std::uint32_t nextConcentrating {kNone};
+    std::uint32_t generation {0};
+    bool active {false};
+  };
+
+  // Per creature slot of the store
+  struct Creature
+  {
+    std::uint32_t effects {kNone};          // Effects on it
+    std::uint32_t concentration {kNone};    // Effects it concentrates on
+    std::uint64_t lastTurnEnd {kNever};
+  };
+
+  Creature& CreatureOf(CreatureHandle handle);
+
+  std::uint64_t Deadline(const Duration& duration);
+
+  void EndEffect(std::uint32_t slot);
+
+  void Refresh(CreatureHandle creature);
+
+  CreatureStore* _store;
+  RollRules _rules;
+  TimingWheel _wheel;
+  int _round_length {1};
+  CreatureHandle _acting {};
+
+  std::vector<Effect> _effects;
+  std::vector<std::uint32_t> _free;
+  std::vector<Creature> _creatures;
+  std::size_t _active {0};
+
+  std::vector<std::uint32_t> _fired;
+  std::vector<EffectHandle> _expired;
+};
+
+
+#endif // __EFFECT_SYSTEM_H__
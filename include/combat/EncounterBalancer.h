@@ -0,0 +1,147 @@
+#ifndef __ENCOUNTER_BALANCER_H__
+#define __ENCOUNTER_BALANCER_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "combat/EncounterSimulator.h"
+#include "entities/Bestiary.h"
+#include "entities/Statblock.h"
+#include "utils/ThreadPool.h"
+
+// count monsters of the roster entry at index monster
+struct MonsterGroup
+{
+  std::uint32_t monster {0};
+  int count {0};
+
+  bool operator==(const MonsterGroup& other) const = default;
+};
+
+struct BalanceQuery
+{
+  double targetWinRate {0.7};       // Deadly but winnable: the party wins this often
+  double minWinRate {0.5};          // Encounters the party wins less often are left out
+  int maxMonsters {8};
+  int maxKinds {2};                 // Different monsters in one encounter
+  float minCR {0.0f};               // Of each monster
+  float maxCR {30.0f};
+  std::size_t candidates {32};      // Best estimates that get simulated
+  std::size_t trials {4000};        // Per candidate, at most
+  std::size_t results {5};
+  std::chrono::milliseconds budget {500};
+  std::uint64_t seed {1};
+};
+
+struct BalancedEncounter
+{
+  std::vector<MonsterGroup> monsters;
+  double estimatedWinRate {0.0};    // Analytic, before simulating
+  double winRate {0.0};             // Simulated, meaningless while trials is 0
+  double meanRounds {0.0};
+  double partyDamage {0.0};         // Mean damage the party took
+  std::size_t trials {0};
+  float totalCR {0.0f};
+};
+
+struct BalanceSearchStats
+{
+  std::size_t estimated {0};        // Compositions given an analytic estimate
+  std::size_t simulated {0};        // Candidates that got trials
+  std::size_t trialsRun {0};
+  std::size_t trialsCached {0};     // Trials reused from earlier queries
+  bool outOfTime {false};
+};
+
+
+// Finds monster compositions from a roster that a party wins about
+// targetWinRate of the time, in three steps:
+//
+// 1. Every composition of up to maxKinds monsters and maxMonsters bodies is
+//    estimated analytically, in parallel over the first monster. Damage per
+//    round is the exact expectation of each creature's EncounterSimulator
+//    turn against the other side's AC, and the two sides are compared with
+//    Lanchester's square law (total damage per round times total hit
+//    points), which is what makes action economy count. Adding a monster
+//    only lowers the party's odds, so a branch stops as soon as its
+//    estimate falls below minWinRate.
+// 2. The candidates closest to the target are simulated with successive
+//    halving: every candidate gets a few trials, the better half gets twice
+//    as many, and so on up to query.trials. Each round is one batch over
+//    the pool; after the first, a round is only started if it fits in the
+//    time budget.
+// 3. Simulated results are cached by party and composition, so later
+//    queries for the same party add trials instead of starting over.
+class EncounterBalancer
+{
+public:
+  explicit EncounterBalancer(std::vector<BestiaryEntry> roster);
+
+  const std::vector<BestiaryEntry>& Roster() const;
+
+  // Best first: closest simulated win rate to the target among those at or
+  // above minWinRate, then the rest.
+  std::vector<BalancedEncounter> Balance(std::span<const Statblock> party,
+                                         const BalanceQuery& query,
+                                         ThreadPool& pool);
+
+  const BalanceSearchStats& LastSearch() const;
+
+  std::size_t CachedSimulations() const;
+
+  void ClearCache();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Profile
+  {
+    double hitPoints {0.0};
+    int armorClass {10};
+    float cr {0.0f};
+    std::vector<AttackEffect> turn;
+  };
+
+  struct Tally
+  {
+    std::size_t trials {0};
+    std::size_t partyWins {0};
+    double rounds {0.0};
+    double partyDamage {0.0};
+
+    void Add(const TrialOutcome& outcome);
+
+    void Merge(const Tally& other);
+  };
+
+  struct Candidate
+  {
+    std::vector<MonsterGroup> monsters;
+    double estimate {0.0};
+    std::uint64_t key {0};
+    Tally tally {};
+  };
+
+  static Profile MakeProfile(const Statblock& statblock);
+
+  static double ExpectedDamage(const std::vector<AttackEffect>& turn, int armorClass);
+
+  static std::uint64_t PartyKey(std::span<const Statblock> party, std::uint64_t seed);
+
+  std::vector<Candidate> Search(std::span<const Statblock> party, const BalanceQuery& query, ThreadPool& pool);
+
+  void Simulate(std::span<const Statblock> party, std::span<Candidate*> batch, std::size_t trials,
+                std::uint64_t seed, ThreadPool& pool);
+
+  std::vector<BestiaryEntry> _roster;
+  std::vector<Profile> _profiles;
+  std::unordered_map<std::uint64_t, Tally> _simulations;
+  BalanceSearchStats _last_search {};
+};
+
+
+#endif // __ENCOUNTER_BALANCER_H__
@@ -0,0 +1,97 @@
+#ifndef __ENCOUNTER_SIMULATOR_H__
+#define __ENCOUNTER_SIMULATOR_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "entities/Action.h"
+#include "entities/Statblock.h"
+#include "rules/DiceEngine.h"
+#include "rules/DiceExpression.h"
+#include "utils/ThreadPool.h"
+
+enum class Side
+{
+    PARTY = 0,
+    MONSTERS = 1,
+    NONE = 2,
+};
+
+struct TrialOutcome
+{
+  Side winner {Side::NONE};
+  int rounds {0};
+  int damageTaken[2] {0, 0};  // Indexed by Side
+};
+
+// Reduction of many trials. Each worker fills its own copy and the copies
+// are merged once all trials are done.
+struct alignas(64) SimulationStats
+{
+  static constexpr int kMaxRounds = 50;    // Fights still going on are draws
+  static constexpr int kMaxDamage = 511;   // Last histogram bucket is "or more"
+
+  std::size_t trials {0};
+  std::size_t wins[3] {0, 0, 0};           // Indexed by Side, NONE are draws
+  std::array<std::size_t, kMaxRounds + 1> roundsHistogram {};
+  std::array<std::size_t, kMaxDamage + 1> partyDamageHistogram {};
+
+  void Add(const TrialOutcome& outcome);
+
+  void Merge(const SimulationStats& other);
+
+  double WinRate(Side side) const;
+
+  double MeanRounds() const;
+
+  // Smallest damage taken by the party in at least `quantile` of the trials.
+  int PartyDamagePercentile(double quantile) const;
+};
+
+
+// Headless combat between a party and a group of monsters. Every combatant
+// uses its most damaging attack or multiattack each turn, every attack on
+// the weakest living enemy. Saving throw actions are not modelled.
+class EncounterSimulator
+{
+public:
+  EncounterSimulator(std::span<const Statblock> party,
+                     std::span<const Statblock> monsters);
+
+  // The attacks a combatant makes every turn: its ACTION attack or
+  // multiattack with the highest expected damage.
+  static std::pmr::vector<AttackEffect> BestTurn(const Statblock& statblock,
+                                                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  TrialOutcome RunTrial(DiceEngine& engine) const;
+
+  // Trial i always draws from stream i of seed, so the result does not depend
+  // on the number of workers or on which worker ran which trial.
+  SimulationStats Run(std::size_t trials, std::uint64_t seed, ThreadPool& pool) const;
+
+  // Trials [firstTrial, firstTrial + trials), to add trials to earlier ones.
+  SimulationStats Run(std::size_t firstTrial, std::size_t trials, std::uint64_t seed, ThreadPool& pool) const;
+
+private:
+  struct Combatant
+  {
+    Side side;
+    int hitPoints;
+    int armorClass;
+    int initiativeBonus;
+    std::uint32_t firstAttack;    // Range of its turn in _attacks
+    std::uint32_t attackCount;
+  };
+
+  void AddCombatant(const Statblock& statblock, Side side);
+
+  std::vector<Combatant> _combatants;
+  std::vector<AttackEffect> _attacks;
+};
+
+
+#endif // __ENCOUNTER_SIMULATOR_H__
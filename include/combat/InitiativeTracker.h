@@ -0,0 +1,115 @@
+#ifndef __INITIATIVE_TRACKER_H__
+#define __INITIATIVE_TRACKER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "entities/Statblock.h"
+
+using CombatantId = std::uint32_t;
+
+constexpr CombatantId kNoCombatant = UINT32_MAX;
+
+struct Turn
+{
+  CombatantId combatant {kNoCombatant};
+  int round {0};
+  bool interrupt {false};   // Legendary action taken after someone's turn
+};
+
+
+// Turn order of an encounter, kept as an indexed 4-ary min-heap of turns.
+// A turn's key is (round, initiative, DEX, arrival, interrupt) packed into
+// one integer; higher initiative and DEX go first. Taking a turn does not pop
+// the combatant, it moves its key to the next round, so adding, removing and
+// delaying combatants and queueing interrupts are all one sift of the heap,
+// O(log n), and the order is never sorted again.
+class InitiativeTracker
+{
+public:
+  static constexpr std::size_t kArity = 4;
+
+  // Rolls d20 + DEX modifier with Die::Roll.
+  CombatantId Add(const Statblock& statblock);
+
+  // A combatant whose place in the order would already have come this round
+  // (e.g. a summon) first acts next round.
+  CombatantId Add(int initiative, int dexterity = 10);
+
+  void Remove(CombatantId id);
+
+  bool Contains(CombatantId id) const;
+
+  std::size_t Size() const;
+
+  // 0 when id is not a combatant
+  int InitiativeOf(CombatantId id) const;
+
+  // Starts the next turn. Returns an empty Turn when nobody is left.
+  Turn NextTurn();
+
+  Turn Current() const;
+
+  int Round() const;
+
+  // Moves a combatant to another initiative count, from the current round on.
+  // Delaying during one's own turn never earns a second turn this round: a
+  // count at or before the turn just taken applies from the next round.
+  void Delay(CombatantId id, int initiative);
+
+  // Lets id act right after the current turn ends, before the next one;
+  // interrupts queued during the same turn keep their order. Ids that are not
+  // combatants are ignored here and by Delay.
+  void Interrupt(CombatantId id);
+
+  // Upcoming turns in order, interrupts included. O(n log n), for display;
+  // pass a per-frame or per-turn Arena to keep it off the heap.
+  std::pmr::vector<Turn> Order(std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) const;
+
+private:
+  struct Entry
+  {
+    std::uint64_t key {0};
+    std::uint32_t position {0};         // Index in _heap
+    CombatantId combatant {kNoCombatant};
+    std::uint32_t arrival {0};          // Of the combatant, to spot reused ids
+    int initiative {0};
+    int dexterity {0};
+    bool interrupt {false};
+    bool used {false};
+  };
+
+  static std::uint64_t PackKey(int round, int initiative, int dexterity, std::uint32_t arrival, int phase);
+
+  static int RoundOf(std::uint64_t key);
+
+  std::uint32_t NewEntry();
+
+  void FreeEntry(std::uint32_t entry);
+
+  void Push(std::uint32_t entry);
+
+  void Erase(std::uint32_t entry);
+
+  // Restores the heap after the key of entry changed.
+  void Fix(std::uint32_t entry);
+
+  void SiftUp(std::size_t index);
+
+  void SiftDown(std::size_t index);
+
+  std::vector<Entry> _entries;          // Combatant ids index this directly
+  std::vector<std::uint32_t> _free;
+  std::vector<std::uint32_t> _heap;
+  std::size_t _combatants {0};
+  std::uint32_t _arrivals {0};
+
+  Turn _current {};
+  std::uint64_t _current_key {0};
+  int _interrupt_phase {0};
+};
+
+
+#endif // __INITIATIVE_TRACKER_H__
@@ -0,0 +1,126 @@
+#ifndef __ACTION_H__
+#define __ACTION_H__
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "rules/DiceExpression.h"
+#include "rules/Stats.h"
+
+enum class ActionType
+{
+    ACTION = 0,
+    BONUS_ACTION = 1,
+    REACTION = 2,
+    LEGENDARY_ACTION = 3,
+    LEGENDARY_REACTION = 4,
+};
+
+constexpr int kNumActionTypes = 5;
+
+
+// Attack roll against the target's AC; a natural 20 doubles the damage dice.
+struct AttackEffect
+{
+  int attackBonus {0};
+  DiceExpression damage {};
+};
+
+// Saving throw of the target against dc.
+struct SaveEffect
+{
+  Stats save {Stats::DEX};
+  int dc {10};
+  DiceExpression damage {};
+  bool halfOnSuccess {true};
+};
+
+// Other actions of the same list taken together, by index, e.g. a goblin
+// boss's two scimitar attacks. Multiattacks inside a multiattack are ignored.
+struct MultiattackEffect
+{
+  std::pmr::vector<std::uint8_t> actions {};
+};
+
+// Tagged union rather than a class hierarchy, so resolving thousands of
+// actions is a switch on the index and never a virtual call.
+using ActionEffect = std::variant<AttackEffect, SaveEffect, MultiattackEffect>;
+
+
+// Allocator-aware: inside a std::pmr container, the name and multiattack
+// list are allocated from the container's memory resource too.
+struct Action
+{
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  std::pmr::string name {};
+  ActionEffect effect {};
+
+  Action() = default;
+
+  explicit Action(const allocator_type& allocator)
+    : name(allocator)
+  {
+
+  }
+
+  Action(std::string_view name, ActionEffect effect, const allocator_type& allocator = {})
+    : name(name, allocator), effect(std::move(effect))
+  {
+    Adopt(allocator);
+  }
+
+  // Plain weapon attack, e.g. Action {"Scimitar", 4, "1d6+2"_dice}
+  Action(std::string_view name, int attackBonus, DiceExpression damage, const allocator_type& allocator = {})
+    : name(name, allocator), effect(AttackEffect {attackBonus, damage})
+  {
+
+  }
+
+  Action(const Action&) = default;
+  Action(Action&&) = default;
+  Action& operator=(const Action&) = default;
+  Action& operator=(Action&&) = default;
+
+  Action(const Action& other, const allocator_type& allocator)
+    : name(other.name, allocator), effect(CopyEffect(other.effect, allocator))
+  {
+
+  }
+
+  Action(Action&& other, const allocator_type& allocator)
+    : name(std::move(other.name), allocator), effect(std::move(other.effect))
+  {
+    Adopt(allocator);
+  }
+
+private:
+  // std::variant does not pass allocators on
+  static ActionEffect CopyEffect(const ActionEffect& effect, const allocator_type& allocator)
+  {
+    if (const auto* multiattack = std::get_if<MultiattackEffect>(&effect))
+    {
+      return MultiattackEffect {std::pmr::vector<std::uint8_t>(multiattack->actions, allocator)};
+    }
+    return effect;
+  }
+
+  void Adopt(const allocator_type& allocator)
+  {
+    if (auto* multiattack = std::get_if<MultiattackEffect>(&effect))
+    {
+      if (multiattack->actions.get_allocator() != allocator)
+      {
+        multiattack->actions = std::pmr::vector<std::uint8_t>(multiattack->actions, allocator);
+      }
+    }
+  }
+};
+
+
+#endif // __ACTION_H__
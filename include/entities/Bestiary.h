@@ -0,0 +1,137 @@
+#ifndef __BESTIARY_H__
+#define __BESTIARY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "entities/Action.h"
+#include "entities/Statblock.h"
+#include "rules/DiceExpression.h"
+#include "rules/Stats.h"
+
+struct BestiaryEntry
+{
+  std::string name;
+  Statblock statblock;
+};
+
+// Reads the text bestiary format, one creature after another:
+//
+//   # Comment
+//   creature Goblin Boss
+//   cr 1                      (fractions such as 1/4 are fine)
+//   hp 21
+//   ac 17
+//   stats STR 10 DEX 14 CON 10 INT 10 WIS 8 CHA 10
+//   action Multiattack: multiattack Scimitar, Scimitar
+//   action Scimitar: attack +4 1d6+2
+//   action Fire Breath: save DEX 13 8d6 half
+//   reaction Parry: ...
+//
+// Action lines start with action, bonus_action, reaction, legendary_action or
+// legendary_reaction. A multiattack names actions of the same list. Returns
+// false and describes the first problem, with its line, in error.
+bool ParseBestiary(std::istream& in, std::vector<BestiaryEntry>& entries, std::string& error);
+
+
+// Action inside a mapped bestiary; points straight into the mapping.
+struct ActionView
+{
+  std::string_view name {};
+  ActionType type {ActionType::ACTION};
+  std::uint8_t kind {0};                  // Index of the ActionEffect alternative
+  int attackBonus {0};
+  Stats save {Stats::DEX};
+  int dc {0};
+  bool halfOnSuccess {false};
+  const DiceExpression* damage {nullptr};
+  std::span<const std::uint8_t> multiattack {};
+
+  Action ToAction() const;
+};
+
+class Bestiary;
+
+// Read-only Statblock-like view of one creature in a mapped bestiary.
+class CreatureView
+{
+public:
+  CreatureView(const Bestiary& bestiary, std::size_t index);
+
+  std::string_view Name() const;
+
+  float GetCR() const;
+
+  int GetHP() const;
+
+  int GetAC() const;
+
+  int GetStat(Stats stat) const;
+
+  std::size_t NumActions(ActionType type) const;
+
+  ActionView GetAction(ActionType type, std::size_t index) const;
+
+  Statblock ToStatblock() const;
+
+private:
+  const Bestiary* _bestiary;
+  std::size_t _index;
+};
+
+
+// Collects creatures and writes them as one bestiary file.
+class BestiaryWriter
+{
+public:
+  void Add(std::string name, const Statblock& statblock);
+
+  bool Write(const std::string& path) const;
+
+private:
+  std::vector<BestiaryEntry> _entries;
+};
+
+
+// Read-only memory mapping of a bestiary file. Nothing is parsed or copied:
+// ability scores, actions and damage expressions are read in place, creatures
+// are looked up by name with a binary search and by CR through an index.
+class Bestiary
+{
+public:
+  Bestiary() = default;
+
+  ~Bestiary();
+
+  Bestiary(const Bestiary&) = delete;
+  Bestiary& operator=(const Bestiary&) = delete;
+
+  bool Open(const std::string& path);
+
+  void Close();
+
+  std::size_t Size() const;
+
+  // Creatures are sorted by name.
+  CreatureView At(std::size_t index) const;
+
+  // Returns Size() when there is no creature with that name.
+  std::size_t Find(std::string_view name) const;
+
+  // Indices of the creatures with minCR <= CR <= maxCR, lowest CR first.
+  std::span<const std::uint32_t> ByChallenge(float minCR, float maxCR) const;
+
+private:
+  friend class CreatureView;
+
+  const std::uint8_t* _data {nullptr};
+  std::size_t _size {0};
+};
+
+
+#endif // __BESTIARY_H__
@@ -0,0 +1,57 @@
+#ifndef __CHALLENGE_RATING_H__
+#define __CHALLENGE_RATING_H__
+
+#include <span>
+#include <vector>
+
+class Bestiary;
+class CreatureView;
+class Statblock;
+class ThreadPool;
+
+struct ChallengeRating
+{
+  float offensive {0.0f};
+  float defensive {0.0f};
+  float cr {0.0f};
+};
+
+// What a monster deals in its best round: the ACTION turn with the highest
+// expected damage plus its best bonus action, with every attack assumed to
+// hit and every save failed. Legendary actions and reactions are not counted.
+struct OffenseProfile
+{
+  double damagePerRound {0.0};
+  int attackBonus {0};          // Of the hardest hitting attack of the round
+  int saveDC {0};
+  bool usesSave {false};        // The round's damage mostly comes from a save
+};
+
+// The Dungeon Master's Guide "Creating a Monster" method. Hit points pick a
+// row of the Monster Statistics by Challenge Rating table, and every two
+// points of AC above or below that row move the defensive CR one step.
+// Damage per round and attack bonus (or save DC) do the same for the
+// offensive CR. The final CR is their average, snapped to the table.
+float DefensiveCR(int hitPoints, int armorClass);
+
+float OffensiveCR(const OffenseProfile& offense);
+
+float CombineCR(float offensive, float defensive);
+
+OffenseProfile ProfileOffense(const Statblock& statblock);
+
+OffenseProfile ProfileOffense(const CreatureView& creature);
+
+// Uncached. Statblock::GetCalculatedCR caches the result.
+ChallengeRating RateStatblock(const Statblock& statblock);
+
+ChallengeRating RateStatblock(const CreatureView& creature);
+
+// Fills the cache of every statblock, spread over the pool.
+void RateAll(std::span<Statblock> statblocks, ThreadPool& pool);
+
+// Rates every creature of a mapped bestiary, in bestiary order.
+std::vector<ChallengeRating> RateAll(const Bestiary& bestiary, ThreadPool& pool);
+
+
+#endif // __CHALLENGE_RATING_H__
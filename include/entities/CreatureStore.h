@@ -0,0 +1,157 @@
+#ifndef __CREATURE_STORE_H__
+#define __CREATURE_STORE_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "entities/Action.h"
+#include "entities/Statblock.h"
+#include "rules/Conditions.h"
+#include "rules/DiceEngine.h"
+#include "rules/Roll.h"
+#include "rules/Stats.h"
+#include "utils/AlignedAllocator.h"
+
+// Stable reference to a creature. It stays valid while other creatures are
+// added and removed, and stops being valid once its creature is removed.
+struct CreatureHandle
+{
+  std::uint32_t slot {UINT32_MAX};
+  std::uint32_t generation {0};
+
+  bool operator==(const CreatureHandle& other) const = default;
+};
+
+class CreatureStore;
+
+// Read-only Statblock-like view of one creature in a CreatureStore. Only
+// valid until the next Add() or Remove() on the store.
+class StatblockView
+{
+public:
+  StatblockView(const CreatureStore& store, std::size_t index);
+
+  float GetCR() const;
+
+  int GetHP() const;
+
+  int GetAC() const;
+
+  int GetStat(Stats stat) const;
+
+  int GetModifier(Stats stat) const;
+
+  std::span<const Action> GetActions(ActionType type) const;
+
+  Statblock ToStatblock() const;
+
+private:
+  const CreatureStore* _store;
+  std::size_t _index;
+};
+
+
+// Structure-of-arrays storage for many creatures: every ability score is its
+// own aligned column, CR is a column, and all action lists live in one
+// flattened table addressed by (first, count) ranges. Columns are dense;
+// removing a creature moves the last one into its place.
+class CreatureStore
+{
+public:
+  CreatureHandle Add(const Statblock& statblock);
+
+  void Remove(CreatureHandle handle);
+
+  bool IsValid(CreatureHandle handle) const;
+
+  std::size_t Size() const;
+
+  void Clear();
+
+  StatblockView View(CreatureHandle handle) const;
+
+  // Dense index of a creature, i.e. its position in the columns.
+  std::size_t IndexOf(CreatureHandle handle) const;
+
+  CreatureHandle HandleAt(std::size_t index) const;
+
+  std::span<const int> Scores(Stats stat) const;
+
+  std::span<const float> ChallengeRatings() const;
+
+  std::span<const int> HitPoints() const;
+
+  std::span<const int> ArmorClasses() const;
+
+  // Subtracts damage[i] from the hit points of creature targets[i]; hit
+  // points stop at 0. Negative damage heals.
+  void ApplyDamage(std::span<const std::uint32_t> targets, std::span<const int> damage);
+
+  float TotalCR() const;
+
+  std::span<const Action> Actions(std::size_t index, ActionType type) const;
+
+  ConditionSet GetConditions(std::size_t index) const;
+
+  void SetConditions(std::size_t index, ConditionSet conditions);
+
+  // The ConditionSet bits of every creature, in column order
+  std::span<const std::uint64_t> Conditions() const;
+
+  // Slots left of a level from 1 to 9
+  int SpellSlots(std::size_t index, int level) const;
+
+  // Returns false, spending nothing, when no slot of that level is left.
+  bool SpendSpellSlot(std::size_t index, int level);
+
+  // Back to what the statblock had, as after a long rest.
+  void RestoreSpellSlots(std::size_t index);
+
+  // Rolls a saving throw against dc for every creature, in column order.
+  // success must hold Size() entries.
+  void RollSavingThrows(Stats stat, int dc, Roll mode, DiceEngine& engine,
+                        std::span<std::uint8_t> success) const;
+
+  // Same, with the mode of each creature derived from its conditions; those
+  // that fail the save outright (e.g. a paralyzed creature's DEX save) fail.
+  void RollSavingThrows(Stats stat, int dc, DiceEngine& engine, std::span<std::uint8_t> success,
+                        const RollRules& rules = {}) const;
+
+  // d20 + DEX modifier for every creature, in column order.
+  void RollInitiative(DiceEngine& engine, std::span<int> initiative) const;
+
+private:
+  friend class StatblockView;
+
+  struct ActionRange
+  {
+    std::uint32_t first {0};
+    std::uint32_t count {0};
+  };
+
+  static constexpr std::size_t kRollChunk = 1024;
+
+  void CompactActions();
+
+  StatArray<AlignedVector<int>> _scores;
+  AlignedVector<float> _cr;
+  AlignedVector<int> _hit_points;
+  AlignedVector<int> _armor_class;
+  AlignedVector<std::uint64_t> _conditions;
+  std::vector<std::array<std::uint8_t, 9>> _spell_slots;
+  std::vector<std::array<std::uint8_t, 9>> _max_spell_slots;
+  std::vector<ActionRange> _action_ranges[kNumActionTypes];
+  std::vector<Action> _action_table;
+  std::size_t _dead_actions {0};
+
+  std::vector<std::uint32_t> _dense_to_slot;
+  std::vector<std::uint32_t> _slot_to_dense;
+  std::vector<std::uint32_t> _generations;
+  std::vector<std::uint32_t> _free_slots;
+};
+
+
+#endif // __CREATURE_STORE_H__
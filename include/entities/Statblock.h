@@ -1,26 +1,105 @@
 #ifndef __STATBLOCK_H__
 #define __STATBLOCK_H__
 
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
 
-class Action;
+#include "entities/Action.h"
+#include "entities/ChallengeRating.h"
+#include "rules/AbilityTables.h"
+#include "rules/Stats.h"
 
+// Allocator-aware: the action lists, and the actions in them, allocate from
+// the statblock's memory resource, so an encounter can keep all of its
+// statblocks in one Arena and free them with one Reset().
 class Statblock
 {
 public:
-  float GetCR();
-  
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  Statblock() = default;
+
+  explicit Statblock(const allocator_type& allocator);
+
+  Statblock(const Statblock&) = default;
+  Statblock(Statblock&&) = default;
+  Statblock& operator=(const Statblock&) = default;
+  Statblock& operator=(Statblock&&) = default;
+
+  Statblock(const Statblock& other, const allocator_type& allocator);
+
+  Statblock(Statblock&& other, const allocator_type& allocator);
+
+  allocator_type GetAllocator() const;
+
+  float GetCR() const;
+
+  void SetCR(float cr);
+
+  int GetHP() const;
+
+  void SetHP(int hitPoints);
+
+  int GetAC() const;
+
+  void SetAC(int armorClass);
 
+  int GetStat(Stats stat) const;
+
+  void SetStat(Stats stat, int score);
+
+  int GetModifier(Stats stat) const;
+
+  // For a stat known at compile time
+  template <Stats S>
+  int GetStat() const
+  {
+    return _stats.Get<S>();
+  }
+
+  template <Stats S>
+  int GetModifier() const
+  {
+    return AbilityModifier(_stats.Get<S>());
+  }
+
+  // Of the published CR
+  int GetProficiencyBonus() const;
+
+  // Spell slots of a level from 1 to 9
+  int GetSpellSlots(int level) const;
+
+  void SetSpellSlots(int level, int count);
+
+  const std::pmr::vector<Action>& GetActions(ActionType type) const;
+
+  void AddAction(ActionType type, const Action& action);
+
+  // CR worked out from HP, AC and the actions (see ChallengeRating.h), as
+  // opposed to the published one GetCR returns. Cached: a change of HP or AC
+  // only redoes the defensive half, a new action only the offensive one.
+  // Not safe to call on the same statblock from several threads at once.
+  const ChallengeRating& GetCalculatedCR() const;
 
 
 private:
-  float _cr;
-  std::vector<Action> _actions{};
-  std::vector<Action> _bouns_actions{};
-  std::vector<Action> _reactions{};
-  std::vector<Action> _legendary_actions{};
-  std::vector<Action> _legendary_reactions{};
-  int _stats[6] { /*STR*/10, /*DEX*/10, /*CON*/10, /*WIS*/10, /*INT*/10, /*CHA*/10};
+  std::pmr::vector<Action>& ActionList(ActionType type);
+
+  float _cr {0.0f};
+  int _hit_points {1};
+  int _armor_class {10};
+  std::pmr::vector<Action> _actions{};
+  std::pmr::vector<Action> _bouns_actions{};
+  std::pmr::vector<Action> _reactions{};
+  std::pmr::vector<Action> _legendary_actions{};
+  std::pmr::vector<Action> _legendary_reactions{};
+  StatArray<int> _stats {{ /*STR*/10, /*DEX*/10, /*CON*/10, /*WIS*/10, /*INT*/10, /*CHA*/10}};
+  std::uint8_t _spell_slots[9] {};
+
+  mutable ChallengeRating _rating {};
+  mutable bool _offense_stale {true};
+  mutable bool _defense_stale {true};
   
 };
 
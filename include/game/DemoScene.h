@@ -0,0 +1,73 @@
+#ifndef __DEMO_SCENE_H__
+#define __DEMO_SCENE_H__
+
+#include <cstdint>
+#include <functional>
+
+#include "graphics/NcursesGraphics.h"
+#include "graphics/ProfileOverlay.h"
+#include "graphics/SpriteAtlas.h"
+#include "map/BattleMap.h"
+#include "map/FieldOfView.h"
+#include "map/Pathfinder.h"
+#include "utils/GameLoop.h"
+
+class DiceEngine;
+
+// The scene the game runs: a player walking with the arrow keys and a goblin
+// chasing them around a wall. 'p' toggles the profiler overlay. It draws into
+// any Display, so the game and SceneBenchmark play exactly the same scene.
+class DemoScene
+{
+public:
+    static constexpr std::uint32_t kGoblin = 0;
+    static constexpr std::uint32_t kPlayer = 1;
+
+    // Called whenever the goblin or the player moves
+    using OnMove = std::function<void(std::uint32_t creature, GridPos pos)>;
+
+    DemoScene(int columns, int lines, SpriteView racket = {});
+
+    DemoScene(const DemoScene&) = delete;
+    DemoScene& operator=(const DemoScene&) = delete;
+
+    void SetOnMove(OnMove onMove);
+
+    // Rolls with dice instead of the calling thread's engine, e.g. so that
+    // every session of a server keeps its own stream
+    void SetDice(DiceEngine& dice);
+
+    // Returns false when the key asks to quit
+    bool OnKey(int key);
+
+    void Tick();
+
+    // inputLatency, if given, is shown under the frame times
+    void Render(Display& display, const FrameTimes& frameTimes, const FrameTimes* inputLatency = nullptr);
+
+    bool Has(std::uint32_t creature) const;
+
+    GridPos Position(std::uint32_t creature) const;
+
+private:
+    void Step(int dx, int dy);
+
+    BattleMap _map;
+    TokenId _goblin_token {kNoToken};
+    TokenId _player_token {kNoToken};
+    FieldOfView _fov;
+    Pathfinder _pathfinder;
+
+    TextSprite _goblin;
+    TextSprite _player;
+    SpriteView _racket;
+
+    int _ticks {0};
+    int _die_roll {0};
+    DiceEngine* _dice {nullptr};
+    OnMove _on_move;
+    ProfileOverlay _profile;
+};
+
+
+#endif // __DEMO_SCENE_H__
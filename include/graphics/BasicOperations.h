@@ -9,7 +9,7 @@ void drawBox();
 
 void drawLines();
 
-void drawText(int x, int y, double fps);
+void drawText(int x, int y, double p50Ms, double p99Ms);
 
 int MainLoop();
 
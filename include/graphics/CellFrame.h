@@ -0,0 +1,70 @@
+#ifndef __CELL_FRAME_H__
+#define __CELL_FRAME_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "graphics/FrameBuffer.h"
+
+// What one Display::Refresh() sent to its target, encoded for a terminal
+// elsewhere to replay. All varints:
+//
+//   flags (kClearScreen), number of runs, then for every run
+//   x, y, length, color pair, attributes and length glyphs
+//
+// Display only sends runs whose cells all have the style of the first one,
+// so the style is written once per run.
+constexpr std::uint8_t kClearScreen = 1;
+
+
+class CellFrameWriter
+{
+public:
+  // Starts a new frame
+  void Reset();
+
+  // The receiver clears its screen before the runs
+  void ClearScreen();
+
+  void AddRun(int x, int y, std::span<const Cell> cells);
+
+  bool Empty() const;
+
+  // Appends the frame to out
+  void Finish(std::vector<std::uint8_t>& out) const;
+
+private:
+  std::vector<std::uint8_t> _runs;
+  std::size_t _num_runs {0};
+  std::uint8_t _flags {0};
+};
+
+
+// Walks the runs of an encoded frame. Cells are decoded into a buffer of the
+// reader, valid until the next call to Next().
+class CellFrameReader
+{
+public:
+  // False if the header is malformed. An empty frame changes nothing.
+  bool Open(std::span<const std::uint8_t> frame);
+
+  bool ClearsScreen() const;
+
+  // False at the end of the frame or on a malformed run
+  bool Next(int& x, int& y, std::span<const Cell>& cells);
+
+  // Replays the whole frame onto screen
+  bool ApplyTo(FrameBuffer& screen);
+
+private:
+  const std::uint8_t* _it {nullptr};
+  const std::uint8_t* _end {nullptr};
+  std::uint64_t _runs_left {0};
+  std::uint8_t _flags {0};
+  std::vector<Cell> _cells;
+};
+
+
+#endif // __CELL_FRAME_H__
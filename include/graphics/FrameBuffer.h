@@ -0,0 +1,66 @@
+#ifndef __FRAME_BUFFER_H__
+#define __FRAME_BUFFER_H__
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// One terminal cell. glyph and attributes use the ncurses chtype/attr_t bit
+// layout, so box drawing characters (A_ALTCHARSET) fit in glyph.
+struct Cell
+{
+  std::uint32_t glyph {' '};
+  std::uint16_t colorPair {0};
+  std::uint32_t attributes {0};
+
+  bool operator==(const Cell& other) const = default;
+
+  bool SameStyle(const Cell& other) const
+  {
+    return colorPair == other.colorPair && attributes == other.attributes;
+  }
+};
+
+
+// Line drawing glyph by its VT100 alternate character set letter, e.g.
+// AcsGlyph('q') for ACS_HLINE. ncurses only fills its ACS_ values once a
+// terminal is up, so cells keep the letter and a target translates it.
+constexpr std::uint32_t kAltCharset = 1u << 22;   // A_ALTCHARSET
+
+constexpr std::uint32_t AcsGlyph(char letter)
+{
+  return kAltCharset | static_cast<std::uint8_t>(letter);
+}
+
+
+// Row-major grid of cells. Writes outside of the grid are clipped.
+class FrameBuffer
+{
+public:
+  void Resize(int columns, int lines);
+
+  void Fill(const Cell& cell);
+
+  void Clear();
+
+  void Put(int x, int y, const Cell& cell);
+
+  void PutText(int x, int y, std::string_view text, std::uint16_t colorPair, std::uint32_t attributes);
+
+  const Cell& At(int x, int y) const;
+
+  std::span<const Cell> Row(int y) const;
+
+  int Columns() const;
+
+  int Lines() const;
+
+private:
+  int _columns {0};
+  int _lines {0};
+  std::vector<Cell> _cells;
+};
+
+
+#endif // __FRAME_BUFFER_H__
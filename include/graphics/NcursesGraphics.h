@@ -3,10 +3,19 @@
  */
 #ifndef __NCURSES_GRAPHICS_H__
 #define __NCURSES_GRAPHICS_H__
+#include <cstdio>
 #include <optional>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "graphics/FrameBuffer.h"
+#include "graphics/RenderTarget.h"
+#include "utils/Arena.h"
+
+class VisibilityGrid;
 
 
 enum class FontColor
@@ -39,13 +48,23 @@ enum class Key
     RIGHT = 0405,
 };
 
+// Cells and runs sent to the terminal by the last Refresh()
+struct FrameStats
+{
+    int changedCells {0};
+    int runs {0};
+};
+
 // Singleton that allows for screen management
+//
+// Drawing goes into an in-memory back buffer. Refresh() compares it with the
+// frame currently on screen and only sends the runs of cells that changed,
+// one attribute set per run, to the render target, then swaps the buffers.
 class Display
 {
 public:
     
     //Display();
-    ~Display();
 
     void SetMarginColor(FontColor color);
 
@@ -54,16 +73,45 @@ public:
         // Do not allow assignations
         Display& operator = (const Display&) = delete;*/
 
-    void DrawText(const std::string& text, 
+    void DrawText(std::string_view text, 
                   int x, 
                   int y, 
                   FontColor color, 
                   int fontFlags = 0);
 
+    // Writes a single cell; glyph is a Unicode code point or an ACS chtype
+    void DrawCell(int x, int y, const Cell& cell);
+
+    // Dims what was drawn so far on every square of the map, placed with its
+    // top left square at (x, y), that is not visible: the cell keeps its
+    // glyph but takes the fog color pair, drawn with A_DIM.
+    void DrawFog(const VisibilityGrid& visible, 
+                 int x, 
+                 int y, 
+                 FontColor fog = FontColor::BLUE_OVER_BLACK);
+
     void Init();
 
+    // Runs on the terminal connected to output/input instead of stdout/stdin
+    void Init(std::FILE* output, std::FILE* input);
+
+    // Renders into memory instead of a terminal, e.g. for benchmarks
+    MemoryTarget& InitHeadless(int columns, int lines);
+
+    // Renders into cell frames for a remote terminal (see StreamTarget)
+    StreamTarget& InitStream(int columns, int lines);
+
+    RenderTarget& Target();
+
     int GetChar();
 
+    // File descriptor GetChar() reads from, to wait on with poll()
+    int InputFd() const;
+
+    // The terminal changed size; the next NewFrame() redraws everything
+    void Resize(int columns, int lines);
+
+    // Also empties FrameArena()
     void NewFrame();
 
     void Refresh();
@@ -72,6 +120,12 @@ public:
 
     int NumColumns();
 
+    const FrameStats& LastFrameStats() const;
+
+    // Scratch memory for text and the like that lives until the next
+    // NewFrame(), so a steady frame loop never touches the heap
+    std::pmr::memory_resource* FrameArena();
+
 private:
 
     void InitColorPalettes();
@@ -80,10 +134,38 @@ private:
                            unsigned int horitzontalChar=0, 
                            unsigned int verticalChar=0);
 
+    void SetUpTerminal();
+
+    template <typename Backend>
+    void RefreshTo(Backend& target);
+
+    // Unchanged cells this close to the end of a run are sent along with it
+    // rather than starting a new run.
+    static constexpr int kMaxRunGap = 3;
+
     std::optional<FontColor> _margin_color {std::nullopt};
+
+    RenderTarget _target;
+
+    FrameBuffer _front;
+    FrameBuffer _back;
+    FrameStats _last_frame {};
+    Arena _frame_arena {16 * 1024};
 };
 
 
+// Horizontal span of opaque cells of a sprite
+struct SpriteRun
+{
+    std::uint16_t row;
+    std::uint16_t column;
+    std::uint16_t length;
+    std::uint32_t first;    // Index of its first glyph in the sprite glyphs
+};
+
+// Text sprite where ' ' is transparent. The char grid is compiled once, at
+// construction, into flat row-major glyphs, an opacity bit mask and the runs
+// of opaque cells, so Draw() is one DrawText() per run and never allocates.
 class TextSprite
 {
 public:
@@ -93,14 +175,27 @@ public:
 
     TextSprite();
 
+    // Parts outside of the screen are clipped when drawn
     void SetPos(int x, int y);
 
-    void Draw(Display& display);
+    void Draw(Display& display) const;
+
+    int Width() const;
+
+    int Height() const;
+
+    bool IsOpaque(int column, int row) const;
 
 private:
+    void Compile(const std::vector<std::vector<char>>& sprite);
+
     int _x {0};
     int _y {0};
-    std::vector<std::vector<char>> _sprite {{}};
+    int _width {0};
+    int _height {0};
+    std::vector<char> _glyphs {};
+    std::vector<std::uint64_t> _opaque {};
+    std::vector<SpriteRun> _runs {};
     FontColor _color {FontColor::RED_OVER_BLACK};
 
 };
@@ -0,0 +1,34 @@
+#ifndef __PROFILE_OVERLAY_H__
+#define __PROFILE_OVERLAY_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/Profiler.h"
+
+class Display;
+
+// Table of the profiler zones over the last second (calls, mean and worst
+// time), drawn over the frame with DrawText. Summarizing reads every ring,
+// so the table is only rebuilt a few times a second.
+class ProfileOverlay
+{
+public:
+    // Showing the overlay turns profiling on
+    void Toggle();
+
+    bool Visible() const;
+
+    void Draw(Display& display, int x, int y);
+
+private:
+    static constexpr std::int64_t kWindowNs = 1'000'000'000;
+    static constexpr std::int64_t kUpdateNs = 250'000'000;
+
+    bool _visible {false};
+    std::vector<ZoneStats> _zones;
+    std::int64_t _next_update {0};
+};
+
+
+#endif // __PROFILE_OVERLAY_H__
@@ -0,0 +1,151 @@
+#ifndef __RENDER_TARGET_H__
+#define __RENDER_TARGET_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "graphics/CellFrame.h"
+#include "graphics/FrameBuffer.h"
+
+// A render target receives what Display sends at Refresh(): the runs of
+// changed cells of one line, all of the same style, then Present(). Display
+// keeps the frame buffers and does the diffing, so a target only writes.
+
+// The terminal, through ncurses and its stdscr.
+class NcursesTarget
+{
+public:
+  NcursesTarget() = default;
+
+  ~NcursesTarget();
+
+  NcursesTarget(const NcursesTarget&) = delete;
+  NcursesTarget& operator=(const NcursesTarget&) = delete;
+
+  void Init();
+
+  // Runs on the terminal connected to output/input instead of stdout/stdin
+  void Init(std::FILE* output, std::FILE* input);
+
+  int Columns() const;
+
+  int Lines() const;
+
+  // After a SIGWINCH that nobody passed to ncurses
+  void Resize(int columns, int lines);
+
+  // Forgets what is on screen, after a resize
+  void Clear();
+
+  void WriteRun(int x, int y, std::span<const Cell> cells);
+
+  void Present();
+
+  int GetChar();
+
+  int InputFd() const;
+
+private:
+  bool _initialized {false};
+  int _input_fd {0};
+};
+
+
+// Headless terminal of a fixed size. Runs are kept as cells, to look at what
+// was drawn, and encoded as the ANSI escape sequences a terminal would get,
+// to count and capture the output. Keys come from PushKey.
+class MemoryTarget
+{
+public:
+  MemoryTarget(int columns = 80, int lines = 24);
+
+  int Columns() const;
+
+  int Lines() const;
+
+  void Resize(int columns, int lines);
+
+  void Clear();
+
+  void WriteRun(int x, int y, std::span<const Cell> cells);
+
+  void Present();
+
+  // Returns the oldest pushed key, or -1 when there is none
+  int GetChar();
+
+  // -1: nothing to poll, so a GameLoop waits its full timeout
+  int InputFd() const;
+
+  void PushKey(int key);
+
+  const FrameBuffer& Screen() const;
+
+  // The whole screen as escape sequences, e.g. to write to a file and cat
+  // in a terminal
+  std::string Capture() const;
+
+  // Of every presented frame so far
+  std::uint64_t OutputBytes() const;
+
+  std::uint64_t Frames() const;
+
+private:
+  FrameBuffer _screen;
+  std::string _pending;
+  std::uint64_t _output_bytes {0};
+  std::uint64_t _frames {0};
+  Cell _style {};                   // Of the last run sent
+  bool _style_known {false};
+  std::vector<int> _keys;           // Emptied once read, so it never reallocates
+  std::size_t _next_key {0};
+};
+
+
+// Headless terminal whose frames are shown elsewhere, e.g. by a client of
+// TableServer: every Present() encodes the runs it got as a cell frame,
+// kept in Frame() until the next one. Keys are handed to the scene by
+// whoever owns the target, so there is no input.
+class StreamTarget
+{
+public:
+  StreamTarget(int columns = 80, int lines = 24);
+
+  int Columns() const;
+
+  int Lines() const;
+
+  void Resize(int columns, int lines);
+
+  void Clear();
+
+  void WriteRun(int x, int y, std::span<const Cell> cells);
+
+  void Present();
+
+  int GetChar();
+
+  int InputFd() const;
+
+  // Of the last Present(); empty when nothing changed
+  std::span<const std::uint8_t> Frame() const;
+
+private:
+  int _columns;
+  int _lines;
+  CellFrameWriter _writer;
+  std::vector<std::uint8_t> _frame;
+};
+
+
+// Closed set of backends: Display switches on the alternative once per run
+// rather than making a virtual call.
+using RenderTarget = std::variant<NcursesTarget, MemoryTarget, StreamTarget>;
+
+
+#endif // __RENDER_TARGET_H__
@@ -0,0 +1,100 @@
+#ifndef __SPRITE_ATLAS_H__
+#define __SPRITE_ATLAS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "graphics/FrameBuffer.h"
+
+class Display;
+
+// 8 bit RGBA pixels, row-major
+struct RgbaImage
+{
+  int width {0};
+  int height {0};
+  std::vector<std::uint8_t> pixels {};
+};
+
+// Cell of a baked sprite as stored in the atlas file
+struct AtlasCell
+{
+  std::uint32_t glyph;      // Unicode code point, usually a half block
+  std::uint16_t colorPair;  // FontColor
+  std::uint16_t opaque;
+};
+
+// Sprite inside a mapped atlas; points straight into the mapping
+struct SpriteView
+{
+  std::string_view name {};
+  int width {0};
+  int height {0};
+  std::span<const AtlasCell> cells {};
+
+  void Draw(Display& display, int x, int y) const;
+};
+
+
+// Turns an image into text cells. Every cell covers two pixels stacked
+// vertically, drawn as an upper/lower half block, a full block or a space,
+// whichever FontColor pair gets closest to the two pixel colors. Cells whose
+// pixels are both transparent stay transparent.
+std::vector<AtlasCell> BakeSprite(const RgbaImage& image, int& width, int& height);
+
+
+// Collects baked sprites and writes them as one atlas file.
+class SpriteAtlasWriter
+{
+public:
+  void Add(std::string name, const RgbaImage& image);
+
+  bool Write(const std::string& path) const;
+
+private:
+  struct Entry
+  {
+    std::string name;
+    int width;
+    int height;
+    std::vector<AtlasCell> cells;
+  };
+
+  std::vector<Entry> _entries;
+};
+
+
+// Read-only memory mapping of an atlas file. Nothing is decoded or copied:
+// sprites are looked up by name with a binary search over the entry table.
+class SpriteAtlas
+{
+public:
+  SpriteAtlas() = default;
+
+  ~SpriteAtlas();
+
+  SpriteAtlas(const SpriteAtlas&) = delete;
+  SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+  bool Open(const std::string& path);
+
+  void Close();
+
+  std::size_t Size() const;
+
+  SpriteView At(std::size_t index) const;
+
+  // Returns an empty view when there is no sprite with that name.
+  SpriteView Find(std::string_view name) const;
+
+private:
+  const std::uint8_t* _data {nullptr};
+  std::size_t _size {0};
+};
+
+
+#endif // __SPRITE_ATLAS_H__
@@ -0,0 +1,68 @@
+#ifndef __AREA_TEMPLATE_H__
+#define __AREA_TEMPLATE_H__
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Square of the battle map. One square is 5 feet.
+struct GridPos
+{
+  int x {0};
+  int y {0};
+
+  bool operator==(const GridPos& other) const = default;
+};
+
+// Squares x0..x1 (inclusive) of row y
+struct CellSpan
+{
+  int y;
+  int x0;
+  int x1;
+};
+
+// Area of effect rasterized into one span of squares per row. A square is
+// inside when its center is inside the shape. Every shape is convex, so a
+// row never needs more than one span, and building a template costs one
+// step per row rather than one per square of its bounding box. Sizes are in
+// squares.
+class AreaTemplate
+{
+public:
+  // Squares whose center lies within radius of the center of `center`.
+  static AreaTemplate Sphere(GridPos center, double radius);
+
+  // Cone starting at the edge of `origin` and pointing at `toward`; as wide
+  // at its end as it is long. The origin square itself is not included.
+  static AreaTemplate Cone(GridPos origin, GridPos toward, double length);
+
+  // Line starting at the edge of `origin` and pointing at `toward`.
+  static AreaTemplate Line(GridPos origin, GridPos toward, double length, double width = 1.0);
+
+  // Squares x0..x1, y0..y1, inclusive.
+  static AreaTemplate Rect(GridPos first, GridPos last);
+
+  std::span<const CellSpan> Spans() const;
+
+  std::size_t NumCells() const;
+
+  bool Contains(GridPos cell) const;
+
+private:
+  struct Point
+  {
+    double x;
+    double y;
+  };
+
+  static AreaTemplate Polygon(std::span<const Point> vertices);
+
+  // Adds the squares whose centers lie in [xmin, xmax] on row y.
+  void AddRow(int y, double xmin, double xmax);
+
+  std::vector<CellSpan> _spans;
+};
+
+
+#endif // __AREA_TEMPLATE_H__
@@ -0,0 +1,106 @@
+#ifndef __BATTLE_MAP_H__
+#define __BATTLE_MAP_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "map/AreaTemplate.h"
+
+using TokenId = std::uint32_t;
+
+constexpr TokenId kNoToken = UINT32_MAX;
+
+// A creature standing on the map. Its footprint is width x height squares
+// with pos as the top left one; reach is in squares (1 = 5 feet).
+struct Token
+{
+  GridPos pos {};
+  int width {0};
+  int height {0};
+  int reach {1};
+  int team {0};
+};
+
+
+// Uniform grid of squares holding creature positions. Occupancy and walls
+// are kept as one bit per square, row by row, next to the id of the token
+// on each square, so an area query walks the squares of its template a word
+// at a time and never looks at creatures outside it.
+class BattleMap
+{
+public:
+  BattleMap(int width, int height);
+
+  int Width() const;
+
+  int Height() const;
+
+  bool InBounds(GridPos cell) const;
+
+  void SetWall(GridPos cell, bool wall);
+
+  bool IsWall(GridPos cell) const;
+
+  // 64 bit words per row of the bit grids below
+  std::size_t RowWords() const;
+
+  // One bit per square, row by row; bit x % 64 of word y * RowWords() + x / 64
+  std::span<const std::uint64_t> WallBits() const;
+
+  std::span<const std::uint64_t> OccupiedBits() const;
+
+  // Returns kNoToken when the footprint leaves the map or overlaps a wall or
+  // another creature.
+  TokenId Place(GridPos pos, int width, int height, int reach = 1, int team = 0);
+
+  // Does nothing when id is not a token on the map, e.g. removed already
+  void Remove(TokenId id);
+
+  // id was handed out by Place and not removed since
+  bool IsValid(TokenId id) const;
+
+  const Token& GetToken(TokenId id) const;
+
+  // Token standing on cell, or kNoToken.
+  TokenId At(GridPos cell) const;
+
+  bool CanMove(TokenId id, GridPos to) const;
+
+  // Moves the token unless it would collide; returns whether it moved.
+  bool Move(TokenId id, GridPos to);
+
+  // Appends every creature with at least one square inside the area, once.
+  void Query(const AreaTemplate& area, std::vector<TokenId>& hits) const;
+
+  // Appends the creatures of other teams that have `target` within reach.
+  void Threatening(TokenId target, std::vector<TokenId>& threats) const;
+
+  // Appends the creatures of other teams that `mover` would leave the reach
+  // of by stepping to `to`, i.e. those that get an opportunity attack.
+  void OpportunityAttackers(TokenId mover, GridPos to, std::vector<TokenId>& attackers) const;
+
+private:
+  std::size_t CellIndex(GridPos cell) const;
+
+  bool Fits(const Token& token, GridPos pos, TokenId self) const;
+
+  void Stamp(const Token& token, TokenId id);
+
+  // Distance in squares between the closest squares of two footprints
+  static int Distance(const Token& a, GridPos aPos, const Token& b);
+
+  int _width;
+  int _height;
+  std::size_t _row_words;
+  std::vector<std::uint64_t> _occupied;
+  std::vector<std::uint64_t> _walls;
+  std::vector<TokenId> _occupant;
+  std::vector<Token> _tokens;
+  std::vector<TokenId> _free_tokens;
+  int _max_reach {0};
+};
+
+
+#endif // __BATTLE_MAP_H__
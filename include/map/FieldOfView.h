@@ -0,0 +1,104 @@
+#ifndef __FIELD_OF_VIEW_H__
+#define __FIELD_OF_VIEW_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "map/BattleMap.h"
+
+// One bit per square, in the same layout as the BattleMap bit grids, so
+// grids can be combined with each other and with the map a word at a time.
+class VisibilityGrid
+{
+public:
+  void Reset(int width, int height);
+
+  void Clear();
+
+  void Set(GridPos cell);
+
+  bool Test(GridPos cell) const;
+
+  // Adds every square visible in other.
+  void Merge(const VisibilityGrid& other);
+
+  int Width() const;
+
+  int Height() const;
+
+  std::size_t RowWords() const;
+
+  std::span<const std::uint64_t> Words() const;
+
+  // Rows outside FirstRow()..LastRow() are all clear
+  int FirstRow() const;
+
+  int LastRow() const;
+
+private:
+  int _width {0};
+  int _height {0};
+  std::size_t _row_words {0};
+  std::vector<std::uint64_t> _words;
+  int _first_row {0};
+  int _last_row {-1};
+};
+
+
+// Squares visible from the center of `eye` within radius squares, using
+// recursive shadowcasting over the map walls. Walls that block the view are
+// visible themselves; creatures never block it.
+void ComputeFieldOfView(const BattleMap& map, GridPos eye, int radius, VisibilityGrid& visible);
+
+
+// Field of view of every tracked creature of a map. Views are only computed
+// again by Update(), and only for the creatures marked dirty: a creature
+// that moved, or one that could see a wall that appeared or went away. As
+// creatures are transparent, nobody else's view changes when one moves.
+class FieldOfView
+{
+public:
+  FieldOfView(const BattleMap& map, int radius);
+
+  void Track(TokenId id);
+
+  void Untrack(TokenId id);
+
+  void MarkMoved(TokenId id);
+
+  void MarkWallChanged(GridPos cell);
+
+  // Recomputes the dirty views; returns how many there were.
+  std::size_t Update();
+
+  const VisibilityGrid& VisibleFrom(TokenId viewer) const;
+
+  bool CanSee(TokenId viewer, TokenId target) const;
+
+  // Appends the creatures with at least one square in view of viewer, once,
+  // viewer included.
+  void VisibleTokens(TokenId viewer, std::vector<TokenId>& seen) const;
+
+  // Everything seen by at least one tracked creature of the team
+  void TeamView(int team, VisibilityGrid& view) const;
+
+private:
+  struct Viewer
+  {
+    bool tracked {false};
+    bool dirty {false};
+    VisibilityGrid visible {};
+  };
+
+  // Center square of the footprint
+  GridPos Eye(TokenId id) const;
+
+  const BattleMap& _map;
+  int _radius;
+  std::vector<Viewer> _viewers;     // Indexed by TokenId
+};
+
+
+#endif // __FIELD_OF_VIEW_H__
@@ -0,0 +1,148 @@
+#ifndef __PATHFINDER_H__
+#define __PATHFINDER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "map/BattleMap.h"
+
+// Steps to the target from every square of the map, for movers of one
+// footprint size. Built once and shared by everyone chasing that target.
+struct FlowField
+{
+  static constexpr std::uint16_t kUnreachable = UINT16_MAX;
+
+  GridPos target {};
+  int width {1};
+  int height {1};
+  int columns {0};
+  std::vector<std::uint16_t> distance {};
+
+  std::uint16_t Distance(GridPos from) const;
+
+  // Neighbor of from one step closer to the target; from itself once the
+  // footprint covers the target or when it cannot be reached.
+  GridPos Next(GridPos from) const;
+};
+
+
+// Pathfinding over the walls of a BattleMap for movers whose top left
+// square is moved and whose width x height footprint must stay off walls.
+// Moves go to the 8 neighbors at a cost of one square each, without
+// cutting wall corners. A path is done once the footprint covers the goal.
+//
+// Other creatures are not obstacles to planning; BattleMap::Move refuses a
+// step onto one and the mover waits or replans.
+//
+// Results are cached. Every result remembers the box of squares its search
+// looked at, and MarkWallChanged drops only the results whose box holds the
+// changed square: a square the search never looked at cannot change it.
+class Pathfinder
+{
+public:
+  explicit Pathfinder(const BattleMap& map);
+
+  // A* from start, start excluded; empty when there is no path or start
+  // already covers goal. Valid until the next call on the Pathfinder.
+  std::span<const GridPos> FindPath(GridPos start, GridPos goal, int width = 1, int height = 1);
+
+  // Valid until it is invalidated by MarkWallChanged or evicted by
+  // kMaxFlowFields newer fields.
+  const FlowField& FlowFieldTo(GridPos target, int width = 1, int height = 1);
+
+  void MarkWallChanged(GridPos cell);
+
+  std::size_t CachedPaths() const;
+
+  std::size_t CachedFlowFields() const;
+
+private:
+  static constexpr std::size_t kMaxCachedPaths = 4096;
+  static constexpr std::size_t kMaxFlowFields = 16;
+
+  // Squares looked at by a search, inclusive
+  struct Region
+  {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+
+    void Add(GridPos pos);
+
+    // Grows the box of expanded squares into everything their steps looked
+    // at: the squares around them and the footprints placed there.
+    void Expand(int width, int height);
+
+    bool Contains(GridPos cell) const;
+  };
+
+  struct PathKey
+  {
+    GridPos start;
+    GridPos goal;
+    int width;
+    int height;
+
+    bool operator==(const PathKey& other) const = default;
+  };
+
+  struct PathKeyHash
+  {
+    std::size_t operator()(const PathKey& key) const;
+  };
+
+  struct CachedPath
+  {
+    std::vector<GridPos> path;
+    Region region;
+  };
+
+  struct CachedField
+  {
+    FlowField field;
+    Region region;
+  };
+
+  struct Passability
+  {
+    int width;
+    int height;
+    std::vector<std::uint8_t> passable;
+  };
+
+  struct HeapEntry
+  {
+    int f;
+    int g;
+    std::uint32_t cell;
+  };
+
+  // Where a width x height footprint fits between the walls, one byte per
+  // square, built on first use and dropped when a wall changes.
+  const std::vector<std::uint8_t>& PassableGrid(int width, int height);
+
+  CachedPath Search(GridPos start, GridPos goal, int width, int height);
+
+  const BattleMap& _map;
+
+  // Node pool of A*, one node per square. A node belongs to the current
+  // search only when its stamp matches, so nothing is cleared between runs.
+  std::vector<std::uint32_t> _stamp;
+  std::vector<int> _g;
+  std::vector<std::uint32_t> _parent;
+  std::vector<HeapEntry> _open;
+  std::vector<std::uint32_t> _queue;
+  std::uint32_t _search {0};
+
+  std::unordered_map<PathKey, CachedPath, PathKeyHash> _paths;
+  std::list<CachedField> _fields;
+  std::vector<Passability> _passability;
+};
+
+
+#endif // __PATHFINDER_H__
@@ -0,0 +1,67 @@
+#ifndef __CREATURE_STATE_H__
+#define __CREATURE_STATE_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// The per-creature values a session changes as it is played, as opposed to
+// statblocks, which a replay gets from the bestiary.
+enum class StateField : std::uint8_t
+{
+  HIT_POINTS = 0,
+  X = 1,
+  Y = 2,
+  INITIATIVE = 3,
+};
+
+constexpr int kNumStateFields = 4;
+
+// Creature state in copy-on-write pages of kPageSize creatures. Copying it
+// (Snapshot) only shares the pages; the first Set into a shared page copies
+// that page alone, so a periodic snapshot of a large session costs a pointer
+// per page plus the pages touched before the next one.
+class CreatureState
+{
+public:
+  static constexpr std::size_t kPageSize = 256;
+
+  std::size_t Size() const;
+
+  // New creatures start with every field at 0.
+  void Resize(std::size_t count);
+
+  int Get(std::uint32_t creature, StateField field) const;
+
+  void Set(std::uint32_t creature, StateField field, int value);
+
+  CreatureState Snapshot() const;
+
+  // Pages shared with snapshots or other copies
+  std::size_t SharedPages() const;
+
+  // Varint encoding, each field delta coded along the creatures.
+  void Encode(std::vector<std::uint8_t>& out) const;
+
+  bool Decode(std::span<const std::uint8_t> in);
+
+  bool operator==(const CreatureState& other) const;
+
+private:
+  struct Page
+  {
+    // Field major: all hit points of the page, then all X, ...
+    std::array<int, kPageSize * kNumStateFields> values {};
+  };
+
+  static std::size_t Slot(std::uint32_t creature, StateField field);
+
+  std::vector<std::shared_ptr<Page>> _pages;
+  std::size_t _size {0};
+};
+
+
+#endif // __CREATURE_STATE_H__
@@ -0,0 +1,208 @@
+#ifndef __REPLAY_LOG_H__
+#define __REPLAY_LOG_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "replay/CreatureState.h"
+#include "rules/Roll.h"
+
+enum class ReplayEventType : std::uint8_t
+{
+  TICK = 0,
+  DICE = 1,
+  KEY = 2,
+  STATE = 3,
+};
+
+struct ReplayEvent
+{
+  ReplayEventType type {ReplayEventType::TICK};
+  std::uint64_t tick {0};       // Tick the event belongs to; of a TICK, the one it starts
+  int nDice {0};                // DICE
+  int facesDie {0};
+  Roll mode {Roll::STRIGHT};
+  std::uint32_t creature {0};   // STATE
+  StateField field {StateField::HIT_POINTS};
+  int value {0};                // Dice result, key, or the new value of the field
+};
+
+
+// Append-only session log. Events are varints, mostly two to four bytes;
+// ticks without events cost nothing, a run of them is one record. Every
+// snapshotInterval ticks the creature state is snapshotted (a copy-on-write
+// share, not a copy) and written to the "<path>.snapshots" sidecar at the
+// next Flush, with the log offset it starts from.
+class ReplayWriter
+{
+public:
+  explicit ReplayWriter(std::uint32_t snapshotInterval = 600);
+
+  ~ReplayWriter();
+
+  ReplayWriter(const ReplayWriter&) = delete;
+  ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+  // tickRate is only stored, so a replay can tell how fast it ran against
+  // real time. The state at tick 0 is the first snapshot.
+  bool Open(const std::string& path, const CreatureState& state, std::uint32_t tickRate = 60);
+
+  // Flushes and closes; also removes a dice hook installed by RecordDice.
+  void Close();
+
+  // Logs the result of every Die call the calling thread makes from now on.
+  void RecordDice();
+
+  void Dice(int nDice, int facesDie, Roll mode, int result);
+
+  void Key(int key);
+
+  // Sets the field and logs the change, if it is one.
+  void Set(CreatureState& state, std::uint32_t creature, StateField field, int value);
+
+  // Starts the next tick, snapshotting state when one is due. Call it first
+  // thing in the game's tick, so what the tick does is logged under it.
+  void Tick(const CreatureState& state);
+
+  // Writes buffered events and pending snapshots.
+  void Flush();
+
+  std::uint64_t CurrentTick() const;
+
+  std::uint64_t BytesWritten() const;
+
+private:
+  struct PendingSnapshot
+  {
+    std::uint64_t tick;
+    std::uint64_t offset;
+    CreatureState state;
+  };
+
+  static constexpr std::size_t kFlushBytes = 64 * 1024;
+
+  void PutTicks();
+
+  void MaybeFlush();
+
+  std::uint32_t _snapshot_interval;
+  std::FILE* _log {nullptr};
+  std::FILE* _snapshots {nullptr};
+  std::vector<std::uint8_t> _buffer;
+  std::vector<PendingSnapshot> _pending;
+  std::uint64_t _written {0};
+  std::uint64_t _tick {0};
+  std::uint64_t _unwritten_ticks {0};
+  bool _hooked {false};
+};
+
+
+// Read-only memory mapping of a session log and its snapshots. Seek starts
+// from the closest snapshot at or before the tick, so reaching any point of a
+// long session decodes at most one snapshot interval of events.
+class ReplayReader
+{
+public:
+  ReplayReader() = default;
+
+  ~ReplayReader();
+
+  ReplayReader(const ReplayReader&) = delete;
+  ReplayReader& operator=(const ReplayReader&) = delete;
+
+  bool Open(const std::string& path);
+
+  void Close();
+
+  std::uint32_t TickRate() const;
+
+  // Where the session ended: Seek(LastTick()) gives its final state.
+  std::uint64_t LastTick() const;
+
+  std::size_t NumSnapshots() const;
+
+  std::uint64_t SnapshotTick(std::size_t index) const;
+
+  // Moves to the start of tick, with state as it was at that point.
+  bool Seek(std::uint64_t tick, CreatureState& state);
+
+  // Back to tick 0 by applying every event from the start, i.e. what Seek
+  // would cost without snapshots.
+  bool SeekFromStart(std::uint64_t tick, CreatureState& state);
+
+  // Decodes the next event, a TICK when the session moves on. A run of ticks
+  // going past maxTick stops there and continues on the next call. Returns
+  // false at the end of the log or on a corrupt record.
+  bool Next(ReplayEvent& event, std::uint64_t maxTick = UINT64_MAX);
+
+  bool Peek(ReplayEvent& event) const;
+
+  std::uint64_t CurrentTick() const;
+
+private:
+  struct SnapshotEntry
+  {
+    std::uint64_t tick;
+    std::uint64_t offset;
+    const std::uint8_t* data;
+    std::size_t size;
+  };
+
+  bool Decode(const std::uint8_t*& it, ReplayEvent& event) const;
+
+  bool SeekFrom(const SnapshotEntry& snapshot, std::uint64_t tick, CreatureState& state);
+
+  const std::uint8_t* _log {nullptr};
+  std::size_t _log_size {0};
+  const std::uint8_t* _snapshot_data {nullptr};
+  std::size_t _snapshot_size {0};
+  std::vector<SnapshotEntry> _snapshots;
+  std::uint32_t _tick_rate {60};
+  std::uint64_t _last_tick {0};
+
+  const std::uint8_t* _cursor {nullptr};
+  std::uint64_t _tick {0};
+  std::uint64_t _owed_ticks {0};    // Of a tick record Seek stopped inside of
+};
+
+
+// Headless replay: state changes are applied as they were recorded, keys
+// and ticks go to the callbacks so game code can be driven again, and the
+// Die rolls that code makes on this thread are answered from the log. A roll
+// the log does not have next (the code took another path) counts as a
+// desync and is rolled for real.
+class ReplaySession
+{
+public:
+  using OnKey = std::function<void(int key)>;
+  using OnTick = std::function<void(std::uint64_t tick)>;
+
+  ReplaySession(ReplayReader& reader, CreatureState& state);
+
+  ~ReplaySession();
+
+  ReplaySession(const ReplaySession&) = delete;
+  ReplaySession& operator=(const ReplaySession&) = delete;
+
+  // Plays from the reader's position up to the start of untilTick, as fast
+  // as it decodes. onTick runs once per tick, before the tick's events, so
+  // onTick(untilTick) is left for the next Run. Returns the tick reached.
+  std::uint64_t Run(std::uint64_t untilTick, const OnKey& onKey = {}, const OnTick& onTick = {});
+
+  std::size_t Desyncs() const;
+
+private:
+  int AnswerRoll(int nDice, int facesDie, Roll mode);
+
+  ReplayReader* _reader;
+  CreatureState* _state;
+  std::size_t _desyncs {0};
+  std::uint64_t _ticked {0};      // Last tick onTick ran for
+};
+
+
+#endif // __REPLAY_LOG_H__
@@ -0,0 +1,47 @@
+#ifndef __VARINT_H__
+#define __VARINT_H__
+
+#include <cstdint>
+#include <vector>
+
+// LEB128 style: 7 bits per byte, low bits first, high bit set on every byte
+// but the last. Values below 128 take one byte.
+inline void PutVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Advances it past the varint. Returns false on a truncated or overlong one.
+inline bool GetVarint(const std::uint8_t*& it, const std::uint8_t* end, std::uint64_t& value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64 && it != end; shift += 7)
+  {
+    const std::uint8_t byte = *it++;
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Maps small negative numbers to small varints: 0, -1, 1, -2, 2 -> 0, 1, 2, 3, 4
+inline std::uint64_t ZigZag(std::int64_t value)
+{
+  return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t UnZigZag(std::uint64_t value)
+{
+  return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+
+#endif // __VARINT_H__
@@ -0,0 +1,170 @@
+#ifndef __ABILITY_TABLES_H__
+#define __ABILITY_TABLES_H__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include "rules/Roll.h"
+
+// The numbers of the rules as tables built at compile time, so looking one
+// up is a clamp and a load: the ability modifier of every score, and the
+// proficiency bonus of every character level and challenge rating.
+
+constexpr int kMaxScore = 30;
+constexpr int kMaxLevel = 20;
+constexpr int kMaxCR = 30;
+
+consteval std::array<std::int8_t, kMaxScore + 1> AbilityModifierTable()
+{
+  std::array<std::int8_t, kMaxScore + 1> table {};
+  for (int score = 0; score <= kMaxScore; score++)
+  {
+    // floor((score - 10) / 2); integer division rounds toward zero
+    const int above = score - 10;
+    table[score] = static_cast<std::int8_t>(above >= 0 ? above / 2 : -((1 - above) / 2));
+  }
+  return table;
+}
+
+// Index 0 is level 1: +2, going up by one every four levels
+consteval std::array<std::int8_t, kMaxLevel> ProficiencyByLevelTable()
+{
+  std::array<std::int8_t, kMaxLevel> table {};
+  for (int level = 1; level <= kMaxLevel; level++)
+  {
+    table[level - 1] = static_cast<std::int8_t>(2 + (level - 1) / 4);
+  }
+  return table;
+}
+
+// By whole CR, fractions counting as 0: +2 up to CR 4, then one more every
+// four CRs up to +9 at CR 29 and 30
+consteval std::array<std::int8_t, kMaxCR + 1> ProficiencyByCRTable()
+{
+  std::array<std::int8_t, kMaxCR + 1> table {};
+  for (int cr = 0; cr <= kMaxCR; cr++)
+  {
+    table[cr] = static_cast<std::int8_t>(2 + std::max(cr - 1, 0) / 4);
+  }
+  return table;
+}
+
+inline constexpr std::array<std::int8_t, kMaxScore + 1> kAbilityModifiers = AbilityModifierTable();
+inline constexpr std::array<std::int8_t, kMaxLevel> kProficiencyByLevel = ProficiencyByLevelTable();
+inline constexpr std::array<std::int8_t, kMaxCR + 1> kProficiencyByCR = ProficiencyByCRTable();
+
+// Scores outside 0-30 take the modifier of the nearest end
+constexpr int AbilityModifier(int score)
+{
+  return kAbilityModifiers[std::clamp(score, 0, kMaxScore)];
+}
+
+constexpr int ProficiencyBonus(int level)
+{
+  return kProficiencyByLevel[std::clamp(level, 1, kMaxLevel) - 1];
+}
+
+constexpr int ProficiencyBonusForCR(float cr)
+{
+  return kProficiencyByCR[std::clamp(static_cast<int>(cr), 0, kMaxCR)];
+}
+
+// 8 + proficiency + modifier, the DC of a monster's or caster's effects
+constexpr int SaveDC(int proficiencyBonus, int score)
+{
+  return 8 + proficiencyBonus + AbilityModifier(score);
+}
+
+static_assert(AbilityModifier(1) == -5 && AbilityModifier(9) == -1 && AbilityModifier(10) == 0 &&
+              AbilityModifier(11) == 0 && AbilityModifier(20) == 5 && AbilityModifier(30) == 10);
+static_assert(ProficiencyBonus(1) == 2 && ProficiencyBonus(5) == 3 && ProficiencyBonus(17) == 6 &&
+              ProficiencyBonus(20) == 6);
+static_assert(ProficiencyBonusForCR(0.25f) == 2 && ProficiencyBonusForCR(4) == 2 &&
+              ProficiencyBonusForCR(5) == 3 && ProficiencyBonusForCR(16) == 5 &&
+              ProficiencyBonusForCR(17) == 6 && ProficiencyBonusForCR(30) == 9);
+
+// AbilityModifier without the clamp and the load, for loops over whole
+// columns of scores in 0-30: a shift vectorizes, a table lookup does not.
+// Checked against the table below.
+constexpr int FastAbilityModifier(int score)
+{
+  return (score >> 1) - 5;
+}
+
+consteval bool FastModifiersMatchTable()
+{
+  for (int score = 0; score <= kMaxScore; score++)
+  {
+    if (FastAbilityModifier(score) != kAbilityModifiers[score])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(FastModifiersMatchTable());
+
+
+// The d20 a roll in Mode keeps of the two rolled for it. The second is only
+// read with advantage or disadvantage.
+template <Roll Mode>
+constexpr int KeepD20(int first, int second)
+{
+  if constexpr (Mode == Roll::ADVANTAGE)
+  {
+    return std::max(first, second);
+  }
+  else if constexpr (Mode == Roll::DISADVANTAGE)
+  {
+    return std::min(first, second);
+  }
+  else
+  {
+    return first;
+  }
+}
+
+// Calls fn(std::integral_constant<Roll, mode>{}): the one branch on a
+// runtime mode, taken before a loop rather than inside it.
+template <typename Fn>
+decltype(auto) DispatchRoll(Roll mode, Fn&& fn)
+{
+  switch (mode)
+  {
+    case Roll::ADVANTAGE:
+      return fn(std::integral_constant<Roll, Roll::ADVANTAGE> {});
+    case Roll::DISADVANTAGE:
+      return fn(std::integral_constant<Roll, Roll::DISADVANTAGE> {});
+    default:
+      return fn(std::integral_constant<Roll, Roll::STRIGHT> {});
+  }
+}
+
+// Saving throws or ability checks of a column of scores against one DC:
+// success[i] is 1 when KeepD20<Mode>(first[i], second[i]) plus the
+// modifier of scores[i], a score in 0-30, reaches dc. No branch per roll.
+template <Roll Mode>
+void ResolveChecks(std::span<const int> first,
+                   std::span<const int> second,
+                   std::span<const int> scores,
+                   int dc,
+                   std::span<std::uint8_t> success)
+{
+  const std::size_t count = success.size();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    int d20 = first[i];
+    if constexpr (Mode != Roll::STRIGHT)
+    {
+      d20 = KeepD20<Mode>(first[i], second[i]);
+    }
+    success[i] = static_cast<std::uint8_t>(d20 + FastAbilityModifier(scores[i]) >= dc);
+  }
+}
+
+
+#endif // __ABILITY_TABLES_H__
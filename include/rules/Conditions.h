@@ -0,0 +1,158 @@
+#ifndef __CONDITIONS_H__
+#define __CONDITIONS_H__
+
+#include <cstdint>
+
+#include "rules/Roll.h"
+#include "rules/Stats.h"
+
+// The conditions of the rules; the values are bit positions in a
+// ConditionSet. Exhaustion is a flag here, its level is not tracked.
+enum class Condition : std::uint8_t
+{
+    BLINDED = 0,
+    CHARMED = 1,
+    DEAFENED = 2,
+    EXHAUSTION = 3,
+    FRIGHTENED = 4,
+    GRAPPLED = 5,
+    INCAPACITATED = 6,
+    INVISIBLE = 7,
+    PARALYZED = 8,
+    PETRIFIED = 9,
+    POISONED = 10,
+    PRONE = 11,
+    RESTRAINED = 12,
+    STUNNED = 13,
+    UNCONSCIOUS = 14,
+};
+
+constexpr int kNumConditions = 15;
+
+// Bits from here on are free for custom flags (Bless, Dodge, Reckless Attack)
+constexpr int kFirstCustomFlag = 16;
+constexpr int kNumCustomFlags = 64 - kFirstCustomFlag;
+
+
+// Conditions and custom flags of one creature, one bit each, so that testing
+// whether a creature is, say, unable to act is a single AND.
+class ConditionSet
+{
+public:
+  constexpr ConditionSet() = default;
+
+  constexpr explicit ConditionSet(std::uint64_t bits)
+    : _bits(bits)
+  {
+
+  }
+
+  constexpr ConditionSet(Condition condition)
+    : _bits(std::uint64_t{1} << static_cast<int>(condition))
+  {
+
+  }
+
+  static constexpr ConditionSet CustomFlag(int flag)
+  {
+    return ConditionSet(std::uint64_t{1} << (kFirstCustomFlag + flag));
+  }
+
+  constexpr std::uint64_t Bits() const
+  {
+    return _bits;
+  }
+
+  constexpr bool Has(ConditionSet other) const
+  {
+    return (_bits & other._bits) != 0;
+  }
+
+  constexpr bool Empty() const
+  {
+    return _bits == 0;
+  }
+
+  constexpr ConditionSet operator|(ConditionSet other) const
+  {
+    return ConditionSet(_bits | other._bits);
+  }
+
+  constexpr ConditionSet operator&(ConditionSet other) const
+  {
+    return ConditionSet(_bits & other._bits);
+  }
+
+  constexpr ConditionSet operator~() const
+  {
+    return ConditionSet(~_bits);
+  }
+
+  constexpr ConditionSet& operator|=(ConditionSet other)
+  {
+    _bits |= other._bits;
+    return *this;
+  }
+
+  constexpr ConditionSet& operator&=(ConditionSet other)
+  {
+    _bits &= other._bits;
+    return *this;
+  }
+
+  constexpr bool operator==(const ConditionSet& other) const = default;
+
+private:
+  std::uint64_t _bits {0};
+};
+
+constexpr ConditionSet operator|(Condition a, Condition b)
+{
+  return ConditionSet(a) | ConditionSet(b);
+}
+
+
+// Which flags grant advantage or impose disadvantage. The defaults are the
+// rules' conditions; custom flags join by being or'ed into a mask, e.g.
+// Reckless Attack into attackerAdvantage and targetAdvantage.
+struct RollRules
+{
+  // On the attacker's side
+  ConditionSet attackerAdvantage {Condition::INVISIBLE};
+  ConditionSet attackerDisadvantage {Condition::BLINDED | Condition::FRIGHTENED | Condition::POISONED |
+                                     Condition::PRONE | Condition::RESTRAINED};
+  // On the target's side
+  ConditionSet targetAdvantage {Condition::BLINDED | Condition::PARALYZED | Condition::PETRIFIED |
+                                Condition::RESTRAINED | Condition::STUNNED | Condition::UNCONSCIOUS};
+  ConditionSet targetDisadvantage {Condition::INVISIBLE};
+  // Prone targets are easier to hit from within 5 feet, harder from further
+  ConditionSet targetAdvantageInMelee {Condition::PRONE};
+  ConditionSet targetDisadvantageAtRange {Condition::PRONE};
+
+  ConditionSet checkDisadvantage {Condition::FRIGHTENED | Condition::POISONED};
+  ConditionSet dexSaveDisadvantage {Condition::RESTRAINED};
+  // Fail STR and DEX saving throws outright
+  ConditionSet failsStrDexSaves {Condition::PARALYZED | Condition::PETRIFIED | Condition::STUNNED |
+                                 Condition::UNCONSCIOUS};
+  // Melee hits against these are critical hits
+  ConditionSet meleeCritical {Condition::PARALYZED | Condition::UNCONSCIOUS};
+  // Cannot take actions or reactions, and lose concentration
+  ConditionSet incapacitating {Condition::INCAPACITATED | Condition::PARALYZED | Condition::PETRIFIED |
+                               Condition::STUNNED | Condition::UNCONSCIOUS};
+};
+
+// Advantage and disadvantage cancel out, however many sources each has.
+Roll CombineModes(bool advantage, bool disadvantage);
+
+Roll AttackRollMode(ConditionSet attacker, ConditionSet target, bool melee, const RollRules& rules = {});
+
+Roll AbilityCheckMode(ConditionSet creature, const RollRules& rules = {});
+
+Roll SavingThrowMode(ConditionSet creature, Stats stat, const RollRules& rules = {});
+
+bool FailsSavingThrow(ConditionSet creature, Stats stat, const RollRules& rules = {});
+
+bool IsIncapacitated(ConditionSet creature, const RollRules& rules = {});
+
+
+#endif // __CONDITIONS_H__
@@ -0,0 +1,63 @@
+#ifndef __DICE_DISTRIBUTION_H__
+#define __DICE_DISTRIBUTION_H__
+
+#include <cstddef>
+#include <vector>
+
+#include "rules/DiceSpec.h"
+#include "rules/Roll.h"
+
+// Exact probability distribution of an integer valued roll, stored as a
+// dense PMF starting at Min() plus its cumulative sum, so every query is a
+// lookup.
+class DiceDistribution
+{
+public:
+  DiceDistribution();
+
+  static DiceDistribution Constant(int value);
+
+  // Distribution of a single die with facesDie faces.
+  static DiceDistribution Uniform(int facesDie);
+
+  // Memoized distribution of a dice term. The reference stays valid for the
+  // lifetime of the program.
+  static const DiceDistribution& Of(const DiceSpec& spec);
+
+  // 1d20 rolled straight, with advantage or with disadvantage.
+  static const DiceDistribution& D20(Roll mode);
+
+  // Distribution of the sum of two independent rolls.
+  DiceDistribution operator+(const DiceDistribution& other) const;
+
+  DiceDistribution operator+(int modifier) const;
+
+  DiceDistribution operator-() const;
+
+  // P(X == value)
+  double Pmf(int value) const;
+
+  // P(X <= value)
+  double Cdf(int value) const;
+
+  // P(X >= value), e.g. the chance of meeting an armor class
+  double AtLeast(int value) const;
+
+  double Mean() const;
+
+  int Min() const;
+
+  int Max() const;
+
+private:
+  DiceDistribution(int min, std::vector<double> pmf);
+
+  static DiceDistribution Compute(const DiceSpec& spec);
+
+  int _min {0};
+  std::vector<double> _pmf {1.0};
+  std::vector<double> _cdf {1.0};
+};
+
+
+#endif //__DICE_DISTRIBUTION_H__
@@ -0,0 +1,54 @@
+#ifndef __DICE_ENGINE_H__
+#define __DICE_ENGINE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "rules/DiceSpec.h"
+
+// Bulk dice roller. Every thread owns its own engine (see ThreadLocal()), so
+// rolling never touches shared state. Random numbers come from kLanes
+// interleaved xoshiro256** streams stored lane-major, which lets the
+// generation and range-reduction loops be auto-vectorized.
+class DiceEngine
+{
+public:
+  static constexpr std::size_t kLanes = 4;
+  static constexpr std::size_t kBlockSize = 256;
+
+  explicit DiceEngine(std::uint64_t seed);
+
+  // Seeds the engine with the stream number `stream` of `seed`. Engines with
+  // the same seed and stream always produce the same rolls, which is what
+  // reproducible simulations rely on.
+  DiceEngine(std::uint64_t seed, std::uint64_t stream);
+
+  void Seed(std::uint64_t seed, std::uint64_t stream = 0);
+
+  // Writes nDice individual rolls of a die with facesDie faces into out.
+  // Only min(nDice, out.size()) values are written.
+  void RollMany(int nDice, int facesDie, std::span<int> out);
+
+  // Sum of nDice rolls of a die with facesDie faces.
+  int RollSum(int nDice, int facesDie);
+
+  // Result of a whole dice term: keep, reroll, explode and modifier included.
+  int Roll(const DiceSpec& spec);
+
+  // Single uniformly distributed value in [1, facesDie].
+  int RollOne(int facesDie);
+
+  std::uint64_t Next();
+
+  // Engine of the calling thread, lazily seeded from std::random_device.
+  static DiceEngine& ThreadLocal();
+
+private:
+  void FillWords(std::uint32_t* words, std::size_t count);
+
+  std::uint64_t _state[4][kLanes] {};
+};
+
+
+#endif //__DICE_ENGINE_H__
@@ -0,0 +1,279 @@
+#ifndef __DICE_EXPRESSION_H__
+#define __DICE_EXPRESSION_H__
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "rules/DiceDistribution.h"
+#include "rules/DiceEngine.h"
+#include "rules/DiceSpec.h"
+
+struct DiceTerm
+{
+  DiceSpec spec {};
+  bool negative {false};
+
+  bool operator==(const DiceTerm& other) const = default;
+};
+
+// Parsed dice notation, e.g. "4d6kh3+2", "1d20adv+5", "8d6!", "2d6r2+1d4-1".
+// It is a flat list of dice terms plus a constant, small enough to be used
+// as a template argument (see RollCompiled).
+//
+// Term suffixes: kh<N>/k<N> keep highest, kl<N> keep lowest, dl<N>/dh<N> drop
+// lowest/highest, adv/dis (single die only), r<N> reroll results <= N once
+// (r alone rerolls 1s), ! exploding. "d%" is a d100.
+struct DiceExpression
+{
+  static constexpr std::size_t kMaxTerms = 8;
+
+  std::array<DiceTerm, kMaxTerms> terms {};
+  std::size_t count {0};
+  int modifier {0};
+
+  bool operator==(const DiceExpression& other) const = default;
+
+  // Throws std::invalid_argument on malformed input. During constant
+  // evaluation that turns into a compile error.
+  static constexpr DiceExpression Parse(std::string_view text);
+
+  // Parses text once per program run and returns the cached expression.
+  static const DiceExpression& Intern(std::string_view text);
+
+  int Roll(DiceEngine& engine) const;
+
+  int Roll() const;
+
+  // Memoized exact distribution of the whole expression.
+  const DiceDistribution& Distribution() const;
+
+  // Exact expected value. Plain dice are summed in closed form; only terms
+  // that keep, reroll or explode look up their distribution.
+  double Mean() const;
+};
+
+
+struct DiceExpressionHash
+{
+  std::size_t operator()(const DiceExpression& expr) const
+  {
+    std::size_t h = std::hash<int>{}(expr.modifier);
+    for (std::size_t i = 0; i < expr.count; i++)
+    {
+      h = h * 1000003u ^ DiceSpecHash{}(expr.terms[i].spec);
+      h = h * 1000003u ^ static_cast<std::size_t>(expr.terms[i].negative);
+    }
+    return h;
+  }
+};
+
+
+consteval DiceExpression operator""_dice(const char* text, std::size_t length)
+{
+  return DiceExpression::Parse(std::string_view(text, length));
+}
+
+
+// Rolls an expression known at compile time, e.g. RollCompiled<"2d6+3"_dice>().
+// Parsing happens at compile time and the term loop is unrolled.
+template <DiceExpression Expr>
+int RollCompiled(DiceEngine& engine = DiceEngine::ThreadLocal())
+{
+  int total = Expr.modifier;
+
+  [&]<std::size_t... I>(std::index_sequence<I...>)
+  {
+    ((total += (Expr.terms[I].negative ? -1 : 1) *
+               (Expr.terms[I].spec.IsPlainSum()
+                    ? engine.RollSum(Expr.terms[I].spec.nDice, Expr.terms[I].spec.facesDie)
+                    : engine.Roll(Expr.terms[I].spec))),
+     ...);
+  }(std::make_index_sequence<Expr.count>{});
+
+  return total;
+}
+
+
+namespace dice_notation
+{
+
+constexpr bool IsDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+constexpr void SkipSpaces(std::string_view text, std::size_t& pos)
+{
+  while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+  {
+    pos++;
+  }
+}
+
+// Returns -1 when there is no number at pos.
+constexpr int ParseNumber(std::string_view text, std::size_t& pos)
+{
+  if (pos >= text.size() || !IsDigit(text[pos]))
+  {
+    return -1;
+  }
+
+  int value = 0;
+  while (pos < text.size() && IsDigit(text[pos]))
+  {
+    value = value * 10 + (text[pos] - '0');
+    if (value > 1'000'000)
+    {
+      throw std::invalid_argument("dice notation: number too large");
+    }
+    pos++;
+  }
+  return value;
+}
+
+constexpr bool Consume(std::string_view text, std::size_t& pos, std::string_view token)
+{
+  if (text.substr(pos, token.size()) == token)
+  {
+    pos += token.size();
+    return true;
+  }
+  return false;
+}
+
+constexpr int ParseCount(std::string_view text, std::size_t& pos)
+{
+  const int value = ParseNumber(text, pos);
+  if (value < 0)
+  {
+    throw std::invalid_argument("dice notation: expected a number");
+  }
+  return value;
+}
+
+// Number of dice kept or dropped, between 1 and most.
+constexpr int ParseKeep(std::string_view text, std::size_t& pos, int most)
+{
+  const int value = ParseCount(text, pos);
+  if (value < 1 || value > most)
+  {
+    throw std::invalid_argument("dice notation: keeps or drops an invalid number of dice");
+  }
+  return value;
+}
+
+constexpr void ParseSuffixes(std::string_view text, std::size_t& pos, DiceSpec& spec)
+{
+  while (pos < text.size())
+  {
+    if (Consume(text, pos, "adv") || Consume(text, pos, "dis"))
+    {
+      if (spec.nDice != 1)
+      {
+        throw std::invalid_argument("dice notation: adv/dis needs a single die");
+      }
+      spec.keepHighest = text[pos - 3] == 'a';
+      spec.nDice = 2;
+      spec.keep = 1;
+    }
+    else if (Consume(text, pos, "kh") || Consume(text, pos, "kl"))
+    {
+      spec.keepHighest = text[pos - 1] == 'h';
+      spec.keep = ParseKeep(text, pos, spec.nDice);
+    }
+    else if (Consume(text, pos, "dl") || Consume(text, pos, "dh"))
+    {
+      spec.keepHighest = text[pos - 1] == 'l';
+      spec.keep = spec.nDice - ParseKeep(text, pos, spec.nDice - 1);
+    }
+    else if (Consume(text, pos, "k"))
+    {
+      spec.keepHighest = true;
+      spec.keep = ParseKeep(text, pos, spec.nDice);
+    }
+    else if (Consume(text, pos, "r"))
+    {
+      const int below = ParseNumber(text, pos);
+      spec.rerollBelow = below < 0 ? 1 : below;
+    }
+    else if (Consume(text, pos, "!"))
+    {
+      spec.explode = true;
+    }
+    else
+    {
+      return;
+    }
+  }
+}
+
+}
+
+
+constexpr DiceExpression DiceExpression::Parse(std::string_view text)
+{
+  using namespace dice_notation;
+
+  DiceExpression expr;
+  std::size_t pos = 0;
+  bool negative = false;
+
+  SkipSpaces(text, pos);
+  if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+  {
+    negative = text[pos] == '-';
+    pos++;
+  }
+
+  while (true)
+  {
+    SkipSpaces(text, pos);
+
+    const int number = ParseNumber(text, pos);
+    if (pos < text.size() && text[pos] == 'd')
+    {
+      pos++;
+
+      DiceSpec spec;
+      spec.nDice = number < 0 ? 1 : number;
+      spec.facesDie = Consume(text, pos, "%") ? 100 : ParseNumber(text, pos);
+      if (spec.facesDie <= 0 || spec.nDice <= 0)
+      {
+        throw std::invalid_argument("dice notation: expected dice such as 2d6");
+      }
+      ParseSuffixes(text, pos, spec);
+
+      if (expr.count == kMaxTerms)
+      {
+        throw std::invalid_argument("dice notation: too many dice terms");
+      }
+      expr.terms[expr.count++] = DiceTerm {spec, negative};
+    }
+    else if (number >= 0)
+    {
+      expr.modifier += negative ? -number : number;
+    }
+    else
+    {
+      throw std::invalid_argument("dice notation: expected a number or dice");
+    }
+
+    SkipSpaces(text, pos);
+    if (pos == text.size())
+    {
+      return expr;
+    }
+    if (text[pos] != '+' && text[pos] != '-')
+    {
+      throw std::invalid_argument("dice notation: unexpected character");
+    }
+    negative = text[pos] == '-';
+    pos++;
+  }
+}
+
+
+#endif //__DICE_EXPRESSION_H__
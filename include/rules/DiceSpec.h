@@ -0,0 +1,42 @@
+#ifndef __DICE_SPEC_H__
+#define __DICE_SPEC_H__
+
+#include <cstddef>
+#include <functional>
+
+// One dice term, e.g. 4d6 keep highest 3, 2d6 rerolling 1s and 2s, 8d6!
+struct DiceSpec
+{
+  int nDice {1};
+  int facesDie {20};
+  int keep {0};             // Number of dice kept, 0 keeps all of them
+  bool keepHighest {true};
+  int rerollBelow {0};      // Results <= rerollBelow are rerolled once
+  bool explode {false};     // A die showing its highest face is rolled again
+  int modifier {0};
+
+  bool operator==(const DiceSpec& other) const = default;
+
+  // True when the term is just the sum of its dice.
+  constexpr bool IsPlainSum() const
+  {
+    return (keep == 0 || keep >= nDice) && rerollBelow == 0 && !explode;
+  }
+};
+
+struct DiceSpecHash
+{
+  std::size_t operator()(const DiceSpec& spec) const
+  {
+    std::size_t h = 0;
+    for (int field : {spec.nDice, spec.facesDie, spec.keep, static_cast<int>(spec.keepHighest),
+                      spec.rerollBelow, static_cast<int>(spec.explode), spec.modifier})
+    {
+      h = h * 1000003u ^ std::hash<int>{}(field);
+    }
+    return h;
+  }
+};
+
+
+#endif //__DICE_SPEC_H__
@@ -1,6 +1,8 @@
 #ifndef __ROLL_H__
 #define __ROLL_H__
 
+#include <functional>
+
 enum class Roll
 {
     STRIGHT = 1,
@@ -9,12 +11,24 @@ enum class Roll
 };
 
 
+// Thin wrappers over the calling thread's DiceEngine.
 class Die
 {
 public:
+  // Produces the result of one Die call instead of the DiceEngine, e.g. to
+  // record a session or to answer rolls from a recorded one. Advantage and
+  // disadvantage come in as one d20 with their mode.
+  using Hook = std::function<int(int nDice, int facesDie, ::Roll mode)>;
+
   static int Roll(int nDice, int facesDie);
   static int RollAdvantage();
   static int RollDisadvantage();
+
+  // Installs hook for the calling thread only; an empty hook removes it.
+  static void SetHook(Hook hook);
+
+  // What the calling thread's DiceEngine rolls, bypassing any hook.
+  static int RollUnhooked(int nDice, int facesDie, ::Roll mode);
   
 };
 
@@ -1,6 +1,9 @@
 #ifndef __STATS_H__
 #define __STATS_H__
 
+#include <array>
+#include <cstddef>
+
 enum class Stats
 {
     STR = 1,
@@ -18,4 +21,48 @@ enum class Skills
 };
 
 
+constexpr int kNumStats = 6;
+
+constexpr Stats kAllStats[kNumStats] = {Stats::STR, Stats::DEX, Stats::CON, Stats::WIS, Stats::INT, Stats::CHA};
+
+// Position of a stat in an array of kNumStats; Stats starts at 1
+constexpr std::size_t StatIndex(Stats stat)
+{
+  return static_cast<std::size_t>(stat) - 1;
+}
+
+// Array indexed by Stats rather than by int, so the off by one of the enum
+// is dealt with here only. Get<Stats::DEX>() resolves the index at compile
+// time.
+template <typename T>
+struct StatArray
+{
+  std::array<T, kNumStats> values {};
+
+  constexpr T& operator[](Stats stat)
+  {
+    return values[StatIndex(stat)];
+  }
+
+  constexpr const T& operator[](Stats stat) const
+  {
+    return values[StatIndex(stat)];
+  }
+
+  template <Stats S>
+  constexpr T& Get()
+  {
+    static_assert(StatIndex(S) < kNumStats);
+    return std::get<StatIndex(S)>(values);
+  }
+
+  template <Stats S>
+  constexpr const T& Get() const
+  {
+    static_assert(StatIndex(S) < kNumStats);
+    return std::get<StatIndex(S)>(values);
+  }
+};
+
+
 #endif //__STATS_H__
@@ -0,0 +1,77 @@
+#ifndef __TABLE_CLIENT_H__
+#define __TABLE_CLIENT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "graphics/CellFrame.h"
+#include "graphics/FrameBuffer.h"
+#include "server/TableProtocol.h"
+
+// One session of a TableServer, from the client's side: sends keys and
+// replays the frames it gets onto Screen(). The socket is non-blocking once
+// connected, so any number of clients can share one poll loop over Fd().
+class TableClient
+{
+public:
+  // Called for every frame, before it is applied to Screen()
+  using OnFrame = std::function<void(const FrameMessage& frame)>;
+
+  TableClient() = default;
+
+  ~TableClient();
+
+  TableClient(const TableClient&) = delete;
+  TableClient& operator=(const TableClient&) = delete;
+
+  // Blocks until connected, then sends hello. False with errno set.
+  bool Connect(const std::string& path, const HelloMessage& hello);
+
+  void Close();
+
+  int Fd() const;
+
+  void SetOnFrame(OnFrame onFrame);
+
+  // Return false once the connection is lost
+  bool SendKey(int key, std::uint32_t tag = 0);
+
+  bool SendResize(int columns, int lines);
+
+  // Sends what the socket did not take before
+  bool Flush();
+
+  // Something is left for Flush(), once Fd() is writable
+  bool WantsWrite() const;
+
+  // Reads and applies whatever arrived, without blocking. False once the
+  // session is over: BYE, a closed socket or a protocol error.
+  bool Receive();
+
+  // The server said BYE
+  bool Finished() const;
+
+  const FrameBuffer& Screen() const;
+
+  std::uint64_t Frames() const;
+
+  std::uint64_t BytesReceived() const;
+
+private:
+  int _fd {-1};
+  MessageReader _reader;
+  CellFrameReader _frame_reader;
+  std::vector<std::uint8_t> _out;
+  std::size_t _sent {0};
+  FrameBuffer _screen;
+  OnFrame _on_frame;
+  std::uint64_t _frames {0};
+  std::uint64_t _bytes_received {0};
+  bool _finished {false};
+};
+
+
+#endif // __TABLE_CLIENT_H__
@@ -0,0 +1,96 @@
+#ifndef __TABLE_PROTOCOL_H__
+#define __TABLE_PROTOCOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// What TableServer and its clients say over a stream socket. Every message
+// is a little endian u32 with the size of the rest, its MessageType, then
+// varint fields:
+//
+//   HELLO   columns, lines, seed       client, once, opens the session
+//   KEY     key, tag                   client; tag comes back with the frame
+//   RESIZE  columns, lines             client
+//   FRAME   tag, cell frame            server; tag of the last key applied
+//   BYE                                server, the session is over
+//
+// A seed of 0 asks for a random one. Keys are ncurses key codes.
+enum class MessageType : std::uint8_t
+{
+    HELLO = 1,
+    KEY = 2,
+    RESIZE = 3,
+    FRAME = 4,
+    BYE = 5,
+};
+
+struct Message
+{
+  MessageType type {MessageType::BYE};
+  std::span<const std::uint8_t> body {};
+};
+
+struct HelloMessage
+{
+  int columns {80};
+  int lines {24};
+  std::uint64_t seed {0};
+};
+
+struct KeyMessage
+{
+  int key {0};
+  std::uint32_t tag {0};
+};
+
+struct FrameMessage
+{
+  std::uint32_t tag {0};
+  std::span<const std::uint8_t> cellFrame {};     // See CellFrame.h
+};
+
+void WriteHello(std::vector<std::uint8_t>& out, const HelloMessage& hello);
+
+void WriteKey(std::vector<std::uint8_t>& out, const KeyMessage& key);
+
+void WriteResize(std::vector<std::uint8_t>& out, int columns, int lines);
+
+void WriteFrame(std::vector<std::uint8_t>& out, std::uint32_t tag, std::span<const std::uint8_t> cellFrame);
+
+void WriteBye(std::vector<std::uint8_t>& out);
+
+// False on a malformed body
+bool ReadHello(std::span<const std::uint8_t> body, HelloMessage& hello);
+
+bool ReadKey(std::span<const std::uint8_t> body, KeyMessage& key);
+
+bool ReadResize(std::span<const std::uint8_t> body, int& columns, int& lines);
+
+bool ReadFrame(std::span<const std::uint8_t> body, FrameMessage& frame);
+
+
+// Cuts the bytes read from a socket into messages. Bodies point into the
+// reader and stay valid until the next Feed().
+class MessageReader
+{
+public:
+  // Larger messages are a protocol error
+  static constexpr std::size_t kMaxMessage = 1 << 20;
+
+  void Feed(std::span<const std::uint8_t> bytes);
+
+  // False when no whole message is buffered, or on an error
+  bool Next(Message& message);
+
+  bool Failed() const;
+
+private:
+  std::vector<std::uint8_t> _buffer;
+  std::size_t _read {0};
+  bool _failed {false};
+};
+
+
+#endif // __TABLE_PROTOCOL_H__
@@ -0,0 +1,86 @@
+#ifndef __TABLE_SERVER_H__
+#define __TABLE_SERVER_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ServerConfig
+{
+  std::size_t workers {0};              // 0: one per hardware thread
+  double tickRate {30.0};               // Scene ticks per second, every session
+  std::size_t maxBacklog {64 * 1024};   // Unsent bytes past which a session skips frames
+};
+
+struct ServerStats
+{
+  std::size_t sessions {0};             // Open now
+  std::uint64_t accepted {0};
+  std::uint64_t rejected {0};           // Worker queue full
+  std::uint64_t keys {0};
+  std::uint64_t frames {0};
+  std::uint64_t skippedFrames {0};      // Not rendered while a client was behind
+  std::uint64_t bytesSent {0};
+  std::int64_t cpuNs {0};               // Spent on the worker threads
+};
+
+
+// Hosts many game tables in one process: every client of a Unix domain
+// socket gets its own session, with its own Display, DemoScene and
+// DiceEngine (seeded from its HELLO), so sessions share no state.
+//
+// An acceptor thread hands every connection to one of a fixed set of
+// workers, round robin, through the worker's SPSC queue. From then on the
+// session lives on that worker only and is never locked. Each worker runs
+// one epoll loop over its sessions' sockets, a timerfd that ticks all of
+// its scenes and an eventfd the acceptor wakes it with.
+//
+// Keys are applied and the frame showing them sent as soon as they arrive;
+// ticks render as well. Frames are the cell diffs of the session's Display
+// (see StreamTarget). While a client has more than maxBacklog bytes unsent
+// its frames are not rendered at all: the Display keeps the difference,
+// so the next frame that goes out catches the client up.
+class TableServer
+{
+public:
+  explicit TableServer(const ServerConfig& config = {});
+
+  ~TableServer();
+
+  TableServer(const TableServer&) = delete;
+  TableServer& operator=(const TableServer&) = delete;
+
+  // Replaces a stale socket file at path. False with errno set on failure.
+  bool Listen(const std::string& path);
+
+  // Starts the acceptor and the workers; Listen() first
+  bool Start();
+
+  // Closes every session and removes the socket file
+  void Stop();
+
+  std::size_t NumWorkers() const;
+
+  // Summed over the workers, each read without stopping them
+  ServerStats Stats() const;
+
+private:
+  struct Worker;
+
+  void Accept();
+
+  ServerConfig _config;
+  std::string _path;
+  int _listen_fd {-1};
+  int _stop_fd {-1};
+  std::thread _acceptor;
+  std::vector<std::unique_ptr<Worker>> _workers;
+  std::atomic<std::uint64_t> _rejected {0};
+};
+
+
+#endif // __TABLE_SERVER_H__
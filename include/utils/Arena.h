@@ -0,0 +1,64 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Monotonic memory resource: allocating bumps a pointer, deallocating does
+// nothing and Reset() frees everything at once. Meant for memory that all
+// dies together, e.g. an encounter's statblocks or a frame's text.
+//
+// When a round between resets needed more than one block, Reset() replaces
+// the blocks with a single one large enough for all of them, so a workload
+// that repeats settles on no upstream allocations at all.
+class Arena : public std::pmr::memory_resource
+{
+public:
+  explicit Arena(std::size_t initialBytes = 4096,
+                 std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+  ~Arena() override;
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Everything allocated from the arena is gone; destructors are not run.
+  void Reset();
+
+  // Bytes handed out since the last Reset(), alignment padding included
+  std::size_t BytesUsed() const;
+
+  // Bytes held from upstream
+  std::size_t Capacity() const;
+
+  // Blocks ever allocated from upstream
+  std::size_t UpstreamAllocations() const;
+
+private:
+  struct Block
+  {
+    std::byte* data;
+    std::size_t size;
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+  void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  void AddBlock(std::size_t minBytes);
+
+  void FreeBlocks();
+
+  std::pmr::memory_resource* _upstream;
+  std::vector<Block> _blocks;
+  std::size_t _offset {0};          // In the last block
+  std::size_t _used {0};
+  std::size_t _next_size;
+  std::size_t _upstream_allocations {0};
+};
+
+
+#endif // __ARENA_H__
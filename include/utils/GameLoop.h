@@ -0,0 +1,72 @@
+#ifndef __GAME_LOOP_H__
+#define __GAME_LOOP_H__
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Rolling window of the last frame times, for p50/p99 style reporting
+class FrameTimes
+{
+public:
+  static constexpr std::size_t kWindow = 256;
+
+  void Record(std::chrono::nanoseconds frameTime);
+
+  // Frame time in milliseconds at the given quantile (0.5 = median) of the
+  // recorded window, 0 before the first frame.
+  double PercentileMs(double quantile) const;
+
+  std::size_t Count() const;
+
+private:
+  std::array<std::int64_t, kWindow> _samples {};
+  std::size_t _next {0};
+  std::size_t _count {0};
+};
+
+
+// Fixed timestep loop. The simulation ticks at a fixed rate no matter how
+// long frames take (catching up when late), rendering runs at its own rate,
+// and the time until the next deadline is spent blocked on the input file
+// descriptor, so a key press is handled as soon as it arrives instead of at
+// the start of the next frame.
+class GameLoop
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Returns the next pending key, or a negative value when there is none.
+  using ReadKey = std::function<int()>;
+  // Handles one key; returning false ends the loop.
+  using OnKey = std::function<bool(int key)>;
+  using OnTick = std::function<void(Clock::duration tick)>;
+  // alpha in [0, 1) is how far the clock is between the last tick and the next
+  using OnRender = std::function<void(double alpha)>;
+
+  GameLoop(double tickRate = 60.0, double renderRate = 60.0, int inputFd = 0);
+
+  void Run(const ReadKey& readKey, const OnKey& onKey, const OnTick& onTick, const OnRender& onRender);
+
+  void Stop();
+
+  // Time between the starts of consecutive rendered frames
+  const FrameTimes& GetFrameTimes() const;
+
+private:
+  // Ticks simulated in a row before the backlog is dropped
+  static constexpr int kMaxCatchUpTicks = 5;
+
+  void WaitForInput(Clock::time_point deadline);
+
+  Clock::duration _tick;
+  Clock::duration _render_period;
+  int _input_fd;
+  bool _running {false};
+  FrameTimes _frame_times;
+};
+
+
+#endif // __GAME_LOOP_H__
@@ -0,0 +1,99 @@
+#ifndef __INPUT_THREAD_H__
+#define __INPUT_THREAD_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "utils/SpscQueue.h"
+
+enum class InputType : std::uint8_t
+{
+  KEY = 0,
+  RESIZE = 1,
+};
+
+struct InputEvent
+{
+  InputType type {InputType::KEY};
+  int key {-1};                   // Byte, or an ncurses key code such as Key::UP
+  int columns {0};                // RESIZE
+  int lines {0};
+  std::chrono::steady_clock::time_point time {};    // When it was read
+};
+
+
+// Turns terminal bytes into keys: arrow keys in both cursor modes (ESC [ A
+// and, with keypad() on, ESC O A) become the ncurses codes of Key. Other
+// escape sequences are dropped; an ESC nothing follows is key 27.
+class KeyDecoder
+{
+public:
+  // Appends the keys that bytes complete
+  void Feed(std::span<const std::uint8_t> bytes, std::vector<int>& keys);
+
+  // True while an escape sequence is incomplete
+  bool Pending() const;
+
+  // The input went quiet mid-sequence: a lone ESC is the escape key
+  void Flush(std::vector<int>& keys);
+
+private:
+  std::uint8_t _sequence[8] {};
+  std::size_t _length {0};
+};
+
+
+// Reads input on its own thread instead of the render loop. The thread
+// blocks in poll() on the input, decodes keys as they arrive, turns SIGWINCH
+// into RESIZE events and pushes everything, timestamped, into a lock-free
+// SPSC queue; WakeFd() becomes readable when something was queued, so a
+// GameLoop can sleep on it and drain the queue with Poll(). ncurses is never
+// called from the thread, since it is not thread-safe.
+class InputThread
+{
+public:
+  static constexpr std::size_t kQueueSize = 256;
+
+  InputThread() = default;
+
+  ~InputThread();
+
+  InputThread(const InputThread&) = delete;
+  InputThread& operator=(const InputThread&) = delete;
+
+  // ttyFd, if not -1, is asked for the terminal size on SIGWINCH. Only one
+  // started InputThread watches SIGWINCH at a time.
+  bool Start(int inputFd, int ttyFd = -1);
+
+  void Stop();
+
+  // Consumer side: next queued event, false when there is none.
+  bool Poll(InputEvent& event);
+
+  int WakeFd() const;
+
+  // Events lost because the consumer fell kQueueSize events behind
+  std::size_t Dropped() const;
+
+private:
+  void Run();
+
+  void Push(const InputEvent& event);
+
+  SpscQueue<InputEvent, kQueueSize> _queue;
+  std::thread _thread;
+  int _input_fd {-1};
+  int _tty_fd {-1};
+  int _wake_fd {-1};
+  int _stop_fd {-1};
+  int _resize_fd {-1};
+  std::atomic<std::size_t> _dropped {0};
+};
+
+
+#endif // __INPUT_THREAD_H__
@@ -0,0 +1,135 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Timing and count of one zone over a window of time
+struct ZoneStats
+{
+  std::string name;
+  std::uint64_t count {0};
+  std::int64_t totalNs {0};
+  std::int64_t maxNs {0};
+
+  double MeanUs() const { return count ? totalNs / 1e3 / count : 0.0; }
+};
+
+// Last kCapacity zones timed by one thread. Only the owning thread writes;
+// any thread may read at any time. Slots are relaxed atomics published by
+// the release store of _head, and a reader drops the slots the writer may
+// have lapped while it was copying them, so reading never takes a lock and
+// never sees a torn event.
+class ProfileRing
+{
+public:
+  static constexpr std::size_t kCapacity = 1 << 14;
+
+  struct Event
+  {
+    std::uint16_t zone;
+    std::int64_t startNs;
+    std::int64_t durationNs;
+  };
+
+  explicit ProfileRing(std::uint32_t thread);
+
+  void Push(std::uint16_t zone, std::int64_t startNs, std::int64_t durationNs);
+
+  // Appends the events still in the ring, oldest first
+  void Read(std::vector<Event>& out) const;
+
+  std::uint32_t Thread() const;
+
+private:
+  // startNs, then durationNs << 16 | zone
+  std::array<std::atomic<std::uint64_t>, 2 * kCapacity> _slots {};
+  std::atomic<std::uint64_t> _head {0};
+  std::uint32_t _thread;
+};
+
+
+// Process-wide registry of zones and of the rings of every thread that
+// timed one. Recording is off until Enable(true); a disabled zone costs a
+// relaxed load and a branch.
+class Profiler
+{
+public:
+  static constexpr std::uint16_t kNoZone = UINT16_MAX;
+
+  // Zone ids are assigned once per name, in registration order
+  static std::uint16_t RegisterZone(const char* name);
+
+  static void Enable(bool enabled);
+
+  static bool Enabled()
+  {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  // Nanoseconds on the steady clock since the profiler started
+  static std::int64_t Now();
+
+  // Ring of the calling thread, created on first use
+  static ProfileRing& ThreadRing();
+
+  // Per zone over the last windowNs, in registration order, zones without
+  // events included.
+  static std::vector<ZoneStats> Summarize(std::int64_t windowNs);
+
+  // Every event still in a ring as Chrome trace JSON ("X" events, one tid
+  // per thread), for chrome://tracing or Perfetto.
+  static bool WriteChromeTrace(const std::string& path);
+
+private:
+  static std::atomic<bool> _enabled;
+};
+
+
+// Times its own scope into the calling thread's ring.
+class ProfileZone
+{
+public:
+  explicit ProfileZone(std::uint16_t zone)
+    : _zone(Profiler::Enabled() ? zone : Profiler::kNoZone), _start(_zone != Profiler::kNoZone ? Profiler::Now() : 0)
+  {
+
+  }
+
+  ~ProfileZone()
+  {
+    if (_zone != Profiler::kNoZone)
+    {
+      Profiler::ThreadRing().Push(_zone, _start, Profiler::Now() - _start);
+    }
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+  std::uint16_t _zone;
+  std::int64_t _start;
+};
+
+
+#define DND_PROFILE_CONCAT_INNER(a, b) a##b
+#define DND_PROFILE_CONCAT(a, b) DND_PROFILE_CONCAT_INNER(a, b)
+
+// PROFILE_ZONE("Display::Refresh"); times the rest of the enclosing scope.
+// Building with DND_NO_PROFILING compiles the zones out.
+#ifdef DND_NO_PROFILING
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE(name)                                                                       \
+  static const std::uint16_t DND_PROFILE_CONCAT(profile_zone_id_, __LINE__) =                   \
+      Profiler::RegisterZone(name);                                                              \
+  const ProfileZone DND_PROFILE_CONCAT(profile_zone_, __LINE__)(DND_PROFILE_CONCAT(profile_zone_id_, __LINE__))
+#endif
+
+
+#endif // __PROFILER_H__
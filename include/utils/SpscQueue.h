@@ -0,0 +1,61 @@
+#ifndef __SPSC_QUEUE_H__
+#define __SPSC_QUEUE_H__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded single producer, single consumer queue. One thread pushes, one
+// thread pops, neither ever blocks or locks: each side owns one index and
+// publishes it with a release store. The indices sit on their own cache
+// lines so the two threads do not keep stealing each other's line.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer only. Returns false when the queue is full.
+  bool TryPush(const T& value)
+  {
+    const std::size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head_cache == Capacity)
+    {
+      _head_cache = _head.load(std::memory_order_acquire);
+      if (tail - _head_cache == Capacity)
+      {
+        return false;
+      }
+    }
+    _items[tail & (Capacity - 1)] = value;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false when the queue is empty.
+  bool TryPop(T& value)
+  {
+    const std::size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail_cache)
+    {
+      _tail_cache = _tail.load(std::memory_order_acquire);
+      if (head == _tail_cache)
+      {
+        return false;
+      }
+    }
+    value = _items[head & (Capacity - 1)];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  alignas(64) std::atomic<std::size_t> _head {0};
+  std::size_t _tail_cache {0};                      // Consumer's last view of _tail
+  alignas(64) std::atomic<std::size_t> _tail {0};
+  std::size_t _head_cache {0};                      // Producer's last view of _head
+  alignas(64) std::array<T, Capacity> _items {};
+};
+
+
+#endif // __SPSC_QUEUE_H__
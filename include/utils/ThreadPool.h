@@ -0,0 +1,69 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of workers, each with its own task deque. A worker pops from
+// the back of its own deque and, when that is empty, steals from the front
+// of the others, so uneven tasks balance themselves without a shared queue.
+class ThreadPool
+{
+public:
+  // The worker index passed to a task is stable for the life of the pool,
+  // which lets callers keep per-worker state without locks.
+  using Task = std::function<void(std::size_t worker)>;
+
+  // 0 threads means one per hardware thread.
+  explicit ThreadPool(std::size_t threads = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t NumWorkers() const;
+
+  void Submit(Task task);
+
+  // Blocks until every submitted task has finished.
+  void Wait();
+
+  // Runs fn(begin, end, worker) over [0, count) in chunks of grain and waits.
+  void ParallelFor(std::size_t count,
+                   std::size_t grain,
+                   const std::function<void(std::size_t, std::size_t, std::size_t)>& fn);
+
+private:
+  struct alignas(64) Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(std::size_t worker);
+
+  bool TryPop(std::size_t worker, Task& task);
+
+  std::vector<std::unique_ptr<Queue>> _queues;
+  std::vector<std::thread> _threads;
+
+  std::atomic<std::size_t> _queued {0};
+  std::atomic<std::size_t> _pending {0};
+  std::atomic<std::size_t> _next_queue {0};
+
+  std::mutex _state_mutex;
+  std::condition_variable _work_available;
+  std::condition_variable _all_done;
+  bool _stop {false};
+};
+
+
+#endif // __THREAD_POOL_H__
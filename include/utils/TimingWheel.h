@@ -0,0 +1,73 @@
+#ifndef __TIMING_WHEEL_H__
+#define __TIMING_WHEEL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel over an integer clock. Level 0 has a slot per
+// tick for the next 64 ticks, level 1 a slot per 64 ticks for the next 4096,
+// and so on; timers further out wait in an overflow list. A timer sits in
+// the slot of its deadline at the finest level that reaches it and moves
+// down a level each time the level above turns over, so scheduling and
+// cancelling are O(1) and advancing costs O(ticks + expired), however many
+// timers are pending.
+class TimingWheel
+{
+public:
+  using TimerId = std::uint32_t;
+
+  static constexpr TimerId kNoTimer = UINT32_MAX;
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 4;
+
+  explicit TimingWheel(std::uint64_t now = 0);
+
+  // payload is handed back when the timer fires, at the first Advance() that
+  // reaches deadline. Deadlines in the past fire on the next Advance().
+  TimerId Schedule(std::uint64_t deadline, std::uint32_t payload);
+
+  // Returns false if the timer already fired or was cancelled.
+  bool Cancel(TimerId timer);
+
+  // Moves the clock to now and appends the payloads of the timers that fire.
+  void Advance(std::uint64_t now, std::vector<std::uint32_t>& expired);
+
+  std::uint64_t Now() const;
+
+  // Timers pending
+  std::size_t Size() const;
+
+private:
+  static constexpr std::uint32_t kOverflow = kLevels * kSlots;
+
+  struct Node
+  {
+    std::uint64_t deadline {0};
+    std::uint32_t payload {0};
+    TimerId prev {kNoTimer};
+    TimerId next {kNoTimer};
+    std::uint32_t list {kOverflow};       // Slot index, kOverflow, or kFree
+  };
+
+  static constexpr std::uint32_t kFree = kOverflow + 1;
+
+  void Place(TimerId timer);
+
+  void Link(TimerId timer, std::uint32_t list);
+
+  void Unlink(TimerId timer);
+
+  // Re-places every timer of a list, emptying it first
+  void Cascade(std::uint32_t list);
+
+  std::vector<Node> _nodes;
+  std::vector<TimerId> _free;
+  TimerId _heads[kOverflow + 1];          // Every slot, then the overflow list
+  std::uint64_t _now;
+  std::size_t _size {0};
+};
+
+
+#endif // __TIMING_WHEEL_H__
@@ -0,0 +1,218 @@
+#include "combat/ActionPipeline.h"
+
+#include <algorithm>
+
+#include "rules/AbilityTables.h"
+#include "utils/Profiler.h"
+
+
+ActionPipeline::ActionPipeline(const RollRules& rules)
+  : _rules(rules)
+{
+
+}
+
+void ActionPipeline::Queue(const CreatureStore& store, std::size_t attacker, ActionType type,
+                           std::size_t actionIndex, std::size_t target)
+{
+  const std::span<const Action> actions = store.Actions(attacker, type);
+  if (actionIndex >= actions.size())
+  {
+    return;
+  }
+  Queue(attacker, actions[actionIndex], actions, target);
+}
+
+void ActionPipeline::Queue(std::size_t attacker, const Action& action, std::span<const Action> list,
+                           std::size_t target)
+{
+  if (const auto* multiattack = std::get_if<MultiattackEffect>(&action.effect))
+  {
+    for (std::uint8_t index : multiattack->actions)
+    {
+      if (index < list.size() && !std::holds_alternative<MultiattackEffect>(list[index].effect))
+      {
+        QueueEffect(attacker, list[index].effect, target);
+      }
+    }
+    return;
+  }
+
+  QueueEffect(attacker, action.effect, target);
+}
+
+std::size_t ActionPipeline::Size() const
+{
+  return _pending.size();
+}
+
+void ActionPipeline::Clear()
+{
+  _pending.clear();
+  for (DiceGroup& group : _groups)
+  {
+    group.count = 0;
+  }
+}
+
+void ActionPipeline::QueueEffect(std::size_t attacker, const ActionEffect& effect, std::size_t target)
+{
+  const DiceExpression& damage = std::holds_alternative<AttackEffect>(effect)
+                                     ? std::get<AttackEffect>(effect).damage
+                                     : std::get<SaveEffect>(effect).damage;
+
+  // Damage dice are counted now so that Resolve can roll them up front
+  for (std::size_t t = 0; t < damage.count; t++)
+  {
+    const DiceSpec& spec = damage.terms[t].spec;
+    if (spec.IsPlainSum())
+    {
+      Group(spec.facesDie).count += spec.nDice;
+    }
+  }
+
+  _pending.push_back({&effect, static_cast<std::uint32_t>(attacker), static_cast<std::uint32_t>(target)});
+}
+
+ActionPipeline::DiceGroup& ActionPipeline::Group(int facesDie)
+{
+  if (facesDie < kIndexedFaces && _group_of_faces[facesDie] != 0)
+  {
+    return _groups[_group_of_faces[facesDie] - 1];
+  }
+
+  for (DiceGroup& group : _groups)
+  {
+    if (group.facesDie == facesDie)
+    {
+      return group;
+    }
+  }
+
+  _groups.push_back({facesDie, 0, 0, {}});
+  if (facesDie < kIndexedFaces)
+  {
+    _group_of_faces[facesDie] = static_cast<std::uint16_t>(_groups.size());
+  }
+  return _groups.back();
+}
+
+int ActionPipeline::RollDamage(const DiceExpression& damage, bool critical, DiceEngine& engine)
+{
+  int total = damage.modifier;
+
+  for (std::size_t t = 0; t < damage.count; t++)
+  {
+    const DiceSpec& spec = damage.terms[t].spec;
+    int sum = spec.modifier;
+
+    if (spec.IsPlainSum())
+    {
+      DiceGroup& group = Group(spec.facesDie);
+      for (int i = 0; i < spec.nDice; i++)
+      {
+        sum += group.rolls[group.next++];
+      }
+      // Criticals are rare enough to roll their extra dice on their own
+      if (critical)
+      {
+        sum += engine.RollSum(spec.nDice, spec.facesDie);
+      }
+    }
+    else
+    {
+      for (int i = 0; i < (critical ? 2 : 1); i++)
+      {
+        sum += engine.Roll(spec) - spec.modifier;
+      }
+    }
+
+    total += damage.terms[t].negative ? -sum : sum;
+  }
+
+  return std::max(total, 0);
+}
+
+std::span<const AttackOutcome> ActionPipeline::Resolve(CreatureStore& store, DiceEngine& engine)
+{
+  PROFILE_ZONE("ActionPipeline::Resolve");
+
+  const std::size_t count = _pending.size();
+  _outcomes.resize(count);
+  _d20.resize(count);
+  _targets.resize(count);
+  _damage.resize(count);
+
+  // Conditions decide who rolls twice; only then is a second d20 needed
+  const std::span<const std::uint64_t> conditions = store.Conditions();
+  _modes.resize(count);
+  bool any_second = false;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const Pending& pending = _pending[i];
+    const ConditionSet target(conditions[pending.target]);
+    if (std::holds_alternative<AttackEffect>(*pending.effect))
+    {
+      _modes[i] = AttackRollMode(ConditionSet(conditions[pending.attacker]), target, true, _rules);
+    }
+    else
+    {
+      _modes[i] = SavingThrowMode(target, std::get<SaveEffect>(*pending.effect).save, _rules);
+    }
+    any_second |= _modes[i] != Roll::STRIGHT;
+  }
+
+  // Damage dice are rolled for misses too; the spare ones are never read
+  engine.RollMany(static_cast<int>(count), 20, _d20);
+  if (any_second)
+  {
+    _second_d20.resize(count);
+    engine.RollMany(static_cast<int>(count), 20, _second_d20);
+    // Selects rather than branches: modes are mixed and unpredictable
+    for (std::size_t i = 0; i < count; i++)
+    {
+      const int high = KeepD20<Roll::ADVANTAGE>(_d20[i], _second_d20[i]);
+      const int low = KeepD20<Roll::DISADVANTAGE>(_d20[i], _second_d20[i]);
+      _d20[i] = _modes[i] == Roll::ADVANTAGE ? high : _modes[i] == Roll::DISADVANTAGE ? low : _d20[i];
+    }
+  }
+  for (DiceGroup& group : _groups)
+  {
+    group.rolls.resize(group.count);
+    group.next = 0;
+    engine.RollMany(static_cast<int>(group.count), group.facesDie, group.rolls);
+  }
+
+  const std::span<const int> armor_class = store.ArmorClasses();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const Pending& pending = _pending[i];
+    AttackOutcome& outcome = _outcomes[i];
+    const int d20 = _d20[i];
+
+    outcome = {pending.attacker, pending.target, 0, static_cast<std::uint8_t>(d20), false, false};
+    if (const auto* attack = std::get_if<AttackEffect>(pending.effect))
+    {
+      outcome.hit = d20 == 20 || (d20 != 1 && d20 + attack->attackBonus >= armor_class[pending.target]);
+      outcome.critical = d20 == 20 ||
+                         (outcome.hit && ConditionSet(conditions[pending.target]).Has(_rules.meleeCritical));
+      outcome.damage = outcome.hit ? RollDamage(attack->damage, outcome.critical, engine) : 0;
+    }
+    else
+    {
+      const auto& save = std::get<SaveEffect>(*pending.effect);
+      const int modifier = AbilityModifier(store.Scores(save.save)[pending.target]);
+      const int damage = RollDamage(save.damage, false, engine);
+      outcome.hit = FailsSavingThrow(ConditionSet(conditions[pending.target]), save.save, _rules) ||
+                    d20 + modifier < save.dc;
+      outcome.damage = outcome.hit ? damage : save.halfOnSuccess ? damage / 2 : 0;
+    }
+
+    _targets[i] = outcome.target;
+    _damage[i] = outcome.damage;
+  }
+  store.ApplyDamage(_targets, _damage);
+
+  Clear();
+  return _outcomes;
+}
@@ -0,0 +1,313 @@
+#include "combat/EffectSystem.h"
+
+#include <algorithm>
+
+#include "rules/AbilityTables.h"
+
+
+Duration Duration::Permanent()
+{
+  return {};
+}
+
+Duration Duration::Turns(int turns)
+{
+  Duration duration;
+  duration._kind = Kind::TURNS;
+  duration._count = turns;
+  return duration;
+}
+
+Duration Duration::Rounds(int rounds)
+{
+  Duration duration;
+  duration._kind = Kind::ROUNDS;
+  duration._count = rounds;
+  return duration;
+}
+
+Duration Duration::Minutes(int minutes)
+{
+  return Rounds(10 * minutes);
+}
+
+Duration Duration::EndOfNextTurn(CreatureHandle creature)
+{
+  Duration duration;
+  duration._kind = Kind::END_OF_NEXT_TURN;
+  duration._creature = creature;
+  return duration;
+}
+
+
+EffectSystem::EffectSystem(CreatureStore& store, const RollRules& rules)
+  : _store(&store), _rules(rules)
+{
+
+}
+
+void EffectSystem::SetRoundLength(int turns)
+{
+  _round_length = std::max(turns, 1);
+}
+
+EffectHandle EffectSystem::Apply(CreatureHandle target, ConditionSet conditions, Duration duration,
+                                 CreatureHandle concentration)
+{
+  if (!_store->IsValid(target))
+  {
+    return {};
+  }
+
+  std::uint32_t slot;
+  if (!_free.empty())
+  {
+    slot = _free.back();
+    _free.pop_back();
+  }
+  else
+  {
+    slot = static_cast<std::uint32_t>(_effects.size());
+    _effects.emplace_back();
+  }
+
+  Effect& effect = _effects[slot];
+  effect.target = target;
+  effect.caster = concentration;
+  effect.conditions = conditions;
+  effect.active = true;
+
+  Creature& on = CreatureOf(target);
+  effect.nextOnTarget = on.effects;
+  on.effects = slot;
+
+  effect.nextConcentrating = kNone;
+  if (_store->IsValid(concentration))
+  {
+    Creature& caster = CreatureOf(concentration);
+    effect.nextConcentrating = caster.concentration;
+    caster.concentration = slot;
+  }
+  else
+  {
+    effect.caster = {};
+  }
+
+  const std::uint64_t deadline = Deadline(duration);
+  effect.timer = deadline == kNever ? TimingWheel::kNoTimer : _wheel.Schedule(deadline, slot);
+  _active++;
+
+  const EffectHandle handle {slot, effect.generation};
+  Refresh(target);
+
+  // Whoever cannot act cannot concentrate
+  if (IsIncapacitated(_store->GetConditions(_store->IndexOf(target)), _rules))
+  {
+    BreakConcentration(target);
+  }
+  return handle;
+}
+
+void EffectSystem::End(EffectHandle effect)
+{
+  if (IsActive(effect))
+  {
+    EndEffect(effect.slot);
+  }
+}
+
+bool EffectSystem::IsActive(EffectHandle effect) const
+{
+  return effect.slot < _effects.size() && _effects[effect.slot].active &&
+         _effects[effect.slot].generation == effect.generation;
+}
+
+void EffectSystem::BreakConcentration(CreatureHandle caster)
+{
+  if (caster.slot >= _creatures.size())
+  {
+    return;
+  }
+  // Ending an effect unlinks it, so the list empties itself
+  while (_creatures[caster.slot].concentration != kNone)
+  {
+    EndEffect(_creatures[caster.slot].concentration);
+  }
+}
+
+bool EffectSystem::IsConcentrating(CreatureHandle caster) const
+{
+  return caster.slot < _creatures.size() && _creatures[caster.slot].concentration != kNone;
+}
+
+bool EffectSystem::ConcentrationCheck(CreatureHandle caster, int damage, DiceEngine& engine)
+{
+  if (!IsConcentrating(caster) || !_store->IsValid(caster))
+  {
+    return true;
+  }
+
+  const std::size_t index = _store->IndexOf(caster);
+  const ConditionSet conditions = _store->GetConditions(index);
+  bool held = false;
+
+  if (!FailsSavingThrow(conditions, Stats::CON, _rules))
+  {
+    const Roll mode = SavingThrowMode(conditions, Stats::CON, _rules);
+    int d20 = engine.RollOne(20);
+    if (mode != Roll::STRIGHT)
+    {
+      const int other = engine.RollOne(20);
+      d20 = mode == Roll::ADVANTAGE ? std::max(d20, other) : std::min(d20, other);
+    }
+    const int modifier = AbilityModifier(_store->Scores(Stats::CON)[index]);
+    held = d20 + modifier >= std::max(10, damage / 2);
+  }
+
+  if (!held)
+  {
+    BreakConcentration(caster);
+  }
+  return held;
+}
+
+void EffectSystem::StartTurn(CreatureHandle creature)
+{
+  _acting = creature;
+}
+
+std::span<const EffectHandle> EffectSystem::EndTurn(CreatureHandle creature)
+{
+  _expired.clear();
+  _fired.clear();
+
+  CreatureOf(creature).lastTurnEnd = _wheel.Now() + 1;
+  _acting = {};
+  _wheel.Advance(_wheel.Now() + 1, _fired);
+
+  for (std::uint32_t slot : _fired)
+  {
+    Effect& effect = _effects[slot];
+    effect.timer = TimingWheel::kNoTimer;
+    if (effect.active)
+    {
+      _expired.push_back({slot, effect.generation});
+      EndEffect(slot);
+    }
+  }
+  return _expired;
+}
+
+void EffectSystem::Forget(CreatureHandle creature)
+{
+  if (creature.slot >= _creatures.size())
+  {
+    return;
+  }
+  BreakConcentration(creature);
+  while (_creatures[creature.slot].effects != kNone)
+  {
+    EndEffect(_creatures[creature.slot].effects);
+  }
+  _creatures[creature.slot].lastTurnEnd = kNever;
+}
+
+std::size_t EffectSystem::Size() const
+{
+  return _active;
+}
+
+std::uint64_t EffectSystem::Now() const
+{
+  return _wheel.Now();
+}
+
+EffectSystem::Creature& EffectSystem::CreatureOf(CreatureHandle handle)
+{
+  if (handle.slot >= _creatures.size())
+  {
+    _creatures.resize(handle.slot + 1);
+  }
+  return _creatures[handle.slot];
+}
+
+std::uint64_t EffectSystem::Deadline(const Duration& duration)
+{
+  const std::uint64_t now = _wheel.Now();
+  const std::uint64_t round = static_cast<std::uint64_t>(_round_length);
+
+  switch (duration._kind)
+  {
+    case Duration::Kind::TURNS:
+      return now + static_cast<std::uint64_t>(std::max(duration._count, 0));
+
+    case Duration::Kind::ROUNDS:
+      return now + static_cast<std::uint64_t>(std::max(duration._count, 0)) * round;
+
+    case Duration::Kind::END_OF_NEXT_TURN:
+    {
+      // The turn under way ends with the next tick and is not its next one
+      if (_acting == duration._creature)
+      {
+        return now + 1 + round;
+      }
+      // The creature's turns end a round apart. Before its first one, the
+      // best guess is a round from now.
+      const std::uint64_t last = CreatureOf(duration._creature).lastTurnEnd;
+      return last == kNever ? now + round : last + ((now - last) / round + 1) * round;
+    }
+
+    default:
+      return kNever;
+  }
+}
+
+void EffectSystem::EndEffect(std::uint32_t slot)
+{
+  Effect& effect = _effects[slot];
+
+  auto unlink = [&](std::uint32_t& head, std::uint32_t Effect::*next) {
+    for (std::uint32_t* link = &head; *link != kNone; link = &(_effects[*link].*next))
+    {
+      if (*link == slot)
+      {
+        *link = effect.*next;
+        return;
+      }
+    }
+  };
+
+  unlink(_creatures[effect.target.slot].effects, &Effect::nextOnTarget);
+  if (effect.caster.slot < _creatures.size())
+  {
+    unlink(_creatures[effect.caster.slot].concentration, &Effect::nextConcentrating);
+  }
+
+  if (effect.timer != TimingWheel::kNoTimer)
+  {
+    _wheel.Cancel(effect.timer);
+    effect.timer = TimingWheel::kNoTimer;
+  }
+
+  effect.active = false;
+  effect.generation++;
+  _free.push_back(slot);
+  _active--;
+
+  Refresh(effect.target);
+}
+
+void EffectSystem::Refresh(CreatureHandle creature)
+{
+  if (!_store->IsValid(creature))
+  {
+    return;
+  }
+
+  ConditionSet conditions;
+  for (std::uint32_t slot = CreatureOf(creature).effects; slot != kNone; slot = _effects[slot].nextOnTarget)
+  {
+    conditions |= _effects[slot].conditions;
+  }
+  _store->SetConditions(_store->IndexOf(creature), conditions);
+}
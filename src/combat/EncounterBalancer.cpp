@@ -0,0 +1,429 @@
+#include "combat/EncounterBalancer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+
+#include "utils/Arena.h"
+#include "utils/Profiler.h"
+
+namespace
+{
+
+// How sharply the estimated win rate turns with the Lanchester ratio; fitted
+// loosely against EncounterSimulator
+constexpr double kSteepness = 3.0;
+
+// Estimates this far under minWinRate still get searched, for the error of
+// the estimate
+constexpr double kEstimateSlack = 0.15;
+
+constexpr std::size_t kMinTrials = 128;
+constexpr std::size_t kTrialsPerTask = 256;
+
+std::uint64_t Mix(std::uint64_t hash, std::uint64_t value)
+{
+  hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+}
+
+
+void EncounterBalancer::Tally::Add(const TrialOutcome& outcome)
+{
+  trials++;
+  partyWins += outcome.winner == Side::PARTY;
+  rounds += outcome.rounds;
+  partyDamage += outcome.damageTaken[static_cast<int>(Side::PARTY)];
+}
+
+void EncounterBalancer::Tally::Merge(const Tally& other)
+{
+  trials += other.trials;
+  partyWins += other.partyWins;
+  rounds += other.rounds;
+  partyDamage += other.partyDamage;
+}
+
+
+EncounterBalancer::EncounterBalancer(std::vector<BestiaryEntry> roster)
+  : _roster(std::move(roster))
+{
+  _profiles.reserve(_roster.size());
+  for (const BestiaryEntry& entry : _roster)
+  {
+    _profiles.push_back(MakeProfile(entry.statblock));
+  }
+}
+
+const std::vector<BestiaryEntry>& EncounterBalancer::Roster() const
+{
+  return _roster;
+}
+
+const BalanceSearchStats& EncounterBalancer::LastSearch() const
+{
+  return _last_search;
+}
+
+std::size_t EncounterBalancer::CachedSimulations() const
+{
+  return _simulations.size();
+}
+
+void EncounterBalancer::ClearCache()
+{
+  _simulations.clear();
+}
+
+EncounterBalancer::Profile EncounterBalancer::MakeProfile(const Statblock& statblock)
+{
+  const std::pmr::vector<AttackEffect> turn = EncounterSimulator::BestTurn(statblock);
+  return {static_cast<double>(statblock.GetHP()),
+          statblock.GetAC(),
+          statblock.GetCR(),
+          std::vector<AttackEffect>(turn.begin(), turn.end())};
+}
+
+double EncounterBalancer::ExpectedDamage(const std::vector<AttackEffect>& turn, int armorClass)
+{
+  // As EncounterSimulator resolves them: a 1 misses, a 20 hits and doubles
+  // the dice, anything else hits when d20 + bonus reaches the AC
+  double total = 0.0;
+  for (const AttackEffect& attack : turn)
+  {
+    const int lowest_hit = std::clamp(armorClass - attack.attackBonus, 2, 20);
+    const double hit = (20 - lowest_hit) / 20.0 + 0.05;
+    const double mean = attack.damage.Mean();
+    total += hit * mean + 0.05 * (mean - attack.damage.modifier);
+  }
+  return total;
+}
+
+std::uint64_t EncounterBalancer::PartyKey(std::span<const Statblock> party, std::uint64_t seed)
+{
+  std::uint64_t hash = Mix(0, seed);
+  for (const Statblock& member : party)
+  {
+    hash = Mix(hash, static_cast<std::uint64_t>(member.GetHP()));
+    hash = Mix(hash, static_cast<std::uint64_t>(member.GetAC()));
+    hash = Mix(hash, static_cast<std::uint64_t>(member.GetStat(Stats::DEX)));
+    for (const AttackEffect& attack : EncounterSimulator::BestTurn(member))
+    {
+      hash = Mix(hash, static_cast<std::uint64_t>(attack.attackBonus));
+      hash = Mix(hash, DiceExpressionHash {}(attack.damage));
+    }
+  }
+  return hash;
+}
+
+std::vector<EncounterBalancer::Candidate> EncounterBalancer::Search(std::span<const Statblock> party,
+                                                                    const BalanceQuery& query,
+                                                                    ThreadPool& pool)
+{
+  PROFILE_ZONE("EncounterBalancer::Search");
+
+  std::vector<Profile> members;
+  double party_hit_points = 0.0;
+  for (const Statblock& member : party)
+  {
+    members.push_back(MakeProfile(member));
+    party_hit_points += member.GetHP();
+  }
+
+  // Per eligible monster: its damage per round against the party, and the
+  // party's against it
+  struct Eligible
+  {
+    std::uint32_t monster;
+    double hitPoints;
+    double damage;
+    double partyDamage;
+    float cr;
+  };
+  std::vector<Eligible> eligible;
+  for (std::size_t m = 0; m < _profiles.size(); m++)
+  {
+    const Profile& profile = _profiles[m];
+    if (profile.cr < query.minCR || profile.cr > query.maxCR || profile.hitPoints <= 0.0)
+    {
+      continue;
+    }
+
+    double damage = 0.0;
+    for (const Profile& member : members)
+    {
+      damage += ExpectedDamage(profile.turn, member.armorClass);
+    }
+    double party_damage = 0.0;
+    for (const Profile& member : members)
+    {
+      party_damage += ExpectedDamage(member.turn, profile.armorClass);
+    }
+    eligible.push_back({static_cast<std::uint32_t>(m),
+                        profile.hitPoints,
+                        members.empty() ? 0.0 : damage / members.size(),
+                        party_damage,
+                        profile.cr});
+  }
+
+  const std::size_t keep = std::max<std::size_t>(query.candidates, 1);
+  auto distance = [&](const Candidate& candidate) {
+    return std::abs(candidate.estimate - query.targetWinRate);
+  };
+  auto by_distance = [&](const Candidate& a, const Candidate& b) {
+    return distance(a) < distance(b);
+  };
+  auto trim = [&](std::vector<Candidate>& candidates) {
+    if (candidates.size() > keep)
+    {
+      std::nth_element(candidates.begin(), candidates.begin() + keep, candidates.end(), by_distance);
+      candidates.resize(keep);
+    }
+  };
+
+  std::vector<std::vector<Candidate>> per_worker(pool.NumWorkers());
+  std::vector<std::size_t> estimated(pool.NumWorkers(), 0);
+
+  pool.ParallelFor(eligible.size(), 1, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+    std::vector<Candidate>& found = per_worker[worker];
+    std::vector<MonsterGroup> groups;
+
+    // Depth first over compositions whose monsters come in roster order.
+    // killTime is how many rounds the party needs for all of them.
+    auto visit = [&](auto& self, std::size_t first, int bodies, double killTime, double damage) -> void
+    {
+      if (static_cast<int>(groups.size()) == query.maxKinds)
+      {
+        return;
+      }
+      for (std::size_t e = first; e < (groups.empty() ? end : eligible.size()); e++)
+      {
+        const Eligible& monster = eligible[e];
+        groups.push_back({monster.monster, 0});
+        for (int count = 1; bodies + count <= query.maxMonsters; count++)
+        {
+          groups.back().count = count;
+          const double kill_time = killTime + (monster.partyDamage > 0.0 ? count * monster.hitPoints / monster.partyDamage
+                                                                         : HUGE_VAL);
+          const double total_damage = damage + count * monster.damage;
+
+          // Lanchester's square law: the party's total damage per round
+          // times its hit points against the monsters'. The party's damage
+          // is the rate at which it gets through the monsters' hit points,
+          // so the ratio comes down to this.
+          const double ratio = total_damage > 0.0 ? party_hit_points / (kill_time * total_damage) : HUGE_VAL;
+          const double estimate = 1.0 / (1.0 + std::pow(ratio, -kSteepness));
+          estimated[worker]++;
+
+          if (estimate < query.minWinRate - kEstimateSlack)
+          {
+            break;      // More monsters only make it worse
+          }
+
+          found.push_back({groups, estimate, 0, {}});
+          if (found.size() >= 4 * keep)
+          {
+            trim(found);
+          }
+          self(self, e + 1, bodies + count, kill_time, total_damage);
+        }
+        groups.pop_back();
+      }
+    };
+
+    visit(visit, begin, 0, 0.0, 0.0);
+  });
+
+  std::vector<Candidate> candidates;
+  for (std::size_t worker = 0; worker < per_worker.size(); worker++)
+  {
+    candidates.insert(candidates.end(),
+                      std::make_move_iterator(per_worker[worker].begin()),
+                      std::make_move_iterator(per_worker[worker].end()));
+    _last_search.estimated += estimated[worker];
+  }
+  trim(candidates);
+  std::sort(candidates.begin(), candidates.end(), by_distance);
+  return candidates;
+}
+
+void EncounterBalancer::Simulate(std::span<const Statblock> party, std::span<Candidate*> batch,
+                                 std::size_t trials, std::uint64_t seed, ThreadPool& pool)
+{
+  PROFILE_ZONE("EncounterBalancer::Simulate");
+
+  // The monsters only live until their simulator has taken what it needs
+  Arena arena;
+  std::vector<EncounterSimulator> simulators;
+  simulators.reserve(batch.size());
+  for (const Candidate* candidate : batch)
+  {
+    std::pmr::vector<Statblock> monsters(&arena);
+    for (const MonsterGroup& group : candidate->monsters)
+    {
+      monsters.insert(monsters.end(), group.count, _roster[group.monster].statblock);
+    }
+    simulators.emplace_back(party, monsters);
+  }
+
+  // One batch for every candidate, in chunks of trials that continue where
+  // the cached trials stopped
+  struct Task
+  {
+    std::size_t candidate;
+    std::size_t begin;
+    std::size_t end;
+  };
+  std::vector<Task> tasks;
+  for (std::size_t c = 0; c < batch.size(); c++)
+  {
+    for (std::size_t begin = batch[c]->tally.trials; begin < trials; begin += kTrialsPerTask)
+    {
+      tasks.push_back({c, begin, std::min(begin + kTrialsPerTask, trials)});
+    }
+  }
+
+  std::vector<Tally> per_worker(pool.NumWorkers() * batch.size());
+  pool.ParallelFor(tasks.size(), 1, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+    DiceEngine engine(seed);
+    for (std::size_t t = begin; t < end; t++)
+    {
+      const Task& task = tasks[t];
+      Tally& tally = per_worker[worker * batch.size() + task.candidate];
+      for (std::size_t trial = task.begin; trial < task.end; trial++)
+      {
+        engine.Seed(seed, trial);
+        tally.Add(simulators[task.candidate].RunTrial(engine));
+      }
+    }
+  });
+
+  for (std::size_t c = 0; c < batch.size(); c++)
+  {
+    const std::size_t before = batch[c]->tally.trials;
+    for (std::size_t worker = 0; worker < pool.NumWorkers(); worker++)
+    {
+      batch[c]->tally.Merge(per_worker[worker * batch.size() + c]);
+    }
+    _last_search.trialsRun += batch[c]->tally.trials - before;
+    _simulations[batch[c]->key] = batch[c]->tally;
+  }
+}
+
+std::vector<BalancedEncounter> EncounterBalancer::Balance(std::span<const Statblock> party,
+                                                          const BalanceQuery& query,
+                                                          ThreadPool& pool)
+{
+  const Clock::time_point deadline = Clock::now() + query.budget;
+  _last_search = {};
+
+  std::vector<Candidate> candidates = Search(party, query, pool);
+
+  const std::uint64_t party_key = PartyKey(party, query.seed);
+  for (Candidate& candidate : candidates)
+  {
+    candidate.key = party_key;
+    for (const MonsterGroup& group : candidate.monsters)
+    {
+      candidate.key = Mix(Mix(candidate.key, group.monster), static_cast<std::uint64_t>(group.count));
+    }
+    if (auto it = _simulations.find(candidate.key); it != _simulations.end())
+    {
+      candidate.tally = it->second;
+      _last_search.trialsCached += it->second.trials;
+    }
+  }
+
+  auto win_rate = [](const Candidate& candidate) {
+    return candidate.tally.trials ? static_cast<double>(candidate.tally.partyWins) / candidate.tally.trials : 0.0;
+  };
+  auto score = [&](const Candidate& candidate) {
+    if (candidate.tally.trials == 0)
+    {
+      return 2.0 + std::abs(candidate.estimate - query.targetWinRate);
+    }
+    const double rate = win_rate(candidate);
+    return (rate < query.minWinRate ? 1.0 : 0.0) + std::abs(rate - query.targetWinRate);
+  };
+
+  // Successive halving: few trials for every candidate, then twice as many
+  // for the better half, until the survivors have query.trials each
+  std::vector<Candidate*> alive;
+  for (Candidate& candidate : candidates)
+  {
+    alive.push_back(&candidate);
+  }
+
+  std::size_t trials = std::min(query.trials, std::max(kMinTrials, query.trials / 8));
+  double seconds_per_trial = 0.0;
+  while (!alive.empty())
+  {
+    std::size_t needed = 0;
+    for (const Candidate* candidate : alive)
+    {
+      needed += trials - std::min(trials, candidate->tally.trials);
+    }
+
+    const Clock::time_point now = Clock::now();
+    if (needed > 0 && seconds_per_trial > 0.0 &&
+        now + std::chrono::duration<double>(seconds_per_trial * needed) > deadline)
+    {
+      _last_search.outOfTime = true;
+      break;
+    }
+
+    if (needed > 0)
+    {
+      Simulate(party, alive, trials, query.seed, pool);
+      seconds_per_trial = std::chrono::duration<double>(Clock::now() - now).count() / needed;
+    }
+
+    if (trials >= query.trials)
+    {
+      break;
+    }
+
+    std::sort(alive.begin(), alive.end(), [&](const Candidate* a, const Candidate* b) {
+      return score(*a) < score(*b);
+    });
+    alive.resize(std::min(alive.size(), std::max(query.results, alive.size() / 2)));
+    trials = std::min(query.trials, trials * 2);
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [&](const Candidate& a, const Candidate& b) {
+    return score(a) < score(b);
+  });
+
+  for (const Candidate& candidate : candidates)
+  {
+    _last_search.simulated += candidate.tally.trials > 0;
+  }
+
+  std::vector<BalancedEncounter> results;
+  for (const Candidate& candidate : candidates)
+  {
+    if (results.size() == query.results)
+    {
+      break;
+    }
+
+    BalancedEncounter encounter;
+    encounter.monsters = candidate.monsters;
+    encounter.estimatedWinRate = candidate.estimate;
+    encounter.winRate = win_rate(candidate);
+    encounter.trials = candidate.tally.trials;
+    if (candidate.tally.trials)
+    {
+      encounter.meanRounds = candidate.tally.rounds / candidate.tally.trials;
+      encounter.partyDamage = candidate.tally.partyDamage / candidate.tally.trials;
+    }
+    for (const MonsterGroup& group : candidate.monsters)
+    {
+      encounter.totalCR += group.count * _profiles[group.monster].cr;
+    }
+    results.push_back(std::move(encounter));
+  }
+  return results;
+}
@@ -0,0 +1,271 @@
+#include "combat/EncounterSimulator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <numeric>
+
+#include "utils/Profiler.h"
+
+namespace
+{
+
+constexpr std::size_t kTrialsPerTask = 256;
+
+int SideIndex(Side side)
+{
+  return static_cast<int>(side);
+}
+
+}
+
+
+void SimulationStats::Add(const TrialOutcome& outcome)
+{
+  trials++;
+  wins[SideIndex(outcome.winner)]++;
+  roundsHistogram[std::min(outcome.rounds, kMaxRounds)]++;
+  partyDamageHistogram[std::min(outcome.damageTaken[SideIndex(Side::PARTY)], kMaxDamage)]++;
+}
+
+void SimulationStats::Merge(const SimulationStats& other)
+{
+  trials += other.trials;
+  for (int side = 0; side < 3; side++)
+  {
+    wins[side] += other.wins[side];
+  }
+  for (int rounds = 0; rounds <= kMaxRounds; rounds++)
+  {
+    roundsHistogram[rounds] += other.roundsHistogram[rounds];
+  }
+  for (int damage = 0; damage <= kMaxDamage; damage++)
+  {
+    partyDamageHistogram[damage] += other.partyDamageHistogram[damage];
+  }
+}
+
+double SimulationStats::WinRate(Side side) const
+{
+  return trials ? static_cast<double>(wins[SideIndex(side)]) / trials : 0.0;
+}
+
+double SimulationStats::MeanRounds() const
+{
+  double total = 0.0;
+  for (int rounds = 0; rounds <= kMaxRounds; rounds++)
+  {
+    total += static_cast<double>(rounds) * roundsHistogram[rounds];
+  }
+  return trials ? total / trials : 0.0;
+}
+
+int SimulationStats::PartyDamagePercentile(double quantile) const
+{
+  const double target = quantile * trials;
+  double seen = 0.0;
+  for (int damage = 0; damage <= kMaxDamage; damage++)
+  {
+    seen += partyDamageHistogram[damage];
+    if (seen >= target)
+    {
+      return damage;
+    }
+  }
+  return kMaxDamage;
+}
+
+
+EncounterSimulator::EncounterSimulator(std::span<const Statblock> party,
+                                       std::span<const Statblock> monsters)
+{
+  for (const Statblock& statblock : party)
+  {
+    AddCombatant(statblock, Side::PARTY);
+  }
+  for (const Statblock& statblock : monsters)
+  {
+    AddCombatant(statblock, Side::MONSTERS);
+  }
+}
+
+std::pmr::vector<AttackEffect> EncounterSimulator::BestTurn(const Statblock& statblock,
+                                                            std::pmr::memory_resource* resource)
+{
+  const std::pmr::vector<Action>& actions = statblock.GetActions(ActionType::ACTION);
+  std::pmr::vector<AttackEffect> best_turn(resource);
+  double best = -1.0;
+
+  for (const Action& action : actions)
+  {
+    std::pmr::vector<AttackEffect> turn(resource);
+    if (const AttackEffect* attack = std::get_if<AttackEffect>(&action.effect))
+    {
+      turn.push_back(*attack);
+    }
+    else if (const MultiattackEffect* multiattack = std::get_if<MultiattackEffect>(&action.effect))
+    {
+      for (std::uint8_t index : multiattack->actions)
+      {
+        const AttackEffect* attack = index < actions.size() ? std::get_if<AttackEffect>(&actions[index].effect)
+                                                            : nullptr;
+        if (attack)
+        {
+          turn.push_back(*attack);
+        }
+      }
+    }
+
+    double expected = 0.0;
+    for (const AttackEffect& attack : turn)
+    {
+      expected += attack.damage.Mean();
+    }
+    if (!turn.empty() && expected > best)
+    {
+      best = expected;
+      best_turn = std::move(turn);
+    }
+  }
+
+  return best_turn;
+}
+
+void EncounterSimulator::AddCombatant(const Statblock& statblock, Side side)
+{
+  // Candidate turns are scratch, carved out of one stack buffer
+  std::byte buffer[2048];
+  std::pmr::monotonic_buffer_resource scratch(buffer, sizeof(buffer));
+  const std::pmr::vector<AttackEffect> best_turn = BestTurn(statblock, &scratch);
+
+  _combatants.push_back({side,
+                         statblock.GetHP(),
+                         statblock.GetAC(),
+                         statblock.GetModifier<Stats::DEX>(),
+                         static_cast<std::uint32_t>(_attacks.size()),
+                         static_cast<std::uint32_t>(best_turn.size())});
+  _attacks.insert(_attacks.end(), best_turn.begin(), best_turn.end());
+}
+
+TrialOutcome EncounterSimulator::RunTrial(DiceEngine& engine) const
+{
+  thread_local std::vector<int> hit_points;
+  thread_local std::vector<int> initiative;
+  thread_local std::vector<std::size_t> order;
+
+  const std::size_t count = _combatants.size();
+  TrialOutcome outcome;
+  int alive[2] {0, 0};
+
+  hit_points.resize(count);
+  initiative.resize(count);
+  order.resize(count);
+
+  engine.RollMany(count, 20, initiative);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    hit_points[i] = _combatants[i].hitPoints;
+    initiative[i] += _combatants[i].initiativeBonus;
+    alive[SideIndex(_combatants[i].side)]++;
+  }
+
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [](std::size_t a, std::size_t b) {
+    return initiative[a] > initiative[b];
+  });
+
+  if (alive[0] == 0 || alive[1] == 0)
+  {
+    outcome.winner = alive[0] ? Side::PARTY : (alive[1] ? Side::MONSTERS : Side::NONE);
+    return outcome;
+  }
+
+  for (int round = 1; round <= SimulationStats::kMaxRounds; round++)
+  {
+    outcome.rounds = round;
+
+    for (std::size_t attacker : order)
+    {
+      const Combatant& me = _combatants[attacker];
+      if (hit_points[attacker] <= 0)
+      {
+        continue;
+      }
+
+      for (std::uint32_t a = me.firstAttack; a < me.firstAttack + me.attackCount; a++)
+      {
+        const AttackEffect& attack = _attacks[a];
+
+        std::size_t target = count;
+        for (std::size_t i = 0; i < count; i++)
+        {
+          if (_combatants[i].side != me.side && hit_points[i] > 0 &&
+              (target == count || hit_points[i] < hit_points[target]))
+          {
+            target = i;
+          }
+        }
+
+        const int d20 = engine.RollOne(20);
+        const bool critical = d20 == 20;
+        if (d20 == 1 || (!critical && d20 + attack.attackBonus < _combatants[target].armorClass))
+        {
+          continue;
+        }
+
+        int damage = attack.damage.Roll(engine);
+        if (critical)
+        {
+          damage += attack.damage.Roll(engine) - attack.damage.modifier;
+        }
+        damage = std::max(damage, 0);
+
+        const int target_side = SideIndex(_combatants[target].side);
+        hit_points[target] -= damage;
+        outcome.damageTaken[target_side] += damage;
+
+        if (hit_points[target] <= 0 && --alive[target_side] == 0)
+        {
+          outcome.winner = me.side;
+          return outcome;
+        }
+      }
+    }
+  }
+
+  return outcome;
+}
+
+SimulationStats EncounterSimulator::Run(std::size_t trials,
+                                        std::uint64_t seed,
+                                        ThreadPool& pool) const
+{
+  return Run(0, trials, seed, pool);
+}
+
+SimulationStats EncounterSimulator::Run(std::size_t firstTrial,
+                                        std::size_t trials,
+                                        std::uint64_t seed,
+                                        ThreadPool& pool) const
+{
+  std::vector<SimulationStats> per_worker(pool.NumWorkers());
+
+  pool.ParallelFor(trials, kTrialsPerTask, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+    PROFILE_ZONE("EncounterSimulator trials");
+    SimulationStats& stats = per_worker[worker];
+    DiceEngine engine(seed);
+
+    for (std::size_t trial = firstTrial + begin; trial < firstTrial + end; trial++)
+    {
+      engine.Seed(seed, trial);
+      stats.Add(RunTrial(engine));
+    }
+  });
+
+  SimulationStats total;
+  for (const SimulationStats& stats : per_worker)
+  {
+    total.Merge(stats);
+  }
+  return total;
+}
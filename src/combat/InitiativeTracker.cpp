@@ -0,0 +1,309 @@
+#include "combat/InitiativeTracker.h"
+
+#include <algorithm>
+
+#include "rules/AbilityTables.h"
+#include "rules/Roll.h"
+
+namespace
+{
+
+constexpr std::uint32_t kArrivalMask = (1u << 24) - 1;
+
+}
+
+
+std::uint64_t InitiativeTracker::PackKey(int round, int initiative, int dexterity, std::uint32_t arrival, int phase)
+{
+  // Bits: round 63-48, initiative 47-40 and DEX 39-32 (both inverted so that
+  // higher goes first), arrival 31-8, interrupt phase 7-0
+  const std::uint64_t packed_round = std::clamp(round, 0, 0xFFFF);
+  const std::uint64_t packed_initiative = 127 - std::clamp(initiative, -128, 127);
+  const std::uint64_t packed_dexterity = 255 - std::clamp(dexterity, 0, 255);
+  const std::uint64_t packed_phase = std::clamp(phase, 0, 255);
+
+  return packed_round << 48 | packed_initiative << 40 | packed_dexterity << 32 |
+         static_cast<std::uint64_t>(arrival & kArrivalMask) << 8 | packed_phase;
+}
+
+int InitiativeTracker::RoundOf(std::uint64_t key)
+{
+  return static_cast<int>(key >> 48);
+}
+
+
+CombatantId InitiativeTracker::Add(const Statblock& statblock)
+{
+  const int dexterity = statblock.GetStat<Stats::DEX>();
+  return Add(Die::Roll(1, 20) + AbilityModifier(dexterity), dexterity);
+}
+
+CombatantId InitiativeTracker::Add(int initiative, int dexterity)
+{
+  const std::uint32_t id = NewEntry();
+  Entry& entry = _entries[id];
+  entry.combatant = id;
+  entry.arrival = _arrivals++;
+  entry.initiative = initiative;
+  entry.dexterity = dexterity;
+
+  const int round = std::max(_current.round, 1);
+  entry.key = PackKey(round, initiative, dexterity, entry.arrival, 0);
+  if (_current.combatant != kNoCombatant && entry.key < _current_key)
+  {
+    entry.key = PackKey(round + 1, initiative, dexterity, entry.arrival, 0);
+  }
+
+  Push(id);
+  _combatants++;
+  return id;
+}
+
+void InitiativeTracker::Remove(CombatantId id)
+{
+  if (!Contains(id))
+  {
+    return;
+  }
+  // Its pending interrupts are dropped when they come up
+  Erase(id);
+  FreeEntry(id);
+  _combatants--;
+}
+
+bool InitiativeTracker::Contains(CombatantId id) const
+{
+  return id < _entries.size() && _entries[id].used && !_entries[id].interrupt;
+}
+
+std::size_t InitiativeTracker::Size() const
+{
+  return _combatants;
+}
+
+int InitiativeTracker::InitiativeOf(CombatantId id) const
+{
+  if (!Contains(id))
+  {
+    return 0;
+  }
+  return _entries[id].initiative;
+}
+
+Turn InitiativeTracker::NextTurn()
+{
+  while (!_heap.empty())
+  {
+    const std::uint32_t top = _heap.front();
+    Entry& entry = _entries[top];
+
+    if (entry.interrupt)
+    {
+      const Turn turn {entry.combatant, RoundOf(entry.key), true};
+      const std::uint32_t arrival = entry.arrival;
+      Erase(top);
+      FreeEntry(top);
+
+      if (Contains(turn.combatant) && _entries[turn.combatant].arrival == arrival)
+      {
+        _current = turn;
+        return _current;
+      }
+      continue;
+    }
+
+    _current = {top, RoundOf(entry.key), false};
+    _current_key = entry.key;
+    _interrupt_phase = 0;
+
+    entry.key = PackKey(_current.round + 1, entry.initiative, entry.dexterity, entry.arrival, 0);
+    SiftDown(entry.position);
+    return _current;
+  }
+
+  _current = {};
+  return _current;
+}
+
+Turn InitiativeTracker::Current() const
+{
+  return _current;
+}
+
+int InitiativeTracker::Round() const
+{
+  return _current.round;
+}
+
+void InitiativeTracker::Delay(CombatantId id, int initiative)
+{
+  if (!Contains(id))
+  {
+    return;
+  }
+  Entry& entry = _entries[id];
+  entry.initiative = initiative;
+  entry.key = PackKey(RoundOf(entry.key), initiative, entry.dexterity, entry.arrival, 0);
+
+  // NextTurn already moved the acting combatant on to the next round. It
+  // acts again this round only at a count after the turn it just took.
+  if (id == _current.combatant && !_current.interrupt)
+  {
+    const std::uint64_t this_round = PackKey(_current.round, initiative, entry.dexterity, entry.arrival, 0);
+    if (this_round > _current_key)
+    {
+      entry.key = this_round;
+    }
+  }
+  Fix(id);
+}
+
+void InitiativeTracker::Interrupt(CombatantId id)
+{
+  if (!Contains(id))
+  {
+    return;
+  }
+  const std::uint32_t interrupt = NewEntry();
+  Entry& entry = _entries[interrupt];
+  entry.interrupt = true;
+  entry.combatant = id;
+  entry.arrival = _entries[id].arrival;
+  // Same key as the turn being taken, one phase later
+  entry.key = (_current_key & ~std::uint64_t{0xFF}) | std::min(++_interrupt_phase, 255);
+  Push(interrupt);
+}
+
+std::pmr::vector<Turn> InitiativeTracker::Order(std::pmr::memory_resource* scratch) const
+{
+  std::pmr::vector<std::uint32_t> order(_heap.begin(), _heap.end(), scratch);
+  std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+    return _entries[a].key < _entries[b].key;
+  });
+
+  std::pmr::vector<Turn> turns(scratch);
+  turns.reserve(order.size());
+  for (std::uint32_t index : order)
+  {
+    const Entry& entry = _entries[index];
+    if (!entry.interrupt || (Contains(entry.combatant) && _entries[entry.combatant].arrival == entry.arrival))
+    {
+      turns.push_back({entry.combatant, RoundOf(entry.key), entry.interrupt});
+    }
+  }
+  return turns;
+}
+
+std::uint32_t InitiativeTracker::NewEntry()
+{
+  std::uint32_t id;
+  if (!_free.empty())
+  {
+    id = _free.back();
+    _free.pop_back();
+  }
+  else
+  {
+    id = static_cast<std::uint32_t>(_entries.size());
+    _entries.emplace_back();
+  }
+
+  _entries[id] = Entry {};
+  _entries[id].used = true;
+  return id;
+}
+
+void InitiativeTracker::FreeEntry(std::uint32_t entry)
+{
+  _entries[entry].used = false;
+  _free.push_back(entry);
+}
+
+void InitiativeTracker::Push(std::uint32_t entry)
+{
+  _entries[entry].position = static_cast<std::uint32_t>(_heap.size());
+  _heap.push_back(entry);
+  SiftUp(_heap.size() - 1);
+}
+
+void InitiativeTracker::Erase(std::uint32_t entry)
+{
+  const std::size_t index = _entries[entry].position;
+  const std::uint32_t last = _heap.back();
+  _heap.pop_back();
+
+  if (index < _heap.size())
+  {
+    _heap[index] = last;
+    _entries[last].position = static_cast<std::uint32_t>(index);
+    Fix(last);
+  }
+}
+
+void InitiativeTracker::Fix(std::uint32_t entry)
+{
+  SiftUp(_entries[entry].position);
+  SiftDown(_entries[entry].position);
+}
+
+void InitiativeTracker::SiftUp(std::size_t index)
+{
+  const std::uint32_t moving = _heap[index];
+  const std::uint64_t key = _entries[moving].key;
+
+  while (index > 0)
+  {
+    const std::size_t parent = (index - 1) / kArity;
+    const std::uint32_t above = _heap[parent];
+    if (_entries[above].key <= key)
+    {
+      break;
+    }
+    _heap[index] = above;
+    _entries[above].position = static_cast<std::uint32_t>(index);
+    index = parent;
+  }
+
+  _heap[index] = moving;
+  _entries[moving].position = static_cast<std::uint32_t>(index);
+}
+
+void InitiativeTracker::SiftDown(std::size_t index)
+{
+  const std::uint32_t moving = _heap[index];
+  const std::uint64_t key = _entries[moving].key;
+  const std::size_t size = _heap.size();
+
+  while (true)
+  {
+    const std::size_t first = index * kArity + 1;
+    if (first >= size)
+    {
+      break;
+    }
+
+    std::size_t best = first;
+    std::uint64_t best_key = _entries[_heap[first]].key;
+    const std::size_t last = std::min(first + kArity, size);
+    for (std::size_t child = first + 1; child < last; child++)
+    {
+      const std::uint64_t child_key = _entries[_heap[child]].key;
+      if (child_key < best_key)
+      {
+        best = child;
+        best_key = child_key;
+      }
+    }
+
+    if (best_key >= key)
+    {
+      break;
+    }
+    _heap[index] = _heap[best];
+    _entries[_heap[index]].position = static_cast<std::uint32_t>(index);
+    index = best;
+  }
+
+  _heap[index] = moving;
+  _entries[moving].position = static_cast<std::uint32_t>(index);
+}
@@ -0,0 +1,768 @@
+#include "entities/Bestiary.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr char kMagic[8] = {'D', 'N', 'D', 'B', 'E', 'A', 'S', 'T'};
+constexpr std::uint32_t kVersion = 1;
+
+// Damage expressions are stored as they are in memory
+static_assert(std::is_trivially_copyable_v<DiceExpression>);
+
+// File layout: header, creature records sorted by name, action records,
+// distinct damage expressions, multiattack indices, name bytes, CR index.
+// Every section starts 8 byte aligned.
+struct BestiaryHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t count;
+  std::uint32_t actionCount;
+  std::uint32_t expressionCount;
+  std::uint32_t expressionSize;   // sizeof(DiceExpression) of the writer
+  std::uint32_t reserved;
+  std::uint64_t creaturesOffset;
+  std::uint64_t actionsOffset;
+  std::uint64_t expressionsOffset;
+  std::uint64_t multiattackOffset;
+  std::uint64_t namesOffset;
+  std::uint64_t challengeOffset;
+  std::uint64_t fileSize;
+};
+
+struct CreatureRecord
+{
+  std::uint32_t nameOffset;
+  std::uint32_t nameLength;
+  float cr;
+  std::int32_t hitPoints;
+  std::int32_t armorClass;
+  std::int32_t stats[6];
+  std::uint32_t firstAction[kNumActionTypes];
+  std::uint16_t actionCount[kNumActionTypes];
+};
+
+struct ActionRecord
+{
+  std::uint32_t nameOffset;
+  std::uint32_t nameLength;
+  std::uint32_t expression;
+  std::uint32_t firstIndex;       // Of a multiattack, in the index section
+  std::uint16_t indexCount;
+  std::uint8_t kind;
+  std::uint8_t save;
+  std::int32_t bonus;             // Attack bonus, or DC of a saving throw
+  std::uint8_t halfOnSuccess;
+};
+
+const BestiaryHeader& Header(const std::uint8_t* data)
+{
+  return *reinterpret_cast<const BestiaryHeader*>(data);
+}
+
+const CreatureRecord& CreatureAt(const std::uint8_t* data, std::size_t index)
+{
+  return reinterpret_cast<const CreatureRecord*>(data + Header(data).creaturesOffset)[index];
+}
+
+std::string_view NameAt(const std::uint8_t* data, std::uint32_t offset, std::uint32_t length)
+{
+  return std::string_view(reinterpret_cast<const char*>(data + Header(data).namesOffset) + offset, length);
+}
+
+std::uint64_t Align8(std::uint64_t offset)
+{
+  return (offset + 7) & ~std::uint64_t{7};
+}
+
+bool ValidHeader(const BestiaryHeader& header, std::size_t size)
+{
+  const bool aligned = (header.creaturesOffset | header.actionsOffset | header.expressionsOffset |
+                        header.multiattackOffset | header.namesOffset | header.challengeOffset) % 8 == 0;
+
+  // Offsets are checked to be in order and inside the file before any of
+  // the section ends is computed, so those cannot overflow
+  return aligned &&
+         std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+         header.version == kVersion &&
+         header.expressionSize == sizeof(DiceExpression) &&
+         header.fileSize == size &&
+         header.creaturesOffset >= sizeof(BestiaryHeader) &&
+         header.creaturesOffset <= header.actionsOffset &&
+         header.actionsOffset <= header.expressionsOffset &&
+         header.expressionsOffset <= header.multiattackOffset &&
+         header.multiattackOffset <= header.namesOffset &&
+         header.namesOffset <= header.challengeOffset &&
+         header.challengeOffset <= size &&
+         header.creaturesOffset + header.count * sizeof(CreatureRecord) <= header.actionsOffset &&
+         header.actionsOffset + header.actionCount * sizeof(ActionRecord) <= header.expressionsOffset &&
+         header.expressionsOffset + header.expressionCount * sizeof(DiceExpression) <= header.multiattackOffset &&
+         header.challengeOffset + header.count * sizeof(std::uint32_t) <= size;
+}
+
+// Every name, action, damage expression, multiattack index and CR index
+// entry a creature leads to lies inside its section, so the views can read
+// them unchecked.
+bool ValidRecords(const std::uint8_t* data)
+{
+  const BestiaryHeader& header = Header(data);
+  const std::uint64_t names_size = header.challengeOffset - header.namesOffset;
+  const std::uint64_t indices_size = header.namesOffset - header.multiattackOffset;
+  const ActionRecord* actions = reinterpret_cast<const ActionRecord*>(data + header.actionsOffset);
+
+  auto valid_name = [&](std::uint32_t offset, std::uint32_t length) {
+    return std::uint64_t{offset} + length <= names_size;
+  };
+
+  for (std::size_t i = 0; i < header.count; i++)
+  {
+    const CreatureRecord& creature = CreatureAt(data, i);
+    if (!valid_name(creature.nameOffset, creature.nameLength))
+    {
+      return false;
+    }
+
+    for (int type = 0; type < kNumActionTypes; type++)
+    {
+      const std::uint64_t first = creature.firstAction[type];
+      const std::uint16_t count = creature.actionCount[type];
+      if (first + count > header.actionCount)
+      {
+        return false;
+      }
+
+      for (std::uint64_t a = first; a < first + count; a++)
+      {
+        const ActionRecord& action = actions[a];
+        if (!valid_name(action.nameOffset, action.nameLength) ||
+            action.expression >= header.expressionCount ||
+            std::uint64_t{action.firstIndex} + action.indexCount > indices_size ||
+            action.kind >= std::variant_size_v<ActionEffect> ||
+            (action.kind == 1 && (action.save < 1 || action.save > kNumStats)))
+        {
+          return false;
+        }
+
+        // A multiattack names actions of its own list
+        const std::uint8_t* index = data + header.multiattackOffset + action.firstIndex;
+        if (std::any_of(index, index + action.indexCount, [&](std::uint8_t target) { return target >= count; }))
+        {
+          return false;
+        }
+      }
+    }
+  }
+
+  const std::uint32_t* by_challenge = reinterpret_cast<const std::uint32_t*>(data + header.challengeOffset);
+  return std::all_of(by_challenge, by_challenge + header.count, [&](std::uint32_t creature) {
+    return creature < header.count;
+  });
+}
+
+
+constexpr std::string_view kActionKeywords[kNumActionTypes] = {
+  "action", "bonus_action", "reaction", "legendary_action", "legendary_reaction",
+};
+
+constexpr std::string_view kStatNames[6] = {"STR", "DEX", "CON", "WIS", "INT", "CHA"};
+
+std::string_view Trim(std::string_view text)
+{
+  const std::size_t first = text.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos)
+  {
+    return {};
+  }
+  return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+// Splits off the first word of text.
+std::string_view NextWord(std::string_view& text)
+{
+  text = Trim(text);
+  const std::size_t end = std::min(text.find_first_of(" \t"), text.size());
+  const std::string_view word = text.substr(0, end);
+  text = Trim(text.substr(end));
+  return word;
+}
+
+template <typename T>
+T ParseNumber(std::string_view text)
+{
+  if (!text.empty() && text.front() == '+')
+  {
+    text.remove_prefix(1);
+  }
+
+  T value {};
+  const auto [end, status] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (status != std::errc() || end != text.data() + text.size())
+  {
+    throw std::invalid_argument(std::format("expected a number, got \"{}\"", text));
+  }
+  return value;
+}
+
+float ParseCR(std::string_view text)
+{
+  const std::size_t slash = text.find('/');
+  if (slash == std::string_view::npos)
+  {
+    return ParseNumber<float>(text);
+  }
+
+  const int denominator = ParseNumber<int>(text.substr(slash + 1));
+  if (denominator <= 0)
+  {
+    throw std::invalid_argument("CR with a zero denominator");
+  }
+  return static_cast<float>(ParseNumber<int>(text.substr(0, slash))) / denominator;
+}
+
+Stats ParseStat(std::string_view text)
+{
+  for (int stat = 0; stat < 6; stat++)
+  {
+    if (text == kStatNames[stat])
+    {
+      return static_cast<Stats>(stat + 1);
+    }
+  }
+  throw std::invalid_argument(std::format("unknown ability \"{}\"", text));
+}
+
+// Action lists of the creature being read. Multiattacks name their actions,
+// which may come later in the list, so the lists are only added to the
+// Statblock once the creature is complete.
+struct ActionLists
+{
+  std::vector<Action> lists[kNumActionTypes];
+  std::vector<std::vector<std::string>> multiattacks[kNumActionTypes];   // Parallel to lists
+
+  void AddTo(Statblock& statblock)
+  {
+    for (int type = 0; type < kNumActionTypes; type++)
+    {
+      for (std::size_t i = 0; i < lists[type].size(); i++)
+      {
+        if (auto* effect = std::get_if<MultiattackEffect>(&lists[type][i].effect))
+        {
+          Resolve(lists[type], multiattacks[type][i], *effect);
+        }
+        statblock.AddAction(static_cast<ActionType>(type), lists[type][i]);
+      }
+      lists[type].clear();
+      multiattacks[type].clear();
+    }
+  }
+
+  static void Resolve(const std::vector<Action>& list, const std::vector<std::string>& names,
+                      MultiattackEffect& effect)
+  {
+    for (const std::string& name : names)
+    {
+      auto it = std::find_if(list.begin(), list.end(), [&](const Action& action) {
+        return std::string_view(action.name) == name;
+      });
+      if (it == list.end() || std::holds_alternative<MultiattackEffect>(it->effect))
+      {
+        throw std::invalid_argument(std::format("multiattack names unknown action \"{}\"", name));
+      }
+      effect.actions.push_back(static_cast<std::uint8_t>(it - list.begin()));
+    }
+  }
+};
+
+Action ParseAction(std::string_view text, std::vector<std::string>& multiattack)
+{
+  const std::size_t colon = text.find(':');
+  if (colon == std::string_view::npos)
+  {
+    throw std::invalid_argument("expected \"<name>: <attack|save|multiattack> ...\"");
+  }
+
+  Action action;
+  action.name = Trim(text.substr(0, colon));
+  std::string_view rest = text.substr(colon + 1);
+  const std::string_view kind = NextWord(rest);
+
+  if (kind == "attack")
+  {
+    AttackEffect attack;
+    attack.attackBonus = ParseNumber<int>(NextWord(rest));
+    attack.damage = DiceExpression::Parse(rest);
+    action.effect = attack;
+  }
+  else if (kind == "save")
+  {
+    SaveEffect save;
+    save.save = ParseStat(NextWord(rest));
+    save.dc = ParseNumber<int>(NextWord(rest));
+
+    const std::size_t last_space = rest.find_last_of(" \t");
+    const std::string_view last = last_space == std::string_view::npos ? rest : rest.substr(last_space + 1);
+    if (last == "half" || last == "none")
+    {
+      save.halfOnSuccess = last == "half";
+      rest = Trim(rest.substr(0, rest.size() - last.size()));
+    }
+    save.damage = DiceExpression::Parse(rest);
+    action.effect = save;
+  }
+  else if (kind == "multiattack")
+  {
+    while (!rest.empty())
+    {
+      const std::size_t comma = std::min(rest.find(','), rest.size());
+      multiattack.emplace_back(Trim(rest.substr(0, comma)));
+      rest = rest.substr(std::min(comma + 1, rest.size()));
+    }
+    action.effect = MultiattackEffect {};
+  }
+  else
+  {
+    throw std::invalid_argument(std::format("unknown action kind \"{}\"", kind));
+  }
+
+  return action;
+}
+
+}
+
+
+bool ParseBestiary(std::istream& in, std::vector<BestiaryEntry>& entries, std::string& error)
+{
+  ActionLists actions;
+  bool in_creature = false;
+  std::string line;
+  int line_number = 0;
+
+  try
+  {
+    auto finish = [&] {
+      if (in_creature)
+      {
+        actions.AddTo(entries.back().statblock);
+      }
+    };
+
+    while (std::getline(in, line))
+    {
+      line_number++;
+      std::string_view rest = Trim(line);
+      if (rest.empty() || rest.front() == '#')
+      {
+        continue;
+      }
+
+      const std::string_view keyword = NextWord(rest);
+      if (keyword == "creature")
+      {
+        finish();
+        if (rest.empty())
+        {
+          throw std::invalid_argument("creature without a name");
+        }
+        entries.push_back({std::string(rest), Statblock {}});
+        in_creature = true;
+        continue;
+      }
+      if (!in_creature)
+      {
+        throw std::invalid_argument("expected \"creature <name>\" first");
+      }
+
+      Statblock& statblock = entries.back().statblock;
+      if (keyword == "cr")
+      {
+        statblock.SetCR(ParseCR(rest));
+      }
+      else if (keyword == "hp")
+      {
+        statblock.SetHP(ParseNumber<int>(rest));
+      }
+      else if (keyword == "ac")
+      {
+        statblock.SetAC(ParseNumber<int>(rest));
+      }
+      else if (keyword == "stats")
+      {
+        while (!rest.empty())
+        {
+          const Stats stat = ParseStat(NextWord(rest));
+          statblock.SetStat(stat, ParseNumber<int>(NextWord(rest)));
+        }
+      }
+      else
+      {
+        auto type = std::find(std::begin(kActionKeywords), std::end(kActionKeywords), keyword);
+        if (type == std::end(kActionKeywords))
+        {
+          throw std::invalid_argument(std::format("unknown keyword \"{}\"", keyword));
+        }
+
+        const std::size_t list = type - std::begin(kActionKeywords);
+        std::vector<std::string> names;
+        actions.lists[list].push_back(ParseAction(rest, names));
+        actions.multiattacks[list].push_back(std::move(names));
+      }
+    }
+
+    finish();
+  }
+  catch (const std::invalid_argument& problem)
+  {
+    error = std::format("line {}: {}", line_number, problem.what());
+    return false;
+  }
+
+  return true;
+}
+
+
+Action ActionView::ToAction() const
+{
+  switch (kind)
+  {
+    case 0:
+      return Action(name, AttackEffect {attackBonus, *damage});
+
+    case 1:
+      return Action(name, SaveEffect {save, dc, *damage, halfOnSuccess});
+
+    default:
+      return Action(name, MultiattackEffect {{multiattack.begin(), multiattack.end()}});
+  }
+}
+
+
+CreatureView::CreatureView(const Bestiary& bestiary, std::size_t index)
+  : _bestiary(&bestiary), _index(index)
+{
+
+}
+
+std::string_view CreatureView::Name() const
+{
+  const CreatureRecord& record = CreatureAt(_bestiary->_data, _index);
+  return NameAt(_bestiary->_data, record.nameOffset, record.nameLength);
+}
+
+float CreatureView::GetCR() const
+{
+  return CreatureAt(_bestiary->_data, _index).cr;
+}
+
+int CreatureView::GetHP() const
+{
+  return CreatureAt(_bestiary->_data, _index).hitPoints;
+}
+
+int CreatureView::GetAC() const
+{
+  return CreatureAt(_bestiary->_data, _index).armorClass;
+}
+
+int CreatureView::GetStat(Stats stat) const
+{
+  return CreatureAt(_bestiary->_data, _index).stats[StatIndex(stat)];
+}
+
+std::size_t CreatureView::NumActions(ActionType type) const
+{
+  return CreatureAt(_bestiary->_data, _index).actionCount[static_cast<int>(type)];
+}
+
+ActionView CreatureView::GetAction(ActionType type, std::size_t index) const
+{
+  const std::uint8_t* data = _bestiary->_data;
+  const BestiaryHeader& header = Header(data);
+  const std::size_t action = CreatureAt(data, _index).firstAction[static_cast<int>(type)] + index;
+  const ActionRecord& record = reinterpret_cast<const ActionRecord*>(data + header.actionsOffset)[action];
+
+  return ActionView {
+    NameAt(data, record.nameOffset, record.nameLength),
+    type,
+    record.kind,
+    record.bonus,
+    static_cast<Stats>(record.save),
+    record.bonus,
+    record.halfOnSuccess != 0,
+    reinterpret_cast<const DiceExpression*>(data + header.expressionsOffset) + record.expression,
+    std::span<const std::uint8_t>(data + header.multiattackOffset + record.firstIndex, record.indexCount),
+  };
+}
+
+Statblock CreatureView::ToStatblock() const
+{
+  Statblock statblock;
+  statblock.SetCR(GetCR());
+  statblock.SetHP(GetHP());
+  statblock.SetAC(GetAC());
+  for (Stats stat : kAllStats)
+  {
+    statblock.SetStat(stat, GetStat(stat));
+  }
+  for (int type = 0; type < kNumActionTypes; type++)
+  {
+    const ActionType action_type = static_cast<ActionType>(type);
+    for (std::size_t i = 0; i < NumActions(action_type); i++)
+    {
+      statblock.AddAction(action_type, GetAction(action_type, i).ToAction());
+    }
+  }
+  return statblock;
+}
+
+
+void BestiaryWriter::Add(std::string name, const Statblock& statblock)
+{
+  _entries.push_back({std::move(name), statblock});
+}
+
+bool BestiaryWriter::Write(const std::string& path) const
+{
+  std::vector<const BestiaryEntry*> sorted;
+  for (const BestiaryEntry& entry : _entries)
+  {
+    sorted.push_back(&entry);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [](const BestiaryEntry* a, const BestiaryEntry* b) {
+    return a->name < b->name;
+  });
+
+  std::vector<CreatureRecord> creatures;
+  std::vector<ActionRecord> actions;
+  std::vector<DiceExpression> expressions;
+  std::unordered_map<DiceExpression, std::uint32_t, DiceExpressionHash> expression_index;
+  std::vector<std::uint8_t> indices;
+  std::string names;
+
+  auto add_name = [&](std::string_view name) {
+    const std::uint32_t offset = static_cast<std::uint32_t>(names.size());
+    names += name;
+    return offset;
+  };
+
+  for (const BestiaryEntry* entry : sorted)
+  {
+    const Statblock& statblock = entry->statblock;
+    CreatureRecord record {};
+    record.nameLength = static_cast<std::uint32_t>(entry->name.size());
+    record.nameOffset = add_name(entry->name);
+    record.cr = statblock.GetCR();
+    record.hitPoints = statblock.GetHP();
+    record.armorClass = statblock.GetAC();
+    for (Stats stat : kAllStats)
+    {
+      record.stats[StatIndex(stat)] = statblock.GetStat(stat);
+    }
+
+    for (int type = 0; type < kNumActionTypes; type++)
+    {
+      const std::pmr::vector<Action>& list = statblock.GetActions(static_cast<ActionType>(type));
+      record.firstAction[type] = static_cast<std::uint32_t>(actions.size());
+      record.actionCount[type] = static_cast<std::uint16_t>(list.size());
+
+      for (const Action& action : list)
+      {
+        ActionRecord stored {};
+        stored.nameLength = static_cast<std::uint32_t>(action.name.size());
+        stored.nameOffset = add_name(action.name);
+        stored.kind = static_cast<std::uint8_t>(action.effect.index());
+        DiceExpression damage {};
+
+        if (const auto* attack = std::get_if<AttackEffect>(&action.effect))
+        {
+          stored.bonus = attack->attackBonus;
+          damage = attack->damage;
+        }
+        else if (const auto* save = std::get_if<SaveEffect>(&action.effect))
+        {
+          stored.bonus = save->dc;
+          stored.save = static_cast<std::uint8_t>(save->save);
+          stored.halfOnSuccess = save->halfOnSuccess;
+          damage = save->damage;
+        }
+        else if (const auto* multiattack = std::get_if<MultiattackEffect>(&action.effect))
+        {
+          stored.firstIndex = static_cast<std::uint32_t>(indices.size());
+          stored.indexCount = static_cast<std::uint16_t>(multiattack->actions.size());
+          indices.insert(indices.end(), multiattack->actions.begin(), multiattack->actions.end());
+        }
+
+        auto [it, added] = expression_index.try_emplace(damage, static_cast<std::uint32_t>(expressions.size()));
+        if (added)
+        {
+          expressions.push_back(damage);
+        }
+        stored.expression = it->second;
+        actions.push_back(stored);
+      }
+    }
+
+    creatures.push_back(record);
+  }
+
+  std::vector<std::uint32_t> by_challenge(creatures.size());
+  for (std::size_t i = 0; i < by_challenge.size(); i++)
+  {
+    by_challenge[i] = static_cast<std::uint32_t>(i);
+  }
+  std::stable_sort(by_challenge.begin(), by_challenge.end(), [&](std::uint32_t a, std::uint32_t b) {
+    return creatures[a].cr < creatures[b].cr;
+  });
+
+  BestiaryHeader header {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.count = static_cast<std::uint32_t>(creatures.size());
+  header.actionCount = static_cast<std::uint32_t>(actions.size());
+  header.expressionCount = static_cast<std::uint32_t>(expressions.size());
+  header.expressionSize = sizeof(DiceExpression);
+  header.creaturesOffset = Align8(sizeof(BestiaryHeader));
+  header.actionsOffset = Align8(header.creaturesOffset + creatures.size() * sizeof(CreatureRecord));
+  header.expressionsOffset = Align8(header.actionsOffset + actions.size() * sizeof(ActionRecord));
+  header.multiattackOffset = Align8(header.expressionsOffset + expressions.size() * sizeof(DiceExpression));
+  header.namesOffset = Align8(header.multiattackOffset + indices.size());
+  header.challengeOffset = Align8(header.namesOffset + names.size());
+  header.fileSize = header.challengeOffset + by_challenge.size() * sizeof(std::uint32_t);
+
+  std::vector<char> file(header.fileSize, 0);
+  std::memcpy(file.data(), &header, sizeof(header));
+  std::memcpy(file.data() + header.creaturesOffset, creatures.data(), creatures.size() * sizeof(CreatureRecord));
+  std::memcpy(file.data() + header.actionsOffset, actions.data(), actions.size() * sizeof(ActionRecord));
+  std::memcpy(file.data() + header.expressionsOffset, expressions.data(), expressions.size() * sizeof(DiceExpression));
+  std::memcpy(file.data() + header.multiattackOffset, indices.data(), indices.size());
+  std::memcpy(file.data() + header.namesOffset, names.data(), names.size());
+  std::memcpy(file.data() + header.challengeOffset, by_challenge.data(), by_challenge.size() * sizeof(std::uint32_t));
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(file.data(), static_cast<std::streamsize>(file.size()));
+  return static_cast<bool>(out);
+}
+
+
+Bestiary::~Bestiary()
+{
+  Close();
+}
+
+bool Bestiary::Open(const std::string& path)
+{
+  Close();
+
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(BestiaryHeader))
+  {
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    return false;
+  }
+
+  _data = static_cast<const std::uint8_t*>(mapping);
+  _size = static_cast<std::size_t>(info.st_size);
+
+  if (!ValidHeader(Header(_data), _size) || !ValidRecords(_data))
+  {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void Bestiary::Close()
+{
+  if (_data)
+  {
+    munmap(const_cast<std::uint8_t*>(_data), _size);
+  }
+  _data = nullptr;
+  _size = 0;
+}
+
+std::size_t Bestiary::Size() const
+{
+  return _data ? Header(_data).count : 0;
+}
+
+CreatureView Bestiary::At(std::size_t index) const
+{
+  return CreatureView(*this, index);
+}
+
+std::size_t Bestiary::Find(std::string_view name) const
+{
+  std::size_t low = 0;
+  std::size_t high = Size();
+
+  while (low < high)
+  {
+    const std::size_t middle = (low + high) / 2;
+    const CreatureRecord& record = CreatureAt(_data, middle);
+    if (NameAt(_data, record.nameOffset, record.nameLength) < name)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  if (low < Size())
+  {
+    const CreatureRecord& record = CreatureAt(_data, low);
+    if (NameAt(_data, record.nameOffset, record.nameLength) == name)
+    {
+      return low;
+    }
+  }
+  return Size();
+}
+
+std::span<const std::uint32_t> Bestiary::ByChallenge(float minCR, float maxCR) const
+{
+  if (!_data)
+  {
+    return {};
+  }
+
+  const std::uint32_t* index = reinterpret_cast<const std::uint32_t*>(_data + Header(_data).challengeOffset);
+  const std::uint32_t* end = index + Size();
+
+  const std::uint32_t* first = std::partition_point(index, end, [&](std::uint32_t creature) {
+    return CreatureAt(_data, creature).cr < minCR;
+  });
+  const std::uint32_t* last = std::partition_point(first, end, [&](std::uint32_t creature) {
+    return CreatureAt(_data, creature).cr <= maxCR;
+  });
+  return std::span<const std::uint32_t>(first, last);
+}
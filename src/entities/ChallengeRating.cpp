@@ -0,0 +1,247 @@
+#include "entities/ChallengeRating.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "entities/Bestiary.h"
+#include "entities/Statblock.h"
+#include "utils/ThreadPool.h"
+
+namespace
+{
+
+constexpr std::size_t kRatingsPerTask = 256;
+
+// Dungeon Master's Guide, Monster Statistics by Challenge Rating
+struct StatisticsRow
+{
+  float cr;
+  int armorClass;
+  int maxHitPoints;
+  int attackBonus;
+  int maxDamage;
+  int saveDC;
+};
+
+constexpr StatisticsRow kTable[] = {
+  {0.0f, 13, 6, 3, 1, 13},        {0.125f, 13, 35, 3, 3, 13},     {0.25f, 13, 49, 3, 5, 13},
+  {0.5f, 13, 70, 3, 8, 13},       {1.0f, 13, 85, 3, 14, 13},      {2.0f, 13, 100, 3, 20, 13},
+  {3.0f, 13, 115, 4, 26, 13},     {4.0f, 14, 130, 5, 32, 14},     {5.0f, 15, 145, 6, 38, 15},
+  {6.0f, 15, 160, 6, 44, 15},     {7.0f, 15, 175, 6, 50, 15},     {8.0f, 16, 190, 7, 56, 16},
+  {9.0f, 16, 205, 7, 62, 16},     {10.0f, 17, 220, 7, 68, 16},    {11.0f, 17, 235, 8, 74, 17},
+  {12.0f, 17, 250, 8, 80, 17},    {13.0f, 18, 265, 8, 86, 18},    {14.0f, 18, 280, 8, 92, 18},
+  {15.0f, 18, 295, 8, 98, 18},    {16.0f, 18, 310, 9, 104, 18},   {17.0f, 19, 325, 10, 110, 19},
+  {18.0f, 19, 340, 10, 116, 19},  {19.0f, 19, 355, 10, 122, 19},  {20.0f, 19, 400, 10, 140, 19},
+  {21.0f, 19, 445, 11, 158, 20},  {22.0f, 19, 490, 11, 176, 20},  {23.0f, 19, 535, 11, 194, 20},
+  {24.0f, 19, 580, 12, 212, 21},  {25.0f, 19, 625, 12, 230, 21},  {26.0f, 19, 670, 12, 248, 21},
+  {27.0f, 19, 715, 13, 266, 22},  {28.0f, 19, 760, 13, 284, 22},  {29.0f, 19, 805, 13, 302, 22},
+  {30.0f, 19, 850, 14, 320, 23},
+};
+
+constexpr int kRows = static_cast<int>(std::size(kTable));
+
+// Moves from row by whole steps of two points, toward zero
+float Adjust(int row, int actual, int expected)
+{
+  return kTable[std::clamp(row + (actual - expected) / 2, 0, kRows - 1)].cr;
+}
+
+// One action as the offense profile sees it, so Statblocks and mapped
+// creatures share the code below.
+struct EffectInfo
+{
+  std::size_t kind;
+  int bonus;                        // Attack bonus or DC
+  const DiceExpression* damage;
+  std::span<const std::uint8_t> multiattack;
+};
+
+EffectInfo InfoOf(const Action& action)
+{
+  if (const auto* attack = std::get_if<AttackEffect>(&action.effect))
+  {
+    return {action.effect.index(), attack->attackBonus, &attack->damage, {}};
+  }
+  if (const auto* save = std::get_if<SaveEffect>(&action.effect))
+  {
+    return {action.effect.index(), save->dc, &save->damage, {}};
+  }
+  return {action.effect.index(), 0, nullptr, std::get<MultiattackEffect>(action.effect).actions};
+}
+
+EffectInfo InfoOf(const ActionView& action)
+{
+  return {action.kind, action.kind == 1 ? action.dc : action.attackBonus, action.damage, action.multiattack};
+}
+
+constexpr std::size_t kSaveKind = 1;
+
+// Best single turn of an action list; info(i) describes action i.
+template <typename Info>
+OffenseProfile BestTurn(std::size_t count, Info&& info)
+{
+  OffenseProfile best;
+
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const EffectInfo action = info(i);
+    double damage = 0.0;
+    double hardest = -1.0;
+    OffenseProfile turn;
+
+    auto add = [&](const EffectInfo& effect) {
+      const double mean = effect.damage->Mean();
+      damage += mean;
+      if (mean > hardest)
+      {
+        hardest = mean;
+        turn.usesSave = effect.kind == kSaveKind;
+        (turn.usesSave ? turn.saveDC : turn.attackBonus) = effect.bonus;
+      }
+    };
+
+    if (action.damage)
+    {
+      add(action);
+    }
+    for (std::uint8_t index : action.multiattack)
+    {
+      const EffectInfo part = index < count ? info(index) : EffectInfo {};
+      if (part.damage)
+      {
+        add(part);
+      }
+    }
+
+    turn.damagePerRound = damage;
+    if (damage > best.damagePerRound)
+    {
+      best = turn;
+    }
+  }
+
+  return best;
+}
+
+// The ACTION turn plus the best bonus action. Bonus and DC come from
+// whichever of the two hits harder.
+template <typename Creature>
+OffenseProfile Profile(const Creature& creature)
+{
+  OffenseProfile turns[2];
+  int slot = 0;
+
+  for (ActionType type : {ActionType::ACTION, ActionType::BONUS_ACTION})
+  {
+    if constexpr (std::is_same_v<Creature, Statblock>)
+    {
+      const std::pmr::vector<Action>& actions = creature.GetActions(type);
+      turns[slot++] = BestTurn(actions.size(), [&](std::size_t i) { return InfoOf(actions[i]); });
+    }
+    else
+    {
+      turns[slot++] = BestTurn(creature.NumActions(type), [&](std::size_t i) {
+        return InfoOf(creature.GetAction(type, i));
+      });
+    }
+  }
+
+  OffenseProfile profile = turns[0].damagePerRound >= turns[1].damagePerRound ? turns[0] : turns[1];
+  profile.damagePerRound = turns[0].damagePerRound + turns[1].damagePerRound;
+  return profile;
+}
+
+template <typename Creature>
+ChallengeRating Rate(const Creature& creature)
+{
+  ChallengeRating rating;
+  rating.defensive = DefensiveCR(creature.GetHP(), creature.GetAC());
+  rating.offensive = OffensiveCR(ProfileOffense(creature));
+  rating.cr = CombineCR(rating.offensive, rating.defensive);
+  return rating;
+}
+
+}
+
+
+float DefensiveCR(int hitPoints, int armorClass)
+{
+  int row = 0;
+  while (row < kRows - 1 && hitPoints > kTable[row].maxHitPoints)
+  {
+    row++;
+  }
+  return Adjust(row, armorClass, kTable[row].armorClass);
+}
+
+float OffensiveCR(const OffenseProfile& offense)
+{
+  const long damage = std::lround(offense.damagePerRound);
+  int row = 0;
+  while (row < kRows - 1 && damage > kTable[row].maxDamage)
+  {
+    row++;
+  }
+  return offense.usesSave ? Adjust(row, offense.saveDC, kTable[row].saveDC)
+                          : Adjust(row, offense.attackBonus, kTable[row].attackBonus);
+}
+
+float CombineCR(float offensive, float defensive)
+{
+  // Halfway between two table values rounds up
+  const float average = (offensive + defensive) / 2.0f;
+  float best = kTable[0].cr;
+  for (const StatisticsRow& row : kTable)
+  {
+    if (std::abs(row.cr - average) <= std::abs(best - average))
+    {
+      best = row.cr;
+    }
+  }
+  return best;
+}
+
+OffenseProfile ProfileOffense(const Statblock& statblock)
+{
+  return Profile(statblock);
+}
+
+OffenseProfile ProfileOffense(const CreatureView& creature)
+{
+  return Profile(creature);
+}
+
+ChallengeRating RateStatblock(const Statblock& statblock)
+{
+  return Rate(statblock);
+}
+
+ChallengeRating RateStatblock(const CreatureView& creature)
+{
+  return Rate(creature);
+}
+
+void RateAll(std::span<Statblock> statblocks, ThreadPool& pool)
+{
+  pool.ParallelFor(statblocks.size(), kRatingsPerTask, [&](std::size_t begin, std::size_t end, std::size_t) {
+    for (std::size_t i = begin; i < end; i++)
+    {
+      statblocks[i].GetCalculatedCR();
+    }
+  });
+}
+
+std::vector<ChallengeRating> RateAll(const Bestiary& bestiary, ThreadPool& pool)
+{
+  std::vector<ChallengeRating> ratings(bestiary.Size());
+  pool.ParallelFor(ratings.size(), kRatingsPerTask, [&](std::size_t begin, std::size_t end, std::size_t) {
+    for (std::size_t i = begin; i < end; i++)
+    {
+      ratings[i] = RateStatblock(bestiary.At(i));
+    }
+  });
+  return ratings;
+}
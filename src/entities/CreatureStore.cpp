@@ -0,0 +1,402 @@
+#include "entities/CreatureStore.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "rules/AbilityTables.h"
+
+
+StatblockView::StatblockView(const CreatureStore& store, std::size_t index)
+  : _store(&store), _index(index)
+{
+
+}
+
+float StatblockView::GetCR() const
+{
+  return _store->_cr[_index];
+}
+
+int StatblockView::GetHP() const
+{
+  return _store->_hit_points[_index];
+}
+
+int StatblockView::GetAC() const
+{
+  return _store->_armor_class[_index];
+}
+
+int StatblockView::GetStat(Stats stat) const
+{
+  return _store->_scores[stat][_index];
+}
+
+int StatblockView::GetModifier(Stats stat) const
+{
+  return AbilityModifier(GetStat(stat));
+}
+
+std::span<const Action> StatblockView::GetActions(ActionType type) const
+{
+  return _store->Actions(_index, type);
+}
+
+Statblock StatblockView::ToStatblock() const
+{
+  Statblock statblock;
+
+  statblock.SetCR(GetCR());
+  statblock.SetHP(GetHP());
+  statblock.SetAC(GetAC());
+  for (Stats stat : kAllStats)
+  {
+    statblock.SetStat(stat, GetStat(stat));
+  }
+  for (int level = 1; level <= 9; level++)
+  {
+    statblock.SetSpellSlots(level, _store->_max_spell_slots[_index][level - 1]);
+  }
+  for (int type = 0; type < kNumActionTypes; type++)
+  {
+    for (const Action& action : GetActions(static_cast<ActionType>(type)))
+    {
+      statblock.AddAction(static_cast<ActionType>(type), action);
+    }
+  }
+
+  return statblock;
+}
+
+
+CreatureHandle CreatureStore::Add(const Statblock& statblock)
+{
+  const std::uint32_t index = static_cast<std::uint32_t>(Size());
+
+  for (Stats stat : kAllStats)
+  {
+    _scores[stat].push_back(statblock.GetStat(stat));
+  }
+  _cr.push_back(statblock.GetCR());
+  _hit_points.push_back(statblock.GetHP());
+  _armor_class.push_back(statblock.GetAC());
+  _conditions.push_back(0);
+
+  std::array<std::uint8_t, 9> slots;
+  for (int level = 1; level <= 9; level++)
+  {
+    slots[level - 1] = static_cast<std::uint8_t>(statblock.GetSpellSlots(level));
+  }
+  _spell_slots.push_back(slots);
+  _max_spell_slots.push_back(slots);
+
+  for (int type = 0; type < kNumActionTypes; type++)
+  {
+    const std::pmr::vector<Action>& actions = statblock.GetActions(static_cast<ActionType>(type));
+    _action_ranges[type].push_back({static_cast<std::uint32_t>(_action_table.size()),
+                                    static_cast<std::uint32_t>(actions.size())});
+    _action_table.insert(_action_table.end(), actions.begin(), actions.end());
+  }
+
+  std::uint32_t slot;
+  if (!_free_slots.empty())
+  {
+    slot = _free_slots.back();
+    _free_slots.pop_back();
+  }
+  else
+  {
+    slot = static_cast<std::uint32_t>(_slot_to_dense.size());
+    _slot_to_dense.push_back(0);
+    _generations.push_back(0);
+  }
+
+  _slot_to_dense[slot] = index;
+  _dense_to_slot.push_back(slot);
+
+  return {slot, _generations[slot]};
+}
+
+void CreatureStore::Remove(CreatureHandle handle)
+{
+  if (!IsValid(handle))
+  {
+    return;
+  }
+
+  const std::size_t index = _slot_to_dense[handle.slot];
+  const std::size_t last = Size() - 1;
+
+  for (int type = 0; type < kNumActionTypes; type++)
+  {
+    _dead_actions += _action_ranges[type][index].count;
+  }
+
+  // Move the last creature into the hole so the columns stay dense.
+  for (AlignedVector<int>& scores : _scores.values)
+  {
+    scores[index] = scores[last];
+    scores.pop_back();
+  }
+  _cr[index] = _cr[last];
+  _cr.pop_back();
+  _hit_points[index] = _hit_points[last];
+  _hit_points.pop_back();
+  _armor_class[index] = _armor_class[last];
+  _armor_class.pop_back();
+  _conditions[index] = _conditions[last];
+  _conditions.pop_back();
+  _spell_slots[index] = _spell_slots[last];
+  _spell_slots.pop_back();
+  _max_spell_slots[index] = _max_spell_slots[last];
+  _max_spell_slots.pop_back();
+  for (int type = 0; type < kNumActionTypes; type++)
+  {
+    _action_ranges[type][index] = _action_ranges[type][last];
+    _action_ranges[type].pop_back();
+  }
+
+  const std::uint32_t moved_slot = _dense_to_slot[last];
+  _dense_to_slot[index] = moved_slot;
+  _slot_to_dense[moved_slot] = static_cast<std::uint32_t>(index);
+  _dense_to_slot.pop_back();
+
+  _generations[handle.slot]++;
+  _free_slots.push_back(handle.slot);
+
+  if (_dead_actions > _action_table.size() / 2)
+  {
+    CompactActions();
+  }
+}
+
+bool CreatureStore::IsValid(CreatureHandle handle) const
+{
+  // Removing a creature bumps the generation of its slot, which invalidates
+  // every handle to it even after the slot is reused.
+  return handle.slot < _generations.size() && _generations[handle.slot] == handle.generation;
+}
+
+std::size_t CreatureStore::Size() const
+{
+  return _cr.size();
+}
+
+void CreatureStore::Clear()
+{
+  for (std::uint32_t slot : _dense_to_slot)
+  {
+    _generations[slot]++;
+    _free_slots.push_back(slot);
+  }
+  for (AlignedVector<int>& scores : _scores.values)
+  {
+    scores.clear();
+  }
+  _cr.clear();
+  _hit_points.clear();
+  _armor_class.clear();
+  _conditions.clear();
+  _spell_slots.clear();
+  _max_spell_slots.clear();
+  for (int type = 0; type < kNumActionTypes; type++)
+  {
+    _action_ranges[type].clear();
+  }
+  _action_table.clear();
+  _dead_actions = 0;
+  _dense_to_slot.clear();
+}
+
+StatblockView CreatureStore::View(CreatureHandle handle) const
+{
+  return StatblockView(*this, IndexOf(handle));
+}
+
+std::size_t CreatureStore::IndexOf(CreatureHandle handle) const
+{
+  return _slot_to_dense[handle.slot];
+}
+
+CreatureHandle CreatureStore::HandleAt(std::size_t index) const
+{
+  const std::uint32_t slot = _dense_to_slot[index];
+  return {slot, _generations[slot]};
+}
+
+std::span<const int> CreatureStore::Scores(Stats stat) const
+{
+  return _scores[stat];
+}
+
+std::span<const float> CreatureStore::ChallengeRatings() const
+{
+  return _cr;
+}
+
+std::span<const int> CreatureStore::HitPoints() const
+{
+  return _hit_points;
+}
+
+std::span<const int> CreatureStore::ArmorClasses() const
+{
+  return _armor_class;
+}
+
+void CreatureStore::ApplyDamage(std::span<const std::uint32_t> targets, std::span<const int> damage)
+{
+  const std::size_t count = std::min(targets.size(), damage.size());
+  for (std::size_t i = 0; i < count; i++)
+  {
+    int& hit_points = _hit_points[targets[i]];
+    hit_points = std::max(hit_points - damage[i], 0);
+  }
+}
+
+float CreatureStore::TotalCR() const
+{
+  return std::accumulate(_cr.begin(), _cr.end(), 0.0f);
+}
+
+std::span<const Action> CreatureStore::Actions(std::size_t index, ActionType type) const
+{
+  const ActionRange& range = _action_ranges[static_cast<int>(type)][index];
+  return std::span<const Action>(_action_table.data() + range.first, range.count);
+}
+
+ConditionSet CreatureStore::GetConditions(std::size_t index) const
+{
+  return ConditionSet(_conditions[index]);
+}
+
+void CreatureStore::SetConditions(std::size_t index, ConditionSet conditions)
+{
+  _conditions[index] = conditions.Bits();
+}
+
+std::span<const std::uint64_t> CreatureStore::Conditions() const
+{
+  return _conditions;
+}
+
+int CreatureStore::SpellSlots(std::size_t index, int level) const
+{
+  return level >= 1 && level <= 9 ? _spell_slots[index][level - 1] : 0;
+}
+
+bool CreatureStore::SpendSpellSlot(std::size_t index, int level)
+{
+  if (SpellSlots(index, level) == 0)
+  {
+    return false;
+  }
+  _spell_slots[index][level - 1]--;
+  return true;
+}
+
+void CreatureStore::RestoreSpellSlots(std::size_t index)
+{
+  _spell_slots[index] = _max_spell_slots[index];
+}
+
+void CreatureStore::RollSavingThrows(Stats stat, int dc, Roll mode, DiceEngine& engine,
+                                     std::span<std::uint8_t> success) const
+{
+  const std::span<const int> scores = _scores[stat];
+  const std::size_t count = std::min(Size(), success.size());
+
+  // One loop per mode, chosen once for the whole column
+  DispatchRoll(mode, [&]<Roll Mode>(std::integral_constant<Roll, Mode>)
+  {
+    int first[kRollChunk];
+    int second[kRollChunk];
+
+    for (std::size_t start = 0; start < count; start += kRollChunk)
+    {
+      const std::size_t len = std::min(kRollChunk, count - start);
+
+      engine.RollMany(len, 20, first);
+      if constexpr (Mode != Roll::STRIGHT)
+      {
+        engine.RollMany(len, 20, second);
+      }
+      ResolveChecks<Mode>({first, len}, {second, len}, scores.subspan(start, len), dc, success.subspan(start, len));
+    }
+  });
+}
+
+void CreatureStore::RollSavingThrows(Stats stat, int dc, DiceEngine& engine, std::span<std::uint8_t> success,
+                                     const RollRules& rules) const
+{
+  const int* scores = _scores[stat].data();
+  const std::uint64_t* conditions = _conditions.data();
+  const std::size_t count = std::min(Size(), success.size());
+
+  // The masks SavingThrowMode and FailsSavingThrow test, for this stat
+  const std::uint64_t disadvantage = SavingThrowMode(rules.dexSaveDisadvantage, stat, rules) == Roll::DISADVANTAGE
+                                         ? rules.dexSaveDisadvantage.Bits() : 0;
+  const std::uint64_t fails = FailsSavingThrow(rules.failsStrDexSaves, stat, rules) ? rules.failsStrDexSaves.Bits() : 0;
+
+  int first[kRollChunk];
+  int second[kRollChunk];
+
+  for (std::size_t start = 0; start < count; start += kRollChunk)
+  {
+    const std::size_t len = std::min(kRollChunk, count - start);
+
+    engine.RollMany(len, 20, first);
+    if (disadvantage != 0)
+    {
+      engine.RollMany(len, 20, second);
+    }
+
+    for (std::size_t i = 0; i < len; i++)
+    {
+      const std::uint64_t flags = conditions[start + i];
+      const int d20 = (flags & disadvantage) ? std::min(first[i], second[i]) : first[i];
+      success[start + i] = static_cast<std::uint8_t>((flags & fails) == 0 &&
+                                                     d20 + FastAbilityModifier(scores[start + i]) >= dc);
+    }
+  }
+}
+
+void CreatureStore::RollInitiative(DiceEngine& engine, std::span<int> initiative) const
+{
+  const int* dex = _scores.Get<Stats::DEX>().data();
+  const std::size_t count = std::min(Size(), initiative.size());
+
+  for (std::size_t start = 0; start < count; start += kRollChunk)
+  {
+    const std::size_t len = std::min(kRollChunk, count - start);
+    int* out = initiative.data() + start;
+
+    engine.RollMany(len, 20, std::span<int>(out, len));
+    for (std::size_t i = 0; i < len; i++)
+    {
+      out[i] += FastAbilityModifier(dex[start + i]);
+    }
+  }
+}
+
+void CreatureStore::CompactActions()
+{
+  std::vector<Action> compacted;
+  compacted.reserve(_action_table.size() - _dead_actions);
+
+  for (std::size_t index = 0; index < Size(); index++)
+  {
+    for (int type = 0; type < kNumActionTypes; type++)
+    {
+      ActionRange& range = _action_ranges[type][index];
+      const std::uint32_t first = static_cast<std::uint32_t>(compacted.size());
+      compacted.insert(compacted.end(),
+                       _action_table.begin() + range.first,
+                       _action_table.begin() + range.first + range.count);
+      range.first = first;
+    }
+  }
+
+  _action_table = std::move(compacted);
+  _dead_actions = 0;
+}
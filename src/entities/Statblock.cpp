@@ -0,0 +1,171 @@
+#include "entities/Statblock.h"
+
+#include <algorithm>
+#include <iterator>
+
+
+Statblock::Statblock(const allocator_type& allocator)
+  : _actions(allocator),
+    _bouns_actions(allocator),
+    _reactions(allocator),
+    _legendary_actions(allocator),
+    _legendary_reactions(allocator)
+{
+
+}
+
+Statblock::Statblock(const Statblock& other, const allocator_type& allocator)
+  : _cr(other._cr),
+    _hit_points(other._hit_points),
+    _armor_class(other._armor_class),
+    _actions(other._actions, allocator),
+    _bouns_actions(other._bouns_actions, allocator),
+    _reactions(other._reactions, allocator),
+    _legendary_actions(other._legendary_actions, allocator),
+    _legendary_reactions(other._legendary_reactions, allocator),
+    _stats(other._stats),
+    _rating(other._rating),
+    _offense_stale(other._offense_stale),
+    _defense_stale(other._defense_stale)
+{
+  std::copy(std::begin(other._spell_slots), std::end(other._spell_slots), _spell_slots);
+}
+
+Statblock::Statblock(Statblock&& other, const allocator_type& allocator)
+  : _cr(other._cr),
+    _hit_points(other._hit_points),
+    _armor_class(other._armor_class),
+    _actions(std::move(other._actions), allocator),
+    _bouns_actions(std::move(other._bouns_actions), allocator),
+    _reactions(std::move(other._reactions), allocator),
+    _legendary_actions(std::move(other._legendary_actions), allocator),
+    _legendary_reactions(std::move(other._legendary_reactions), allocator),
+    _stats(other._stats),
+    _rating(other._rating),
+    _offense_stale(other._offense_stale),
+    _defense_stale(other._defense_stale)
+{
+  std::copy(std::begin(other._spell_slots), std::end(other._spell_slots), _spell_slots);
+}
+
+Statblock::allocator_type Statblock::GetAllocator() const
+{
+  return _actions.get_allocator();
+}
+
+
+float Statblock::GetCR() const
+{
+  return _cr;
+}
+
+void Statblock::SetCR(float cr)
+{
+  _cr = cr;
+}
+
+int Statblock::GetHP() const
+{
+  return _hit_points;
+}
+
+void Statblock::SetHP(int hitPoints)
+{
+  _defense_stale |= hitPoints != _hit_points;
+  _hit_points = hitPoints;
+}
+
+int Statblock::GetAC() const
+{
+  return _armor_class;
+}
+
+void Statblock::SetAC(int armorClass)
+{
+  _defense_stale |= armorClass != _armor_class;
+  _armor_class = armorClass;
+}
+
+int Statblock::GetStat(Stats stat) const
+{
+  return _stats[stat];
+}
+
+void Statblock::SetStat(Stats stat, int score)
+{
+  _stats[stat] = score;
+}
+
+int Statblock::GetModifier(Stats stat) const
+{
+  return AbilityModifier(_stats[stat]);
+}
+
+int Statblock::GetProficiencyBonus() const
+{
+  return ProficiencyBonusForCR(_cr);
+}
+
+int Statblock::GetSpellSlots(int level) const
+{
+  return level >= 1 && level <= 9 ? _spell_slots[level - 1] : 0;
+}
+
+void Statblock::SetSpellSlots(int level, int count)
+{
+  if (level >= 1 && level <= 9)
+  {
+    _spell_slots[level - 1] = static_cast<std::uint8_t>(std::clamp(count, 0, 255));
+  }
+}
+
+const std::pmr::vector<Action>& Statblock::GetActions(ActionType type) const
+{
+  return const_cast<Statblock*>(this)->ActionList(type);
+}
+
+void Statblock::AddAction(ActionType type, const Action& action)
+{
+  ActionList(type).push_back(action);
+  _offense_stale = true;
+}
+
+const ChallengeRating& Statblock::GetCalculatedCR() const
+{
+  if (_defense_stale)
+  {
+    _rating.defensive = DefensiveCR(_hit_points, _armor_class);
+  }
+  if (_offense_stale)
+  {
+    _rating.offensive = OffensiveCR(ProfileOffense(*this));
+  }
+  if (_defense_stale || _offense_stale)
+  {
+    _rating.cr = CombineCR(_rating.offensive, _rating.defensive);
+    _defense_stale = false;
+    _offense_stale = false;
+  }
+  return _rating;
+}
+
+std::pmr::vector<Action>& Statblock::ActionList(ActionType type)
+{
+  switch (type)
+  {
+    case ActionType::BONUS_ACTION:
+      return _bouns_actions;
+
+    case ActionType::REACTION:
+      return _reactions;
+
+    case ActionType::LEGENDARY_ACTION:
+      return _legendary_actions;
+
+    case ActionType::LEGENDARY_REACTION:
+      return _legendary_reactions;
+
+    default:
+      return _actions;
+  }
+}
@@ -0,0 +1,219 @@
+#include "game/DemoScene.h"
+
+#include <format>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "rules/DiceEngine.h"
+#include "rules/DiceExpression.h"
+#include "utils/Profiler.h"
+
+DemoScene::DemoScene(int columns, int lines, SpriteView racket)
+    : _map(columns, lines),
+      _fov(_map, 15),
+      _pathfinder(_map),
+      /*
+      "<(o_o)>"
+      " -|_|-/"
+      "  / \  "; 
+     */
+      _goblin({{'<', '(', 'o', '_', 'o', ')', '>'},
+               {' ', '-', '|', '_', '|', '-', '/'},
+               {' ', ' ', '|', ' ', '|', ' ', ' '},
+              },
+              FontColor::BLACK_OVER_RED),
+      _player({{'#'}}, FontColor::WHITE_OVER_RED),
+      _racket(racket)
+{
+    // The screen margins are walls; creatures cannot walk through each other
+    for (int column = 0; column < _map.Width(); column++)
+    {
+        _map.SetWall({column, 0}, true);
+        _map.SetWall({column, _map.Height() - 1}, true);
+    }
+    for (int line = 0; line < _map.Height(); line++)
+    {
+        _map.SetWall({0, line}, true);
+        _map.SetWall({_map.Width() - 1, line}, true);
+    }
+
+    // A wall between the player and the goblin, to hide behind
+    for (int line = 2; line < 8; line++)
+    {
+        _map.SetWall({22, line}, true);
+    }
+
+    _goblin_token = _map.Place({30, 5}, _goblin.Width(), _goblin.Height(), 1, 1);
+    _player_token = _map.Place({10, 5}, _player.Width(), _player.Height(), 1, 0);
+
+    if (_player_token != kNoToken && _goblin_token != kNoToken)
+    {
+        _fov.Track(_player_token);
+        _fov.Track(_goblin_token);
+    }
+}
+
+void DemoScene::SetOnMove(OnMove onMove)
+{
+    _on_move = std::move(onMove);
+}
+
+void DemoScene::SetDice(DiceEngine& dice)
+{
+    _dice = &dice;
+}
+
+bool DemoScene::Has(std::uint32_t creature) const
+{
+    return (creature == kGoblin ? _goblin_token : _player_token) != kNoToken;
+}
+
+GridPos DemoScene::Position(std::uint32_t creature) const
+{
+    return _map.GetToken(creature == kGoblin ? _goblin_token : _player_token).pos;
+}
+
+void DemoScene::Step(int dx, int dy)
+{
+    if (_player_token == kNoToken)
+    {
+        return;
+    }
+    const GridPos pos = _map.GetToken(_player_token).pos;
+    if (_map.Move(_player_token, {pos.x + dx, pos.y + dy}))
+    {
+        _fov.MarkMoved(_player_token);
+        if (_on_move)
+        {
+            _on_move(kPlayer, _map.GetToken(_player_token).pos);
+        }
+    }
+}
+
+bool DemoScene::OnKey(int key)
+{
+    switch (key) {
+        case 'q':
+        case 27:
+            return false;
+
+        case 'p':
+            _profile.Toggle();
+            break;
+
+        case static_cast<int>(Key::UP): 
+            Step(0, -1); 
+            break;
+
+        case static_cast<int>(Key::DOWN):  
+            Step(0, 1); 
+            break;
+
+        case static_cast<int>(Key::LEFT):  
+            Step(-1, 0); 
+            break;
+
+        case static_cast<int>(Key::RIGHT): 
+            Step(1, 0); 
+            break;
+    }
+    return true;
+}
+
+void DemoScene::Tick()
+{
+    PROFILE_ZONE("DemoScene::Tick");
+
+    _die_roll = RollCompiled<"2d3"_dice>(_dice != nullptr ? *_dice : DiceEngine::ThreadLocal());
+    _fov.Update();
+
+    // The goblin walks towards the player while it can see them
+    if (++_ticks % 12 == 0 && _player_token != kNoToken && _goblin_token != kNoToken &&
+        _fov.CanSee(_goblin_token, _player_token))
+    {
+        const Token& goblin_at = _map.GetToken(_goblin_token);
+        std::span<const GridPos> path = _pathfinder.FindPath(goblin_at.pos, 
+                                                             _map.GetToken(_player_token).pos,
+                                                             goblin_at.width,
+                                                             goblin_at.height);
+        if (!path.empty() && _map.Move(_goblin_token, path.front()))
+        {
+            _fov.MarkMoved(_goblin_token);
+            if (_on_move)
+            {
+                _on_move(kGoblin, _map.GetToken(_goblin_token).pos);
+            }
+        }
+    }
+}
+
+void DemoScene::Render(Display& display, const FrameTimes& frameTimes, const FrameTimes* inputLatency)
+{
+    display.NewFrame();
+
+    for (int line = 2; line < 8; line++)
+    {
+        display.DrawText("#", 22, line, FontColor::YELLOW_OVER_BLACK);
+    }
+
+    if (_goblin_token != kNoToken && _player_token != kNoToken)
+    {
+        const GridPos goblin_pos = _map.GetToken(_goblin_token).pos;
+        const GridPos player_pos = _map.GetToken(_player_token).pos;
+        _goblin.SetPos(goblin_pos.x, goblin_pos.y);
+        _player.SetPos(player_pos.x, player_pos.y);
+
+        if (_fov.CanSee(_player_token, _goblin_token))
+        {
+            _goblin.Draw(display);
+        }
+        _player.Draw(display);
+        display.DrawFog(_fov.VisibleFrom(_player_token), 0, 0);
+    }
+
+    // Text is formatted into the frame arena: no heap allocation per frame
+    std::pmr::string frame_text(display.FrameArena());
+    std::format_to(std::back_inserter(frame_text),
+                   "p50 {:.1f}ms p99 {:.1f}ms",
+                   frameTimes.PercentileMs(0.5),
+                   frameTimes.PercentileMs(0.99));
+    display.DrawText(frame_text,  
+             display.NumColumns() - 25, 
+             1,
+             FontColor::CYAN_OVER_BLACK);
+
+    if (inputLatency != nullptr && inputLatency->Count() > 0)
+    {
+        std::pmr::string latency_text(display.FrameArena());
+        std::format_to(std::back_inserter(latency_text),
+                       "key p50 {:.1f}ms p99 {:.1f}ms",
+                       inputLatency->PercentileMs(0.5),
+                       inputLatency->PercentileMs(0.99));
+        display.DrawText(latency_text,
+                         display.NumColumns() - 25,
+                         2,
+                         FontColor::CYAN_OVER_BLACK);
+    }
+
+    display.DrawText("Hello, ncurses!", 
+                     10,
+                     10,
+                     FontColor::GREEN_OVER_BLACK);
+
+    display.DrawText("Move with arrow keys!", 10, 12, FontColor::GREEN_OVER_BLACK);
+    display.DrawText("Press 'q' to quit, 'p' for the profiler", 10, 14, FontColor::GREEN_OVER_BLACK);
+    std::pmr::string roll_text(display.FrameArena());
+    std::format_to(std::back_inserter(roll_text), "{}", _die_roll);
+    display.DrawText(roll_text, 20, 20, FontColor::BLUE_OVER_BLACK);
+
+    if (_racket.height + 2 < display.NumLines() && _racket.width + 2 < display.NumColumns() / 2)
+    {
+        _racket.Draw(display, display.NumColumns() - _racket.width - 2, 2);
+    }
+
+    _profile.Draw(display, 2, 16);
+
+    display.Refresh();
+}
@@ -1,9 +1,6 @@
 #include "graphics/BasicOperations.h"
+#include "utils/GameLoop.h"
 #include <ncurses.h>
-#include <chrono>
-#include <thread>
-
-using namespace std::chrono;
 
 void initColors() {
     start_color();
@@ -31,7 +28,7 @@ void drawLines() {
     attroff(COLOR_PAIR(3));
 }
 
-void drawText(int x, int y, double fps) {
+void drawText(int x, int y, double p50Ms, double p99Ms) {
     attron(COLOR_PAIR(2) | A_BOLD);
     mvprintw(y, x, "Hello, ncurses!");
     attroff(COLOR_PAIR(2) | A_BOLD);
@@ -44,9 +41,9 @@ void drawText(int x, int y, double fps) {
     mvprintw(y + 4, x, "Press 'q' to quit");
     attroff(COLOR_PAIR(1) | A_BLINK);
 
-    // Display FPS
+    // Display frame times
     attron(COLOR_PAIR(6) | A_BOLD);
-    mvprintw(1, COLS - 15, "FPS: %.2f", fps);
+    mvprintw(1, COLS - 25, "p50 %.1fms p99 %.1fms", p50Ms, p99Ms);
     attroff(COLOR_PAIR(6) | A_BOLD);
 }
 
@@ -62,38 +59,29 @@ int MainLoop() {
     }
 
     int x = 10, y = 5;
-    int ch;
-    int frameCount = 0;
-    auto lastTime = high_resolution_clock::now();
-    double fps = 0.0;
-
-    while ((ch = getch()) != 'q') {
-        erase();
-        drawBox();
-        drawLines();
-        drawText(x, y, fps);
-
-        switch (ch) {
-            case KEY_UP:    y = (y > 1) ? y - 1 : y; break;
-            case KEY_DOWN:  y = (y < LINES - 2) ? y + 1 : y; break;
-            case KEY_LEFT:  x = (x > 1) ? x - 1 : x; break;
-            case KEY_RIGHT: x = (x < COLS - 20) ? x + 1 : x; break;
-        }
-
-        refresh();
-        frameCount++;
-
-        // Calculate FPS every second
-        auto currentTime = high_resolution_clock::now();
-        double elapsedTime = duration<double>(currentTime - lastTime).count();
-        if (elapsedTime >= 1.0) {
-            fps = frameCount / elapsedTime;
-            frameCount = 0;
-            lastTime = currentTime;
-        }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // Limit FPS (~60 FPS)
-    }
+    GameLoop loop(60.0, 60.0, 0);
+
+    loop.Run(
+        [] { return getch(); },  // ERR when no key is pending
+        [&](int ch) {
+            switch (ch) {
+                case 'q':       return false;
+                case KEY_UP:    y = (y > 1) ? y - 1 : y; break;
+                case KEY_DOWN:  y = (y < LINES - 2) ? y + 1 : y; break;
+                case KEY_LEFT:  x = (x > 1) ? x - 1 : x; break;
+                case KEY_RIGHT: x = (x < COLS - 20) ? x + 1 : x; break;
+            }
+            return true;
+        },
+        [](GameLoop::Clock::duration) {},
+        [&](double) {
+            const FrameTimes& frame_times = loop.GetFrameTimes();
+            erase();
+            drawBox();
+            drawLines();
+            drawText(x, y, frame_times.PercentileMs(0.5), frame_times.PercentileMs(0.99));
+            refresh();
+        });
 
     endwin();
     return 0;
@@ -0,0 +1,142 @@
+#include "graphics/CellFrame.h"
+
+#include "replay/Varint.h"
+
+namespace
+{
+
+// Longer runs than any terminal line are malformed
+constexpr std::uint64_t kMaxRunLength = 4096;
+
+}
+
+
+void CellFrameWriter::Reset()
+{
+  _runs.clear();
+  _num_runs = 0;
+  _flags = 0;
+}
+
+void CellFrameWriter::ClearScreen()
+{
+  _flags |= kClearScreen;
+}
+
+void CellFrameWriter::AddRun(int x, int y, std::span<const Cell> cells)
+{
+  if (cells.empty())
+  {
+    return;
+  }
+
+  PutVarint(_runs, static_cast<std::uint64_t>(x));
+  PutVarint(_runs, static_cast<std::uint64_t>(y));
+  PutVarint(_runs, cells.size());
+  PutVarint(_runs, cells.front().colorPair);
+  PutVarint(_runs, cells.front().attributes);
+  for (const Cell& cell : cells)
+  {
+    PutVarint(_runs, cell.glyph);
+  }
+  _num_runs++;
+}
+
+bool CellFrameWriter::Empty() const
+{
+  return _num_runs == 0 && _flags == 0;
+}
+
+void CellFrameWriter::Finish(std::vector<std::uint8_t>& out) const
+{
+  PutVarint(out, _flags);
+  PutVarint(out, _num_runs);
+  out.insert(out.end(), _runs.begin(), _runs.end());
+}
+
+
+bool CellFrameReader::Open(std::span<const std::uint8_t> frame)
+{
+  _it = frame.data();
+  _end = frame.data() + frame.size();
+  _runs_left = 0;
+  _flags = 0;
+  if (frame.empty())
+  {
+    return true;
+  }
+
+  std::uint64_t flags = 0;
+  if (!GetVarint(_it, _end, flags) || !GetVarint(_it, _end, _runs_left))
+  {
+    _runs_left = 0;
+    return false;
+  }
+  _flags = static_cast<std::uint8_t>(flags);
+  return true;
+}
+
+bool CellFrameReader::ClearsScreen() const
+{
+  return _flags & kClearScreen;
+}
+
+bool CellFrameReader::Next(int& x, int& y, std::span<const Cell>& cells)
+{
+  if (_runs_left == 0)
+  {
+    return false;
+  }
+  _runs_left--;
+
+  std::uint64_t column = 0;
+  std::uint64_t line = 0;
+  std::uint64_t length = 0;
+  std::uint64_t color_pair = 0;
+  std::uint64_t attributes = 0;
+  if (!GetVarint(_it, _end, column) || !GetVarint(_it, _end, line) || !GetVarint(_it, _end, length) ||
+      length > kMaxRunLength || !GetVarint(_it, _end, color_pair) || !GetVarint(_it, _end, attributes))
+  {
+    _runs_left = 0;
+    return false;
+  }
+
+  _cells.resize(length);
+  for (Cell& cell : _cells)
+  {
+    std::uint64_t glyph = 0;
+    if (!GetVarint(_it, _end, glyph))
+    {
+      _runs_left = 0;
+      return false;
+    }
+    cell = {static_cast<std::uint32_t>(glyph),
+            static_cast<std::uint16_t>(color_pair),
+            static_cast<std::uint32_t>(attributes)};
+  }
+
+  x = static_cast<int>(column);
+  y = static_cast<int>(line);
+  cells = _cells;
+  return true;
+}
+
+bool CellFrameReader::ApplyTo(FrameBuffer& screen)
+{
+  if (ClearsScreen())
+  {
+    screen.Clear();
+  }
+
+  int x = 0;
+  int y = 0;
+  std::span<const Cell> cells;
+  while (Next(x, y, cells))
+  {
+    for (std::size_t i = 0; i < cells.size(); i++)
+    {
+      screen.Put(x + static_cast<int>(i), y, cells[i]);
+    }
+  }
+  return _it == _end;
+}
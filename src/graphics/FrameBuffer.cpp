@@ -0,0 +1,75 @@
+#include "graphics/FrameBuffer.h"
+
+#include <algorithm>
+
+
+void FrameBuffer::Resize(int columns, int lines)
+{
+  _columns = std::max(columns, 0);
+  _lines = std::max(lines, 0);
+  _cells.assign(static_cast<std::size_t>(_columns) * _lines, Cell {});
+}
+
+void FrameBuffer::Fill(const Cell& cell)
+{
+  std::fill(_cells.begin(), _cells.end(), cell);
+}
+
+void FrameBuffer::Clear()
+{
+  Fill(Cell {});
+}
+
+void FrameBuffer::Put(int x, int y, const Cell& cell)
+{
+  if (x >= 0 && x < _columns && y >= 0 && y < _lines)
+  {
+    _cells[static_cast<std::size_t>(y) * _columns + x] = cell;
+  }
+}
+
+void FrameBuffer::PutText(int x,
+                          int y,
+                          std::string_view text,
+                          std::uint16_t colorPair,
+                          std::uint32_t attributes)
+{
+  if (y < 0 || y >= _lines || x >= _columns)
+  {
+    return;
+  }
+
+  std::size_t first = 0;
+  if (x < 0)
+  {
+    first = std::min(text.size(), static_cast<std::size_t>(-x));
+    x = 0;
+  }
+  const std::size_t length = std::min(text.size() - first, static_cast<std::size_t>(_columns - x));
+
+  Cell* row = _cells.data() + static_cast<std::size_t>(y) * _columns + x;
+  for (std::size_t i = 0; i < length; i++)
+  {
+    row[i] = Cell {static_cast<unsigned char>(text[first + i]), colorPair, attributes};
+  }
+}
+
+const Cell& FrameBuffer::At(int x, int y) const
+{
+  return _cells[static_cast<std::size_t>(y) * _columns + x];
+}
+
+std::span<const Cell> FrameBuffer::Row(int y) const
+{
+  return std::span<const Cell>(_cells.data() + static_cast<std::size_t>(y) * _columns, _columns);
+}
+
+int FrameBuffer::Columns() const
+{
+  return _columns;
+}
+
+int FrameBuffer::Lines() const
+{
+  return _lines;
+}
@@ -1,8 +1,11 @@
 #include "graphics/NcursesGraphics.h"
+#include "map/FieldOfView.h"
+#include "utils/Profiler.h"
 
+#define NCURSES_WIDECHAR 1
 #include <ncurses.h>
-#include <format>
-
+#include <algorithm>
+#include <variant>
 
 void Display::SetMarginColor(FontColor color)
 {
@@ -10,21 +13,82 @@ void Display::SetMarginColor(FontColor color)
 }
 
 
-void Display::DrawText(const std::string& text, 
+void Display::DrawText(std::string_view text, 
                      int x, 
                      int y, 
                      FontColor color, 
                      int fontFlags)
 {
-    attron(COLOR_PAIR(color) | fontFlags);
-    mvprintw(y, x, text.c_str());
-    attroff(COLOR_PAIR(color) | fontFlags);
+    _back.PutText(x, 
+                  y, 
+                  text, 
+                  static_cast<std::uint16_t>(color), 
+                  static_cast<std::uint32_t>(fontFlags));
+}
+
+
+void Display::DrawCell(int x, int y, const Cell& cell)
+{
+    _back.Put(x, y, cell);
+}
+
+
+void Display::DrawFog(const VisibilityGrid& visible, int x, int y, FontColor fog)
+{
+    const int last_line = std::min(visible.Height(), _back.Lines() - y);
+    const int last_column = std::min(visible.Width(), _back.Columns() - x);
+
+    for (int line = std::max(0, -y); line < last_line; line++)
+    {
+        for (int column = std::max(0, -x); column < last_column; column++)
+        {
+            if (!visible.Test({column, line}))
+            {
+                Cell cell = _back.At(x + column, y + line);
+                cell.colorPair = static_cast<std::uint16_t>(fog);
+                cell.attributes |= A_DIM;
+                _back.Put(x + column, y + line, cell);
+            }
+        }
+    }
 }
 
 
 void Display::Init()
 {
-    initscr();
+    _target.emplace<NcursesTarget>().Init();
+    SetUpTerminal();
+}
+
+
+void Display::Init(std::FILE* output, std::FILE* input)
+{
+    _target.emplace<NcursesTarget>().Init(output, input);
+    SetUpTerminal();
+}
+
+
+MemoryTarget& Display::InitHeadless(int columns, int lines)
+{
+    return _target.emplace<MemoryTarget>(columns, lines);
+}
+
+
+StreamTarget& Display::InitStream(int columns, int lines)
+{
+    return _target.emplace<StreamTarget>(columns, lines);
+}
+
+
+RenderTarget& Display::Target()
+{
+    return _target;
+}
+
+
+void Display::SetUpTerminal()
+{
+    cbreak();             // Keys arrive as they are typed, not per line
     noecho();
     curs_set(0);          // Hide cursor
     keypad(stdscr, TRUE);
@@ -38,39 +102,125 @@ void Display::Init()
 
 int Display::GetChar()
 {
-    return getch();
+    return std::visit([](auto& target) { return target.GetChar(); }, _target);
+}
+
+
+int Display::InputFd() const
+{
+    return std::visit([](const auto& target) { return target.InputFd(); }, _target);
+}
+
+
+void Display::Resize(int columns, int lines)
+{
+    std::visit([=](auto& target) { target.Resize(columns, lines); }, _target);
 }
 
 
 void Display::NewFrame()
 {
-    erase();
+    PROFILE_ZONE("Display::NewFrame");
+
+    const int columns = NumColumns();
+    const int lines = NumLines();
+    if (_back.Columns() != columns || _back.Lines() != lines)
+    {
+        // Nothing on screen can be trusted after a resize: make every cell
+        // of the front buffer differ from anything that can be drawn.
+        _back.Resize(columns, lines);
+        _front.Resize(columns, lines);
+        _front.Fill(Cell {0, 0, 0});
+        std::visit([](auto& target) { target.Clear(); }, _target);
+    }
+
+    _back.Clear();
+    _frame_arena.Reset();
 
     if(_margin_color)
     {
-        DrawScreenMargins();
+        DrawScreenMargins(*_margin_color);
     }
     //drawLines();
     
 }
+
 void Display::Refresh()
 {
-    refresh();
+    PROFILE_ZONE("Display::Refresh");
+
+    // One dispatch per frame; the diff below is compiled for each target
+    std::visit([this](auto& target) { RefreshTo(target); }, _target);
 }
 
-Display::~Display()
+template <typename Backend>
+void Display::RefreshTo(Backend& target)
 {
-    endwin();
+    _last_frame = {};
+
+    for (int y = 0; y < _back.Lines(); y++)
+    {
+        std::span<const Cell> next = _back.Row(y);
+        std::span<const Cell> shown = _front.Row(y);
+        const int columns = static_cast<int>(next.size());
+
+        int x = 0;
+        while (x < columns)
+        {
+            if (next[x] == shown[x])
+            {
+                x++;
+                continue;
+            }
+
+            // Grow the run over cells of the same style, bridging short gaps
+            // of unchanged cells.
+            const int start = x;
+            int end = x + 1;
+            int changed = 1;
+            for (int j = end; j < columns && next[j].SameStyle(next[start]); j++)
+            {
+                if (next[j] != shown[j])
+                {
+                    end = j + 1;
+                    changed++;
+                }
+                else if (j - end >= kMaxRunGap)
+                {
+                    break;
+                }
+            }
+
+            target.WriteRun(start, y, next.subspan(start, end - start));
+
+            _last_frame.runs++;
+            _last_frame.changedCells += changed;
+            x = end;
+        }
+    }
+
+    std::swap(_front, _back);
+    target.Present();
 }
 
 int Display::NumLines()
 {
-    return LINES;
+    return std::visit([](const auto& target) { return target.Lines(); }, _target);
 }
 
 int Display::NumColumns()
 {
-    return COLS;
+    return std::visit([](const auto& target) { return target.Columns(); }, _target);
+}
+
+const FrameStats& Display::LastFrameStats() const
+{
+    return _last_frame;
+}
+
+std::pmr::memory_resource* Display::FrameArena()
+{
+    return &_frame_arena;
 }
 
 void Display::InitColorPalettes() 
@@ -101,7 +251,7 @@ void Display::InitColorPalettes()
               COLOR_CYAN, 
               COLOR_BLACK);
 
-    init_pair(static_cast<short>(FontColor::RED_OVER_BLACK), 
+    init_pair(static_cast<short>(FontColor::WHITE_OVER_BLACK), 
               COLOR_WHITE, 
               COLOR_BLACK);
 
@@ -145,9 +295,26 @@ void Display::DrawScreenMargins(FontColor color,
                                 unsigned int horitzontalChar, 
                                 unsigned int verticalChar) 
 {
-    attron(COLOR_PAIR(color));
-    box(stdscr, verticalChar, horitzontalChar);
-    attroff(COLOR_PAIR(color));
+    const std::uint16_t pair = static_cast<std::uint16_t>(color);
+    const int right = _back.Columns() - 1;
+    const int bottom = _back.Lines() - 1;
+    const std::uint32_t horizontal = horitzontalChar ? horitzontalChar : AcsGlyph('q');
+    const std::uint32_t vertical = verticalChar ? verticalChar : AcsGlyph('x');
+
+    for (int x = 1; x < right; x++)
+    {
+        _back.Put(x, 0, Cell {horizontal, pair, 0});
+        _back.Put(x, bottom, Cell {horizontal, pair, 0});
+    }
+    for (int y = 1; y < bottom; y++)
+    {
+        _back.Put(0, y, Cell {vertical, pair, 0});
+        _back.Put(right, y, Cell {vertical, pair, 0});
+    }
+    _back.Put(0, 0, Cell {AcsGlyph('l'), pair, 0});
+    _back.Put(right, 0, Cell {AcsGlyph('k'), pair, 0});
+    _back.Put(0, bottom, Cell {AcsGlyph('m'), pair, 0});
+    _back.Put(right, bottom, Cell {AcsGlyph('j'), pair, 0});
 }
 
 
@@ -156,13 +323,13 @@ void Display::DrawScreenMargins(FontColor color,
 TextSprite::TextSprite(const std::vector<std::vector<char>>& sprite, 
                        FontColor color)
 {
-    _sprite = sprite;
+    Compile(sprite);
     _color = color;
 }
 
 TextSprite::TextSprite(const std::vector<std::vector<char>>& sprite)
 {
-    _sprite = sprite;
+    Compile(sprite);
 }
 
 TextSprite::TextSprite()
@@ -171,31 +338,90 @@ TextSprite::TextSprite()
 }
 
 
-void TextSprite::SetPos(int x, int y)
+void TextSprite::Compile(const std::vector<std::vector<char>>& sprite)
 {
-    if(x > 0 && x < COLS - _sprite[0].size())
+    _height = static_cast<int>(sprite.size());
+    _width = 0;
+    for (const std::vector<char>& row : sprite)
     {
-        _x = x;
+        _width = std::max(_width, static_cast<int>(row.size()));
     }
-    if(y > 0 && y < LINES - _sprite.size())
-    {
-        _y = y;
-    }
-}
 
-void TextSprite::Draw(Display& display)
-{
-    for (size_t num_col = 0; num_col < _sprite.size(); num_col++) 
+    // Rows shorter than the widest one are padded with transparent cells
+    _glyphs.assign(static_cast<std::size_t>(_width) * _height, ' ');
+    _opaque.assign((_glyphs.size() + 63) / 64, 0);
+    _runs.clear();
+
+    for (int row = 0; row < _height; row++)
     {
-        for (size_t num_row = 0; num_row < _sprite[num_col].size(); num_row++) 
+        const std::vector<char>& line = sprite[row];
+        for (int col = 0; col < static_cast<int>(line.size()); col++)
+        {
+            const std::size_t index = static_cast<std::size_t>(row) * _width + col;
+            _glyphs[index] = line[col];
+            if (line[col] != ' ')
+            {
+                _opaque[index / 64] |= std::uint64_t{1} << (index % 64);
+            }
+        }
+
+        int col = 0;
+        while (col < _width)
         {
-            if (_sprite[num_col][num_row] != ' ') 
+            if (!IsOpaque(col, row))
             {
-                display.DrawText(std::string(1, _sprite[num_col][num_row]), 
-                                 _x + num_row, 
-                                 _y + num_col, 
-                                 _color);
+                col++;
+                continue;
             }
+            const int start = col;
+            while (col < _width && IsOpaque(col, row))
+            {
+                col++;
+            }
+            _runs.push_back({static_cast<std::uint16_t>(row),
+                             static_cast<std::uint16_t>(start),
+                             static_cast<std::uint16_t>(col - start),
+                             static_cast<std::uint32_t>(row * _width + start)});
         }
     }
-}
\ No newline at end of file
+}
+
+
+void TextSprite::SetPos(int x, int y)
+{
+    _x = x;
+    _y = y;
+}
+
+void TextSprite::Draw(Display& display) const
+{
+    PROFILE_ZONE("TextSprite::Draw");
+
+    for (const SpriteRun& run : _runs) 
+    {
+        display.DrawText(std::string_view(_glyphs.data() + run.first, run.length), 
+                         _x + run.column, 
+                         _y + run.row, 
+                         _color);
+    }
+}
+
+int TextSprite::Width() const
+{
+    return _width;
+}
+
+int TextSprite::Height() const
+{
+    return _height;
+}
+
+bool TextSprite::IsOpaque(int column, int row) const
+{
+    if (column < 0 || column >= _width || row < 0 || row >= _height)
+    {
+        return false;
+    }
+    const std::size_t index = static_cast<std::size_t>(row) * _width + column;
+    return (_opaque[index / 64] >> (index % 64)) & 1;
+}
@@ -0,0 +1,54 @@
+#include "graphics/ProfileOverlay.h"
+
+#include <format>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+
+#include "graphics/NcursesGraphics.h"
+
+void ProfileOverlay::Toggle()
+{
+    _visible = !_visible;
+    if (_visible)
+    {
+        Profiler::Enable(true);
+        _next_update = 0;
+    }
+}
+
+bool ProfileOverlay::Visible() const
+{
+    return _visible;
+}
+
+void ProfileOverlay::Draw(Display& display, int x, int y)
+{
+    if (!_visible)
+    {
+        return;
+    }
+
+    const std::int64_t now = Profiler::Now();
+    if (now >= _next_update)
+    {
+        _zones = Profiler::Summarize(kWindowNs);
+        _next_update = now + kUpdateNs;
+    }
+
+    std::pmr::string text(display.FrameArena());
+    std::format_to(std::back_inserter(text), "{:<28}{:>8}{:>10}{:>10}", "zone (last 1 s)", "calls", "mean us", "max us");
+    display.DrawText(text, x, y, FontColor::BLACK_OVER_GREEN);
+    int line = y + 1;
+    for (const ZoneStats& zone : _zones)
+    {
+        if (zone.count == 0)
+        {
+            continue;
+        }
+        text.clear();
+        std::format_to(std::back_inserter(text), "{:<28.28}{:>8}{:>10.2f}{:>10.2f}",
+                       zone.name, zone.count, zone.MeanUs(), zone.maxNs / 1e3);
+        display.DrawText(text, x, line++, FontColor::GREEN_OVER_BLACK);
+    }
+}
@@ -0,0 +1,397 @@
+#include "graphics/RenderTarget.h"
+
+#define NCURSES_WIDECHAR 1
+#include <ncurses.h>
+#include <algorithm>
+#include <clocale>
+#include <format>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+
+static_assert(kAltCharset == A_ALTCHARSET);
+
+// Cells hold line drawing glyphs by letter; ncurses wants its acs_map entry
+std::uint32_t TerminalGlyph(std::uint32_t glyph)
+{
+    if (glyph & A_ALTCHARSET)
+    {
+        return static_cast<std::uint32_t>(NCURSES_ACS(glyph & A_CHARTEXT)) | (glyph & ~A_CHARTEXT);
+    }
+    return glyph;
+}
+
+chtype ToChtype(const Cell& cell)
+{
+    return static_cast<chtype>(TerminalGlyph(cell.glyph)) | COLOR_PAIR(cell.colorPair) |
+           static_cast<chtype>(cell.attributes);
+}
+
+// Code points past ASCII (e.g. the half blocks of atlas sprites) need the
+// wide character API; ACS glyphs and plain text do not.
+bool IsWide(const Cell& cell)
+{
+    return cell.glyph >= 0x80 && !(cell.glyph & A_ALTCHARSET);
+}
+
+cchar_t ToCchar(const Cell& cell)
+{
+    cchar_t wide {};
+    const std::uint32_t glyph = TerminalGlyph(cell.glyph);
+    attr_t attributes = static_cast<attr_t>(cell.attributes);
+    wchar_t text[2] = {static_cast<wchar_t>(glyph & A_CHARTEXT), L'\0'};
+
+    if (IsWide(cell))
+    {
+        text[0] = static_cast<wchar_t>(glyph);
+    }
+    else
+    {
+        attributes |= static_cast<attr_t>(glyph & A_ATTRIBUTES);
+    }
+    setcchar(&wide, text, attributes, static_cast<short>(cell.colorPair), nullptr);
+    return wide;
+}
+
+// ANSI foreground/background of every FontColor pair; must match
+// Display::InitColorPalettes
+struct AnsiPair
+{
+    std::uint8_t foreground;
+    std::uint8_t background;
+};
+
+constexpr AnsiPair kAnsiPairs[] = {
+    {7, 0},
+    {COLOR_RED, COLOR_BLACK}, {COLOR_GREEN, COLOR_BLACK}, {COLOR_YELLOW, COLOR_BLACK},
+    {COLOR_BLUE, COLOR_BLACK}, {COLOR_MAGENTA, COLOR_BLACK}, {COLOR_CYAN, COLOR_BLACK},
+    {COLOR_WHITE, COLOR_BLACK},
+    {COLOR_BLACK, COLOR_RED}, {COLOR_GREEN, COLOR_RED}, {COLOR_YELLOW, COLOR_RED},
+    {COLOR_BLUE, COLOR_RED}, {COLOR_MAGENTA, COLOR_RED}, {COLOR_CYAN, COLOR_RED},
+    {COLOR_WHITE, COLOR_RED},
+    {COLOR_BLACK, COLOR_GREEN},
+};
+
+// Unicode box drawing for the VT100 line drawing letters
+char32_t LineDrawing(std::uint32_t letter)
+{
+    switch (letter)
+    {
+        case 'j': return U'┘';
+        case 'k': return U'┐';
+        case 'l': return U'┌';
+        case 'm': return U'└';
+        case 'n': return U'┼';
+        case 'q': return U'─';
+        case 't': return U'├';
+        case 'u': return U'┤';
+        case 'v': return U'┴';
+        case 'w': return U'┬';
+        case 'x': return U'│';
+        default: return U'?';
+    }
+}
+
+void AppendUtf8(std::string& out, char32_t code)
+{
+    if (code < 0x80)
+    {
+        out.push_back(static_cast<char>(code));
+    }
+    else if (code < 0x800)
+    {
+        out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+    else if (code < 0x10000)
+    {
+        out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+}
+
+// Cursor move, style when it differs from the last one sent, then the glyphs
+void AppendRun(std::string& out, int x, int y, std::span<const Cell> cells, const Cell* lastStyle)
+{
+    std::format_to(std::back_inserter(out), "\x1b[{};{}H", y + 1, x + 1);
+
+    const Cell& style = cells.front();
+    if (!lastStyle || !style.SameStyle(*lastStyle))
+    {
+        const AnsiPair colors = style.colorPair < std::size(kAnsiPairs) ? kAnsiPairs[style.colorPair]
+                                                                        : kAnsiPairs[0];
+        out.append("\x1b[0");
+        if (style.attributes & A_BOLD)      out.append(";1");
+        if (style.attributes & A_DIM)       out.append(";2");
+        if (style.attributes & A_UNDERLINE) out.append(";4");
+        if (style.attributes & A_BLINK)     out.append(";5");
+        if (style.attributes & A_REVERSE)   out.append(";7");
+        std::format_to(std::back_inserter(out), ";{};{}m", 30 + colors.foreground, 40 + colors.background);
+    }
+
+    for (const Cell& cell : cells)
+    {
+        AppendUtf8(out, (cell.glyph & A_ALTCHARSET) ? LineDrawing(cell.glyph & A_CHARTEXT) : cell.glyph);
+    }
+}
+
+}
+
+
+NcursesTarget::~NcursesTarget()
+{
+    if (_initialized)
+    {
+        endwin();
+    }
+}
+
+void NcursesTarget::Init()
+{
+    std::setlocale(LC_ALL, "");
+    initscr();
+    _initialized = true;
+}
+
+void NcursesTarget::Init(std::FILE* output, std::FILE* input)
+{
+    std::setlocale(LC_ALL, "");
+    set_term(newterm(nullptr, output, input));
+    _input_fd = fileno(input);
+    _initialized = true;
+}
+
+int NcursesTarget::Columns() const
+{
+    return COLS;
+}
+
+int NcursesTarget::Lines() const
+{
+    return LINES;
+}
+
+void NcursesTarget::Resize(int columns, int lines)
+{
+    resize_term(lines, columns);
+}
+
+void NcursesTarget::Clear()
+{
+    clear();
+}
+
+void NcursesTarget::WriteRun(int x, int y, std::span<const Cell> cells)
+{
+    static std::vector<chtype> run;
+    static std::vector<cchar_t> wide_run;
+
+    const int length = static_cast<int>(cells.size());
+    if (std::any_of(cells.begin(), cells.end(), IsWide))
+    {
+        wide_run.resize(cells.size());
+        std::transform(cells.begin(), cells.end(), wide_run.begin(), ToCchar);
+        mvadd_wchnstr(y, x, wide_run.data(), length);
+    }
+    else
+    {
+        run.resize(cells.size());
+        std::transform(cells.begin(), cells.end(), run.begin(), ToChtype);
+        mvaddchnstr(y, x, run.data(), length);
+    }
+}
+
+void NcursesTarget::Present()
+{
+    refresh();
+}
+
+int NcursesTarget::GetChar()
+{
+    return getch();
+}
+
+int NcursesTarget::InputFd() const
+{
+    return _input_fd;
+}
+
+
+MemoryTarget::MemoryTarget(int columns, int lines)
+{
+    _screen.Resize(columns, lines);
+}
+
+int MemoryTarget::Columns() const
+{
+    return _screen.Columns();
+}
+
+int MemoryTarget::Lines() const
+{
+    return _screen.Lines();
+}
+
+void MemoryTarget::Resize(int columns, int lines)
+{
+    _screen.Resize(columns, lines);
+}
+
+void MemoryTarget::Clear()
+{
+    _screen.Clear();
+    _pending.append("\x1b[0m\x1b[2J");
+    _style_known = false;
+}
+
+void MemoryTarget::WriteRun(int x, int y, std::span<const Cell> cells)
+{
+    if (cells.empty())
+    {
+        return;
+    }
+
+    AppendRun(_pending, x, y, cells, _style_known ? &_style : nullptr);
+    _style = cells.front();
+    _style_known = true;
+
+    for (std::size_t i = 0; i < cells.size(); i++)
+    {
+        _screen.Put(x + static_cast<int>(i), y, cells[i]);
+    }
+}
+
+void MemoryTarget::Present()
+{
+    _output_bytes += _pending.size();
+    _frames++;
+    _pending.clear();
+}
+
+std::string MemoryTarget::Capture() const
+{
+    std::string out = "\x1b[0m\x1b[2J";
+    const Cell* style = nullptr;
+    for (int y = 0; y < _screen.Lines(); y++)
+    {
+        std::span<const Cell> row = _screen.Row(y);
+        std::size_t start = 0;
+        while (start < row.size())
+        {
+            std::size_t end = start + 1;
+            while (end < row.size() && row[end].SameStyle(row[start]))
+            {
+                end++;
+            }
+            AppendRun(out, static_cast<int>(start), y, row.subspan(start, end - start), style);
+            style = &row[start];
+            start = end;
+        }
+    }
+    out.append("\x1b[0m\n");
+    return out;
+}
+
+int MemoryTarget::GetChar()
+{
+    if (_next_key == _keys.size())
+    {
+        _keys.clear();
+        _next_key = 0;
+        return -1;
+    }
+    return _keys[_next_key++];
+}
+
+int MemoryTarget::InputFd() const
+{
+    return -1;
+}
+
+void MemoryTarget::PushKey(int key)
+{
+    _keys.push_back(key);
+}
+
+const FrameBuffer& MemoryTarget::Screen() const
+{
+    return _screen;
+}
+
+std::uint64_t MemoryTarget::OutputBytes() const
+{
+    return _output_bytes;
+}
+
+std::uint64_t MemoryTarget::Frames() const
+{
+    return _frames;
+}
+
+
+StreamTarget::StreamTarget(int columns, int lines)
+    : _columns(columns),
+      _lines(lines)
+{
+}
+
+int StreamTarget::Columns() const
+{
+    return _columns;
+}
+
+int StreamTarget::Lines() const
+{
+    return _lines;
+}
+
+void StreamTarget::Resize(int columns, int lines)
+{
+    _columns = columns;
+    _lines = lines;
+}
+
+void StreamTarget::Clear()
+{
+    _writer.ClearScreen();
+}
+
+void StreamTarget::WriteRun(int x, int y, std::span<const Cell> cells)
+{
+    _writer.AddRun(x, y, cells);
+}
+
+void StreamTarget::Present()
+{
+    _frame.clear();
+    if (!_writer.Empty())
+    {
+        _writer.Finish(_frame);
+    }
+    _writer.Reset();
+}
+
+int StreamTarget::GetChar()
+{
+    return -1;
+}
+
+int StreamTarget::InputFd() const
+{
+    return -1;
+}
+
+std::span<const std::uint8_t> StreamTarget::Frame() const
+{
+    return _frame;
+}
@@ -0,0 +1,364 @@
+#include "graphics/SpriteAtlas.h"
+#include "graphics/NcursesGraphics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr char kMagic[8] = {'D', 'N', 'D', 'A', 'T', 'L', 'A', 'S'};
+constexpr std::uint32_t kVersion = 1;
+
+constexpr std::uint32_t kSpace = U' ';
+constexpr std::uint32_t kUpperHalf = U'▀';
+constexpr std::uint32_t kLowerHalf = U'▄';
+constexpr std::uint32_t kFullBlock = U'█';
+
+// File layout: header, entry table sorted by name, name bytes, cells. Every
+// section starts 8 byte aligned.
+struct AtlasHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t count;
+  std::uint64_t entriesOffset;
+  std::uint64_t namesOffset;
+  std::uint64_t cellsOffset;
+  std::uint64_t fileSize;
+};
+
+struct AtlasEntry
+{
+  std::uint32_t nameOffset;
+  std::uint32_t nameLength;
+  std::uint32_t firstCell;
+  std::uint16_t width;
+  std::uint16_t height;
+};
+
+struct Rgb
+{
+  int r;
+  int g;
+  int b;
+};
+
+// xterm defaults for the eight ncurses colors
+enum PaletteColor { BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE };
+
+constexpr Rgb kPalette[8] = {
+  {0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0},
+  {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+};
+
+struct PairColors
+{
+  FontColor pair;
+  PaletteColor foreground;
+  PaletteColor background;
+};
+
+// Must match Display::InitColorPalettes
+constexpr PairColors kPairs[] = {
+  {FontColor::RED_OVER_BLACK, RED, BLACK},
+  {FontColor::GREEN_OVER_BLACK, GREEN, BLACK},
+  {FontColor::YELLOW_OVER_BLACK, YELLOW, BLACK},
+  {FontColor::BLUE_OVER_BLACK, BLUE, BLACK},
+  {FontColor::MAGENTA_OVER_BLACK, MAGENTA, BLACK},
+  {FontColor::CYAN_OVER_BLACK, CYAN, BLACK},
+  {FontColor::WHITE_OVER_BLACK, WHITE, BLACK},
+  {FontColor::BLACK_OVER_RED, BLACK, RED},
+  {FontColor::GREEN_OVER_RED, GREEN, RED},
+  {FontColor::YELLOW_OVER_RED, YELLOW, RED},
+  {FontColor::BLUE_OVER_RED, BLUE, RED},
+  {FontColor::MAGENTA_OVER_RED, MAGENTA, RED},
+  {FontColor::CYAN_OVER_RED, CYAN, RED},
+  {FontColor::WHITE_OVER_RED, WHITE, RED},
+  {FontColor::BLACK_OVER_GREEN, BLACK, GREEN},
+};
+
+int Distance(const Rgb& a, const Rgb& b)
+{
+  return (a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b);
+}
+
+// Transparent pixels, and pixels below the image, read as black.
+bool ReadPixel(const RgbaImage& image, int x, int y, Rgb& color)
+{
+  if (y >= image.height)
+  {
+    color = kPalette[BLACK];
+    return false;
+  }
+  const std::uint8_t* pixel = image.pixels.data() + (static_cast<std::size_t>(y) * image.width + x) * 4;
+  if (pixel[3] < 128)
+  {
+    color = kPalette[BLACK];
+    return false;
+  }
+  color = {pixel[0], pixel[1], pixel[2]};
+  return true;
+}
+
+AtlasCell BakeCell(const Rgb& top, const Rgb& bottom)
+{
+  AtlasCell best {kSpace, static_cast<std::uint16_t>(FontColor::WHITE_OVER_BLACK), 1};
+  int best_error = std::numeric_limits<int>::max();
+
+  for (const PairColors& pair : kPairs)
+  {
+    const PaletteColor fg = pair.foreground;
+    const PaletteColor bg = pair.background;
+    const struct { std::uint32_t glyph; PaletteColor top; PaletteColor bottom; } candidates[] = {
+      {kUpperHalf, fg, bg}, {kLowerHalf, bg, fg}, {kFullBlock, fg, fg}, {kSpace, bg, bg},
+    };
+
+    for (const auto& candidate : candidates)
+    {
+      const int error = Distance(top, kPalette[candidate.top]) +
+                        Distance(bottom, kPalette[candidate.bottom]);
+      if (error < best_error)
+      {
+        best_error = error;
+        best = {candidate.glyph, static_cast<std::uint16_t>(pair.pair), 1};
+      }
+    }
+  }
+
+  return best;
+}
+
+std::uint64_t Align8(std::uint64_t offset)
+{
+  return (offset + 7) & ~std::uint64_t{7};
+}
+
+// Every entry's name and cells lie inside their sections, so At() can read
+// them unchecked. The header is already known to be valid.
+bool ValidEntries(const std::uint8_t* data, std::size_t size)
+{
+  const AtlasHeader* header = reinterpret_cast<const AtlasHeader*>(data);
+  const AtlasEntry* entries = reinterpret_cast<const AtlasEntry*>(data + header->entriesOffset);
+  const std::uint64_t names_size = header->cellsOffset - header->namesOffset;
+  const std::uint64_t cell_count = (size - header->cellsOffset) / sizeof(AtlasCell);
+
+  return std::all_of(entries, entries + header->count, [&](const AtlasEntry& entry) {
+    return std::uint64_t{entry.nameOffset} + entry.nameLength <= names_size &&
+           std::uint64_t{entry.firstCell} + std::uint64_t{entry.width} * entry.height <= cell_count;
+  });
+}
+
+}
+
+
+void SpriteView::Draw(Display& display, int x, int y) const
+{
+  for (int row = 0; row < height; row++)
+  {
+    for (int col = 0; col < width; col++)
+    {
+      const AtlasCell& cell = cells[static_cast<std::size_t>(row) * width + col];
+      if (cell.opaque)
+      {
+        display.DrawCell(x + col, y + row, Cell {cell.glyph, cell.colorPair, 0});
+      }
+    }
+  }
+}
+
+
+std::vector<AtlasCell> BakeSprite(const RgbaImage& image, int& width, int& height)
+{
+  width = image.width;
+  height = (image.height + 1) / 2;
+
+  std::vector<AtlasCell> cells(static_cast<std::size_t>(width) * height, AtlasCell {kSpace, 0, 0});
+
+  for (int row = 0; row < height; row++)
+  {
+    for (int col = 0; col < width; col++)
+    {
+      Rgb top;
+      Rgb bottom;
+      const bool top_opaque = ReadPixel(image, col, 2 * row, top);
+      const bool bottom_opaque = ReadPixel(image, col, 2 * row + 1, bottom);
+
+      if (top_opaque || bottom_opaque)
+      {
+        cells[static_cast<std::size_t>(row) * width + col] = BakeCell(top, bottom);
+      }
+    }
+  }
+
+  return cells;
+}
+
+
+void SpriteAtlasWriter::Add(std::string name, const RgbaImage& image)
+{
+  Entry entry {std::move(name), 0, 0, {}};
+  entry.cells = BakeSprite(image, entry.width, entry.height);
+  _entries.push_back(std::move(entry));
+}
+
+bool SpriteAtlasWriter::Write(const std::string& path) const
+{
+  std::vector<const Entry*> sorted;
+  for (const Entry& entry : _entries)
+  {
+    sorted.push_back(&entry);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const Entry* a, const Entry* b) {
+    return a->name < b->name;
+  });
+
+  std::vector<AtlasEntry> table;
+  std::string names;
+  std::vector<AtlasCell> cells;
+  for (const Entry* entry : sorted)
+  {
+    table.push_back({static_cast<std::uint32_t>(names.size()),
+                     static_cast<std::uint32_t>(entry->name.size()),
+                     static_cast<std::uint32_t>(cells.size()),
+                     static_cast<std::uint16_t>(entry->width),
+                     static_cast<std::uint16_t>(entry->height)});
+    names += entry->name;
+    cells.insert(cells.end(), entry->cells.begin(), entry->cells.end());
+  }
+
+  AtlasHeader header {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.count = static_cast<std::uint32_t>(table.size());
+  header.entriesOffset = Align8(sizeof(AtlasHeader));
+  header.namesOffset = Align8(header.entriesOffset + table.size() * sizeof(AtlasEntry));
+  header.cellsOffset = Align8(header.namesOffset + names.size());
+  header.fileSize = header.cellsOffset + cells.size() * sizeof(AtlasCell);
+
+  std::vector<char> file(header.fileSize, 0);
+  std::memcpy(file.data(), &header, sizeof(header));
+  std::memcpy(file.data() + header.entriesOffset, table.data(), table.size() * sizeof(AtlasEntry));
+  std::memcpy(file.data() + header.namesOffset, names.data(), names.size());
+  std::memcpy(file.data() + header.cellsOffset, cells.data(), cells.size() * sizeof(AtlasCell));
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(file.data(), static_cast<std::streamsize>(file.size()));
+  return static_cast<bool>(out);
+}
+
+
+SpriteAtlas::~SpriteAtlas()
+{
+  Close();
+}
+
+bool SpriteAtlas::Open(const std::string& path)
+{
+  Close();
+
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(AtlasHeader))
+  {
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    return false;
+  }
+
+  _data = static_cast<const std::uint8_t*>(mapping);
+  _size = static_cast<std::size_t>(info.st_size);
+
+  const AtlasHeader* header = reinterpret_cast<const AtlasHeader*>(_data);
+  const bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                     header->version == kVersion &&
+                     header->fileSize == _size &&
+                     (header->entriesOffset | header->namesOffset | header->cellsOffset) % 8 == 0 &&
+                     header->entriesOffset >= sizeof(AtlasHeader) &&
+                     header->entriesOffset <= header->namesOffset &&
+                     header->namesOffset <= header->cellsOffset &&
+                     header->cellsOffset <= _size &&
+                     header->entriesOffset + header->count * sizeof(AtlasEntry) <= header->namesOffset;
+  if (!valid || !ValidEntries(_data, _size))
+  {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void SpriteAtlas::Close()
+{
+  if (_data)
+  {
+    munmap(const_cast<std::uint8_t*>(_data), _size);
+  }
+  _data = nullptr;
+  _size = 0;
+}
+
+std::size_t SpriteAtlas::Size() const
+{
+  return _data ? reinterpret_cast<const AtlasHeader*>(_data)->count : 0;
+}
+
+SpriteView SpriteAtlas::At(std::size_t index) const
+{
+  const AtlasHeader* header = reinterpret_cast<const AtlasHeader*>(_data);
+  const AtlasEntry& entry = reinterpret_cast<const AtlasEntry*>(_data + header->entriesOffset)[index];
+  const AtlasCell* cells = reinterpret_cast<const AtlasCell*>(_data + header->cellsOffset);
+
+  return SpriteView {
+    std::string_view(reinterpret_cast<const char*>(_data + header->namesOffset) + entry.nameOffset,
+                     entry.nameLength),
+    entry.width,
+    entry.height,
+    std::span<const AtlasCell>(cells + entry.firstCell,
+                               static_cast<std::size_t>(entry.width) * entry.height),
+  };
+}
+
+SpriteView SpriteAtlas::Find(std::string_view name) const
+{
+  std::size_t low = 0;
+  std::size_t high = Size();
+
+  while (low < high)
+  {
+    const std::size_t middle = (low + high) / 2;
+    const SpriteView view = At(middle);
+    if (view.name < name)
+    {
+      low = middle + 1;
+    }
+    else if (name < view.name)
+    {
+      high = middle;
+    }
+    else
+    {
+      return view;
+    }
+  }
+
+  return SpriteView {};
+}
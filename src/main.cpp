@@ -1,98 +1,319 @@
+#include <cerrno>
 #include <chrono>
-#include <thread>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <string>
+#include <variant>
 
+#include <poll.h>
+#include <unistd.h>
+
+#include "game/DemoScene.h"
+#include "graphics/CellFrame.h"
 #include "graphics/NcursesGraphics.h"
-#include "rules/Roll.h"
+#include "graphics/SpriteAtlas.h"
+#include "replay/ReplayLog.h"
+#include "server/TableClient.h"
+#include "server/TableServer.h"
+#include "utils/GameLoop.h"
+#include "utils/InputThread.h"
+#include "utils/Profiler.h"
+
+#ifndef DND_SPRITE_ATLAS
+#define DND_SPRITE_ATLAS "sprites.atlas"
+#endif
+
+namespace
+{
+
+// Hosts tables until SIGINT or SIGTERM, reporting every few seconds
+int Serve(const std::string& path, std::size_t workers)
+{
+    ServerConfig config;
+    config.workers = workers;
+    TableServer server(config);
+    if (!server.Listen(path))
+    {
+        std::cerr << std::format("Cannot listen on {}: {}\n", path, std::strerror(errno));
+        return 1;
+    }
+
+    // Blocked before the threads start, so they all inherit the mask and
+    // the signals wait for sigtimedwait below
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    if (!server.Start())
+    {
+        std::cerr << "Cannot start the server\n";
+        return 1;
+    }
+    std::cout << std::format("Serving tables on {} with {} workers\n", path, server.NumWorkers());
+
+    const timespec report_period {5, 0};
+    while (sigtimedwait(&signals, nullptr, &report_period) < 0)
+    {
+        const ServerStats stats = server.Stats();
+        std::cout << std::format("{} sessions, {} keys, {} frames ({} skipped), {:.1f} MB sent\n",
+                                 stats.sessions,
+                                 stats.keys,
+                                 stats.frames,
+                                 stats.skippedFrames,
+                                 stats.bytesSent / 1e6);
+    }
+
+    server.Stop();
+    return 0;
+}
+
+// Plays a table of a server: keys go to the server, its cell frames are
+// written straight to the terminal
+int Connect(const std::string& path)
+{
+    TableClient client;
+    int error = 0;
+    {
+        Display display;
+        display.Init();
+        NcursesTarget& terminal = std::get<NcursesTarget>(display.Target());
+
+        if (!client.Connect(path, {display.NumColumns(), display.NumLines(), 0}))
+        {
+            error = errno;
+        }
+        else
+        {
+            CellFrameReader reader;
+            client.SetOnFrame([&](const FrameMessage& frame)
+            {
+                if (!reader.Open(frame.cellFrame))
+                {
+                    return;
+                }
+                if (reader.ClearsScreen())
+                {
+                    terminal.Clear();
+                }
+                int x = 0;
+                int y = 0;
+                std::span<const Cell> cells;
+                while (reader.Next(x, y, cells))
+                {
+                    terminal.WriteRun(x, y, cells);
+                }
+                terminal.Present();
+            });
+
+            InputThread input;
+            input.Start(display.InputFd(), STDOUT_FILENO);
+            pollfd fds[2] = {{client.Fd(), POLLIN, 0}, {input.WakeFd(), POLLIN, 0}};
+            std::uint32_t tag = 0;
+            bool playing = true;
+
+            while (playing)
+            {
+                fds[0].events = POLLIN | (client.WantsWrite() ? POLLOUT : 0);
+                if (poll(fds, 2, -1) < 0)
+                {
+                    continue;
+                }
+                if ((fds[0].revents & POLLOUT) && !client.Flush())
+                {
+                    break;
+                }
+                if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) && !client.Receive())
+                {
+                    break;
+                }
+
+                InputEvent event;
+                while (playing && input.Poll(event))
+                {
+                    if (event.type == InputType::RESIZE)
+                    {
+                        display.Resize(event.columns, event.lines);
+                        playing = client.SendResize(event.columns, event.lines);
+                    }
+                    else
+                    {
+                        playing = client.SendKey(event.key, ++tag);
+                    }
+                }
+            }
+            input.Stop();
+        }
+    }
+
+    if (error != 0)
+    {
+        std::cerr << std::format("Cannot connect to {}: {}\n", path, std::strerror(error));
+        return 1;
+    }
+    return 0;
+}
 
-namespace cr = std::chrono;
+}
 
-int main()
+int main(int argc, char** argv)
 {
+    // --serve <path> hosts tables for clients of a Unix socket, on
+    // --workers <n> threads; --connect <path> plays one of them
+    std::string serve_path;
+    std::string connect_path;
+    std::size_t workers = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        if (option == "--serve")
+        {
+            serve_path = argv[i + 1];
+        }
+        else if (option == "--connect")
+        {
+            connect_path = argv[i + 1];
+        }
+        else if (option == "--workers")
+        {
+            workers = std::strtoul(argv[i + 1], nullptr, 10);
+        }
+    }
+    if (!serve_path.empty())
+    {
+        return Serve(serve_path, workers);
+    }
+    if (!connect_path.empty())
+    {
+        return Connect(connect_path);
+    }
+
     Display display;
-    /*
-    "<(o_o)>"
-    " -|_|-/"
-    "  / \  "; 
-   */
-    TextSprite goblin (
-        {{'<', '(', 'o', '_', 'o', ')', '>'},
-         {' ', '-', '|', '_', '|', '-', '/'},
-         {' ', ' ', '|', ' ', '|', ' ', ' '},
-        },
-        FontColor::BLACK_OVER_RED
-    );
-
-    TextSprite player (
-        {{'#'}},
-        FontColor::WHITE_OVER_RED
-
-    );
 
-    display.Init();
+    // Baked from resources/sprites at build time, mapped, never decoded
+    SpriteAtlas atlas;
+    atlas.Open(DND_SPRITE_ATLAS);
 
-    int x = 10, y = 5;
-    int ch;
-    int frameCount = 0;
-    auto lastTime = cr::high_resolution_clock::now();
-    float fps = 0.0;
+    display.Init();
 
     display.SetMarginColor(FontColor::BLUE_OVER_BLACK);
 
-    while ((ch = display.GetChar()) != 'q' && ch != 27) 
+    DemoScene scene(display.NumColumns(), display.NumLines(), atlas.Find("racket"));
+
+    // --record <path> logs keys, Die rolls and token moves for a headless
+    // replay (see ReplayTool); --trace <path> writes the profiler zones as a
+    // Chrome trace on exit
+    std::string record_path;
+    std::string trace_path;
+    for (int i = 1; i + 1 < argc; i += 2)
     {
-        display.NewFrame();
-        std::string fps_text = std::format("FPS: {:.2f}", fps);
-        display.DrawText(fps_text,  
-                 display.NumColumns() - 15, 
-                 1,
-                 FontColor::CYAN_OVER_BLACK);
-
-        display.DrawText("Hello, ncurses!", 
-                         10,
-                         10,
-                         FontColor::GREEN_OVER_BLACK);
-
-        display.DrawText("Move with arrow keys!", 10, 12, FontColor::GREEN_OVER_BLACK);
-        display.DrawText("Press 'q' to quit", 10, 14, FontColor::GREEN_OVER_BLACK);
-	std::string die_roll = std::format("%d", Die::Roll(2, 3));
-	display.DrawText(die_roll, 20, 20, FontColor::BLUE_OVER_BLACK);
-
-        switch (ch) {
-            case static_cast<int>(Key::UP): 
-               y = (y > 1) ? y - 1 : y; 
-               break;
-
-            case static_cast<int>(Key::DOWN):  
-                y = (y < display.NumLines() - 2) ? y + 1 : y; 
-                break;
-
-            case static_cast<int>(Key::LEFT):  
-                x = (x > 1) ? x - 1 : x; 
-                break;
-
-            case static_cast<int>(Key::RIGHT): 
-                x = (x < display.NumColumns() - 20) ? x + 1 : x; 
-                break;
+        const std::string option = argv[i];
+        if (option == "--record")
+        {
+            record_path = argv[i + 1];
+        }
+        else if (option == "--trace")
+        {
+            trace_path = argv[i + 1];
         }
+    }
+    if (!trace_path.empty())
+    {
+        Profiler::Enable(true);
+    }
+
+    CreatureState state;
+    state.Resize(2);
+    ReplayWriter recorder;
+    bool recording = false;
+
+    if (!record_path.empty())
+    {
+        for (std::uint32_t creature : {DemoScene::kGoblin, DemoScene::kPlayer})
+        {
+            if (scene.Has(creature))
+            {
+                state.Set(creature, StateField::X, scene.Position(creature).x);
+                state.Set(creature, StateField::Y, scene.Position(creature).y);
+            }
+        }
+        recording = recorder.Open(record_path, state, 60);
+        if (recording)
+        {
+            recorder.RecordDice();
+            scene.SetOnMove([&](std::uint32_t creature, GridPos pos)
+            {
+                recorder.Set(state, creature, StateField::X, pos.x);
+                recorder.Set(state, creature, StateField::Y, pos.y);
+            });
+        }
+    }
+
+    // Keys are read and decoded on their own thread; between frames the loop
+    // sleeps on the thread's wake-up fd, so key presses are handled as soon
+    // as they arrive. 60 simulation ticks and 60 frames per second.
+    InputThread input;
+    input.Start(display.InputFd(), STDOUT_FILENO);
+    GameLoop loop(60.0, 60.0, input.WakeFd());
 
-        goblin.SetPos(x, y);
-        player.SetPos(x + 10, y);
-        goblin.Draw(display);
-        player.Draw(display);
-
-        display.Refresh();
-        frameCount++;
-
-        // Calculate FPS every second
-        auto currentTime = cr::high_resolution_clock::now();
-        double elapsedTime = cr::duration<double>(currentTime - lastTime).count();
-        if (elapsedTime >= 1.0) {
-            fps = frameCount / elapsedTime;
-            frameCount = 0;
-            lastTime = currentTime;
+    // Input-to-photon: from when a key was read to the Refresh() showing it
+    FrameTimes input_latency;
+    GameLoop::Clock::time_point unshown_key {};
+
+    auto read_key = [&]
+    {
+        InputEvent event;
+        while (input.Poll(event))
+        {
+            if (event.type == InputType::RESIZE)
+            {
+                display.Resize(event.columns, event.lines);
+                continue;
+            }
+            if (unshown_key == GameLoop::Clock::time_point {})
+            {
+                unshown_key = event.time;
+            }
+            if (recording)
+            {
+                recorder.Key(event.key);
+            }
+            return event.key;
+        }
+        return -1;
+    };
+
+    auto on_tick = [&](GameLoop::Clock::duration)
+    {
+        if (recording)
+        {
+            recorder.Tick(state);
         }
+        scene.Tick();
+    };
+
+    loop.Run(read_key,
+             [&](int ch) { return scene.OnKey(ch); },
+             on_tick,
+             [&](double)
+             {
+                 scene.Render(display, loop.GetFrameTimes(), &input_latency);
+                 if (unshown_key != GameLoop::Clock::time_point {})
+                 {
+                     input_latency.Record(GameLoop::Clock::now() - unshown_key);
+                     unshown_key = {};
+                 }
+             });
 
-        std::this_thread::sleep_for(cr::milliseconds(16)); // Limit FPS (~60 FPS)
+    input.Stop();
+
+    if (!trace_path.empty())
+    {
+        Profiler::WriteChromeTrace(trace_path);
     }
     
     return 0;
@@ -0,0 +1,180 @@
+#include "map/AreaTemplate.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// Keeps squares whose center sits exactly on the edge of a shape
+constexpr double kEpsilon = 1e-9;
+
+struct Direction
+{
+  double x;
+  double y;
+};
+
+Direction Towards(GridPos origin, GridPos toward)
+{
+  const double dx = toward.x - origin.x;
+  const double dy = toward.y - origin.y;
+  const double length = std::hypot(dx, dy);
+  if (length == 0.0)
+  {
+    return {1.0, 0.0};
+  }
+  return {dx / length, dy / length};
+}
+
+double CenterOf(int coordinate)
+{
+  return coordinate + 0.5;
+}
+
+}
+
+
+AreaTemplate AreaTemplate::Sphere(GridPos center, double radius)
+{
+  AreaTemplate area;
+  const double cx = CenterOf(center.x);
+  const int rows = static_cast<int>(std::floor(radius + kEpsilon));
+
+  for (int dy = -rows; dy <= rows; dy++)
+  {
+    const double half = std::sqrt(std::max(radius * radius - dy * dy, 0.0));
+    area.AddRow(center.y + dy, cx - half, cx + half);
+  }
+  return area;
+}
+
+AreaTemplate AreaTemplate::Cone(GridPos origin, GridPos toward, double length)
+{
+  const Direction d = Towards(origin, toward);
+  const Point apex {CenterOf(origin.x) + 0.5 * d.x, CenterOf(origin.y) + 0.5 * d.y};
+  const Point end {apex.x + length * d.x, apex.y + length * d.y};
+  const double half = length / 2.0;
+
+  const Point vertices[] = {
+    apex,
+    {end.x - d.y * half, end.y + d.x * half},
+    {end.x + d.y * half, end.y - d.x * half},
+  };
+  return Polygon(vertices);
+}
+
+AreaTemplate AreaTemplate::Line(GridPos origin, GridPos toward, double length, double width)
+{
+  const Direction d = Towards(origin, toward);
+  const Point start {CenterOf(origin.x) + 0.5 * d.x, CenterOf(origin.y) + 0.5 * d.y};
+  const Point end {start.x + length * d.x, start.y + length * d.y};
+  const double half = width / 2.0;
+
+  const Point vertices[] = {
+    {start.x - d.y * half, start.y + d.x * half},
+    {end.x - d.y * half, end.y + d.x * half},
+    {end.x + d.y * half, end.y - d.x * half},
+    {start.x + d.y * half, start.y - d.x * half},
+  };
+  return Polygon(vertices);
+}
+
+AreaTemplate AreaTemplate::Rect(GridPos first, GridPos last)
+{
+  AreaTemplate area;
+  for (int y = first.y; y <= last.y; y++)
+  {
+    area._spans.push_back({y, first.x, last.x});
+  }
+  return area;
+}
+
+AreaTemplate AreaTemplate::Polygon(std::span<const Point> vertices)
+{
+  AreaTemplate area;
+
+  double ymin = vertices[0].y;
+  double ymax = vertices[0].y;
+  for (const Point& vertex : vertices)
+  {
+    ymin = std::min(ymin, vertex.y);
+    ymax = std::max(ymax, vertex.y);
+  }
+
+  const int first = static_cast<int>(std::ceil(ymin - 0.5 - kEpsilon));
+  const int last = static_cast<int>(std::floor(ymax - 0.5 + kEpsilon));
+
+  for (int y = first; y <= last; y++)
+  {
+    const double cy = CenterOf(y);
+    double xmin = HUGE_VAL;
+    double xmax = -HUGE_VAL;
+
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+      const Point& a = vertices[i];
+      const Point& b = vertices[(i + 1) % vertices.size()];
+      if (cy < std::min(a.y, b.y) - kEpsilon || cy > std::max(a.y, b.y) + kEpsilon)
+      {
+        continue;
+      }
+
+      if (std::abs(b.y - a.y) < kEpsilon)
+      {
+        xmin = std::min({xmin, a.x, b.x});
+        xmax = std::max({xmax, a.x, b.x});
+      }
+      else
+      {
+        const double x = a.x + (cy - a.y) * (b.x - a.x) / (b.y - a.y);
+        xmin = std::min(xmin, x);
+        xmax = std::max(xmax, x);
+      }
+    }
+
+    if (xmin <= xmax)
+    {
+      area.AddRow(y, xmin, xmax);
+    }
+  }
+
+  return area;
+}
+
+void AreaTemplate::AddRow(int y, double xmin, double xmax)
+{
+  const int x0 = static_cast<int>(std::ceil(xmin - 0.5 - kEpsilon));
+  const int x1 = static_cast<int>(std::floor(xmax - 0.5 + kEpsilon));
+  if (x0 <= x1)
+  {
+    _spans.push_back({y, x0, x1});
+  }
+}
+
+std::span<const CellSpan> AreaTemplate::Spans() const
+{
+  return _spans;
+}
+
+std::size_t AreaTemplate::NumCells() const
+{
+  std::size_t cells = 0;
+  for (const CellSpan& span : _spans)
+  {
+    cells += span.x1 - span.x0 + 1;
+  }
+  return cells;
+}
+
+bool AreaTemplate::Contains(GridPos cell) const
+{
+  for (const CellSpan& span : _spans)
+  {
+    if (span.y == cell.y)
+    {
+      return cell.x >= span.x0 && cell.x <= span.x1;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,279 @@
+#include "map/BattleMap.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+
+constexpr int kWordBits = 64;
+
+bool TestBit(const std::vector<std::uint64_t>& bits, std::size_t word, int bit)
+{
+  return (bits[word] >> bit) & 1;
+}
+
+void SetBit(std::vector<std::uint64_t>& bits, std::size_t word, int bit, bool value)
+{
+  const std::uint64_t mask = std::uint64_t{1} << bit;
+  bits[word] = value ? bits[word] | mask : bits[word] & ~mask;
+}
+
+}
+
+
+BattleMap::BattleMap(int width, int height)
+  : _width(width),
+    _height(height),
+    _row_words((width + kWordBits - 1) / kWordBits),
+    _occupied(_row_words * height, 0),
+    _walls(_row_words * height, 0),
+    _occupant(static_cast<std::size_t>(width) * height, kNoToken)
+{
+
+}
+
+int BattleMap::Width() const
+{
+  return _width;
+}
+
+int BattleMap::Height() const
+{
+  return _height;
+}
+
+bool BattleMap::InBounds(GridPos cell) const
+{
+  return cell.x >= 0 && cell.y >= 0 && cell.x < _width && cell.y < _height;
+}
+
+void BattleMap::SetWall(GridPos cell, bool wall)
+{
+  if (InBounds(cell))
+  {
+    SetBit(_walls, cell.y * _row_words + cell.x / kWordBits, cell.x % kWordBits, wall);
+  }
+}
+
+bool BattleMap::IsWall(GridPos cell) const
+{
+  return InBounds(cell) && TestBit(_walls, cell.y * _row_words + cell.x / kWordBits, cell.x % kWordBits);
+}
+
+std::size_t BattleMap::RowWords() const
+{
+  return _row_words;
+}
+
+std::span<const std::uint64_t> BattleMap::WallBits() const
+{
+  return _walls;
+}
+
+std::span<const std::uint64_t> BattleMap::OccupiedBits() const
+{
+  return _occupied;
+}
+
+TokenId BattleMap::Place(GridPos pos, int width, int height, int reach, int team)
+{
+  const Token token {pos, width, height, reach, team};
+  if (width <= 0 || height <= 0 || !Fits(token, pos, kNoToken))
+  {
+    return kNoToken;
+  }
+
+  TokenId id;
+  if (!_free_tokens.empty())
+  {
+    id = _free_tokens.back();
+    _free_tokens.pop_back();
+    _tokens[id] = token;
+  }
+  else
+  {
+    id = static_cast<TokenId>(_tokens.size());
+    _tokens.push_back(token);
+  }
+
+  _max_reach = std::max(_max_reach, reach);
+  Stamp(token, id);
+  return id;
+}
+
+void BattleMap::Remove(TokenId id)
+{
+  if (!IsValid(id))
+  {
+    return;
+  }
+  Stamp(_tokens[id], kNoToken);
+  _tokens[id] = Token {};
+  _free_tokens.push_back(id);
+}
+
+bool BattleMap::IsValid(TokenId id) const
+{
+  // Placed tokens have a footprint; freed slots are reset to width 0
+  return id < _tokens.size() && _tokens[id].width > 0;
+}
+
+const Token& BattleMap::GetToken(TokenId id) const
+{
+  return _tokens[id];
+}
+
+TokenId BattleMap::At(GridPos cell) const
+{
+  return InBounds(cell) ? _occupant[CellIndex(cell)] : kNoToken;
+}
+
+bool BattleMap::CanMove(TokenId id, GridPos to) const
+{
+  return Fits(_tokens[id], to, id);
+}
+
+bool BattleMap::Move(TokenId id, GridPos to)
+{
+  Token& token = _tokens[id];
+  if (!Fits(token, to, id))
+  {
+    return false;
+  }
+
+  Stamp(token, kNoToken);
+  token.pos = to;
+  Stamp(token, id);
+  return true;
+}
+
+void BattleMap::Query(const AreaTemplate& area, std::vector<TokenId>& hits) const
+{
+  const std::size_t first_hit = hits.size();
+  bool multi_cell = false;
+
+  for (const CellSpan& span : area.Spans())
+  {
+    if (span.y < 0 || span.y >= _height)
+    {
+      continue;
+    }
+    const int x0 = std::max(span.x0, 0);
+    const int x1 = std::min(span.x1, _width - 1);
+    if (x0 > x1)
+    {
+      continue;
+    }
+
+    const std::size_t row = span.y * _row_words;
+    const int last_word = x1 / kWordBits;
+    for (int word_index = x0 / kWordBits; word_index <= last_word; word_index++)
+    {
+      std::uint64_t word = _occupied[row + word_index];
+      const int base = word_index * kWordBits;
+      if (x0 > base)
+      {
+        word &= ~std::uint64_t{0} << (x0 - base);
+      }
+      if (x1 - base < kWordBits - 1)
+      {
+        word &= ~std::uint64_t{0} >> (kWordBits - 1 - (x1 - base));
+      }
+
+      while (word)
+      {
+        const int x = base + std::countr_zero(word);
+        const TokenId id = _occupant[static_cast<std::size_t>(span.y) * _width + x];
+        multi_cell |= _tokens[id].width * _tokens[id].height > 1;
+        hits.push_back(id);
+        word &= word - 1;
+      }
+    }
+  }
+
+  // A creature bigger than one square can be hit on several of them
+  if (multi_cell)
+  {
+    std::sort(hits.begin() + first_hit, hits.end());
+    hits.erase(std::unique(hits.begin() + first_hit, hits.end()), hits.end());
+  }
+}
+
+void BattleMap::Threatening(TokenId target, std::vector<TokenId>& threats) const
+{
+  const Token& token = _tokens[target];
+  const AreaTemplate around = AreaTemplate::Rect(
+    {token.pos.x - _max_reach, token.pos.y - _max_reach},
+    {token.pos.x + token.width - 1 + _max_reach, token.pos.y + token.height - 1 + _max_reach});
+
+  thread_local std::vector<TokenId> candidates;
+  candidates.clear();
+  Query(around, candidates);
+
+  for (TokenId id : candidates)
+  {
+    const Token& other = _tokens[id];
+    if (other.team != token.team && Distance(token, token.pos, other) <= other.reach)
+    {
+      threats.push_back(id);
+    }
+  }
+}
+
+void BattleMap::OpportunityAttackers(TokenId mover, GridPos to, std::vector<TokenId>& attackers) const
+{
+  const Token& token = _tokens[mover];
+  const std::size_t first = attackers.size();
+
+  Threatening(mover, attackers);
+  attackers.erase(std::remove_if(attackers.begin() + first, attackers.end(), [&](TokenId id) {
+                    return Distance(token, to, _tokens[id]) <= _tokens[id].reach;
+                  }),
+                  attackers.end());
+}
+
+std::size_t BattleMap::CellIndex(GridPos cell) const
+{
+  return static_cast<std::size_t>(cell.y) * _width + cell.x;
+}
+
+bool BattleMap::Fits(const Token& token, GridPos pos, TokenId self) const
+{
+  if (!InBounds(pos) || !InBounds({pos.x + token.width - 1, pos.y + token.height - 1}))
+  {
+    return false;
+  }
+
+  for (int y = pos.y; y < pos.y + token.height; y++)
+  {
+    for (int x = pos.x; x < pos.x + token.width; x++)
+    {
+      const TokenId occupant = _occupant[CellIndex({x, y})];
+      if (IsWall({x, y}) || (occupant != kNoToken && occupant != self))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void BattleMap::Stamp(const Token& token, TokenId id)
+{
+  for (int y = token.pos.y; y < token.pos.y + token.height; y++)
+  {
+    for (int x = token.pos.x; x < token.pos.x + token.width; x++)
+    {
+      _occupant[CellIndex({x, y})] = id;
+      SetBit(_occupied, y * _row_words + x / kWordBits, x % kWordBits, id != kNoToken);
+    }
+  }
+}
+
+int BattleMap::Distance(const Token& a, GridPos aPos, const Token& b)
+{
+  const int dx = std::max({0, aPos.x - (b.pos.x + b.width - 1), b.pos.x - (aPos.x + a.width - 1)});
+  const int dy = std::max({0, aPos.y - (b.pos.y + b.height - 1), b.pos.y - (aPos.y + a.height - 1)});
+  return std::max(dx, dy);
+}
@@ -0,0 +1,353 @@
+#include "map/FieldOfView.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "utils/Profiler.h"
+
+namespace
+{
+
+constexpr int kWordBits = 64;
+
+// Maps octant coordinates (column, row) to map offsets
+struct Octant
+{
+  int xx;
+  int xy;
+  int yx;
+  int yy;
+};
+
+constexpr Octant kOctants[8] = {
+  {1, 0, 0, -1}, {0, 1, -1, 0}, {0, -1, -1, 0}, {-1, 0, 0, -1},
+  {-1, 0, 0, 1}, {0, -1, 1, 0}, {0, 1, 1, 0}, {1, 0, 0, 1},
+};
+
+struct Caster
+{
+  const BattleMap& map;
+  GridPos eye;
+  int radius;
+  VisibilityGrid& visible;
+
+  bool Blocks(GridPos cell) const
+  {
+    return !map.InBounds(cell) || map.IsWall(cell);
+  }
+
+  // Lights row `row` onwards of one octant between slopes start >= end.
+  // Squares outside the radius are skipped before they are looked at, so a
+  // square is looked at exactly when it ends up visible.
+  void Cast(const Octant& octant, int row, double start, double end)
+  {
+    if (start < end)
+    {
+      return;
+    }
+
+    const int radius_squared = radius * radius;
+    double next_start = start;
+
+    for (int depth = row; depth <= radius; depth++)
+    {
+      bool blocked = false;
+      const int dy = -depth;
+
+      for (int dx = -depth; dx <= 0; dx++)
+      {
+        const double left_slope = (dx - 0.5) / (dy + 0.5);
+        const double right_slope = (dx + 0.5) / (dy - 0.5);
+        if (start < right_slope)
+        {
+          continue;
+        }
+        if (end > left_slope)
+        {
+          break;
+        }
+        if (dx * dx + dy * dy > radius_squared)
+        {
+          continue;
+        }
+
+        const GridPos cell {eye.x + dx * octant.xx + dy * octant.xy,
+                            eye.y + dx * octant.yx + dy * octant.yy};
+        const bool wall = Blocks(cell);
+        if (map.InBounds(cell))
+        {
+          visible.Set(cell);
+        }
+
+        if (blocked)
+        {
+          if (wall)
+          {
+            next_start = right_slope;
+          }
+          else
+          {
+            blocked = false;
+            start = next_start;
+          }
+        }
+        else if (wall && depth < radius)
+        {
+          blocked = true;
+          Cast(octant, depth + 1, start, left_slope);
+          next_start = right_slope;
+        }
+      }
+
+      if (blocked)
+      {
+        break;
+      }
+    }
+  }
+};
+
+}
+
+
+void VisibilityGrid::Reset(int width, int height)
+{
+  _width = width;
+  _height = height;
+  _row_words = (width + kWordBits - 1) / kWordBits;
+  _words.assign(_row_words * height, 0);
+  _first_row = height;
+  _last_row = -1;
+}
+
+void VisibilityGrid::Clear()
+{
+  if (_first_row <= _last_row)
+  {
+    std::fill(_words.begin() + _first_row * _row_words, _words.begin() + (_last_row + 1) * _row_words, 0);
+  }
+  _first_row = _height;
+  _last_row = -1;
+}
+
+void VisibilityGrid::Set(GridPos cell)
+{
+  _words[cell.y * _row_words + cell.x / kWordBits] |= std::uint64_t{1} << (cell.x % kWordBits);
+  _first_row = std::min(_first_row, cell.y);
+  _last_row = std::max(_last_row, cell.y);
+}
+
+bool VisibilityGrid::Test(GridPos cell) const
+{
+  if (cell.x < 0 || cell.y < 0 || cell.x >= _width || cell.y >= _height)
+  {
+    return false;
+  }
+  return (_words[cell.y * _row_words + cell.x / kWordBits] >> (cell.x % kWordBits)) & 1;
+}
+
+void VisibilityGrid::Merge(const VisibilityGrid& other)
+{
+  if (other._first_row > other._last_row)
+  {
+    return;
+  }
+
+  const std::size_t first = other._first_row * _row_words;
+  const std::size_t last = (other._last_row + 1) * _row_words;
+  for (std::size_t word = first; word < last; word++)
+  {
+    _words[word] |= other._words[word];
+  }
+  _first_row = std::min(_first_row, other._first_row);
+  _last_row = std::max(_last_row, other._last_row);
+}
+
+int VisibilityGrid::Width() const
+{
+  return _width;
+}
+
+int VisibilityGrid::Height() const
+{
+  return _height;
+}
+
+std::size_t VisibilityGrid::RowWords() const
+{
+  return _row_words;
+}
+
+std::span<const std::uint64_t> VisibilityGrid::Words() const
+{
+  return _words;
+}
+
+int VisibilityGrid::FirstRow() const
+{
+  return _first_row;
+}
+
+int VisibilityGrid::LastRow() const
+{
+  return _last_row;
+}
+
+
+void ComputeFieldOfView(const BattleMap& map, GridPos eye, int radius, VisibilityGrid& visible)
+{
+  if (visible.Width() != map.Width() || visible.Height() != map.Height())
+  {
+    visible.Reset(map.Width(), map.Height());
+  }
+  visible.Clear();
+
+  if (!map.InBounds(eye))
+  {
+    return;
+  }
+  visible.Set(eye);
+
+  Caster caster {map, eye, radius, visible};
+  for (const Octant& octant : kOctants)
+  {
+    caster.Cast(octant, 1, 1.0, 0.0);
+  }
+}
+
+
+FieldOfView::FieldOfView(const BattleMap& map, int radius)
+  : _map(map), _radius(radius)
+{
+
+}
+
+void FieldOfView::Track(TokenId id)
+{
+  if (id >= _viewers.size())
+  {
+    _viewers.resize(id + 1);
+  }
+  _viewers[id].tracked = true;
+  _viewers[id].dirty = true;
+}
+
+void FieldOfView::Untrack(TokenId id)
+{
+  _viewers[id].tracked = false;
+  _viewers[id].dirty = false;
+  _viewers[id].visible.Clear();
+}
+
+void FieldOfView::MarkMoved(TokenId id)
+{
+  _viewers[id].dirty = _viewers[id].tracked;
+}
+
+void FieldOfView::MarkWallChanged(GridPos cell)
+{
+  // A square nobody could see was never looked at by the shadowcasting, so
+  // changing it cannot change any view.
+  for (Viewer& viewer : _viewers)
+  {
+    viewer.dirty |= viewer.tracked && viewer.visible.Test(cell);
+  }
+}
+
+std::size_t FieldOfView::Update()
+{
+  PROFILE_ZONE("FieldOfView::Update");
+
+  std::size_t updated = 0;
+  for (TokenId id = 0; id < _viewers.size(); id++)
+  {
+    Viewer& viewer = _viewers[id];
+    if (viewer.dirty)
+    {
+      ComputeFieldOfView(_map, Eye(id), _radius, viewer.visible);
+      viewer.dirty = false;
+      updated++;
+    }
+  }
+  return updated;
+}
+
+const VisibilityGrid& FieldOfView::VisibleFrom(TokenId viewer) const
+{
+  return _viewers[viewer].visible;
+}
+
+bool FieldOfView::CanSee(TokenId viewer, TokenId target) const
+{
+  const VisibilityGrid& visible = _viewers[viewer].visible;
+  const Token& token = _map.GetToken(target);
+
+  for (int y = token.pos.y; y < token.pos.y + token.height; y++)
+  {
+    for (int x = token.pos.x; x < token.pos.x + token.width; x++)
+    {
+      if (visible.Test({x, y}))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void FieldOfView::VisibleTokens(TokenId viewer, std::vector<TokenId>& seen) const
+{
+  const VisibilityGrid& visible = _viewers[viewer].visible;
+  const std::span<const std::uint64_t> view = visible.Words();
+  const std::span<const std::uint64_t> occupied = _map.OccupiedBits();
+  const std::size_t row_words = visible.RowWords();
+  const std::size_t first_seen = seen.size();
+  bool multi_cell = false;
+
+  for (int y = visible.FirstRow(); y <= visible.LastRow(); y++)
+  {
+    for (std::size_t word_index = 0; word_index < row_words; word_index++)
+    {
+      const std::size_t index = y * row_words + word_index;
+      std::uint64_t word = view[index] & occupied[index];
+      while (word)
+      {
+        const int x = static_cast<int>(word_index) * kWordBits + std::countr_zero(word);
+        const TokenId id = _map.At({x, y});
+        const Token& token = _map.GetToken(id);
+        multi_cell |= token.width * token.height > 1;
+        seen.push_back(id);
+        word &= word - 1;
+      }
+    }
+  }
+
+  if (multi_cell)
+  {
+    std::sort(seen.begin() + first_seen, seen.end());
+    seen.erase(std::unique(seen.begin() + first_seen, seen.end()), seen.end());
+  }
+}
+
+void FieldOfView::TeamView(int team, VisibilityGrid& view) const
+{
+  if (view.Width() != _map.Width() || view.Height() != _map.Height())
+  {
+    view.Reset(_map.Width(), _map.Height());
+  }
+  view.Clear();
+
+  for (TokenId id = 0; id < _viewers.size(); id++)
+  {
+    if (_viewers[id].tracked && _map.GetToken(id).team == team)
+    {
+      view.Merge(_viewers[id].visible);
+    }
+  }
+}
+
+GridPos FieldOfView::Eye(TokenId id) const
+{
+  const Token& token = _map.GetToken(id);
+  return {token.pos.x + (token.width - 1) / 2, token.pos.y + (token.height - 1) / 2};
+}
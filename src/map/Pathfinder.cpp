@@ -0,0 +1,358 @@
+#include "map/Pathfinder.h"
+
+#include <algorithm>
+
+#include "utils/Profiler.h"
+
+namespace
+{
+
+struct Step
+{
+  int dx;
+  int dy;
+};
+
+// Straight steps first, so ties resolve into straight lines
+constexpr Step kSteps[8] = {
+  {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1},
+};
+
+// Squares between a width x height footprint at pos and the goal square
+int Heuristic(GridPos pos, int width, int height, GridPos goal)
+{
+  const int dx = std::max({0, goal.x - (pos.x + width - 1), pos.x - goal.x});
+  const int dy = std::max({0, goal.y - (pos.y + height - 1), pos.y - goal.y});
+  return std::max(dx, dy);
+}
+
+// Whether a mover at from may step by (dx, dy), given where its footprint fits
+bool CanStep(const std::vector<std::uint8_t>& passable, int columns, int rows, GridPos from, int dx, int dy)
+{
+  const GridPos to {from.x + dx, from.y + dy};
+  if (to.x < 0 || to.y < 0 || to.x >= columns || to.y >= rows || !passable[to.y * columns + to.x])
+  {
+    return false;
+  }
+  // No squeezing diagonally between two walls
+  return dx == 0 || dy == 0 ||
+         (passable[from.y * columns + to.x] && passable[to.y * columns + from.x]);
+}
+
+}
+
+
+std::uint16_t FlowField::Distance(GridPos from) const
+{
+  const int rows = columns ? static_cast<int>(distance.size()) / columns : 0;
+  if (from.x < 0 || from.y < 0 || from.x >= columns || from.y >= rows)
+  {
+    return kUnreachable;
+  }
+  return distance[static_cast<std::size_t>(from.y) * columns + from.x];
+}
+
+GridPos FlowField::Next(GridPos from) const
+{
+  const std::uint16_t here = Distance(from);
+  if (here == 0 || here == kUnreachable)
+  {
+    return from;
+  }
+
+  for (const Step& step : kSteps)
+  {
+    const GridPos next {from.x + step.dx, from.y + step.dy};
+    if (Distance(next) != here - 1)
+    {
+      continue;
+    }
+    // Passable squares are exactly the reachable ones
+    if (step.dx != 0 && step.dy != 0 &&
+        (Distance({from.x + step.dx, from.y}) == kUnreachable ||
+         Distance({from.x, from.y + step.dy}) == kUnreachable))
+    {
+      continue;
+    }
+    return next;
+  }
+  return from;
+}
+
+
+void Pathfinder::Region::Add(GridPos pos)
+{
+  x0 = std::min(x0, pos.x);
+  y0 = std::min(y0, pos.y);
+  x1 = std::max(x1, pos.x);
+  y1 = std::max(y1, pos.y);
+}
+
+void Pathfinder::Region::Expand(int width, int height)
+{
+  x0 -= 1;
+  y0 -= 1;
+  x1 += width;
+  y1 += height;
+}
+
+bool Pathfinder::Region::Contains(GridPos cell) const
+{
+  return cell.x >= x0 && cell.x <= x1 && cell.y >= y0 && cell.y <= y1;
+}
+
+std::size_t Pathfinder::PathKeyHash::operator()(const PathKey& key) const
+{
+  std::size_t hash = static_cast<std::uint32_t>(key.start.x) | static_cast<std::size_t>(key.start.y) << 16;
+  hash ^= (static_cast<std::size_t>(key.goal.x) << 32 | static_cast<std::size_t>(key.goal.y) << 48) ^
+          static_cast<std::size_t>(key.width * 31 + key.height) * 0x9E3779B97F4A7C15ull;
+  return hash;
+}
+
+
+Pathfinder::Pathfinder(const BattleMap& map)
+  : _map(map),
+    _stamp(static_cast<std::size_t>(map.Width()) * map.Height(), 0),
+    _g(_stamp.size(), 0),
+    _parent(_stamp.size(), 0)
+{
+
+}
+
+std::span<const GridPos> Pathfinder::FindPath(GridPos start, GridPos goal, int width, int height)
+{
+  PROFILE_ZONE("Pathfinder::FindPath");
+
+  const PathKey key {start, goal, width, height};
+  auto found = _paths.find(key);
+  if (found != _paths.end())
+  {
+    return found->second.path;
+  }
+
+  if (_paths.size() >= kMaxCachedPaths)
+  {
+    _paths.clear();
+  }
+  return _paths.emplace(key, Search(start, goal, width, height)).first->second.path;
+}
+
+const FlowField& Pathfinder::FlowFieldTo(GridPos target, int width, int height)
+{
+  for (const CachedField& cached : _fields)
+  {
+    if (cached.field.target == target && cached.field.width == width && cached.field.height == height)
+    {
+      return cached.field;
+    }
+  }
+
+  if (_fields.size() >= kMaxFlowFields)
+  {
+    _fields.pop_front();
+  }
+
+  const std::vector<std::uint8_t>& passable = PassableGrid(width, height);
+  const int columns = _map.Width();
+  const int rows = _map.Height();
+
+  CachedField& cached = _fields.emplace_back();
+  FlowField& field = cached.field;
+  field.target = target;
+  field.width = width;
+  field.height = height;
+  field.columns = columns;
+  field.distance.assign(_stamp.size(), FlowField::kUnreachable);
+  cached.region = {target.x - width + 1, target.y - height + 1, target.x, target.y};
+
+  // Breadth first search from every position whose footprint covers the
+  // target; with unit costs it is Dijkstra without the heap.
+  std::vector<std::uint32_t>& queue = _queue;
+  queue.clear();
+
+  for (int y = std::max(target.y - height + 1, 0); y <= target.y; y++)
+  {
+    for (int x = std::max(target.x - width + 1, 0); x <= target.x; x++)
+    {
+      const std::uint32_t cell = static_cast<std::uint32_t>(y * columns + x);
+      if (_map.InBounds({x, y}) && passable[cell])
+      {
+        field.distance[cell] = 0;
+        queue.push_back(cell);
+      }
+    }
+  }
+
+  for (std::size_t head = 0; head < queue.size(); head++)
+  {
+    const std::uint32_t cell = queue[head];
+    const GridPos pos {static_cast<int>(cell % columns), static_cast<int>(cell / columns)};
+    const std::uint16_t next_distance = field.distance[cell] + 1;
+    cached.region.Add(pos);
+
+    for (const Step& step : kSteps)
+    {
+      // Steps are symmetric, so this is also the step from next back to pos
+      if (!CanStep(passable, columns, rows, pos, step.dx, step.dy))
+      {
+        continue;
+      }
+
+      const std::uint32_t next_cell = cell + step.dy * columns + step.dx;
+      if (field.distance[next_cell] == FlowField::kUnreachable)
+      {
+        field.distance[next_cell] = next_distance;
+        queue.push_back(next_cell);
+      }
+    }
+  }
+
+  cached.region.Expand(width, height);
+  return field;
+}
+
+void Pathfinder::MarkWallChanged(GridPos cell)
+{
+  std::erase_if(_paths, [&](const auto& entry) { return entry.second.region.Contains(cell); });
+  _fields.remove_if([&](const CachedField& cached) { return cached.region.Contains(cell); });
+  _passability.clear();
+}
+
+std::size_t Pathfinder::CachedPaths() const
+{
+  return _paths.size();
+}
+
+std::size_t Pathfinder::CachedFlowFields() const
+{
+  return _fields.size();
+}
+
+const std::vector<std::uint8_t>& Pathfinder::PassableGrid(int width, int height)
+{
+  for (const Passability& grid : _passability)
+  {
+    if (grid.width == width && grid.height == height)
+    {
+      return grid.passable;
+    }
+  }
+
+  Passability& grid = _passability.emplace_back(Passability {width, height, {}});
+  grid.passable.assign(_stamp.size(), 0);
+
+  // A footprint fits where the walls in the width x height box below and to
+  // the right of its top left square add up to zero.
+  const int columns = _map.Width();
+  const int rows = _map.Height();
+  std::vector<int> walls_above((columns + 1) * (rows + 1), 0);
+  for (int y = 0; y < rows; y++)
+  {
+    for (int x = 0; x < columns; x++)
+    {
+      walls_above[(y + 1) * (columns + 1) + x + 1] = _map.IsWall({x, y}) +
+                                                     walls_above[y * (columns + 1) + x + 1] +
+                                                     walls_above[(y + 1) * (columns + 1) + x] -
+                                                     walls_above[y * (columns + 1) + x];
+    }
+  }
+
+  for (int y = 0; y + height <= rows; y++)
+  {
+    for (int x = 0; x + width <= columns; x++)
+    {
+      const int walls = walls_above[(y + height) * (columns + 1) + x + width] -
+                        walls_above[y * (columns + 1) + x + width] -
+                        walls_above[(y + height) * (columns + 1) + x] +
+                        walls_above[y * (columns + 1) + x];
+      grid.passable[y * columns + x] = walls == 0;
+    }
+  }
+
+  return grid.passable;
+}
+
+Pathfinder::CachedPath Pathfinder::Search(GridPos start, GridPos goal, int width, int height)
+{
+  CachedPath result {{}, {start.x, start.y, start.x, start.y}};
+  result.region.Add(goal);
+  result.region.Expand(width, height);
+
+  const std::vector<std::uint8_t>& passable = PassableGrid(width, height);
+  const int columns = _map.Width();
+  const int rows = _map.Height();
+  const std::uint32_t start_cell = static_cast<std::uint32_t>(start.y * columns + start.x);
+  if (!_map.InBounds(start) || !passable[start_cell])
+  {
+    return result;
+  }
+
+  if (++_search == 0)
+  {
+    std::fill(_stamp.begin(), _stamp.end(), 0);
+    _search = 1;
+  }
+
+  // Lowest f first; among equal f the deepest node, which heads straight on
+  auto later = [](const HeapEntry& a, const HeapEntry& b) {
+    return a.f > b.f || (a.f == b.f && a.g < b.g);
+  };
+
+  _stamp[start_cell] = _search;
+  _g[start_cell] = 0;
+  _parent[start_cell] = start_cell;
+  _open.clear();
+  _open.push_back({Heuristic(start, width, height, goal), 0, start_cell});
+
+  Region expanded {start.x, start.y, start.x, start.y};
+
+  while (!_open.empty())
+  {
+    std::pop_heap(_open.begin(), _open.end(), later);
+    const HeapEntry entry = _open.back();
+    _open.pop_back();
+
+    if (entry.g > _g[entry.cell])
+    {
+      continue;
+    }
+
+    const GridPos pos {static_cast<int>(entry.cell % columns), static_cast<int>(entry.cell / columns)};
+    expanded.Add(pos);
+
+    if (entry.f == entry.g)
+    {
+      for (std::uint32_t cell = entry.cell; cell != start_cell; cell = _parent[cell])
+      {
+        result.path.push_back({static_cast<int>(cell % columns), static_cast<int>(cell / columns)});
+      }
+      std::reverse(result.path.begin(), result.path.end());
+      break;
+    }
+
+    for (const Step& step : kSteps)
+    {
+      if (!CanStep(passable, columns, rows, pos, step.dx, step.dy))
+      {
+        continue;
+      }
+
+      const GridPos next {pos.x + step.dx, pos.y + step.dy};
+      const std::uint32_t next_cell = entry.cell + step.dy * columns + step.dx;
+      const int g = entry.g + 1;
+      if (_stamp[next_cell] != _search || g < _g[next_cell])
+      {
+        _stamp[next_cell] = _search;
+        _g[next_cell] = g;
+        _parent[next_cell] = entry.cell;
+        _open.push_back({g + Heuristic(next, width, height, goal), g, next_cell});
+        std::push_heap(_open.begin(), _open.end(), later);
+      }
+    }
+  }
+
+  expanded.Expand(width, height);
+  result.region.Add({expanded.x0, expanded.y0});
+  result.region.Add({expanded.x1, expanded.y1});
+  return result;
+}
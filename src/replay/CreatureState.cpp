@@ -0,0 +1,144 @@
+#include "replay/CreatureState.h"
+
+#include <algorithm>
+
+#include "replay/Varint.h"
+
+std::size_t CreatureState::Size() const
+{
+  return _size;
+}
+
+void CreatureState::Resize(std::size_t count)
+{
+  const std::size_t old_size = _size;
+  _pages.resize((count + kPageSize - 1) / kPageSize);
+  for (auto& page : _pages)
+  {
+    if (!page)
+    {
+      page = std::make_shared<Page>();
+    }
+  }
+  _size = count;
+
+  // A page kept from a smaller size may still hold values past old_size
+  for (std::size_t creature = old_size; creature < count && creature % kPageSize != 0; creature++)
+  {
+    for (int field = 0; field < kNumStateFields; field++)
+    {
+      Set(static_cast<std::uint32_t>(creature), static_cast<StateField>(field), 0);
+    }
+  }
+}
+
+std::size_t CreatureState::Slot(std::uint32_t creature, StateField field)
+{
+  return static_cast<std::size_t>(field) * kPageSize + creature % kPageSize;
+}
+
+int CreatureState::Get(std::uint32_t creature, StateField field) const
+{
+  return _pages[creature / kPageSize]->values[Slot(creature, field)];
+}
+
+void CreatureState::Set(std::uint32_t creature, StateField field, int value)
+{
+  std::shared_ptr<Page>& page = _pages[creature / kPageSize];
+  int& slot = page->values[Slot(creature, field)];
+  if (slot == value)
+  {
+    return;
+  }
+
+  if (page.use_count() > 1)
+  {
+    page = std::make_shared<Page>(*page);
+  }
+  page->values[Slot(creature, field)] = value;
+}
+
+CreatureState CreatureState::Snapshot() const
+{
+  return *this;
+}
+
+std::size_t CreatureState::SharedPages() const
+{
+  return static_cast<std::size_t>(std::count_if(_pages.begin(), _pages.end(),
+                                                [](const auto& page) { return page.use_count() > 1; }));
+}
+
+void CreatureState::Encode(std::vector<std::uint8_t>& out) const
+{
+  PutVarint(out, _size);
+  for (int field = 0; field < kNumStateFields; field++)
+  {
+    int previous = 0;
+    for (std::size_t creature = 0; creature < _size; creature++)
+    {
+      const int value = Get(static_cast<std::uint32_t>(creature), static_cast<StateField>(field));
+      PutVarint(out, ZigZag(static_cast<std::int64_t>(value) - previous));
+      previous = value;
+    }
+  }
+}
+
+bool CreatureState::Decode(std::span<const std::uint8_t> in)
+{
+  const std::uint8_t* it = in.data();
+  const std::uint8_t* end = it + in.size();
+
+  std::uint64_t size = 0;
+  if (!GetVarint(it, end, size) || size > in.size())
+  {
+    return false;
+  }
+
+  _pages.clear();
+  _size = 0;
+  Resize(size);
+
+  for (int field = 0; field < kNumStateFields; field++)
+  {
+    std::int64_t value = 0;
+    for (std::size_t creature = 0; creature < _size; creature++)
+    {
+      std::uint64_t delta = 0;
+      if (!GetVarint(it, end, delta))
+      {
+        return false;
+      }
+      value += UnZigZag(delta);
+      _pages[creature / kPageSize]->values[Slot(static_cast<std::uint32_t>(creature),
+                                                static_cast<StateField>(field))] = static_cast<int>(value);
+    }
+  }
+  return it == end;
+}
+
+bool CreatureState::operator==(const CreatureState& other) const
+{
+  if (_size != other._size)
+  {
+    return false;
+  }
+  for (std::size_t creature = 0; creature < _size; creature++)
+  {
+    const std::size_t page = creature / kPageSize;
+    if (_pages[page] == other._pages[page])
+    {
+      creature += kPageSize - 1 - creature % kPageSize;
+      continue;
+    }
+    for (int field = 0; field < kNumStateFields; field++)
+    {
+      const auto f = static_cast<StateField>(field);
+      if (Get(static_cast<std::uint32_t>(creature), f) != other.Get(static_cast<std::uint32_t>(creature), f))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,598 @@
+#include "replay/ReplayLog.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "replay/Varint.h"
+
+namespace
+{
+
+constexpr char kLogMagic[8] = {'D', 'N', 'D', 'R', 'E', 'P', 'L', 'Y'};
+constexpr char kSnapshotMagic[8] = {'D', 'N', 'D', 'S', 'N', 'A', 'P', 'S'};
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t tickRate;         // Unused in the snapshot file
+};
+
+// Followed by size bytes of CreatureState::Encode
+struct SnapshotHeader
+{
+  std::uint64_t tick;
+  std::uint64_t offset;           // Of the first log record of tick
+  std::uint64_t size;
+};
+
+// Every record starts with a varint whose low two bits are its type:
+//   TICK   ticks << 2                    ticks passed since the last record
+//   DICE   mode << 2, nDice, facesDie, result
+//   KEY    zigzag(key) << 2
+//   STATE  field << 2, creature, zigzag(value)
+constexpr int kTypeBits = 2;
+
+std::string SnapshotPath(const std::string& path)
+{
+  return path + ".snapshots";
+}
+
+const std::uint8_t* MapFile(const std::string& path, std::size_t& size)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return nullptr;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(FileHeader))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    return nullptr;
+  }
+
+  size = static_cast<std::size_t>(info.st_size);
+  return static_cast<const std::uint8_t*>(mapping);
+}
+
+bool ValidHeader(const std::uint8_t* data, const char (&magic)[8])
+{
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  return std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == kVersion;
+}
+
+}
+
+
+ReplayWriter::ReplayWriter(std::uint32_t snapshotInterval)
+  : _snapshot_interval(std::max<std::uint32_t>(snapshotInterval, 1))
+{
+
+}
+
+ReplayWriter::~ReplayWriter()
+{
+  Close();
+}
+
+bool ReplayWriter::Open(const std::string& path, const CreatureState& state, std::uint32_t tickRate)
+{
+  Close();
+
+  _log = std::fopen(path.c_str(), "wb");
+  _snapshots = std::fopen(SnapshotPath(path).c_str(), "wb");
+  if (!_log || !_snapshots)
+  {
+    Close();
+    return false;
+  }
+
+  FileHeader header {};
+  std::memcpy(header.magic, kLogMagic, sizeof(kLogMagic));
+  header.version = kVersion;
+  header.tickRate = tickRate;
+  std::fwrite(&header, sizeof(header), 1, _log);
+
+  std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+  header.tickRate = 0;
+  std::fwrite(&header, sizeof(header), 1, _snapshots);
+
+  _written = sizeof(header);
+  _tick = 0;
+  _unwritten_ticks = 0;
+  _pending.push_back({0, _written, state.Snapshot()});
+  Flush();
+  return true;
+}
+
+void ReplayWriter::Close()
+{
+  if (_hooked)
+  {
+    Die::SetHook({});
+    _hooked = false;
+  }
+
+  if (_log && _snapshots)
+  {
+    // Ends the last tick: the session stops at the start of one that never runs
+    _unwritten_ticks++;
+    PutTicks();
+    Flush();
+  }
+  if (_log)
+  {
+    std::fclose(_log);
+  }
+  if (_snapshots)
+  {
+    std::fclose(_snapshots);
+  }
+  _log = nullptr;
+  _snapshots = nullptr;
+  _buffer.clear();
+  _pending.clear();
+}
+
+void ReplayWriter::RecordDice()
+{
+  Die::SetHook([this](int nDice, int facesDie, Roll mode)
+  {
+    const int result = Die::RollUnhooked(nDice, facesDie, mode);
+    Dice(nDice, facesDie, mode, result);
+    return result;
+  });
+  _hooked = true;
+}
+
+void ReplayWriter::Dice(int nDice, int facesDie, Roll mode, int result)
+{
+  PutTicks();
+  PutVarint(_buffer, static_cast<std::uint64_t>(mode) << kTypeBits | static_cast<int>(ReplayEventType::DICE));
+  PutVarint(_buffer, static_cast<std::uint64_t>(nDice));
+  PutVarint(_buffer, static_cast<std::uint64_t>(facesDie));
+  PutVarint(_buffer, static_cast<std::uint64_t>(result));
+  MaybeFlush();
+}
+
+void ReplayWriter::Key(int key)
+{
+  PutTicks();
+  PutVarint(_buffer, ZigZag(key) << kTypeBits | static_cast<int>(ReplayEventType::KEY));
+  MaybeFlush();
+}
+
+void ReplayWriter::Set(CreatureState& state, std::uint32_t creature, StateField field, int value)
+{
+  if (state.Get(creature, field) == value)
+  {
+    return;
+  }
+  state.Set(creature, field, value);
+
+  PutTicks();
+  PutVarint(_buffer, static_cast<std::uint64_t>(field) << kTypeBits | static_cast<int>(ReplayEventType::STATE));
+  PutVarint(_buffer, creature);
+  PutVarint(_buffer, ZigZag(value));
+  MaybeFlush();
+}
+
+void ReplayWriter::Tick(const CreatureState& state)
+{
+  _tick++;
+  _unwritten_ticks++;
+
+  if (_tick % _snapshot_interval == 0)
+  {
+    PutTicks();
+    _pending.push_back({_tick, _written + _buffer.size(), state.Snapshot()});
+    MaybeFlush();
+  }
+}
+
+void ReplayWriter::Flush()
+{
+  if (!_log || !_snapshots)
+  {
+    return;
+  }
+
+  std::fwrite(_buffer.data(), 1, _buffer.size(), _log);
+  _written += _buffer.size();
+  _buffer.clear();
+  std::fflush(_log);
+
+  // Snapshots only after the log they point into
+  std::vector<std::uint8_t> payload;
+  for (const PendingSnapshot& snapshot : _pending)
+  {
+    payload.clear();
+    snapshot.state.Encode(payload);
+
+    const SnapshotHeader header {snapshot.tick, snapshot.offset, payload.size()};
+    std::fwrite(&header, sizeof(header), 1, _snapshots);
+    std::fwrite(payload.data(), 1, payload.size(), _snapshots);
+  }
+  _pending.clear();
+  std::fflush(_snapshots);
+}
+
+std::uint64_t ReplayWriter::CurrentTick() const
+{
+  return _tick;
+}
+
+std::uint64_t ReplayWriter::BytesWritten() const
+{
+  return _written + _buffer.size();
+}
+
+void ReplayWriter::PutTicks()
+{
+  if (_unwritten_ticks > 0)
+  {
+    PutVarint(_buffer, _unwritten_ticks << kTypeBits | static_cast<int>(ReplayEventType::TICK));
+    _unwritten_ticks = 0;
+  }
+}
+
+void ReplayWriter::MaybeFlush()
+{
+  // Pending snapshots hold on to the pages the game has changed since
+  if (_buffer.size() >= kFlushBytes || _pending.size() >= 4)
+  {
+    Flush();
+  }
+}
+
+
+ReplayReader::~ReplayReader()
+{
+  Close();
+}
+
+bool ReplayReader::Open(const std::string& path)
+{
+  Close();
+
+  _log = MapFile(path, _log_size);
+  _snapshot_data = MapFile(SnapshotPath(path), _snapshot_size);
+  if (!_log || !_snapshot_data || !ValidHeader(_log, kLogMagic) || !ValidHeader(_snapshot_data, kSnapshotMagic))
+  {
+    Close();
+    return false;
+  }
+
+  FileHeader header;
+  std::memcpy(&header, _log, sizeof(header));
+  _tick_rate = header.tickRate;
+
+  // A session cut short may end in a partly written snapshot; keep the whole ones
+  std::size_t at = sizeof(FileHeader);
+  while (at + sizeof(SnapshotHeader) <= _snapshot_size)
+  {
+    SnapshotHeader entry;
+    std::memcpy(&entry, _snapshot_data + at, sizeof(entry));
+    at += sizeof(entry);
+    if (entry.size > _snapshot_size - at || entry.offset < sizeof(FileHeader) || entry.offset > _log_size ||
+        (!_snapshots.empty() && entry.tick <= _snapshots.back().tick))
+    {
+      break;
+    }
+    _snapshots.push_back({entry.tick, entry.offset, _snapshot_data + at, static_cast<std::size_t>(entry.size)});
+    at += entry.size;
+  }
+  if (_snapshots.empty() || _snapshots.front().tick != 0)
+  {
+    Close();
+    return false;
+  }
+
+  // The session's length is past the last snapshot, at most one interval away
+  _cursor = _log + _snapshots.back().offset;
+  _tick = _snapshots.back().tick;
+  ReplayEvent event;
+  while (Next(event))
+  {
+
+  }
+  _last_tick = _tick;
+
+  _cursor = _log + _snapshots.front().offset;
+  _tick = 0;
+  _owed_ticks = 0;
+  return true;
+}
+
+void ReplayReader::Close()
+{
+  if (_log)
+  {
+    munmap(const_cast<std::uint8_t*>(_log), _log_size);
+  }
+  if (_snapshot_data)
+  {
+    munmap(const_cast<std::uint8_t*>(_snapshot_data), _snapshot_size);
+  }
+  _log = nullptr;
+  _log_size = 0;
+  _snapshot_data = nullptr;
+  _snapshot_size = 0;
+  _snapshots.clear();
+  _last_tick = 0;
+  _cursor = nullptr;
+  _tick = 0;
+  _owed_ticks = 0;
+}
+
+std::uint32_t ReplayReader::TickRate() const
+{
+  return _tick_rate;
+}
+
+std::uint64_t ReplayReader::LastTick() const
+{
+  return _last_tick;
+}
+
+std::size_t ReplayReader::NumSnapshots() const
+{
+  return _snapshots.size();
+}
+
+std::uint64_t ReplayReader::SnapshotTick(std::size_t index) const
+{
+  return _snapshots[index].tick;
+}
+
+bool ReplayReader::Seek(std::uint64_t tick, CreatureState& state)
+{
+  if (_snapshots.empty())
+  {
+    return false;
+  }
+
+  auto after = std::upper_bound(_snapshots.begin(), _snapshots.end(), tick,
+                                [](std::uint64_t value, const SnapshotEntry& entry) { return value < entry.tick; });
+  return SeekFrom(*(after - 1), tick, state);
+}
+
+bool ReplayReader::SeekFromStart(std::uint64_t tick, CreatureState& state)
+{
+  return !_snapshots.empty() && SeekFrom(_snapshots.front(), tick, state);
+}
+
+bool ReplayReader::SeekFrom(const SnapshotEntry& snapshot, std::uint64_t tick, CreatureState& state)
+{
+  if (!state.Decode({snapshot.data, snapshot.size}))
+  {
+    return false;
+  }
+
+  _cursor = _log + snapshot.offset;
+  _tick = snapshot.tick;
+  _owed_ticks = 0;
+
+  ReplayEvent event;
+  while (_tick < tick && Next(event, tick))
+  {
+    if (event.type == ReplayEventType::STATE && event.creature < state.Size())
+    {
+      state.Set(event.creature, event.field, event.value);
+    }
+  }
+  return _tick == tick;
+}
+
+bool ReplayReader::Next(ReplayEvent& event, std::uint64_t maxTick)
+{
+  if (_owed_ticks == 0)
+  {
+    if (!Decode(_cursor, event))
+    {
+      return false;
+    }
+    if (event.type != ReplayEventType::TICK)
+    {
+      return true;
+    }
+    _owed_ticks = event.tick - _tick;
+  }
+
+  const std::uint64_t ticks = std::min(_owed_ticks, std::max(maxTick, _tick + 1) - _tick);
+  _tick += ticks;
+  _owed_ticks -= ticks;
+
+  event = {};
+  event.type = ReplayEventType::TICK;
+  event.tick = _tick;
+  return true;
+}
+
+bool ReplayReader::Peek(ReplayEvent& event) const
+{
+  if (_owed_ticks > 0)
+  {
+    event = {};
+    event.type = ReplayEventType::TICK;
+    event.tick = _tick + _owed_ticks;
+    return true;
+  }
+
+  const std::uint8_t* it = _cursor;
+  return Decode(it, event);
+}
+
+std::uint64_t ReplayReader::CurrentTick() const
+{
+  return _tick;
+}
+
+bool ReplayReader::Decode(const std::uint8_t*& it, ReplayEvent& event) const
+{
+  const std::uint8_t* end = _log + _log_size;
+  const std::uint8_t* at = it;
+
+  std::uint64_t tag = 0;
+  if (!at || !GetVarint(at, end, tag))
+  {
+    return false;
+  }
+
+  event = {};
+  event.type = static_cast<ReplayEventType>(tag & ((1 << kTypeBits) - 1));
+  event.tick = _tick + _owed_ticks;
+  const std::uint64_t payload = tag >> kTypeBits;
+
+  switch (event.type)
+  {
+    case ReplayEventType::TICK:
+      event.tick += payload;
+      break;
+
+    case ReplayEventType::DICE:
+    {
+      std::uint64_t nDice = 0;
+      std::uint64_t facesDie = 0;
+      std::uint64_t result = 0;
+      if (!GetVarint(at, end, nDice) || !GetVarint(at, end, facesDie) || !GetVarint(at, end, result))
+      {
+        return false;
+      }
+      event.mode = static_cast<Roll>(payload);
+      event.nDice = static_cast<int>(nDice);
+      event.facesDie = static_cast<int>(facesDie);
+      event.value = static_cast<int>(result);
+      break;
+    }
+
+    case ReplayEventType::KEY:
+      event.value = static_cast<int>(UnZigZag(payload));
+      break;
+
+    case ReplayEventType::STATE:
+    {
+      std::uint64_t creature = 0;
+      std::uint64_t value = 0;
+      if (payload >= kNumStateFields || !GetVarint(at, end, creature) || !GetVarint(at, end, value))
+      {
+        return false;
+      }
+      event.field = static_cast<StateField>(payload);
+      event.creature = static_cast<std::uint32_t>(creature);
+      event.value = static_cast<int>(UnZigZag(value));
+      break;
+    }
+  }
+
+  it = at;
+  return true;
+}
+
+
+ReplaySession::ReplaySession(ReplayReader& reader, CreatureState& state)
+  : _reader(&reader), _state(&state)
+{
+  Die::SetHook([this](int nDice, int facesDie, Roll mode) { return AnswerRoll(nDice, facesDie, mode); });
+}
+
+ReplaySession::~ReplaySession()
+{
+  Die::SetHook({});
+}
+
+std::uint64_t ReplaySession::Run(std::uint64_t untilTick, const OnKey& onKey, const OnTick& onTick)
+{
+  // A Seek or the last Run stopped at the start of a tick that has not run
+  if (onTick && _reader->CurrentTick() != _ticked && _reader->CurrentTick() < untilTick)
+  {
+    _ticked = _reader->CurrentTick();
+    onTick(_ticked);
+  }
+
+  ReplayEvent event;
+  while (_reader->CurrentTick() < untilTick)
+  {
+    // Tick by tick when there is tick code to run, otherwise whole runs
+    const std::uint64_t step = onTick ? std::min(untilTick, _reader->CurrentTick() + 1) : untilTick;
+    if (!_reader->Next(event, step))
+    {
+      break;
+    }
+
+    switch (event.type)
+    {
+      case ReplayEventType::TICK:
+        if (onTick && event.tick < untilTick)
+        {
+          _ticked = event.tick;
+          onTick(event.tick);
+        }
+        break;
+
+      case ReplayEventType::KEY:
+        if (onKey)
+        {
+          onKey(event.value);
+        }
+        break;
+
+      case ReplayEventType::STATE:
+        if (event.creature < _state->Size())
+        {
+          _state->Set(event.creature, event.field, event.value);
+        }
+        break;
+
+      case ReplayEventType::DICE:
+        // Rolled by code that is not being replayed
+        break;
+    }
+  }
+  return _reader->CurrentTick();
+}
+
+std::size_t ReplaySession::Desyncs() const
+{
+  return _desyncs;
+}
+
+int ReplaySession::AnswerRoll(int nDice, int facesDie, Roll mode)
+{
+  // The recorded changes the code made before this roll are applied on the way
+  ReplayEvent event;
+  while (_reader->Peek(event) && event.type == ReplayEventType::STATE)
+  {
+    _reader->Next(event);
+    if (event.creature < _state->Size())
+    {
+      _state->Set(event.creature, event.field, event.value);
+    }
+  }
+
+  if (event.type == ReplayEventType::DICE && event.nDice == nDice &&
+      event.facesDie == facesDie && event.mode == mode)
+  {
+    _reader->Next(event);
+    return event.value;
+  }
+
+  _desyncs++;
+  return Die::RollUnhooked(nDice, facesDie, mode);
+}
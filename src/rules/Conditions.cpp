@@ -0,0 +1,42 @@
+#include "rules/Conditions.h"
+
+
+Roll CombineModes(bool advantage, bool disadvantage)
+{
+  if (advantage == disadvantage)
+  {
+    return Roll::STRIGHT;
+  }
+  return advantage ? Roll::ADVANTAGE : Roll::DISADVANTAGE;
+}
+
+Roll AttackRollMode(ConditionSet attacker, ConditionSet target, bool melee, const RollRules& rules)
+{
+  const bool advantage = attacker.Has(rules.attackerAdvantage) ||
+                         target.Has(rules.targetAdvantage) ||
+                         (melee && target.Has(rules.targetAdvantageInMelee));
+  const bool disadvantage = attacker.Has(rules.attackerDisadvantage) ||
+                            target.Has(rules.targetDisadvantage) ||
+                            (!melee && target.Has(rules.targetDisadvantageAtRange));
+  return CombineModes(advantage, disadvantage);
+}
+
+Roll AbilityCheckMode(ConditionSet creature, const RollRules& rules)
+{
+  return CombineModes(false, creature.Has(rules.checkDisadvantage));
+}
+
+Roll SavingThrowMode(ConditionSet creature, Stats stat, const RollRules& rules)
+{
+  return CombineModes(false, stat == Stats::DEX && creature.Has(rules.dexSaveDisadvantage));
+}
+
+bool FailsSavingThrow(ConditionSet creature, Stats stat, const RollRules& rules)
+{
+  return (stat == Stats::STR || stat == Stats::DEX) && creature.Has(rules.failsStrDexSaves);
+}
+
+bool IsIncapacitated(ConditionSet creature, const RollRules& rules)
+{
+  return creature.Has(rules.incapacitating);
+}
@@ -0,0 +1,399 @@
+#include "rules/DiceDistribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <mutex>
+#include <numbers>
+#include <unordered_map>
+
+namespace
+{
+
+// Below this many multiply-adds a schoolbook convolution beats the FFT.
+constexpr std::size_t kFftThreshold = 1 << 15;
+
+// Exploding dice are expanded until the remaining probability is negligible.
+constexpr double kExplodeEpsilon = 1e-12;
+constexpr int kMaxExplosions = 64;
+
+void Fft(std::vector<std::complex<double>>& a, bool invert)
+{
+  const std::size_t n = a.size();
+
+  for (std::size_t i = 1, j = 0; i < n; i++)
+  {
+    std::size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+    {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j)
+    {
+      std::swap(a[i], a[j]);
+    }
+  }
+
+  for (std::size_t len = 2; len <= n; len <<= 1)
+  {
+    const double angle = 2 * std::numbers::pi / len * (invert ? -1 : 1);
+    const std::complex<double> wlen(std::cos(angle), std::sin(angle));
+
+    for (std::size_t i = 0; i < n; i += len)
+    {
+      std::complex<double> w(1);
+      for (std::size_t j = 0; j < len / 2; j++)
+      {
+        const std::complex<double> u = a[i + j];
+        const std::complex<double> v = a[i + j + len / 2] * w;
+        a[i + j] = u + v;
+        a[i + j + len / 2] = u - v;
+        w *= wlen;
+      }
+    }
+  }
+
+  if (invert)
+  {
+    for (std::complex<double>& x : a)
+    {
+      x /= static_cast<double>(n);
+    }
+  }
+}
+
+std::vector<double> Convolve(const std::vector<double>& a, const std::vector<double>& b)
+{
+  std::vector<double> result(a.size() + b.size() - 1, 0.0);
+
+  if (a.size() * b.size() < kFftThreshold)
+  {
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+      for (std::size_t j = 0; j < b.size(); j++)
+      {
+        result[i + j] += a[i] * b[j];
+      }
+    }
+    return result;
+  }
+
+  std::size_t n = 1;
+  while (n < result.size())
+  {
+    n <<= 1;
+  }
+
+  std::vector<std::complex<double>> fa(a.begin(), a.end());
+  std::vector<std::complex<double>> fb(b.begin(), b.end());
+  fa.resize(n);
+  fb.resize(n);
+
+  Fft(fa, false);
+  Fft(fb, false);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    fa[i] *= fb[i];
+  }
+  Fft(fa, true);
+
+  // Round-off leaves tiny negative values where the exact answer is zero.
+  for (std::size_t i = 0; i < result.size(); i++)
+  {
+    result[i] = std::max(0.0, fa[i].real());
+  }
+  return result;
+}
+
+// PMF of one die of the spec, indexed by face value - 1.
+std::vector<double> SingleDiePmf(const DiceSpec& spec)
+{
+  const int faces = spec.facesDie;
+  std::vector<double> die(faces, 1.0 / faces);
+
+  if (spec.rerollBelow > 0)
+  {
+    const int rerolled = std::min(spec.rerollBelow, faces);
+    for (int value = 1; value <= faces; value++)
+    {
+      die[value - 1] = (value > rerolled ? 1.0 / faces : 0.0) +
+                       (static_cast<double>(rerolled) / faces) / faces;
+    }
+  }
+
+  if (!spec.explode || faces < 2)
+  {
+    return die;
+  }
+
+  std::vector<double> exploded;
+  double mass = 1.0;
+  int offset = 0;
+
+  for (int depth = 0; depth < kMaxExplosions && mass > kExplodeEpsilon; depth++)
+  {
+    exploded.resize(offset + faces, 0.0);
+    for (int value = 1; value < faces; value++)
+    {
+      exploded[offset + value - 1] += mass * die[value - 1];
+    }
+    mass *= die[faces - 1];
+    offset += faces;
+  }
+  // Whatever is left kept rolling the highest face; stop it there.
+  exploded[offset - 1] += mass;
+
+  return exploded;
+}
+
+// Sum of nDice independent dice with the given PMF (values starting at 1),
+// by exponentiation by squaring. The result starts at value nDice.
+std::vector<double> SumOfDice(const std::vector<double>& die, int nDice)
+{
+  std::vector<double> result {1.0};
+  std::vector<double> power = die;
+
+  for (int n = nDice; n > 0; n >>= 1)
+  {
+    if (n & 1)
+    {
+      result = Convolve(result, power);
+    }
+    if (n > 1)
+    {
+      power = Convolve(power, power);
+    }
+  }
+  return result;
+}
+
+// Sum of the `keep` highest (or lowest) of nDice dice. Faces are visited from
+// the best one for the keeper down; the first `keep` dice assigned are the
+// kept ones, so only (dice assigned, kept sum) has to be tracked. The result
+// is indexed by kept sum starting at 0.
+std::vector<double> KeepDice(const std::vector<double>& die, int nDice, int keep, bool highest)
+{
+  const int values = static_cast<int>(die.size());
+  const int max_sum = keep * values;
+
+  std::vector<std::vector<double>> binom(nDice + 1, std::vector<double>(nDice + 1, 0.0));
+  for (int n = 0; n <= nDice; n++)
+  {
+    binom[n][0] = 1.0;
+    for (int k = 1; k <= n; k++)
+    {
+      binom[n][k] = binom[n - 1][k - 1] + (k <= n - 1 ? binom[n - 1][k] : 0.0);
+    }
+  }
+
+  std::vector<std::vector<double>> dp(nDice + 1, std::vector<double>(max_sum + 1, 0.0));
+  std::vector<std::vector<double>> next = dp;
+  std::vector<double> powers(nDice + 1);
+  dp[0][0] = 1.0;
+
+  for (int step = 0; step < values; step++)
+  {
+    const int value = highest ? values - step : step + 1;
+    const double p = die[value - 1];
+
+    powers[0] = 1.0;
+    for (int c = 1; c <= nDice; c++)
+    {
+      powers[c] = powers[c - 1] * p;
+    }
+
+    for (std::vector<double>& row : next)
+    {
+      std::fill(row.begin(), row.end(), 0.0);
+    }
+
+    for (int assigned = 0; assigned <= nDice; assigned++)
+    {
+      for (int sum = 0; sum <= max_sum; sum++)
+      {
+        const double weight = dp[assigned][sum];
+        if (weight == 0.0)
+        {
+          continue;
+        }
+
+        const int remaining = nDice - assigned;
+        const int upper = (p == 0.0) ? 0 : remaining;
+        for (int c = 0; c <= upper; c++)
+        {
+          const int kept = std::min(assigned + c, keep) - std::min(assigned, keep);
+          next[assigned + c][sum + kept * value] += weight * binom[remaining][c] * powers[c];
+        }
+      }
+    }
+    std::swap(dp, next);
+  }
+
+  return dp[nDice];
+}
+
+}
+
+
+DiceDistribution::DiceDistribution()
+{
+
+}
+
+DiceDistribution::DiceDistribution(int min, std::vector<double> pmf)
+{
+  // Drop impossible values at both ends so Min() and Max() are exact.
+  std::size_t first = 0;
+  while (first + 1 < pmf.size() && pmf[first] == 0.0)
+  {
+    first++;
+  }
+  std::size_t last = pmf.size();
+  while (last > first + 1 && pmf[last - 1] == 0.0)
+  {
+    last--;
+  }
+
+  _min = min + static_cast<int>(first);
+  _pmf.assign(pmf.begin() + first, pmf.begin() + last);
+  if (_pmf.empty())
+  {
+    _pmf.push_back(1.0);
+  }
+
+  _cdf.resize(_pmf.size());
+  double running = 0.0;
+  for (std::size_t i = 0; i < _pmf.size(); i++)
+  {
+    running += _pmf[i];
+    _cdf[i] = running;
+  }
+}
+
+DiceDistribution DiceDistribution::Constant(int value)
+{
+  return DiceDistribution(value, {1.0});
+}
+
+DiceDistribution DiceDistribution::Uniform(int facesDie)
+{
+  return DiceDistribution(1, std::vector<double>(facesDie, 1.0 / facesDie));
+}
+
+const DiceDistribution& DiceDistribution::Of(const DiceSpec& spec)
+{
+  static std::mutex cache_mutex;
+  static std::unordered_map<DiceSpec, DiceDistribution, DiceSpecHash> cache;
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(spec);
+    if (it != cache.end())
+    {
+      return it->second;
+    }
+  }
+
+  DiceDistribution computed = Compute(spec);
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return cache.try_emplace(spec, std::move(computed)).first->second;
+}
+
+const DiceDistribution& DiceDistribution::D20(Roll mode)
+{
+  switch (mode)
+  {
+    case Roll::ADVANTAGE:
+      return Of({.nDice = 2, .facesDie = 20, .keep = 1, .keepHighest = true});
+
+    case Roll::DISADVANTAGE:
+      return Of({.nDice = 2, .facesDie = 20, .keep = 1, .keepHighest = false});
+
+    default:
+      return Of({.nDice = 1, .facesDie = 20});
+  }
+}
+
+DiceDistribution DiceDistribution::Compute(const DiceSpec& spec)
+{
+  if (spec.nDice <= 0 || spec.facesDie <= 0)
+  {
+    return Constant(spec.modifier);
+  }
+
+  const std::vector<double> die = SingleDiePmf(spec);
+
+  if (spec.keep > 0 && spec.keep < spec.nDice)
+  {
+    return DiceDistribution(spec.modifier,
+                            KeepDice(die, spec.nDice, spec.keep, spec.keepHighest));
+  }
+
+  return DiceDistribution(spec.nDice + spec.modifier, SumOfDice(die, spec.nDice));
+}
+
+DiceDistribution DiceDistribution::operator+(const DiceDistribution& other) const
+{
+  return DiceDistribution(_min + other._min, Convolve(_pmf, other._pmf));
+}
+
+DiceDistribution DiceDistribution::operator+(int modifier) const
+{
+  DiceDistribution shifted = *this;
+  shifted._min += modifier;
+  return shifted;
+}
+
+DiceDistribution DiceDistribution::operator-() const
+{
+  return DiceDistribution(-Max(), std::vector<double>(_pmf.rbegin(), _pmf.rend()));
+}
+
+double DiceDistribution::Pmf(int value) const
+{
+  if (value < _min || value > Max())
+  {
+    return 0.0;
+  }
+  return _pmf[value - _min];
+}
+
+double DiceDistribution::Cdf(int value) const
+{
+  if (value < _min)
+  {
+    return 0.0;
+  }
+  if (value >= Max())
+  {
+    return 1.0;
+  }
+  return _cdf[value - _min];
+}
+
+double DiceDistribution::AtLeast(int value) const
+{
+  return 1.0 - Cdf(value - 1);
+}
+
+double DiceDistribution::Mean() const
+{
+  double mean = 0.0;
+  for (std::size_t i = 0; i < _pmf.size(); i++)
+  {
+    mean += _pmf[i] * (_min + static_cast<int>(i));
+  }
+  return mean;
+}
+
+int DiceDistribution::Min() const
+{
+  return _min;
+}
+
+int DiceDistribution::Max() const
+{
+  return _min + static_cast<int>(_pmf.size()) - 1;
+}
@@ -0,0 +1,283 @@
+#include "rules/DiceEngine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "utils/Profiler.h"
+
+namespace
+{
+
+std::uint64_t SplitMix64(std::uint64_t& x)
+{
+  std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Same cap as DiceDistribution, so sampled and exact results agree.
+constexpr int kMaxExplosions = 64;
+
+constexpr std::uint64_t Rotl(std::uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+}
+
+
+DiceEngine::DiceEngine(std::uint64_t seed)
+{
+  Seed(seed);
+}
+
+DiceEngine::DiceEngine(std::uint64_t seed, std::uint64_t stream)
+{
+  Seed(seed, stream);
+}
+
+void DiceEngine::Seed(std::uint64_t seed, std::uint64_t stream)
+{
+  std::uint64_t mix = seed ^ SplitMix64(stream);
+
+  for (std::size_t lane = 0; lane < kLanes; lane++)
+  {
+    for (int word = 0; word < 4; word++)
+    {
+      _state[word][lane] = SplitMix64(mix);
+    }
+  }
+}
+
+std::uint64_t DiceEngine::Next()
+{
+  // Scalar draws advance lane 0 only.
+  std::uint64_t* s0 = &_state[0][0];
+  std::uint64_t* s1 = &_state[1][0];
+  std::uint64_t* s2 = &_state[2][0];
+  std::uint64_t* s3 = &_state[3][0];
+
+  const std::uint64_t result = Rotl(*s1 * 5, 7) * 9;
+  const std::uint64_t t = *s1 << 17;
+
+  *s2 ^= *s0;
+  *s3 ^= *s1;
+  *s1 ^= *s2;
+  *s0 ^= *s3;
+  *s2 ^= t;
+  *s3 = Rotl(*s3, 45);
+
+  return result;
+}
+
+void DiceEngine::FillWords(std::uint32_t* words, std::size_t count)
+{
+  // Short requests (a single attack roll, a handful of damage dice) would
+  // throw most of a full lane step away, so they come from lane 0 alone.
+  if (count < 2 * kLanes)
+  {
+    for (std::size_t i = 0; i < count; i += 2)
+    {
+      const std::uint64_t value = Next();
+      words[i] = static_cast<std::uint32_t>(value);
+      if (i + 1 < count)
+      {
+        words[i + 1] = static_cast<std::uint32_t>(value >> 32);
+      }
+    }
+    return;
+  }
+
+  std::uint64_t (&s)[4][kLanes] = _state;
+
+  // Each step of the lanes yields kLanes 64 bit values, i.e. 2 * kLanes words.
+  for (std::size_t offset = 0; offset < count; offset += 2 * kLanes)
+  {
+    std::uint64_t results[kLanes];
+
+    for (std::size_t lane = 0; lane < kLanes; lane++)
+    {
+      results[lane] = Rotl(s[1][lane] * 5, 7) * 9;
+      const std::uint64_t t = s[1][lane] << 17;
+
+      s[2][lane] ^= s[0][lane];
+      s[3][lane] ^= s[1][lane];
+      s[1][lane] ^= s[2][lane];
+      s[0][lane] ^= s[3][lane];
+      s[2][lane] ^= t;
+      s[3][lane] = Rotl(s[3][lane], 45);
+    }
+
+    const std::size_t n = std::min(2 * kLanes, count - offset);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      words[offset + i] = static_cast<std::uint32_t>(results[i / 2] >> (32 * (i & 1)));
+    }
+  }
+}
+
+void DiceEngine::RollMany(int nDice, int facesDie, std::span<int> out)
+{
+  PROFILE_ZONE("DiceEngine::RollMany");
+
+  if (nDice <= 0 || facesDie <= 0)
+  {
+    return;
+  }
+
+  // Lemire's multiply-shift reduction: the high half of word * faces is the
+  // roll, and the low half tells whether the word fell in the small biased
+  // region that has to be redrawn. The threshold only depends on the die, so
+  // the main loop is branch free and the redraw pass almost never runs.
+  const std::uint32_t faces = static_cast<std::uint32_t>(facesDie);
+  const std::uint32_t threshold = (0u - faces) % faces;
+  const std::size_t count = std::min(static_cast<std::size_t>(nDice), out.size());
+
+  std::uint32_t words[kBlockSize];
+
+  for (std::size_t start = 0; start < count; start += kBlockSize)
+  {
+    const std::size_t len = std::min(kBlockSize, count - start);
+    int* dst = out.data() + start;
+
+    FillWords(words, len);
+
+    std::uint32_t rejected = 0;
+    for (std::size_t i = 0; i < len; i++)
+    {
+      const std::uint64_t m = static_cast<std::uint64_t>(words[i]) * faces;
+      dst[i] = static_cast<int>(m >> 32) + 1;
+      rejected |= static_cast<std::uint32_t>(static_cast<std::uint32_t>(m) < threshold);
+    }
+
+    if (rejected)
+    {
+      for (std::size_t i = 0; i < len; i++)
+      {
+        std::uint64_t m = static_cast<std::uint64_t>(words[i]) * faces;
+        while (static_cast<std::uint32_t>(m) < threshold)
+        {
+          m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(Next() >> 32)) * faces;
+        }
+        dst[i] = static_cast<int>(m >> 32) + 1;
+      }
+    }
+  }
+}
+
+int DiceEngine::RollSum(int nDice, int facesDie)
+{
+  if (facesDie <= 0)
+  {
+    return 0;
+  }
+
+  int rolls[kBlockSize];
+  int sum = 0;
+
+  while (nDice > 0)
+  {
+    const int len = std::min(nDice, static_cast<int>(kBlockSize));
+    RollMany(len, facesDie, rolls);
+
+    for (int i = 0; i < len; i++)
+    {
+      sum += rolls[i];
+    }
+    nDice -= len;
+  }
+
+  return sum;
+}
+
+int DiceEngine::Roll(const DiceSpec& spec)
+{
+  if (spec.nDice <= 0 || spec.facesDie <= 0)
+  {
+    return spec.modifier;
+  }
+  if (spec.IsPlainSum())
+  {
+    return RollSum(spec.nDice, spec.facesDie) + spec.modifier;
+  }
+
+  int local[kBlockSize];
+  std::vector<int> heap;
+  std::span<int> rolls(local, kBlockSize);
+  if (static_cast<std::size_t>(spec.nDice) > kBlockSize)
+  {
+    heap.resize(spec.nDice);
+    rolls = heap;
+  }
+  rolls = rolls.first(spec.nDice);
+
+  RollMany(spec.nDice, spec.facesDie, rolls);
+
+  if (spec.rerollBelow > 0)
+  {
+    for (int& roll : rolls)
+    {
+      if (roll <= spec.rerollBelow)
+      {
+        roll = RollOne(spec.facesDie);
+      }
+    }
+  }
+
+  if (spec.explode && spec.facesDie > 1)
+  {
+    for (int& roll : rolls)
+    {
+      int last = roll;
+      for (int depth = 0; last == spec.facesDie && depth < kMaxExplosions; depth++)
+      {
+        last = RollOne(spec.facesDie);
+        if (last <= spec.rerollBelow)
+        {
+          last = RollOne(spec.facesDie);
+        }
+        roll += last;
+      }
+    }
+  }
+
+  if (spec.keep > 0 && spec.keep < spec.nDice)
+  {
+    if (spec.keepHighest)
+    {
+      std::nth_element(rolls.begin(), rolls.begin() + spec.keep, rolls.end(), std::greater<int>());
+    }
+    else
+    {
+      std::nth_element(rolls.begin(), rolls.begin() + spec.keep, rolls.end());
+    }
+    rolls = rolls.first(spec.keep);
+  }
+
+  int sum = spec.modifier;
+  for (int roll : rolls)
+  {
+    sum += roll;
+  }
+  return sum;
+}
+
+int DiceEngine::RollOne(int facesDie)
+{
+  int roll = 0;
+  RollMany(1, facesDie, std::span<int>(&roll, 1));
+  return roll;
+}
+
+DiceEngine& DiceEngine::ThreadLocal()
+{
+  static std::atomic<std::uint64_t> thread_counter {0};
+
+  thread_local DiceEngine engine(std::random_device{}(),
+                                 thread_counter.fetch_add(1, std::memory_order_relaxed));
+  return engine;
+}
@@ -0,0 +1,100 @@
+#include "rules/DiceExpression.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+const DiceExpression& DiceExpression::Intern(std::string_view text)
+{
+  // The shared table owns the strings and expressions; node based maps keep
+  // both at a fixed address, so each thread can cache plain pointers to them
+  // and only takes the lock the first time it sees a string.
+  static std::mutex intern_mutex;
+  static std::unordered_map<std::string, DiceExpression> interned;
+  thread_local std::unordered_map<std::string_view, const DiceExpression*> local;
+
+  auto hit = local.find(text);
+  if (hit != local.end())
+  {
+    return *hit->second;
+  }
+
+  std::lock_guard<std::mutex> lock(intern_mutex);
+  auto it = interned.find(std::string(text));
+  if (it == interned.end())
+  {
+    it = interned.emplace(std::string(text), Parse(text)).first;
+  }
+  local.emplace(it->first, &it->second);
+  return it->second;
+}
+
+int DiceExpression::Roll(DiceEngine& engine) const
+{
+  int total = modifier;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const int value = engine.Roll(terms[i].spec);
+    total += terms[i].negative ? -value : value;
+  }
+  return total;
+}
+
+int DiceExpression::Roll() const
+{
+  return Roll(DiceEngine::ThreadLocal());
+}
+
+double DiceExpression::Mean() const
+{
+  // Per thread, so rating a bestiary on every core never takes the lock of
+  // the shared distribution cache twice for the same term
+  thread_local std::unordered_map<DiceSpec, double, DiceSpecHash> term_means;
+
+  double mean = modifier;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const DiceSpec& spec = terms[i].spec;
+    double term;
+    if (spec.IsPlainSum())
+    {
+      term = spec.nDice * (spec.facesDie + 1) / 2.0 + spec.modifier;
+    }
+    else
+    {
+      auto [it, added] = term_means.try_emplace(spec, 0.0);
+      if (added)
+      {
+        it->second = DiceDistribution::Of(spec).Mean();
+      }
+      term = it->second;
+    }
+    mean += terms[i].negative ? -term : term;
+  }
+  return mean;
+}
+
+const DiceDistribution& DiceExpression::Distribution() const
+{
+  static std::mutex cache_mutex;
+  static std::unordered_map<DiceExpression, DiceDistribution, DiceExpressionHash> cache;
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(*this);
+    if (it != cache.end())
+    {
+      return it->second;
+    }
+  }
+
+  DiceDistribution result = DiceDistribution::Constant(modifier);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const DiceDistribution& term = DiceDistribution::Of(terms[i].spec);
+    result = terms[i].negative ? result + -term : result + term;
+  }
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return cache.try_emplace(*this, std::move(result)).first->second;
+}
@@ -1,37 +1,60 @@
 #include "rules/Roll.h"
+#include "rules/DiceEngine.h"
+#include "utils/Profiler.h"
 
-#include <random>
+#include <algorithm>
+#include <utility>
 
-int Die::Roll(int nDice, int facesDie)
+namespace
 {
-  int sum = 0;
-  static std::random_device seed;
 
-  static std::mt19937 gen(seed());
+thread_local Die::Hook tHook;
+
+}
 
-  static std::uniform_int_distribution<int>distrib(1, facesDie);
+int Die::Roll(int nDice, int facesDie)
+{
+  PROFILE_ZONE("Die::Roll");
 
-  for (int num_die = 0;  num_die < nDice; num_die++)
+  if (tHook)
   {
-    sum += distrib(gen);
+    return tHook(nDice, facesDie, ::Roll::STRIGHT);
   }
-
-  return sum;
-  
+  return DiceEngine::ThreadLocal().RollSum(nDice, facesDie);
 }
 
 int Die::RollAdvantage()
 {
-  int roll_1 = Roll(1, 20);
-  int roll_2 = Roll(1, 20);
-
-  return std::max(roll_1, roll_2);
+  if (tHook)
+  {
+    return tHook(1, 20, ::Roll::ADVANTAGE);
+  }
+  return RollUnhooked(1, 20, ::Roll::ADVANTAGE);
 }
 
 int Die::RollDisadvantage()
 {
-  int roll_1 = Roll(1, 20);
-  int roll_2 = Roll(1, 20);
+  if (tHook)
+  {
+    return tHook(1, 20, ::Roll::DISADVANTAGE);
+  }
+  return RollUnhooked(1, 20, ::Roll::DISADVANTAGE);
+}
+
+void Die::SetHook(Hook hook)
+{
+  tHook = std::move(hook);
+}
+
+int Die::RollUnhooked(int nDice, int facesDie, ::Roll mode)
+{
+  if (mode == ::Roll::STRIGHT)
+  {
+    return DiceEngine::ThreadLocal().RollSum(nDice, facesDie);
+  }
+
+  int rolls[2];
+  DiceEngine::ThreadLocal().RollMany(2, facesDie, rolls);
 
-  return std::min(roll_1, roll_2);
+  return mode == ::Roll::ADVANTAGE ? std::max(rolls[0], rolls[1]) : std::min(rolls[0], rolls[1]);
 }
@@ -0,0 +1,183 @@
+#include "server/TableClient.h"
+
+#include <cerrno>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+TableClient::~TableClient()
+{
+  Close();
+}
+
+bool TableClient::Connect(const std::string& path, const HelloMessage& hello)
+{
+  Close();
+
+  sockaddr_un address {};
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  path.copy(address.sun_path, path.size());
+
+  _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (_fd < 0)
+  {
+    return false;
+  }
+  if (connect(_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    const int error = errno;
+    Close();
+    errno = error;
+    return false;
+  }
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+
+  _screen.Resize(hello.columns, hello.lines);
+  WriteHello(_out, hello);
+  return Flush();
+}
+
+void TableClient::Close()
+{
+  if (_fd >= 0)
+  {
+    close(_fd);
+  }
+  _fd = -1;
+  _reader = {};
+  _out.clear();
+  _sent = 0;
+  _finished = false;
+}
+
+int TableClient::Fd() const
+{
+  return _fd;
+}
+
+void TableClient::SetOnFrame(OnFrame onFrame)
+{
+  _on_frame = std::move(onFrame);
+}
+
+bool TableClient::SendKey(int key, std::uint32_t tag)
+{
+  WriteKey(_out, {key, tag});
+  return Flush();
+}
+
+bool TableClient::SendResize(int columns, int lines)
+{
+  _screen.Resize(columns, lines);
+  WriteResize(_out, columns, lines);
+  return Flush();
+}
+
+bool TableClient::Flush()
+{
+  while (_sent < _out.size())
+  {
+    const ssize_t written = send(_fd, _out.data() + _sent, _out.size() - _sent, MSG_NOSIGNAL);
+    if (written > 0)
+    {
+      _sent += static_cast<std::size_t>(written);
+      continue;
+    }
+    if (written < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    return written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+  _out.clear();
+  _sent = 0;
+  return true;
+}
+
+bool TableClient::WantsWrite() const
+{
+  return _sent < _out.size();
+}
+
+bool TableClient::Receive()
+{
+  std::uint8_t buffer[16 * 1024];
+
+  while (!_finished)
+  {
+    const ssize_t got = recv(_fd, buffer, sizeof(buffer), 0);
+    if (got == 0)
+    {
+      return false;
+    }
+    if (got < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    _bytes_received += static_cast<std::uint64_t>(got);
+
+    _reader.Feed({buffer, static_cast<std::size_t>(got)});
+    Message message;
+    while (_reader.Next(message))
+    {
+      if (message.type == MessageType::BYE)
+      {
+        _finished = true;
+        break;
+      }
+
+      FrameMessage frame;
+      if (message.type != MessageType::FRAME || !ReadFrame(message.body, frame) ||
+          !_frame_reader.Open(frame.cellFrame))
+      {
+        return false;
+      }
+      if (_on_frame)
+      {
+        _on_frame(frame);
+      }
+      if (!_frame_reader.ApplyTo(_screen))
+      {
+        return false;
+      }
+      _frames++;
+    }
+    if (_reader.Failed())
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool TableClient::Finished() const
+{
+  return _finished;
+}
+
+const FrameBuffer& TableClient::Screen() const
+{
+  return _screen;
+}
+
+std::uint64_t TableClient::Frames() const
+{
+  return _frames;
+}
+
+std::uint64_t TableClient::BytesReceived() const
+{
+  return _bytes_received;
+}
@@ -0,0 +1,181 @@
+#include "server/TableProtocol.h"
+
+#include "replay/Varint.h"
+
+namespace
+{
+
+// Terminals larger than this are a malformed message rather than a session
+// that eats the server's memory
+constexpr std::uint64_t kMaxTerminalSide = 1000;
+
+constexpr std::size_t kHeaderSize = 4;
+
+// Writes the size once the body is in place
+class MessageWriter
+{
+public:
+  MessageWriter(std::vector<std::uint8_t>& out, MessageType type)
+    : _out(out),
+      _start(out.size())
+  {
+    _out.resize(_start + kHeaderSize);
+    _out.push_back(static_cast<std::uint8_t>(type));
+  }
+
+  ~MessageWriter()
+  {
+    const std::uint32_t size = static_cast<std::uint32_t>(_out.size() - _start - kHeaderSize);
+    for (std::size_t i = 0; i < kHeaderSize; i++)
+    {
+      _out[_start + i] = static_cast<std::uint8_t>(size >> (8 * i));
+    }
+  }
+
+  std::vector<std::uint8_t>& Out()
+  {
+    return _out;
+  }
+
+private:
+  std::vector<std::uint8_t>& _out;
+  std::size_t _start;
+};
+
+bool GetSide(const std::uint8_t*& it, const std::uint8_t* end, int& side)
+{
+  std::uint64_t value = 0;
+  if (!GetVarint(it, end, value) || value == 0 || value > kMaxTerminalSide)
+  {
+    return false;
+  }
+  side = static_cast<int>(value);
+  return true;
+}
+
+}
+
+
+void WriteHello(std::vector<std::uint8_t>& out, const HelloMessage& hello)
+{
+  MessageWriter message(out, MessageType::HELLO);
+  PutVarint(message.Out(), static_cast<std::uint64_t>(hello.columns));
+  PutVarint(message.Out(), static_cast<std::uint64_t>(hello.lines));
+  PutVarint(message.Out(), hello.seed);
+}
+
+void WriteKey(std::vector<std::uint8_t>& out, const KeyMessage& key)
+{
+  MessageWriter message(out, MessageType::KEY);
+  PutVarint(message.Out(), static_cast<std::uint64_t>(key.key));
+  PutVarint(message.Out(), key.tag);
+}
+
+void WriteResize(std::vector<std::uint8_t>& out, int columns, int lines)
+{
+  MessageWriter message(out, MessageType::RESIZE);
+  PutVarint(message.Out(), static_cast<std::uint64_t>(columns));
+  PutVarint(message.Out(), static_cast<std::uint64_t>(lines));
+}
+
+void WriteFrame(std::vector<std::uint8_t>& out, std::uint32_t tag, std::span<const std::uint8_t> cellFrame)
+{
+  MessageWriter message(out, MessageType::FRAME);
+  PutVarint(message.Out(), tag);
+  message.Out().insert(message.Out().end(), cellFrame.begin(), cellFrame.end());
+}
+
+void WriteBye(std::vector<std::uint8_t>& out)
+{
+  MessageWriter message(out, MessageType::BYE);
+}
+
+bool ReadHello(std::span<const std::uint8_t> body, HelloMessage& hello)
+{
+  const std::uint8_t* it = body.data();
+  const std::uint8_t* end = it + body.size();
+  return GetSide(it, end, hello.columns) && GetSide(it, end, hello.lines) && GetVarint(it, end, hello.seed);
+}
+
+bool ReadKey(std::span<const std::uint8_t> body, KeyMessage& key)
+{
+  const std::uint8_t* it = body.data();
+  const std::uint8_t* end = it + body.size();
+  std::uint64_t code = 0;
+  std::uint64_t tag = 0;
+  if (!GetVarint(it, end, code) || code > 0xffff || !GetVarint(it, end, tag))
+  {
+    return false;
+  }
+  key.key = static_cast<int>(code);
+  key.tag = static_cast<std::uint32_t>(tag);
+  return true;
+}
+
+bool ReadResize(std::span<const std::uint8_t> body, int& columns, int& lines)
+{
+  const std::uint8_t* it = body.data();
+  const std::uint8_t* end = it + body.size();
+  return GetSide(it, end, columns) && GetSide(it, end, lines);
+}
+
+bool ReadFrame(std::span<const std::uint8_t> body, FrameMessage& frame)
+{
+  const std::uint8_t* it = body.data();
+  const std::uint8_t* end = it + body.size();
+  std::uint64_t tag = 0;
+  if (!GetVarint(it, end, tag))
+  {
+    return false;
+  }
+  frame.tag = static_cast<std::uint32_t>(tag);
+  frame.cellFrame = {it, end};
+  return true;
+}
+
+
+void MessageReader::Feed(std::span<const std::uint8_t> bytes)
+{
+  // Drop what was read before, so the buffer only ever holds one partial
+  // message plus what just came in
+  if (_read > 0)
+  {
+    _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(_read));
+    _read = 0;
+  }
+  _buffer.insert(_buffer.end(), bytes.begin(), bytes.end());
+}
+
+bool MessageReader::Next(Message& message)
+{
+  if (_failed || _buffer.size() - _read < kHeaderSize)
+  {
+    return false;
+  }
+
+  std::uint32_t size = 0;
+  for (std::size_t i = 0; i < kHeaderSize; i++)
+  {
+    size |= static_cast<std::uint32_t>(_buffer[_read + i]) << (8 * i);
+  }
+  if (size == 0 || size > kMaxMessage)
+  {
+    _failed = true;
+    return false;
+  }
+  if (_buffer.size() - _read - kHeaderSize < size)
+  {
+    return false;
+  }
+
+  const std::uint8_t* start = _buffer.data() + _read + kHeaderSize;
+  message.type = static_cast<MessageType>(start[0]);
+  message.body = {start + 1, size - 1};
+  _read += kHeaderSize + size;
+  return true;
+}
+
+bool MessageReader::Failed() const
+{
+  return _failed;
+}
@@ -0,0 +1,652 @@
+#include "server/TableServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <random>
+#include <span>
+#include <variant>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game/DemoScene.h"
+#include "graphics/NcursesGraphics.h"
+#include "rules/DiceEngine.h"
+#include "server/TableProtocol.h"
+#include "utils/GameLoop.h"
+#include "utils/SpscQueue.h"
+
+namespace
+{
+
+constexpr std::size_t kAcceptQueue = 1024;
+constexpr int kMaxEvents = 64;
+constexpr std::uint64_t kMaxCatchUpTicks = 5;
+constexpr std::size_t kReadChunk = 4096;
+
+void Signal(int fd)
+{
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t written = write(fd, &one, sizeof(one));
+}
+
+std::uint64_t Drain(int fd)
+{
+  std::uint64_t count = 0;
+  [[maybe_unused]] const ssize_t got = read(fd, &count, sizeof(count));
+  return count;
+}
+
+void CloseFd(int& fd)
+{
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+  fd = -1;
+}
+
+std::int64_t ThreadCpuNs()
+{
+  timespec now {};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return static_cast<std::int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+// Written by one worker, read by Stats() from any thread
+struct Counters
+{
+  std::atomic<std::size_t> sessions {0};
+  std::atomic<std::uint64_t> accepted {0};
+  std::atomic<std::uint64_t> keys {0};
+  std::atomic<std::uint64_t> frames {0};
+  std::atomic<std::uint64_t> skippedFrames {0};
+  std::atomic<std::uint64_t> bytesSent {0};
+  std::atomic<std::int64_t> cpuNs {0};
+};
+
+// One client and its table. Only its worker ever touches it.
+class Session
+{
+public:
+  Session(int fd, int epollFd, std::uint64_t id, const ServerConfig& config, Counters& counters)
+    : _fd(fd),
+      _epoll_fd(epollFd),
+      _id(id),
+      _config(config),
+      _counters(counters)
+  {
+  }
+
+  ~Session()
+  {
+    Close();
+  }
+
+  Session(const Session&) = delete;
+  Session& operator=(const Session&) = delete;
+
+  // These return false once the session should be closed
+  bool OnReadable()
+  {
+    std::uint8_t buffer[kReadChunk];
+    bool render = false;
+
+    while (true)
+    {
+      const ssize_t got = recv(_fd, buffer, sizeof(buffer), 0);
+      if (got == 0)
+      {
+        return false;
+      }
+      if (got < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          break;
+        }
+        return false;
+      }
+
+      _reader.Feed({buffer, static_cast<std::size_t>(got)});
+      Message message;
+      while (_reader.Next(message))
+      {
+        if (!Handle(message, render))
+        {
+          // A quit still gets its last frame and BYE, if the socket takes them
+          Flush();
+          return false;
+        }
+      }
+      if (_reader.Failed())
+      {
+        return false;
+      }
+      if (static_cast<std::size_t>(got) < sizeof(buffer))
+      {
+        break;
+      }
+    }
+
+    // Every key read at once is shown by one frame
+    if (render)
+    {
+      Render();
+    }
+    return Flush();
+  }
+
+  bool OnWritable()
+  {
+    if (!Flush())
+    {
+      return false;
+    }
+    if (_stale && _out.empty())
+    {
+      Render();
+      return Flush();
+    }
+    return true;
+  }
+
+  bool OnTick(std::uint64_t ticks)
+  {
+    if (!_scene)
+    {
+      return true;
+    }
+    for (std::uint64_t tick = 0; tick < ticks; tick++)
+    {
+      _scene->Tick();
+    }
+    Render();
+    return Flush();
+  }
+
+  void Close()
+  {
+    if (_closed)
+    {
+      return;
+    }
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _fd, nullptr);
+    close(_fd);
+    _closed = true;
+    _counters.sessions.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  bool Closed() const
+  {
+    return _closed;
+  }
+
+private:
+  bool Handle(const Message& message, bool& render)
+  {
+    switch (message.type)
+    {
+      case MessageType::HELLO:
+      {
+        HelloMessage hello;
+        if (_scene || !ReadHello(message.body, hello))
+        {
+          return false;
+        }
+        _dice.Seed(hello.seed != 0 ? hello.seed : std::random_device{}(), _id);
+        _display = std::make_unique<Display>();
+        _display->InitStream(hello.columns, hello.lines);
+        _display->SetMarginColor(FontColor::BLUE_OVER_BLACK);
+        _scene = std::make_unique<DemoScene>(hello.columns, hello.lines);
+        _scene->SetDice(_dice);
+        render = true;
+        return true;
+      }
+
+      case MessageType::KEY:
+      {
+        KeyMessage key;
+        if (!_scene || !ReadKey(message.body, key))
+        {
+          return false;
+        }
+        _counters.keys.fetch_add(1, std::memory_order_relaxed);
+        _tag = key.tag;
+        if (!_scene->OnKey(key.key))
+        {
+          Render();
+          WriteBye(_out);
+          return false;
+        }
+        render = true;
+        return true;
+      }
+
+      case MessageType::RESIZE:
+      {
+        int columns = 0;
+        int lines = 0;
+        if (!_scene || !ReadResize(message.body, columns, lines))
+        {
+          return false;
+        }
+        _display->Resize(columns, lines);
+        render = true;
+        return true;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  void Render()
+  {
+    if (_out.size() - _sent > _config.maxBacklog)
+    {
+      _stale = true;
+      _counters.skippedFrames.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    _stale = false;
+
+    const GameLoop::Clock::time_point start = GameLoop::Clock::now();
+    _scene->Render(*_display, _frame_times);
+
+    // A key that changed nothing is still acknowledged, with an empty frame
+    std::span<const std::uint8_t> frame = std::get<StreamTarget>(_display->Target()).Frame();
+    if (!frame.empty() || _tag != _sent_tag)
+    {
+      WriteFrame(_out, _tag, frame);
+      _sent_tag = _tag;
+      _counters.frames.fetch_add(1, std::memory_order_relaxed);
+    }
+    _frame_times.Record(GameLoop::Clock::now() - start);
+  }
+
+  bool Flush()
+  {
+    while (_sent < _out.size())
+    {
+      const ssize_t written = send(_fd, _out.data() + _sent, _out.size() - _sent, MSG_NOSIGNAL);
+      if (written > 0)
+      {
+        _sent += static_cast<std::size_t>(written);
+        _counters.bytesSent.fetch_add(static_cast<std::uint64_t>(written), std::memory_order_relaxed);
+        continue;
+      }
+      if (written < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      {
+        WatchWrites(true);
+        return true;
+      }
+      return false;
+    }
+
+    _out.clear();
+    _sent = 0;
+    WatchWrites(false);
+    return true;
+  }
+
+  void WatchWrites(bool watch)
+  {
+    if (watch == _watching_writes)
+    {
+      return;
+    }
+    epoll_event event {};
+    event.events = static_cast<std::uint32_t>(EPOLLIN) | (watch ? static_cast<std::uint32_t>(EPOLLOUT) : 0u);
+    event.data.ptr = this;
+    epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, _fd, &event);
+    _watching_writes = watch;
+  }
+
+  int _fd;
+  int _epoll_fd;
+  std::uint64_t _id;
+  const ServerConfig& _config;
+  Counters& _counters;
+
+  MessageReader _reader;
+  std::vector<std::uint8_t> _out;
+  std::size_t _sent {0};
+  bool _watching_writes {false};
+  bool _closed {false};
+  bool _stale {false};              // A frame was skipped while the client was behind
+  std::uint32_t _tag {0};           // Of the last key applied
+  std::uint32_t _sent_tag {0};
+
+  // Created by HELLO
+  std::unique_ptr<Display> _display;
+  std::unique_ptr<DemoScene> _scene;
+  DiceEngine _dice {0};
+  FrameTimes _frame_times;          // Worker time spent on each frame
+};
+
+}
+
+
+struct TableServer::Worker
+{
+  SpscQueue<int, kAcceptQueue> incoming;
+  std::thread thread;
+  int epollFd {-1};
+  int wakeFd {-1};
+  int timerFd {-1};
+  std::atomic<bool> stopping {false};
+  Counters counters;
+  std::vector<std::unique_ptr<Session>> sessions;
+  std::uint64_t nextId {0};
+  std::uint64_t idStride {1};
+
+  ~Worker()
+  {
+    sessions.clear();
+    int fd = -1;
+    while (incoming.TryPop(fd))
+    {
+      close(fd);
+    }
+    CloseFd(epollFd);
+    CloseFd(wakeFd);
+    CloseFd(timerFd);
+  }
+
+  bool Open(double tickRate)
+  {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0 || timerFd < 0)
+    {
+      return false;
+    }
+
+    const std::int64_t period = static_cast<std::int64_t>(1e9 / tickRate);
+    itimerspec ticks {};
+    ticks.it_interval = {static_cast<time_t>(period / 1'000'000'000), static_cast<long>(period % 1'000'000'000)};
+    ticks.it_value = ticks.it_interval;
+    if (timerfd_settime(timerFd, 0, &ticks, nullptr) != 0)
+    {
+      return false;
+    }
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.ptr = &wakeFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0)
+    {
+      return false;
+    }
+    event.data.ptr = &timerFd;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event) == 0;
+  }
+
+  void Adopt(const ServerConfig& config)
+  {
+    int fd = -1;
+    while (incoming.TryPop(fd))
+    {
+      auto session = std::make_unique<Session>(fd, epollFd, nextId, config, counters);
+      nextId += idStride;
+      counters.sessions.fetch_add(1, std::memory_order_relaxed);
+      counters.accepted.fetch_add(1, std::memory_order_relaxed);
+
+      epoll_event event {};
+      event.events = EPOLLIN;
+      event.data.ptr = session.get();
+      if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0)
+      {
+        sessions.push_back(std::move(session));
+      }
+    }
+  }
+
+  void Run(const ServerConfig& config)
+  {
+    epoll_event events[kMaxEvents];
+
+    while (!stopping.load(std::memory_order_acquire))
+    {
+      const int ready = epoll_wait(epollFd, events, kMaxEvents, -1);
+      bool closed = false;
+
+      for (int i = 0; i < ready; i++)
+      {
+        void* source = events[i].data.ptr;
+        if (source == &wakeFd)
+        {
+          Drain(wakeFd);
+          Adopt(config);
+        }
+        else if (source == &timerFd)
+        {
+          const std::uint64_t ticks = std::min(Drain(timerFd), kMaxCatchUpTicks);
+          for (const std::unique_ptr<Session>& session : sessions)
+          {
+            if (!session->Closed() && !session->OnTick(ticks))
+            {
+              session->Close();
+              closed = true;
+            }
+          }
+        }
+        else
+        {
+          Session* session = static_cast<Session*>(source);
+          if (session->Closed())
+          {
+            continue;
+          }
+          bool open = true;
+          if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+          {
+            open = session->OnReadable();
+          }
+          if (open && (events[i].events & EPOLLOUT))
+          {
+            open = session->OnWritable();
+          }
+          if (!open)
+          {
+            session->Close();
+            closed = true;
+          }
+        }
+      }
+
+      if (closed)
+      {
+        std::erase_if(sessions, [](const std::unique_ptr<Session>& session) { return session->Closed(); });
+      }
+      counters.cpuNs.store(ThreadCpuNs(), std::memory_order_relaxed);
+    }
+  }
+};
+
+
+TableServer::TableServer(const ServerConfig& config)
+  : _config(config)
+{
+  if (_config.workers == 0)
+  {
+    _config.workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+TableServer::~TableServer()
+{
+  Stop();
+}
+
+bool TableServer::Listen(const std::string& path)
+{
+  sockaddr_un address {};
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  path.copy(address.sun_path, path.size());
+
+  CloseFd(_listen_fd);
+  _listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (_listen_fd < 0)
+  {
+    return false;
+  }
+
+  unlink(path.c_str());
+  if (bind(_listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(_listen_fd, SOMAXCONN) != 0)
+  {
+    const int error = errno;
+    CloseFd(_listen_fd);
+    errno = error;
+    return false;
+  }
+  _path = path;
+  return true;
+}
+
+bool TableServer::Start()
+{
+  if (_listen_fd < 0 || _acceptor.joinable())
+  {
+    return false;
+  }
+
+  _stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_stop_fd < 0)
+  {
+    return false;
+  }
+
+  _workers.clear();
+  for (std::size_t i = 0; i < _config.workers; i++)
+  {
+    auto worker = std::make_unique<Worker>();
+    worker->nextId = i;
+    worker->idStride = _config.workers;
+    if (!worker->Open(_config.tickRate))
+    {
+      _workers.clear();
+      CloseFd(_stop_fd);
+      return false;
+    }
+    _workers.push_back(std::move(worker));
+  }
+
+  for (const std::unique_ptr<Worker>& worker : _workers)
+  {
+    worker->thread = std::thread(&Worker::Run, worker.get(), std::cref(_config));
+  }
+  _acceptor = std::thread(&TableServer::Accept, this);
+  return true;
+}
+
+void TableServer::Stop()
+{
+  if (_acceptor.joinable())
+  {
+    Signal(_stop_fd);
+    _acceptor.join();
+  }
+
+  // Workers stay around, so Stats() still adds up after Stop()
+  for (const std::unique_ptr<Worker>& worker : _workers)
+  {
+    if (worker->thread.joinable())
+    {
+      worker->stopping.store(true, std::memory_order_release);
+      Signal(worker->wakeFd);
+      worker->thread.join();
+      worker->sessions.clear();
+    }
+  }
+
+  CloseFd(_stop_fd);
+  if (_listen_fd >= 0)
+  {
+    CloseFd(_listen_fd);
+    unlink(_path.c_str());
+  }
+}
+
+std::size_t TableServer::NumWorkers() const
+{
+  return _config.workers;
+}
+
+ServerStats TableServer::Stats() const
+{
+  ServerStats stats;
+  for (const std::unique_ptr<Worker>& worker : _workers)
+  {
+    const Counters& counters = worker->counters;
+    stats.sessions += counters.sessions.load(std::memory_order_relaxed);
+    stats.accepted += counters.accepted.load(std::memory_order_relaxed);
+    stats.keys += counters.keys.load(std::memory_order_relaxed);
+    stats.frames += counters.frames.load(std::memory_order_relaxed);
+    stats.skippedFrames += counters.skippedFrames.load(std::memory_order_relaxed);
+    stats.bytesSent += counters.bytesSent.load(std::memory_order_relaxed);
+    stats.cpuNs += counters.cpuNs.load(std::memory_order_relaxed);
+  }
+  stats.rejected = _rejected.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TableServer::Accept()
+{
+  pollfd fds[2] = {{_listen_fd, POLLIN, 0}, {_stop_fd, POLLIN, 0}};
+  std::size_t next_worker = 0;
+
+  while (true)
+  {
+    if (poll(fds, 2, -1) < 0)
+    {
+      continue;   // EINTR
+    }
+    if (fds[1].revents)
+    {
+      return;
+    }
+
+    while (true)
+    {
+      const int fd = accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0)
+      {
+        break;    // EAGAIN once the backlog is empty
+      }
+
+      Worker& worker = *_workers[next_worker];
+      next_worker = (next_worker + 1) % _workers.size();
+      if (!worker.incoming.TryPush(fd))
+      {
+        close(fd);
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      Signal(worker.wakeFd);
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#include "utils/Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+Arena::Arena(std::size_t initialBytes, std::pmr::memory_resource* upstream)
+  : _upstream(upstream), _next_size(std::max<std::size_t>(initialBytes, 64))
+{
+
+}
+
+Arena::~Arena()
+{
+  FreeBlocks();
+}
+
+void Arena::Reset()
+{
+  if (_blocks.size() > 1)
+  {
+    std::size_t total = 0;
+    for (const Block& block : _blocks)
+    {
+      total += block.size;
+    }
+    FreeBlocks();
+    AddBlock(total);
+  }
+  _offset = 0;
+  _used = 0;
+}
+
+std::size_t Arena::BytesUsed() const
+{
+  return _used;
+}
+
+std::size_t Arena::Capacity() const
+{
+  std::size_t total = 0;
+  for (const Block& block : _blocks)
+  {
+    total += block.size;
+  }
+  return total;
+}
+
+std::size_t Arena::UpstreamAllocations() const
+{
+  return _upstream_allocations;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  auto fits = [&]
+  {
+    const Block& block = _blocks.back();
+    const std::size_t start = (reinterpret_cast<std::uintptr_t>(block.data + _offset) + alignment - 1)
+                              & ~(alignment - 1);
+    return start + bytes <= reinterpret_cast<std::uintptr_t>(block.data + block.size);
+  };
+
+  if (_blocks.empty() || !fits())
+  {
+    AddBlock(bytes + alignment);
+  }
+
+  Block& block = _blocks.back();
+  const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block.data + _offset);
+  const std::size_t padding = ((address + alignment - 1) & ~(alignment - 1)) - address;
+
+  std::byte* memory = block.data + _offset + padding;
+  _offset += padding + bytes;
+  _used += padding + bytes;
+  return memory;
+}
+
+void Arena::do_deallocate(void*, std::size_t, std::size_t)
+{
+
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+void Arena::AddBlock(std::size_t minBytes)
+{
+  // Blocks double, so a round needs O(log n) of them
+  const std::size_t size = std::max(_next_size, minBytes);
+  _blocks.push_back({static_cast<std::byte*>(_upstream->allocate(size, alignof(std::max_align_t))), size});
+  _upstream_allocations++;
+  _offset = 0;
+  _next_size = size * 2;
+}
+
+void Arena::FreeBlocks()
+{
+  for (const Block& block : _blocks)
+  {
+    _upstream->deallocate(block.data, block.size, alignof(std::max_align_t));
+  }
+  _blocks.clear();
+}
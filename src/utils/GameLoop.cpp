@@ -0,0 +1,130 @@
+#include "utils/GameLoop.h"
+
+#include <algorithm>
+
+#include <poll.h>
+
+namespace cr = std::chrono;
+
+
+void FrameTimes::Record(cr::nanoseconds frameTime)
+{
+  _samples[_next] = frameTime.count();
+  _next = (_next + 1) % kWindow;
+  _count = std::min(_count + 1, kWindow);
+}
+
+double FrameTimes::PercentileMs(double quantile) const
+{
+  if (_count == 0)
+  {
+    return 0.0;
+  }
+
+  std::array<std::int64_t, kWindow> sorted;
+  std::copy(_samples.begin(), _samples.begin() + _count, sorted.begin());
+
+  const std::size_t rank = std::min(_count - 1, static_cast<std::size_t>(quantile * _count));
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + _count);
+
+  return sorted[rank] / 1e6;
+}
+
+std::size_t FrameTimes::Count() const
+{
+  return _count;
+}
+
+
+GameLoop::GameLoop(double tickRate, double renderRate, int inputFd)
+  : _tick(cr::duration_cast<Clock::duration>(cr::duration<double>(1.0 / tickRate))),
+    _render_period(cr::duration_cast<Clock::duration>(cr::duration<double>(1.0 / renderRate))),
+    _input_fd(inputFd)
+{
+
+}
+
+void GameLoop::Run(const ReadKey& readKey, const OnKey& onKey, const OnTick& onTick, const OnRender& onRender)
+{
+  _running = true;
+
+  Clock::time_point next_tick = Clock::now();
+  Clock::time_point next_render = next_tick;
+  Clock::time_point last_render {};
+
+  while (_running)
+  {
+    Clock::time_point now = Clock::now();
+
+    int ticks = 0;
+    while (now >= next_tick && ticks < kMaxCatchUpTicks)
+    {
+      onTick(_tick);
+      next_tick += _tick;
+      ticks++;
+    }
+    if (ticks == kMaxCatchUpTicks && now >= next_tick)
+    {
+      // Too far behind to ever catch up: drop the backlog
+      next_tick = now + _tick;
+    }
+
+    now = Clock::now();
+    if (now >= next_render)
+    {
+      if (last_render != Clock::time_point {})
+      {
+        _frame_times.Record(cr::duration_cast<cr::nanoseconds>(now - last_render));
+      }
+      last_render = now;
+
+      const double alpha = cr::duration<double>(now - (next_tick - _tick)) / _tick;
+      onRender(std::clamp(alpha, 0.0, 1.0));
+
+      // Keep the cadence anchored to the deadlines, not to when the frame
+      // finished, unless a whole period was missed.
+      next_render += _render_period;
+      if (next_render <= Clock::now())
+      {
+        next_render = Clock::now() + _render_period;
+      }
+    }
+
+    WaitForInput(std::min(next_tick, next_render));
+
+    for (int key = readKey(); key >= 0 && _running; key = readKey())
+    {
+      if (!onKey(key))
+      {
+        _running = false;
+      }
+    }
+  }
+}
+
+void GameLoop::Stop()
+{
+  _running = false;
+}
+
+const FrameTimes& GameLoop::GetFrameTimes() const
+{
+  return _frame_times;
+}
+
+void GameLoop::WaitForInput(Clock::time_point deadline)
+{
+  const Clock::duration remaining = deadline - Clock::now();
+  if (remaining <= Clock::duration::zero())
+  {
+    return;
+  }
+
+  const cr::nanoseconds ns = cr::duration_cast<cr::nanoseconds>(remaining);
+  timespec timeout {static_cast<time_t>(ns.count() / 1'000'000'000),
+                    static_cast<long>(ns.count() % 1'000'000'000)};
+  pollfd input {_input_fd, POLLIN, 0};
+
+  // EINTR (e.g. SIGWINCH on resize) just means checking for input early
+  ppoll(&input, 1, &timeout, nullptr);
+}
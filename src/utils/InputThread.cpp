@@ -0,0 +1,277 @@
+#include "utils/InputThread.h"
+
+#include <csignal>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace
+{
+
+// ncurses KEY_DOWN, KEY_UP, KEY_LEFT, KEY_RIGHT: the values of Key
+constexpr int kKeyDown = 0402;
+constexpr int kKeyUp = 0403;
+constexpr int kKeyLeft = 0404;
+constexpr int kKeyRight = 0405;
+constexpr int kEscape = 0x1b;
+
+// How long an unfinished escape sequence may wait for its next byte
+constexpr int kEscapeTimeoutMs = 25;
+
+std::atomic<int> gResizeFd {-1};
+struct sigaction gPreviousWinch {};
+
+void OnWinch(int)
+{
+  const int fd = gResizeFd.load(std::memory_order_relaxed);
+  if (fd >= 0)
+  {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(fd, &one, sizeof(one));
+  }
+}
+
+void Signal(int fd)
+{
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t written = write(fd, &one, sizeof(one));
+}
+
+void Drain(int fd)
+{
+  std::uint64_t count = 0;
+  [[maybe_unused]] const ssize_t got = read(fd, &count, sizeof(count));
+}
+
+void CloseFd(int& fd)
+{
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+  fd = -1;
+}
+
+}
+
+
+void KeyDecoder::Feed(std::span<const std::uint8_t> bytes, std::vector<int>& keys)
+{
+  for (const std::uint8_t byte : bytes)
+  {
+    if (_length == 0)
+    {
+      if (byte == kEscape)
+      {
+        _sequence[_length++] = byte;
+      }
+      else
+      {
+        keys.push_back(byte);
+      }
+      continue;
+    }
+
+    if (_length == 1 && byte != '[' && byte != 'O')
+    {
+      // Not a sequence: the escape key, then whatever this is
+      _length = 0;
+      keys.push_back(kEscape);
+      Feed({&byte, 1}, keys);
+      continue;
+    }
+
+    _sequence[_length++] = byte;
+    const bool final = _length > 2 && byte >= 0x40 && byte <= 0x7e;
+    if (final && _length == 3)
+    {
+      switch (byte)
+      {
+        case 'A': keys.push_back(kKeyUp); break;
+        case 'B': keys.push_back(kKeyDown); break;
+        case 'C': keys.push_back(kKeyRight); break;
+        case 'D': keys.push_back(kKeyLeft); break;
+        default: break;
+      }
+    }
+    if (final || _length == sizeof(_sequence))
+    {
+      _length = 0;
+    }
+  }
+}
+
+bool KeyDecoder::Pending() const
+{
+  return _length > 0;
+}
+
+void KeyDecoder::Flush(std::vector<int>& keys)
+{
+  if (_length == 1)
+  {
+    keys.push_back(kEscape);
+  }
+  _length = 0;
+}
+
+
+InputThread::~InputThread()
+{
+  Stop();
+}
+
+bool InputThread::Start(int inputFd, int ttyFd)
+{
+  Stop();
+
+  _input_fd = inputFd;
+  _tty_fd = ttyFd;
+  _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  _stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_wake_fd < 0 || _stop_fd < 0)
+  {
+    Stop();
+    return false;
+  }
+
+  int expected = -1;
+  if (ttyFd >= 0)
+  {
+    _resize_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_resize_fd >= 0 && gResizeFd.compare_exchange_strong(expected, _resize_fd))
+    {
+      struct sigaction action {};
+      action.sa_handler = OnWinch;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+      sigaction(SIGWINCH, &action, &gPreviousWinch);
+    }
+    else
+    {
+      CloseFd(_resize_fd);
+    }
+  }
+
+  _thread = std::thread(&InputThread::Run, this);
+  return true;
+}
+
+void InputThread::Stop()
+{
+  if (_thread.joinable())
+  {
+    Signal(_stop_fd);
+    _thread.join();
+  }
+
+  if (_resize_fd >= 0 && gResizeFd.load() == _resize_fd)
+  {
+    sigaction(SIGWINCH, &gPreviousWinch, nullptr);
+    gResizeFd.store(-1);
+  }
+  CloseFd(_resize_fd);
+  CloseFd(_wake_fd);
+  CloseFd(_stop_fd);
+}
+
+bool InputThread::Poll(InputEvent& event)
+{
+  if (_queue.TryPop(event))
+  {
+    return true;
+  }
+
+  // Reset the wake-up before looking again, so an event pushed in between
+  // either is popped now or signals the fd anew
+  if (_wake_fd >= 0)
+  {
+    Drain(_wake_fd);
+  }
+  return _queue.TryPop(event);
+}
+
+int InputThread::WakeFd() const
+{
+  return _wake_fd;
+}
+
+std::size_t InputThread::Dropped() const
+{
+  return _dropped.load(std::memory_order_relaxed);
+}
+
+void InputThread::Push(const InputEvent& event)
+{
+  if (!_queue.TryPush(event))
+  {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void InputThread::Run()
+{
+  KeyDecoder decoder;
+  std::vector<int> keys;
+  std::uint8_t buffer[256];
+
+  pollfd fds[3] = {{_input_fd, POLLIN, 0}, {_stop_fd, POLLIN, 0}, {_resize_fd, POLLIN, 0}};
+
+  while (true)
+  {
+    const int ready = poll(fds, 3, decoder.Pending() ? kEscapeTimeoutMs : -1);
+    if (ready < 0)
+    {
+      continue;   // EINTR
+    }
+    if (fds[1].revents)
+    {
+      return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    keys.clear();
+
+    if (ready == 0)
+    {
+      decoder.Flush(keys);
+    }
+    if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+    {
+      const ssize_t got = read(_input_fd, buffer, sizeof(buffer));
+      if (got > 0)
+      {
+        decoder.Feed({buffer, static_cast<std::size_t>(got)}, keys);
+      }
+      else if (got == 0 || (fds[0].revents & (POLLHUP | POLLERR)))
+      {
+        fds[0].fd = -1;     // End of input: stop watching it
+      }
+    }
+
+    bool pushed = false;
+    for (int key : keys)
+    {
+      Push({InputType::KEY, key, 0, 0, now});
+      pushed = true;
+    }
+
+    if (fds[2].revents & POLLIN)
+    {
+      Drain(_resize_fd);
+      winsize size {};
+      if (ioctl(_tty_fd, TIOCGWINSZ, &size) == 0)
+      {
+        Push({InputType::RESIZE, -1, size.ws_col, size.ws_row, now});
+        pushed = true;
+      }
+    }
+
+    if (pushed)
+    {
+      Signal(_wake_fd);
+    }
+  }
+}
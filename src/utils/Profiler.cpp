@@ -0,0 +1,215 @@
+#include "utils/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+
+struct Registry
+{
+  std::mutex mutex;
+  std::vector<std::string> zones;
+  std::vector<std::unique_ptr<ProfileRing>> rings;    // Outlive their threads
+};
+
+Registry& GetRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+const std::chrono::steady_clock::time_point kEpoch = std::chrono::steady_clock::now();
+
+void AppendJsonString(std::string& out, const std::string& text)
+{
+  out.push_back('"');
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  out.push_back('"');
+}
+
+}
+
+
+ProfileRing::ProfileRing(std::uint32_t thread)
+  : _thread(thread)
+{
+
+}
+
+void ProfileRing::Push(std::uint16_t zone, std::int64_t startNs, std::int64_t durationNs)
+{
+  const std::uint64_t head = _head.load(std::memory_order_relaxed);
+  const std::size_t slot = 2 * (head % kCapacity);
+
+  // Orders the previous _head store before the overwrite, for Read
+  std::atomic_thread_fence(std::memory_order_release);
+  _slots[slot].store(static_cast<std::uint64_t>(startNs), std::memory_order_relaxed);
+  _slots[slot + 1].store(static_cast<std::uint64_t>(durationNs) << 16 | zone, std::memory_order_relaxed);
+  _head.store(head + 1, std::memory_order_release);
+}
+
+void ProfileRing::Read(std::vector<Event>& out) const
+{
+  const std::uint64_t head = _head.load(std::memory_order_acquire);
+  const std::uint64_t first = head > kCapacity ? head - kCapacity : 0;
+  const std::size_t start = out.size();
+
+  for (std::uint64_t i = first; i < head; i++)
+  {
+    const std::size_t slot = 2 * (i % kCapacity);
+    const std::uint64_t packed = _slots[slot + 1].load(std::memory_order_relaxed);
+    out.push_back({static_cast<std::uint16_t>(packed & 0xffff),
+                   static_cast<std::int64_t>(_slots[slot].load(std::memory_order_relaxed)),
+                   static_cast<std::int64_t>(packed >> 16)});
+  }
+
+  // Events the writer lapped, or is overwriting, while they were copied
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const std::uint64_t now_head = _head.load(std::memory_order_relaxed);
+  const std::uint64_t valid = now_head >= kCapacity ? now_head - kCapacity + 1 : 0;
+  if (valid > first)
+  {
+    const std::size_t lapped = static_cast<std::size_t>(std::min(valid, head) - first);
+    out.erase(out.begin() + start, out.begin() + start + lapped);
+  }
+}
+
+std::uint32_t ProfileRing::Thread() const
+{
+  return _thread;
+}
+
+
+std::atomic<bool> Profiler::_enabled {false};
+
+std::uint16_t Profiler::RegisterZone(const char* name)
+{
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  auto found = std::find(registry.zones.begin(), registry.zones.end(), name);
+  if (found != registry.zones.end())
+  {
+    return static_cast<std::uint16_t>(found - registry.zones.begin());
+  }
+  if (registry.zones.size() >= kNoZone)
+  {
+    return kNoZone;
+  }
+  registry.zones.emplace_back(name);
+  return static_cast<std::uint16_t>(registry.zones.size() - 1);
+}
+
+void Profiler::Enable(bool enabled)
+{
+  _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::int64_t Profiler::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kEpoch).count();
+}
+
+ProfileRing& Profiler::ThreadRing()
+{
+  thread_local ProfileRing* ring = nullptr;
+  if (!ring)
+  {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.rings.push_back(std::make_unique<ProfileRing>(static_cast<std::uint32_t>(registry.rings.size())));
+    ring = registry.rings.back().get();
+  }
+  return *ring;
+}
+
+std::vector<ZoneStats> Profiler::Summarize(std::int64_t windowNs)
+{
+  Registry& registry = GetRegistry();
+  std::vector<ZoneStats> stats;
+  std::vector<const ProfileRing*> rings;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const std::string& zone : registry.zones)
+    {
+      stats.push_back({zone});
+    }
+    for (const auto& ring : registry.rings)
+    {
+      rings.push_back(ring.get());
+    }
+  }
+
+  const std::int64_t since = Now() - windowNs;
+  std::vector<ProfileRing::Event> events;
+  for (const ProfileRing* ring : rings)
+  {
+    events.clear();
+    ring->Read(events);
+    for (const ProfileRing::Event& event : events)
+    {
+      if (event.startNs >= since && event.zone < stats.size())
+      {
+        ZoneStats& zone = stats[event.zone];
+        zone.count++;
+        zone.totalNs += event.durationNs;
+        zone.maxNs = std::max(zone.maxNs, event.durationNs);
+      }
+    }
+  }
+  return stats;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+  Registry& registry = GetRegistry();
+  std::vector<std::string> zones;
+  std::vector<const ProfileRing*> rings;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    zones = registry.zones;
+    for (const auto& ring : registry.rings)
+    {
+      rings.push_back(ring.get());
+    }
+  }
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  std::vector<ProfileRing::Event> events;
+  for (const ProfileRing* ring : rings)
+  {
+    json += std::format("{}{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":{},"
+                        "\"args\":{{\"name\":\"thread {}\"}}}}",
+                        first ? "" : ",", ring->Thread(), ring->Thread());
+    first = false;
+
+    events.clear();
+    ring->Read(events);
+    for (const ProfileRing::Event& event : events)
+    {
+      json += ",{\"ph\":\"X\",\"cat\":\"dnd\",\"name\":";
+      AppendJsonString(json, event.zone < zones.size() ? zones[event.zone] : "?");
+      json += std::format(",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                          ring->Thread(), event.startNs / 1e3, event.durationNs / 1e3);
+    }
+  }
+  json += "]}\n";
+
+  std::ofstream out(path, std::ios::binary);
+  out << json;
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,149 @@
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// Index of the calling worker, or SIZE_MAX outside of a pool.
+thread_local std::size_t current_worker = SIZE_MAX;
+thread_local const ThreadPool* current_pool = nullptr;
+
+}
+
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+  if (threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (std::size_t worker = 0; worker < threads; worker++)
+  {
+    _queues.push_back(std::make_unique<Queue>());
+  }
+  for (std::size_t worker = 0; worker < threads; worker++)
+  {
+    _threads.emplace_back(&ThreadPool::WorkerLoop, this, worker);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_state_mutex);
+    _stop = true;
+  }
+  _work_available.notify_all();
+
+  for (std::thread& thread : _threads)
+  {
+    thread.join();
+  }
+}
+
+std::size_t ThreadPool::NumWorkers() const
+{
+  return _threads.size();
+}
+
+void ThreadPool::Submit(Task task)
+{
+  // Tasks spawned by a worker stay local to it; the rest are spread out.
+  const std::size_t target = (current_pool == this)
+      ? current_worker
+      : _next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+
+  _pending.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(_queues[target]->mutex);
+    _queues[target]->tasks.push_back(std::move(task));
+  }
+  {
+    // Counted under the state lock so a worker about to sleep cannot miss it.
+    std::lock_guard<std::mutex> lock(_state_mutex);
+    _queued.fetch_add(1, std::memory_order_relaxed);
+  }
+  _work_available.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(_state_mutex);
+  _all_done.wait(lock, [this] { return _pending.load() == 0; });
+}
+
+void ThreadPool::ParallelFor(std::size_t count,
+                             std::size_t grain,
+                             const std::function<void(std::size_t, std::size_t, std::size_t)>& fn)
+{
+  grain = std::max<std::size_t>(1, grain);
+
+  for (std::size_t begin = 0; begin < count; begin += grain)
+  {
+    const std::size_t end = std::min(count, begin + grain);
+    Submit([&fn, begin, end](std::size_t worker) { fn(begin, end, worker); });
+  }
+  Wait();
+}
+
+bool ThreadPool::TryPop(std::size_t worker, Task& task)
+{
+  {
+    Queue& own = *_queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+    {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      _queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  for (std::size_t offset = 1; offset < _queues.size(); offset++)
+  {
+    Queue& victim = *_queues[(worker + offset) % _queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty())
+    {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      _queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::WorkerLoop(std::size_t worker)
+{
+  current_worker = worker;
+  current_pool = this;
+
+  Task task;
+  while (true)
+  {
+    if (TryPop(worker, task))
+    {
+      task(worker);
+      task = nullptr;
+
+      if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        std::lock_guard<std::mutex> lock(_state_mutex);
+        _all_done.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_state_mutex);
+    _work_available.wait(lock, [this] { return _stop || _queued.load() > 0; });
+    if (_stop && _queued.load() == 0)
+    {
+      return;
+    }
+  }
+}
@@ -0,0 +1,152 @@
+#include "utils/TimingWheel.h"
+
+#include <algorithm>
+
+
+TimingWheel::TimingWheel(std::uint64_t now)
+  : _now(now)
+{
+  std::fill(std::begin(_heads), std::end(_heads), kNoTimer);
+}
+
+TimingWheel::TimerId TimingWheel::Schedule(std::uint64_t deadline, std::uint32_t payload)
+{
+  TimerId timer;
+  if (!_free.empty())
+  {
+    timer = _free.back();
+    _free.pop_back();
+  }
+  else
+  {
+    timer = static_cast<TimerId>(_nodes.size());
+    _nodes.emplace_back();
+  }
+
+  // Past deadlines fire on the next tick
+  _nodes[timer].deadline = std::max(deadline, _now + 1);
+  _nodes[timer].payload = payload;
+  Place(timer);
+  _size++;
+  return timer;
+}
+
+bool TimingWheel::Cancel(TimerId timer)
+{
+  if (timer >= _nodes.size() || _nodes[timer].list == kFree)
+  {
+    return false;
+  }
+  Unlink(timer);
+  _nodes[timer].list = kFree;
+  _free.push_back(timer);
+  _size--;
+  return true;
+}
+
+void TimingWheel::Advance(std::uint64_t now, std::vector<std::uint32_t>& expired)
+{
+  while (_now < now)
+  {
+    _now++;
+
+    // When a level turns over, the next slot of the level above comes due
+    // and its timers move down to finer slots
+    for (int level = 1; level <= kLevels; level++)
+    {
+      if ((_now & ((std::uint64_t{1} << (level * kSlotBits)) - 1)) != 0)
+      {
+        break;
+      }
+      if (level == kLevels)
+      {
+        Cascade(kOverflow);
+      }
+      else
+      {
+        Cascade(level * kSlots + ((_now >> (level * kSlotBits)) & (kSlots - 1)));
+      }
+    }
+
+    const std::uint32_t slot = static_cast<std::uint32_t>(_now & (kSlots - 1));
+    for (TimerId timer = _heads[slot]; timer != kNoTimer;)
+    {
+      const TimerId next = _nodes[timer].next;
+      expired.push_back(_nodes[timer].payload);
+      _nodes[timer].list = kFree;
+      _free.push_back(timer);
+      _size--;
+      timer = next;
+    }
+    _heads[slot] = kNoTimer;
+  }
+}
+
+std::uint64_t TimingWheel::Now() const
+{
+  return _now;
+}
+
+std::size_t TimingWheel::Size() const
+{
+  return _size;
+}
+
+void TimingWheel::Place(TimerId timer)
+{
+  // Cascading timers due this very tick land in the slot about to fire
+  const std::uint64_t deadline = _nodes[timer].deadline;
+  const std::uint64_t delta = deadline - _now;
+
+  for (int level = 0; level < kLevels; level++)
+  {
+    if (delta < (std::uint64_t{1} << ((level + 1) * kSlotBits)))
+    {
+      Link(timer, level * kSlots + ((deadline >> (level * kSlotBits)) & (kSlots - 1)));
+      return;
+    }
+  }
+  Link(timer, kOverflow);
+}
+
+void TimingWheel::Link(TimerId timer, std::uint32_t list)
+{
+  Node& node = _nodes[timer];
+  node.list = list;
+  node.prev = kNoTimer;
+  node.next = _heads[list];
+  if (node.next != kNoTimer)
+  {
+    _nodes[node.next].prev = timer;
+  }
+  _heads[list] = timer;
+}
+
+void TimingWheel::Unlink(TimerId timer)
+{
+  Node& node = _nodes[timer];
+  if (node.prev != kNoTimer)
+  {
+    _nodes[node.prev].next = node.next;
+  }
+  else
+  {
+    _heads[node.list] = node.next;
+  }
+  if (node.next != kNoTimer)
+  {
+    _nodes[node.next].prev = node.prev;
+  }
+}
+
+void TimingWheel::Cascade(std::uint32_t list)
+{
+  TimerId timer = _heads[list];
+  _heads[list] = kNoTimer;
+  while (timer != kNoTimer)
+  {
+    const TimerId next = _nodes[timer].next;
+    Place(timer);
+    timer = next;
+  }
+}
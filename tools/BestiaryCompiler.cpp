@@ -0,0 +1,50 @@
+// Build step that compiles text bestiaries into one memory-mapped bestiary
+// file, so the game never parses creature data at runtime. See ParseBestiary
+// for the source format.
+//
+//   BestiaryCompiler <output.bestiary> <source.txt>...
+#include <format>
+#include <fstream>
+#include <iostream>
+
+#include "entities/Bestiary.h"
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "usage: BestiaryCompiler <output.bestiary> <source.txt>...\n";
+    return 1;
+  }
+
+  BestiaryWriter writer;
+
+  for (int arg = 2; arg < argc; arg++)
+  {
+    std::ifstream in(argv[arg]);
+    if (!in)
+    {
+      std::cerr << std::format("cannot read {}\n", argv[arg]);
+      return 1;
+    }
+
+    std::vector<BestiaryEntry> entries;
+    std::string error;
+    if (!ParseBestiary(in, entries, error))
+    {
+      std::cerr << std::format("{}: {}\n", argv[arg], error);
+      return 1;
+    }
+    for (BestiaryEntry& entry : entries)
+    {
+      writer.Add(std::move(entry.name), entry.statblock);
+    }
+  }
+
+  if (!writer.Write(argv[1]))
+  {
+    std::cerr << std::format("cannot write {}\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Finds deadly-but-winnable encounters for a party of fighters from the
+// compiled bestiary. The query runs twice, the second time for a slightly
+// easier fight, to show the simulations it reuses.
+//
+//   DnDBalancer [party size] [target win rate] [budget ms] [threads]
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "combat/EncounterBalancer.h"
+#include "entities/Bestiary.h"
+#include "entities/Statblock.h"
+#include "utils/ThreadPool.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+Statblock Fighter()
+{
+  Statblock fighter;
+  fighter.SetHP(28);
+  fighter.SetAC(18);
+  fighter.SetStat(Stats::STR, 16);
+  fighter.SetStat(Stats::DEX, 12);
+  fighter.AddAction(ActionType::ACTION, Action {"Longsword", 5, "1d8+3"_dice});
+  return fighter;
+}
+
+void Report(const EncounterBalancer& balancer, const std::vector<BalancedEncounter>& encounters,
+            double target, double seconds)
+{
+  const BalanceSearchStats& search = balancer.LastSearch();
+  std::cout << std::format("Target win rate {:.0f}%: {} compositions estimated, {} simulated, "
+                           "{} trials run, {} reused, {:.0f} ms{}\n",
+                           100.0 * target, search.estimated, search.simulated, search.trialsRun,
+                           search.trialsCached, seconds * 1e3, search.outOfTime ? " (out of time)" : "");
+
+  for (const BalancedEncounter& encounter : encounters)
+  {
+    std::string monsters;
+    for (const MonsterGroup& group : encounter.monsters)
+    {
+      monsters += std::format("{}{} {}", monsters.empty() ? "" : ", ", group.count,
+                              balancer.Roster()[group.monster].name);
+    }
+    std::cout << std::format("  {:>5.1f}% won (estimate {:>5.1f}%, {:>5} trials)  CR {:>5.2f}  "
+                             "{:>4.1f} rounds  {:>5.1f} damage taken  {}\n",
+                             100.0 * encounter.winRate, 100.0 * encounter.estimatedWinRate, encounter.trials,
+                             encounter.totalCR, encounter.meanRounds, encounter.partyDamage, monsters);
+  }
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const int party_size = argc > 1 ? std::atoi(argv[1]) : 4;
+  const double target = argc > 2 ? std::atof(argv[2]) : 0.7;
+  const int budget_ms = argc > 3 ? std::atoi(argv[3]) : 500;
+  const std::size_t threads = argc > 4 ? std::atoll(argv[4]) : 0;
+
+  std::vector<BestiaryEntry> roster;
+#ifdef DND_BESTIARY
+  Bestiary bestiary;
+  if (bestiary.Open(DND_BESTIARY))
+  {
+    for (std::size_t i = 0; i < bestiary.Size(); i++)
+    {
+      roster.push_back({std::string(bestiary.At(i).Name()), bestiary.At(i).ToStatblock()});
+    }
+  }
+#endif
+  if (roster.empty())
+  {
+    std::cerr << "No bestiary to build encounters from\n";
+    return 1;
+  }
+
+  EncounterBalancer balancer(std::move(roster));
+  ThreadPool pool(threads);
+  const std::vector<Statblock> party(party_size, Fighter());
+
+  BalanceQuery query;
+  query.targetWinRate = target;
+  query.minWinRate = target - 0.2;
+  query.budget = cr::milliseconds(budget_ms);
+
+  for (double shift : {0.0, 0.05})
+  {
+    query.targetWinRate = target + shift;
+    const auto start = cr::steady_clock::now();
+    const std::vector<BalancedEncounter> encounters = balancer.Balance(party, query, pool);
+    const double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+    Report(balancer, encounters, query.targetWinRate, seconds);
+  }
+
+  return 0;
+}
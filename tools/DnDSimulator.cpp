@@ -0,0 +1,98 @@
+// Headless Monte Carlo encounter simulator.
+//
+//   DnDSimulator [trials] [goblins] [threads] [seed]
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "combat/EncounterSimulator.h"
+#include "entities/Bestiary.h"
+#include "entities/Statblock.h"
+#include "utils/Arena.h"
+#include "utils/ThreadPool.h"
+
+namespace cr = std::chrono;
+
+namespace
+{
+
+Statblock Fighter()
+{
+  Statblock fighter;
+  fighter.SetHP(28);
+  fighter.SetAC(18);
+  fighter.SetStat(Stats::STR, 16);
+  fighter.SetStat(Stats::DEX, 12);
+  fighter.AddAction(ActionType::ACTION, Action {"Longsword", 5, "1d8+3"_dice});
+  return fighter;
+}
+
+Statblock Goblin()
+{
+#ifdef DND_BESTIARY
+  Bestiary bestiary;
+  if (bestiary.Open(DND_BESTIARY))
+  {
+    const std::size_t index = bestiary.Find("Goblin");
+    if (index < bestiary.Size())
+    {
+      return bestiary.At(index).ToStatblock();
+    }
+  }
+#endif
+
+  Statblock goblin;
+  goblin.SetCR(0.25f);
+  goblin.SetHP(7);
+  goblin.SetAC(15);
+  goblin.SetStat(Stats::DEX, 14);
+  goblin.AddAction(ActionType::ACTION, Action {"Scimitar", 4, "1d6+2"_dice});
+  return goblin;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  const std::size_t trials = argc > 1 ? std::atoll(argv[1]) : 200'000;
+  const int goblins = argc > 2 ? std::atoi(argv[2]) : 8;
+  const std::size_t threads = argc > 3 ? std::atoll(argv[3]) : 0;
+  const std::uint64_t seed = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+
+  // Everything the encounter owns lives in one arena
+  Arena encounter;
+  std::pmr::vector<Statblock> party(4, Fighter(), &encounter);
+  std::pmr::vector<Statblock> monsters(goblins, Goblin(), &encounter);
+
+  EncounterSimulator simulator(party, monsters);
+  ThreadPool pool(threads);
+
+  auto start = cr::steady_clock::now();
+  SimulationStats stats = simulator.Run(trials, seed, pool);
+  double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+
+  std::cout << std::format("4 fighters vs {} goblins, {} trials on {} workers\n",
+                           goblins, stats.trials, pool.NumWorkers());
+  std::cout << std::format("  trials/s          {:.0f}\n", stats.trials / seconds);
+  std::cout << std::format("  party wins        {:.2f}%\n", 100.0 * stats.WinRate(Side::PARTY));
+  std::cout << std::format("  monster wins      {:.2f}%\n", 100.0 * stats.WinRate(Side::MONSTERS));
+  std::cout << std::format("  draws             {:.2f}%\n", 100.0 * stats.WinRate(Side::NONE));
+  std::cout << std::format("  mean rounds       {:.2f}\n", stats.MeanRounds());
+  std::cout << std::format("  party damage p50  {}\n", stats.PartyDamagePercentile(0.5));
+  std::cout << std::format("  party damage p95  {}\n", stats.PartyDamagePercentile(0.95));
+
+  std::cout << "  rounds histogram\n";
+  for (int rounds = 0; rounds <= SimulationStats::kMaxRounds; rounds++)
+  {
+    if (stats.roundsHistogram[rounds])
+    {
+      std::cout << std::format("    {:>3}  {:>6.2f}%\n", rounds,
+                               100.0 * stats.roundsHistogram[rounds] / stats.trials);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+// Headless look into a session recorded with DnDSystem --record <path>.
+//
+//   ReplayTool <path> [tick]
+//
+// Replays the whole session as fast as it decodes and counts its events;
+// with a tick, seeks there from the nearest snapshot and prints the state.
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+
+#include "replay/ReplayLog.h"
+
+namespace cr = std::chrono;
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "usage: ReplayTool <path> [tick]\n";
+    return 1;
+  }
+
+  ReplayReader reader;
+  if (!reader.Open(argv[1]))
+  {
+    std::cerr << "cannot read a replay log from " << argv[1] << "\n";
+    return 1;
+  }
+
+  CreatureState state;
+  auto start = cr::steady_clock::now();
+  reader.SeekFromStart(0, state);
+
+  std::array<std::size_t, 4> counts {};
+  ReplayEvent event;
+  while (reader.Next(event))
+  {
+    counts[static_cast<int>(event.type)]++;
+  }
+  const double seconds = cr::duration<double>(cr::steady_clock::now() - start).count();
+  const double real_seconds = static_cast<double>(reader.LastTick()) / reader.TickRate();
+
+  std::cout << std::format("{} ticks ({:.1f} s at {} ticks/s), {} snapshots, {} creatures\n",
+                           reader.LastTick(), real_seconds, reader.TickRate(), reader.NumSnapshots(), state.Size());
+  std::cout << std::format("{} keys, {} dice rolls, {} state changes\n", counts[2], counts[1], counts[3]);
+  std::cout << std::format("replayed in {:.3f} ms ({:.0f}x real time)\n", seconds * 1e3,
+                           seconds > 0.0 ? real_seconds / seconds : 0.0);
+
+  if (argc > 2)
+  {
+    const std::uint64_t tick = std::strtoull(argv[2], nullptr, 10);
+    if (!reader.Seek(tick, state))
+    {
+      std::cerr << "tick " << tick << " is past the end of the session\n";
+      return 1;
+    }
+
+    std::cout << std::format("at tick {}:\n", tick);
+    for (std::uint32_t creature = 0; creature < state.Size(); creature++)
+    {
+      std::cout << std::format("  creature {}: hp {} at ({}, {}) initiative {}\n", creature,
+                               state.Get(creature, StateField::HIT_POINTS),
+                               state.Get(creature, StateField::X),
+                               state.Get(creature, StateField::Y),
+                               state.Get(creature, StateField::INITIATIVE));
+    }
+  }
+  return 0;
+}
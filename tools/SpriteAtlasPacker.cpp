@@ -0,0 +1,69 @@
+// Build step that bakes PNG sprites into one atlas file, so the game never
+// decodes images at runtime. Sprites are named after their file stem.
+//
+//   SpriteAtlasPacker <output.atlas> <sprite.png>...
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+#include <png.h>
+
+#include "graphics/SpriteAtlas.h"
+
+namespace
+{
+
+bool LoadPng(const std::string& path, RgbaImage& image)
+{
+  png_image png {};
+  png.version = PNG_IMAGE_VERSION;
+
+  if (!png_image_begin_read_from_file(&png, path.c_str()))
+  {
+    return false;
+  }
+
+  png.format = PNG_FORMAT_RGBA;
+  image.width = static_cast<int>(png.width);
+  image.height = static_cast<int>(png.height);
+  image.pixels.resize(PNG_IMAGE_SIZE(png));
+
+  if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr))
+  {
+    png_image_free(&png);
+    return false;
+  }
+  return true;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "usage: SpriteAtlasPacker <output.atlas> <sprite.png>...\n";
+    return 1;
+  }
+
+  SpriteAtlasWriter writer;
+
+  for (int arg = 2; arg < argc; arg++)
+  {
+    RgbaImage image;
+    if (!LoadPng(argv[arg], image))
+    {
+      std::cerr << std::format("cannot read {}\n", argv[arg]);
+      return 1;
+    }
+    writer.Add(std::filesystem::path(argv[arg]).stem().string(), image);
+  }
+
+  if (!writer.Write(argv[1]))
+  {
+    std::cerr << std::format("cannot write {}\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}